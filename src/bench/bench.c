@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench.h"
+
+bench_allocs bench_alloc_count;
+bench_options bench_opts = { 3, 31 };
+
+static FILE *bench_json;
+static size_t bench_json_count;
+
+#ifdef BENCH_WRAP_MALLOC
+/* The linker redirects calls to malloc() etc. to these wrappers (using
+ * -Wl,--wrap=malloc) so that allocations can be counted.
+ */
+void *__real_malloc(size_t sz);
+void *__real_realloc(void *p, size_t sz);
+void __real_free(void *p);
+
+void *__wrap_malloc(size_t sz)
+{
+    bench_alloc_count.mallocs++;
+    return __real_malloc(sz);
+}
+
+void *__wrap_realloc(void *p, size_t sz)
+{
+    if (p)
+        bench_alloc_count.reallocs++;
+    else
+        bench_alloc_count.mallocs++;
+    return __real_realloc(p, sz);
+}
+
+void __wrap_free(void *p)
+{
+    if (p)
+        bench_alloc_count.frees++;
+    __real_free(p);
+}
+#endif
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/* Start a JSON object for a result; the caller adds its own fields and
+ * closes it with "}"
+ */
+static void bench_json_begin(const char *name, size_t iterations)
+{
+    const char *c;
+
+    fprintf(bench_json, "%s\n    {\"name\": \"", bench_json_count++ ? "," : "");
+    for (c = name; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', bench_json);
+        fputc(*c, bench_json);
+    }
+    fprintf(bench_json, "\", \"ops\": %zu", iterations);
+}
+
+static int bench_cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest rank percentile of n sorted values */
+static double bench_percentile(const double *v, size_t n, unsigned pct)
+{
+    size_t rank = (pct * n + 99) / 100;
+    return v[rank ? rank - 1 : 0];
+}
+
+void bench_report(const char *name, size_t iterations, uint64_t elapsed_ns,
+                  const bench_allocs *allocs)
+{
+    double per_op = iterations ? (double)elapsed_ns / iterations : 0.0;
+
+    printf("%-40s %10zu ops %10.2f ns/op", name, iterations, per_op);
+    if (allocs && iterations) {
+        printf(" %6.2f mallocs/op %6.2f reallocs/op",
+               (double)allocs->mallocs / iterations,
+               (double)allocs->reallocs / iterations);
+    }
+    printf("\n");
+
+    if (bench_json) {
+        bench_json_begin(name, iterations);
+        fprintf(bench_json, ", \"ns_per_op\": %.3f", per_op);
+        if (allocs && iterations) {
+            fprintf(bench_json, ", \"mallocs_per_op\": %.3f, "
+                    "\"reallocs_per_op\": %.3f",
+                    (double)allocs->mallocs / iterations,
+                    (double)allocs->reallocs / iterations);
+        }
+        fprintf(bench_json, "}");
+    }
+}
+
+void bench_report_bytes(const char *name, size_t iterations,
+                        uint64_t elapsed_ns, size_t bytes)
+{
+    double per_op = iterations ? (double)elapsed_ns / iterations : 0.0;
+    double gbps = elapsed_ns ? (double)bytes / elapsed_ns : 0.0;
+
+    printf("%-40s %10zu ops %10.2f ns/op %8.2f GB/s\n", name, iterations,
+           per_op, gbps);
+
+    if (bench_json) {
+        bench_json_begin(name, iterations);
+        fprintf(bench_json, ", \"ns_per_op\": %.3f, \"gb_per_s\": %.3f}",
+                per_op, gbps);
+    }
+}
+
+void bench_run(const char *name, bench_fn fn, void *ctx, size_t ops,
+               size_t bytes, bench_stats *stats)
+{
+    size_t n = bench_opts.samples ? bench_opts.samples : 1, i;
+    double *ns = malloc(n * sizeof *ns), sum = 0.0;
+    bench_stats s;
+
+    if (!ns || ops == 0) {
+        free(ns);
+        return;
+    }
+    for (i = 0; i < bench_opts.warmup; i++)
+        fn(ctx, ops);
+    for (i = 0; i < n; i++) {
+        uint64_t start = bench_now_ns();
+        fn(ctx, ops);
+        ns[i] = (double)(bench_now_ns() - start) / ops;
+        sum += ns[i];
+    }
+    qsort(ns, n, sizeof *ns, bench_cmp_double);
+
+    s.min = ns[0];
+    s.p50 = bench_percentile(ns, n, 50);
+    s.p90 = bench_percentile(ns, n, 90);
+    s.p99 = bench_percentile(ns, n, 99);
+    s.max = ns[n - 1];
+    s.mean = sum / n;
+    free(ns);
+
+    printf("%-40s %10zu ops %10.2f ns/op  p90 %.2f  p99 %.2f", name, ops * n,
+           s.p50, s.p90, s.p99);
+    if (bytes)
+        printf(" %8.2f GB/s", bytes / s.p50);
+    printf("\n");
+
+    if (bench_json) {
+        bench_json_begin(name, ops * n);
+        fprintf(bench_json, ", \"samples\": %zu, \"ns_per_op\": %.3f, "
+                "\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+                "\"max\": %.3f", n, s.mean, s.min, s.p50, s.p90, s.p99, s.max);
+        if (bytes)
+            fprintf(bench_json, ", \"gb_per_s\": %.3f", bytes / s.p50);
+        fprintf(bench_json, "}");
+    }
+    if (stats)
+        *stats = s;
+}
+
+int bench_json_open(const char *path)
+{
+    bench_json = fopen(path, "w");
+    if (!bench_json)
+        return -1;
+    bench_json_count = 0;
+    fprintf(bench_json, "{\"benchmarks\": [");
+    return 0;
+}
+
+void bench_json_close(void)
+{
+    if (!bench_json)
+        return;
+    fprintf(bench_json, "\n]}\n");
+    fclose(bench_json);
+    bench_json = NULL;
+}
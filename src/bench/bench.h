@@ -0,0 +1,55 @@
+#ifndef CU_INCLUDE_BENCH_H
+#define CU_INCLUDE_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Allocation counters. These are only updated when the benchmark is linked
+ * with malloc/realloc/free wrapped (see src/CMakeLists.txt), otherwise they
+ * stay at zero.
+ */
+typedef struct bench_allocs {
+    size_t mallocs;
+    size_t reallocs;
+    size_t frees;
+} bench_allocs;
+
+extern bench_allocs bench_alloc_count;
+
+/* Settings for bench_run(), set from the command line by bench_main.c */
+typedef struct bench_options {
+    size_t warmup;      // untimed calls before sampling
+    size_t samples;     // timed calls
+} bench_options;
+
+extern bench_options bench_opts;
+
+/* One call of a sampled benchmark, running ops operations on ctx */
+typedef void (*bench_fn)(void *ctx, size_t ops);
+
+/* Per operation latencies over the samples of a bench_run() */
+typedef struct bench_stats {
+    double min, p50, p90, p99, max, mean;
+} bench_stats;
+
+uint64_t bench_now_ns(void);
+void bench_report(const char *name, size_t iterations, uint64_t elapsed_ns,
+                  const bench_allocs *allocs);
+void bench_report_bytes(const char *name, size_t iterations,
+                        uint64_t elapsed_ns, size_t bytes);
+
+/* Call fn bench_opts.warmup times untimed, then time each of
+ * bench_opts.samples calls separately and report the percentiles of the
+ * per operation latency. bytes is the size of one operation for the GB/s
+ * figure, or 0 to leave it out.
+ */
+void bench_run(const char *name, bench_fn fn, void *ctx, size_t ops,
+               size_t bytes, bench_stats *stats);
+
+/* Also write every result as JSON to path; returns -1 if the file can't be
+ * opened. bench_json_close() finishes the document.
+ */
+int bench_json_open(const char *path);
+void bench_json_close(void);
+
+#endif /* CU_INCLUDE_BENCH_H */
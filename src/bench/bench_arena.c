@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include "bench.h"
+#include "bench_arena.h"
+#include "../cutil_arena.h"
+#include "../cutil_string.h"
+
+#define BENCH_ARENA_REQUESTS    10000
+#define BENCH_ARENA_STRINGS     100     // strings per request
+
+/* Simulate a request: build a batch of strings, some short and some long
+ * enough to need a buffer, then throw them all away. With an arena, the
+ * strings are never destroyed individually; one reset releases them all.
+ */
+static void bench_request(const char *name, cuArena *arena)
+{
+    static cuStr *strs[BENCH_ARENA_STRINGS];
+    bench_allocs before, delta;
+    uint64_t start, elapsed;
+    size_t r, i;
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (r = 0; r < BENCH_ARENA_REQUESTS; r++) {
+        for (i = 0; i < BENCH_ARENA_STRINGS; i++) {
+            strs[i] = arena ? cuStr_new_in(arena, -1) : cuStr_new(-1);
+            cuStr_set(strs[i], "x-request-header");
+            if (i & 1)
+                cuStr_append(strs[i], ": a value long enough to need a buffer");
+        }
+        if (arena) {
+            cuArena_reset(arena);
+        } else {
+            for (i = 0; i < BENCH_ARENA_STRINGS; i++)
+                cuStr_destroy(&strs[i]);
+        }
+    }
+    elapsed = bench_now_ns() - start;
+
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    bench_report(name, BENCH_ARENA_REQUESTS * BENCH_ARENA_STRINGS, elapsed,
+                 &delta);
+}
+
+void bench_arena(void)
+{
+    cuArena *arena = cuArena_new(0);
+
+    if (!arena) {
+        printf("cuArena_new() failed\n");
+        return;
+    }
+    bench_request("per-request strings, malloc", NULL);
+    bench_request("per-request strings, arena", arena);
+    cuArena_destroy(&arena);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_ARENA_H
+#define CU_INCLUDE_BENCH_ARENA_H
+
+void bench_arena(void);
+
+#endif /* CU_INCLUDE_BENCH_ARENA_H */
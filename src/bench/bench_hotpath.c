@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "bench_hotpath.h"
+#include "../cutil_string.h"
+#include "../cutil_math.h"
+
+/* Sampled benchmarks of the calls that show up in profiles, run through
+ * bench_run() for percentiles and JSON output
+ */
+
+#define BENCH_HOTPATH_OPS   1000
+#define BENCH_HOTPATH_PAIRS 4096
+
+typedef struct bench_hotpath_ctx {
+    cuStr *a, *b;
+    FILE *out;
+    size_t n;
+    ptrdiff_t shift;
+    int x[BENCH_HOTPATH_PAIRS], y[BENCH_HOTPATH_PAIRS];
+    size_t check;       // results are summed here so no call is optimised out
+} bench_hotpath_ctx;
+
+static void bench_hot_append(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    cuStr_clear(ctx->a);
+    for (i = 0; i < ops; i++)
+        cuStr_append(ctx->a, "field=value;");
+    ctx->check += cuStr_len(ctx->a);
+}
+
+static void bench_hot_append_array(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    cuStr_clear(ctx->a);
+    for (i = 0; i < ops; i++)
+        cuStr_append_array(ctx->a, "field=value;", 12);
+    ctx->check += cuStr_len(ctx->a);
+}
+
+static void bench_hot_printf(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    for (i = 0; i < ops; i++)
+        ctx->check += cuStr_printf(ctx->a, "%s: %d", "content-length", (int)i);
+}
+
+static void bench_hot_printf_append(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    cuStr_clear(ctx->a);
+    for (i = 0; i < ops; i++)
+        ctx->check += cuStr_printf_append(ctx->a, "%d%c", (int)(i & 7), '1');
+}
+
+static void bench_hot_copy(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    for (i = 0; i < ops; i++) {
+        cuStr *copy = cuStr_copy(ctx->a);
+        ctx->check += cuStr_len(copy);
+        cuStr_destroy(&copy);
+    }
+}
+
+static void bench_hot_rotate(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    for (i = 0; i < ops; i++)
+        cuStr_rotate(ctx->a, ctx->shift, ctx->n);
+}
+
+static void bench_hot_cmp(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    for (i = 0; i < ops; i++)
+        ctx->check += cuStr_cmp(ctx->a, ctx->b) == 0;
+}
+
+static void bench_hot_hexdump(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    for (i = 0; i < ops; i++)
+        cuStr_hexdump(ctx->out, ctx->a, 16);
+}
+
+static void bench_hot_gcd(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    size_t i;
+
+    for (i = 0; i < ops; i++)
+        ctx->check += gcd(ctx->x[i % BENCH_HOTPATH_PAIRS],
+                          ctx->y[i % BENCH_HOTPATH_PAIRS]);
+}
+
+/* The workload of look_and_say() in tests/test_string.c, which is only
+ * built without NDEBUG: one cuStr_printf_append() per run of digits
+ */
+static void bench_hot_look_and_say(void *arg, size_t ops)
+{
+    bench_hotpath_ctx *ctx = arg;
+    cuStr *src = ctx->a, *dest = ctx->b, *tmp;
+    size_t i;
+
+    cuStr_set(src, "1");
+    for (i = 0; i < ops; i++) {
+        int count = 1;
+        char search_char = cuStr_at(src, 0);
+        unsigned j;
+
+        cuStr_clear(dest);
+        for (j = 1; search_char != '\0'; j++) {
+            char ch = cuStr_at(src, j);
+            if (ch == search_char)
+                count++;
+            else {
+                cuStr_printf_append(dest, "%d%c", count, search_char);
+                count = 1;
+                search_char = ch;
+            }
+        }
+        tmp = src; src = dest; dest = tmp;
+    }
+    ctx->check += cuStr_len(src);
+}
+
+/* Fill a with n bytes and make b an equal copy */
+static void bench_hot_fill(bench_hotpath_ctx *ctx, size_t n)
+{
+    size_t i;
+
+    cuStr_clear(ctx->a);
+    for (i = 0; i < n; i++)
+        cuStr_append_array(ctx->a, &"0123456789abcdef"[i & 15], 1);
+    cuStr_set_fromarray(ctx->b, cuStr_cstr(ctx->a), (unsigned)n);
+}
+
+void bench_hotpath(void)
+{
+    static const size_t sizes[] = { 16, 256, 4096 };
+    bench_hotpath_ctx *ctx = calloc(1, sizeof *ctx);
+    char label[64];
+    size_t i;
+    unsigned x = 2463534242u;
+
+    if (!ctx)
+        return;
+    ctx->a = cuStr_new(-1);
+    ctx->b = cuStr_new(-1);
+    ctx->out = fopen("/dev/null", "w");
+    if (!ctx->a || !ctx->b || !ctx->out)
+        goto end;
+
+    bench_run("cuStr_append 12 bytes", bench_hot_append, ctx,
+              BENCH_HOTPATH_OPS, 12, NULL);
+    bench_run("cuStr_append_array 12 bytes", bench_hot_append_array, ctx,
+              BENCH_HOTPATH_OPS, 12, NULL);
+    bench_run("cuStr_printf \"%s: %d\"", bench_hot_printf, ctx,
+              BENCH_HOTPATH_OPS, 0, NULL);
+    bench_run("cuStr_printf_append \"%d%c\"", bench_hot_printf_append, ctx,
+              BENCH_HOTPATH_OPS, 0, NULL);
+
+    for (i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+        bench_hot_fill(ctx, sizes[i]);
+        snprintf(label, sizeof label, "cuStr_copy %zu bytes", sizes[i]);
+        bench_run(label, bench_hot_copy, ctx, BENCH_HOTPATH_OPS, sizes[i], NULL);
+        snprintf(label, sizeof label, "cuStr_cmp %zu bytes", sizes[i]);
+        bench_run(label, bench_hot_cmp, ctx, BENCH_HOTPATH_OPS, sizes[i], NULL);
+    }
+
+    /* Short rotations stay in the scratch buffer, long ones reverse */
+    bench_hot_fill(ctx, 1 << 20);
+    ctx->n = 4096;
+    ctx->shift = 1000;
+    bench_run("cuStr_rotate 4096 by 1000", bench_hot_rotate, ctx, BENCH_HOTPATH_OPS,
+              ctx->n, NULL);
+    ctx->n = 1 << 20;
+    ctx->shift = -(ptrdiff_t)ctx->n / 3;
+    bench_run("cuStr_rotate 1M by -n/3", bench_hot_rotate, ctx, 4, ctx->n, NULL);
+
+    bench_hot_fill(ctx, 4096);
+    bench_run("cuStr_hexdump 4096 bytes", bench_hot_hexdump, ctx, 8, 4096, NULL);
+
+    for (i = 0; i < BENCH_HOTPATH_PAIRS; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        ctx->x[i] = (int)(x >> 1) - (1 << 30);
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        ctx->y[i] = (int)((x >> 1) * (i % 6 + 1)) - (1 << 30);
+    }
+    bench_run("gcd 31 bit", bench_hot_gcd, ctx, BENCH_HOTPATH_PAIRS, 0, NULL);
+
+    /* 40 terms, ending at about 60K digits */
+    bench_run("look_and_say 40 terms", bench_hot_look_and_say, ctx, 40, 0, NULL);
+
+    if (ctx->check == 0)
+        printf("unexpected: no results\n");
+end:
+    if (ctx->out)
+        fclose(ctx->out);
+    cuStr_destroy(&ctx->a);
+    cuStr_destroy(&ctx->b);
+    free(ctx);
+}
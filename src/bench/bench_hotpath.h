@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_HOTPATH_H
+#define CU_INCLUDE_BENCH_HOTPATH_H
+
+void bench_hotpath(void);
+
+#endif /* CU_INCLUDE_BENCH_HOTPATH_H */
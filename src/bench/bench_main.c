@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_string.h"
+#include "bench_arena.h"
+#include "bench_strnum.h"
+#include "bench_strsearch.h"
+#include "bench_strcmp.h"
+#include "bench_strhash.h"
+#include "bench_strmap.h"
+#include "bench_strpool.h"
+#include "bench_strrotate.h"
+#include "bench_math.h"
+#include "bench_hotpath.h"
+#include "bench_strview.h"
+#include "bench_strfile.h"
+#include "bench_strreader.h"
+#include "bench_strchain.h"
+#include "bench_strcodec.h"
+#include "bench_strlog.h"
+#include "bench_strcache.h"
+#include "bench_strutf8.h"
+#include "bench_strxform.h"
+#include "bench_strmatch.h"
+
+/* Each group runs a set of related benchmarks */
+static const struct {
+    const char *name;
+    void (*run)(void);
+} bench_groups[] = {
+    { "sso", bench_sso },
+    { "growth", bench_growth },
+    { "printf", bench_printf },
+    { "arena", bench_arena },
+    { "strnum", bench_strnum },
+    { "strsearch", bench_strsearch },
+    { "strcmp", bench_strcmp },
+    { "strhash", bench_strhash },
+    { "strmap", bench_strmap },
+    { "strpool", bench_strpool },
+    { "strrotate", bench_strrotate },
+    { "math", bench_math },
+    { "hotpath", bench_hotpath },
+    { "strview", bench_strview },
+    { "strfile", bench_strfile },
+    { "strreader", bench_strreader },
+    { "strchain", bench_strchain },
+    { "strcodec", bench_strcodec },
+    { "strlog", bench_strlog },
+    { "strcache", bench_strcache },
+    { "strutf8", bench_strutf8 },
+    { "strxform", bench_strxform },
+    { "strmatch", bench_strmatch },
+};
+
+static void bench_usage(const char *prog)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s [--json FILE] [--warmup N] [--samples N] [GROUP...]\n"
+            "groups:", prog);
+    for (i = 0; i < sizeof bench_groups / sizeof bench_groups[0]; i++)
+        fprintf(stderr, " %s", bench_groups[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *json = NULL;
+    int i, first_group = argc, selected;
+    size_t g;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            json = argv[++i];
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            bench_opts.warmup = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+            bench_opts.samples = strtoul(argv[++i], NULL, 10);
+        else if (argv[i][0] == '-') {
+            bench_usage(argv[0]);
+            return 1;
+        } else {
+            first_group = i;
+            break;
+        }
+    }
+    if (json && bench_json_open(json) != 0) {
+        perror(json);
+        return 1;
+    }
+
+    /* Without group names, run all of them */
+    for (g = 0; g < sizeof bench_groups / sizeof bench_groups[0]; g++) {
+        selected = first_group == argc;
+        for (i = first_group; i < argc && !selected; i++)
+            selected = strcmp(argv[i], bench_groups[g].name) == 0;
+        if (selected)
+            bench_groups[g].run();
+    }
+
+    bench_json_close();
+    return 0;
+}
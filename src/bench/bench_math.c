@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "bench_math.h"
+#include "../cutil_math.h"
+#include "../cutil_simd.h"
+
+#define BENCH_MATH_PAIRS    (1 << 20)
+#define BENCH_MATH_POWS     20000
+#define BENCH_MATH_PRIMES   200
+
+/* Baseline: the one bit per iteration binary GCD that gcd() used to be */
+static uint64_t bench_gcd_bitwise(uint64_t u, uint64_t v)
+{
+    unsigned shift;
+
+    if (u == 0) return v;
+    if (v == 0) return u;
+
+    for (shift = 0; ((u | v) & 1) == 0; shift++) {
+        u >>= 1;
+        v >>= 1;
+    }
+    while (!(u & 1))
+        u >>= 1;
+    do {
+        while ((v & 1) == 0)
+            v >>= 1;
+        if (v < u) {
+            uint64_t t = u;
+            u = v;
+            v = t;
+        }
+        v -= u;
+    } while (v);
+    return u << shift;
+}
+
+static uint64_t bench_gcd_euclid(uint64_t a, uint64_t b)
+{
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Operands of the given number of bits sharing a small random factor, like
+ * the numerators and denominators of a fraction to be reduced
+ */
+static void bench_fill(uint64_t *a, uint64_t *b, size_t n, unsigned bits)
+{
+    uint64_t x = 88172645463325252u, mask = bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        uint64_t f;
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        f = (x >> 59) + 1;
+        a[i] = ((x & mask) | 1) * f;
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        b[i] = ((x & mask) | 1) * f;
+    }
+}
+
+static void bench_gcd_bits(uint64_t *a, uint64_t *b, uint64_t *out,
+                           unsigned bits)
+{
+    char label[64];
+    size_t i, n = BENCH_MATH_PAIRS;
+    uint64_t start, sum = 0, check = 0;
+
+    bench_fill(a, b, n, bits);
+
+    start = bench_now_ns();
+    for (i = 0; i < n; i++)
+        check += bench_gcd_euclid(a[i], b[i]);
+    snprintf(label, sizeof label, "gcd %u bit, euclid", bits);
+    bench_report(label, n, bench_now_ns() - start, NULL);
+
+    start = bench_now_ns();
+    for (i = 0; i < n; i++)
+        sum += bench_gcd_bitwise(a[i], b[i]);
+    snprintf(label, sizeof label, "gcd %u bit, bit at a time", bits);
+    bench_report(label, n, bench_now_ns() - start, NULL);
+
+    start = bench_now_ns();
+    for (i = 0; i < n; i++)
+        sum += gcd_u64(a[i], b[i]);
+    snprintf(label, sizeof label, "gcd_u64 %u bit", bits);
+    bench_report(label, n, bench_now_ns() - start, NULL);
+
+    cu_cpu_set_mask(0);
+    start = bench_now_ns();
+    gcd_pairs_u64(a, b, out, n);
+    snprintf(label, sizeof label, "gcd_pairs_u64 %u bit, scalar", bits);
+    bench_report(label, n, bench_now_ns() - start, NULL);
+    cu_cpu_set_mask(~0U);
+
+    start = bench_now_ns();
+    gcd_pairs_u64(a, b, out, n);
+    snprintf(label, sizeof label, "gcd_pairs_u64 %u bit, avx2", bits);
+    bench_report(label, n, bench_now_ns() - start, NULL);
+
+    for (i = 0; i < n; i++)
+        sum += out[i];
+    if (sum != 3 * check)
+        printf("unexpected: gcd results differ\n");
+}
+
+static void bench_gcd_array(uint64_t *a, uint64_t *b)
+{
+    size_t i, n = BENCH_MATH_PAIRS;
+    uint64_t start, g1, g2;
+
+    /* A common factor of 6 everywhere, so there is no early exit */
+    bench_fill(a, b, n, 40);
+    for (i = 0; i < n; i++)
+        a[i] = a[i] * 6;
+
+    start = bench_now_ns();
+    for (i = 0, g1 = 0; i < n; i++)
+        g1 = gcd_u64(g1, a[i]);
+    bench_report("gcd_u64 fold over array", n, bench_now_ns() - start, NULL);
+
+    start = bench_now_ns();
+    g2 = gcd_array_u64(a, n);
+    bench_report("gcd_array_u64", n, bench_now_ns() - start, NULL);
+
+    if (g1 != g2 || g1 % 6 != 0)
+        printf("unexpected: gcd_array_u64 results differ\n");
+}
+
+#ifdef __SIZEOF_INT128__
+/* Baselines for the modular code: the textbook versions using a 128 bit %
+ * for every product
+ */
+static uint64_t bench_mulmod_naive(uint64_t a, uint64_t b, uint64_t m)
+{
+    return (uint64_t)((cu_uint128)a * b % m);
+}
+
+static uint64_t bench_modpow_naive(uint64_t b, uint64_t e, uint64_t m)
+{
+    uint64_t r = 1;
+
+    b %= m;
+    for (; e; e >>= 1) {
+        if (e & 1)
+            r = bench_mulmod_naive(r, b, m);
+        b = bench_mulmod_naive(b, b, m);
+    }
+    return r;
+}
+
+static int bench_trial_division(uint64_t n)
+{
+    uint64_t d;
+
+    if (n < 2 || n % 2 == 0)
+        return n == 2;
+    for (d = 3; d * d <= n; d += 2) {
+        if (n % d == 0)
+            return 0;
+    }
+    return 1;
+}
+
+static void bench_modpow(uint64_t *a, uint64_t *b, unsigned bits)
+{
+    uint64_t m = 1ULL << (bits - 1), sum1 = 0, sum2 = 0, start;
+    cuMontgomery mont;
+    char label[64];
+    size_t i;
+
+    m = next_prime_u64(m);
+    bench_fill(a, b, BENCH_MATH_PAIRS, 64);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_MATH_POWS; i++)
+        sum1 += bench_modpow_naive(a[i], b[i], m);
+    snprintf(label, sizeof label, "modpow with %% (%u bit modulus)", bits);
+    bench_report(label, BENCH_MATH_POWS, bench_now_ns() - start, NULL);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_MATH_POWS; i++)
+        sum2 += modpow_u64(a[i], b[i], m);
+    snprintf(label, sizeof label, "modpow_u64 (%u bit modulus)", bits);
+    bench_report(label, BENCH_MATH_POWS, bench_now_ns() - start, NULL);
+
+    /* A chain of dependent multiplications under one modulus. Montgomery
+     * form only needs its operands below m, so both get the same reduced
+     * inputs.
+     */
+    cuMontgomery_init(&mont, m);
+    for (i = 0; i < BENCH_MATH_PAIRS; i++)
+        a[i] %= m;
+    start = bench_now_ns();
+    for (i = 0, b[0] = a[0] % m; i < BENCH_MATH_PAIRS; i++)
+        b[0] = bench_mulmod_naive(b[0], a[i], m);
+    snprintf(label, sizeof label, "mulmod with %% (%u bit modulus)", bits);
+    bench_report(label, BENCH_MATH_PAIRS, bench_now_ns() - start, NULL);
+
+    start = bench_now_ns();
+    for (i = 0, b[1] = cuMontgomery_to(&mont, a[0]); i < BENCH_MATH_PAIRS; i++)
+        b[1] = cuMontgomery_mul(&mont, b[1], a[i]);
+    snprintf(label, sizeof label, "cuMontgomery_mul (%u bit modulus)", bits);
+    bench_report(label, BENCH_MATH_PAIRS, bench_now_ns() - start, NULL);
+
+    if (sum1 != sum2)
+        printf("unexpected: modpow results differ\n");
+}
+
+#endif
+
+static void bench_primality(void)
+{
+    static const unsigned bits[] = { 32, 40 };
+    uint64_t n, start;
+    char label[64];
+    size_t i, k, found1, found2;
+
+    for (k = 0; k < sizeof bits / sizeof bits[0]; k++) {
+        n = 1ULL << bits[k];
+        found1 = found2 = 0;
+        start = bench_now_ns();
+        for (i = 0; i < BENCH_MATH_PRIMES; i++)
+            found1 += bench_trial_division(n + 2 * i + 1);
+        snprintf(label, sizeof label, "trial division (%u bit, odd n)", bits[k]);
+        bench_report(label, BENCH_MATH_PRIMES, bench_now_ns() - start, NULL);
+
+        start = bench_now_ns();
+        for (i = 0; i < BENCH_MATH_PRIMES; i++)
+            found2 += is_prime_u64(n + 2 * i + 1);
+        snprintf(label, sizeof label, "is_prime_u64 (%u bit, odd n)", bits[k]);
+        bench_report(label, BENCH_MATH_PRIMES, bench_now_ns() - start, NULL);
+        if (found1 != found2)
+            printf("unexpected: is_prime_u64 results differ\n");
+    }
+
+    start = bench_now_ns();
+    for (i = 0, n = 1ULL << 63; i < BENCH_MATH_PRIMES; i++)
+        n = next_prime_u64(n + 1);
+    bench_report("next_prime_u64 (64 bit)", BENCH_MATH_PRIMES,
+                 bench_now_ns() - start, NULL);
+}
+
+void bench_math(void)
+{
+    uint64_t *a = malloc(BENCH_MATH_PAIRS * sizeof *a);
+    uint64_t *b = malloc(BENCH_MATH_PAIRS * sizeof *b);
+    uint64_t *out = malloc(BENCH_MATH_PAIRS * sizeof *out);
+
+    if (a && b && out) {
+        bench_gcd_bits(a, b, out, 16);
+        bench_gcd_bits(a, b, out, 32);
+        bench_gcd_bits(a, b, out, 58);
+        bench_gcd_array(a, b);
+#ifdef __SIZEOF_INT128__
+        bench_modpow(a, b, 32);
+        bench_modpow(a, b, 63);
+        bench_modpow(a, b, 64);
+#endif
+    }
+    free(a);
+    free(b);
+    free(out);
+    bench_primality();
+}
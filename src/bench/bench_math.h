@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_MATH_H
+#define CU_INCLUDE_BENCH_MATH_H
+
+void bench_math(void);
+
+#endif /* CU_INCLUDE_BENCH_MATH_H */
@@ -0,0 +1,89 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "bench.h"
+#include "bench_strcache.h"
+#include "../cutil_strcache.h"
+#include "../cutil_string.h"
+
+#define BENCH_STRCACHE_STRINGS  1000000     // strings made by all threads
+#define BENCH_STRCACHE_LIVE     16          // strings each thread keeps at once
+
+typedef struct bench_strcache_worker {
+    pthread_t thread;
+    size_t count, bytes;
+} bench_strcache_worker;
+
+/* Short-lived strings of a few dozen to a few thousand bytes, built with
+ * appends so that most of them grow at least once
+ */
+static void *bench_strcache_worker_run(void *arg)
+{
+    static const char field[] = "name=value; ";
+    bench_strcache_worker *w = arg;
+    cuStr *live[BENCH_STRCACHE_LIVE] = { NULL };
+    size_t i, k, n;
+
+    for (i = 0; i < w->count; i++) {
+        cuStr **cus = &live[i % BENCH_STRCACHE_LIVE];
+
+        cuStr_destroy(cus);
+        if ((*cus = cuStr_new(-1)) == NULL)
+            break;
+        n = 2 << (i * 2654435761u >> 7) % 8;
+        for (k = 0; k < n; k++)
+            cuStr_append_array(*cus, field, sizeof field - 1);
+        w->bytes += cuStr_len(*cus);
+    }
+    for (i = 0; i < BENCH_STRCACHE_LIVE; i++)
+        cuStr_destroy(&live[i]);
+    return NULL;
+}
+
+static void bench_strcache_threads(size_t nthreads, bool cached)
+{
+    bench_strcache_worker workers[8];
+    bench_allocs before, delta;
+    char label[64];
+    size_t t, started, bytes = 0;
+    uint64_t start;
+
+    cuStr_cache_enable(cached);
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (started = 0; started < nthreads; started++) {
+        bench_strcache_worker *w = &workers[started];
+        w->count = BENCH_STRCACHE_STRINGS / nthreads;
+        w->bytes = 0;
+        if (pthread_create(&w->thread, NULL, bench_strcache_worker_run, w) != 0)
+            break;
+    }
+    for (t = 0; t < started; t++) {
+        pthread_join(workers[t].thread, NULL);
+        bytes += workers[t].bytes;
+    }
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    snprintf(label, sizeof label, "%zu threads, cache %s", nthreads,
+             cached ? "on" : "off");
+    bench_report(label, BENCH_STRCACHE_STRINGS, bench_now_ns() - start, &delta);
+    if (bytes == 0)
+        printf("unexpected: no strings built\n");
+    cuStr_cache_trim();
+}
+
+void bench_strcache(void)
+{
+    bool enabled = cuStr_cache_enabled();
+    size_t nthreads;
+
+    for (nthreads = 1; nthreads <= 8; nthreads *= 2) {
+        bench_strcache_threads(nthreads, false);
+        bench_strcache_threads(nthreads, true);
+    }
+    cuStr_cache_enable(enabled);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRCACHE_H
+#define CU_INCLUDE_BENCH_STRCACHE_H
+
+void bench_strcache(void);
+
+#endif /* CU_INCLUDE_BENCH_STRCACHE_H */
@@ -0,0 +1,122 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench.h"
+#include "bench_strchain.h"
+#include "../cutil_strchain.h"
+
+#define BENCH_STRCHAIN_BYTES    ((size_t)256 << 20)   // per case
+#define BENCH_STRCHAIN_BODIES   64                    // distinct body strings
+
+/* One response: `pieces` parts, each a short header line followed by a
+ * body of `body_len` bytes taken from bodies[]
+ */
+typedef struct bench_strchain_case {
+    const char *name;
+    size_t pieces, body_len;
+} bench_strchain_case;
+
+static size_t bench_header(char *buf, size_t sz, size_t i)
+{
+    return (size_t)snprintf(buf, sz, "part %zu\r\n", i);
+}
+
+/* Baseline: append everything to one cuStr, then write() it */
+static void bench_append_write(int fd, cuStr **bodies,
+                               const bench_strchain_case *c, const char *label)
+{
+    cuStr *out = cuStr_new(-1);
+    size_t i, k, iterations, total = 0;
+    char header[32];
+    uint64_t start;
+
+    if (!out)
+        return;
+    iterations = BENCH_STRCHAIN_BYTES / (c->pieces * c->body_len) + 1;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++) {
+        cuStr_clear(out);
+        for (k = 0; k < c->pieces; k++) {
+            size_t len = bench_header(header, sizeof header, k);
+            cuStr_append_array(out, header, (unsigned)len);
+            cuStr_append_array(out, cuStr_cstr(bodies[k % BENCH_STRCHAIN_BODIES]),
+                               (unsigned)c->body_len);
+        }
+        lseek(fd, 0, SEEK_SET);
+        if (write(fd, cuStr_cstr(out), cuStr_len(out)) > 0)
+            total += cuStr_len(out);
+    }
+    bench_report_bytes(label, iterations, bench_now_ns() - start, total);
+    cuStr_destroy(&out);
+}
+
+static void bench_chain_write(int fd, cuStr **bodies,
+                              const bench_strchain_case *c, const char *label)
+{
+    cuStrChain *chain = cuStrChain_new();
+    size_t i, k, iterations, total = 0;
+    char header[32];
+    uint64_t start;
+
+    if (!chain)
+        return;
+    iterations = BENCH_STRCHAIN_BYTES / (c->pieces * c->body_len) + 1;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++) {
+        for (k = 0; k < c->pieces; k++) {
+            size_t len = bench_header(header, sizeof header, k);
+            cuStrChain_copy_array(chain, header, len);
+            cuStrChain_add_array(chain, cuStr_cstr(bodies[k % BENCH_STRCHAIN_BODIES]),
+                                 c->body_len);
+        }
+        total += cuStrChain_len(chain);
+        lseek(fd, 0, SEEK_SET);
+        if (cuStrChain_write(chain, fd) != 0)
+            break;
+    }
+    bench_report_bytes(label, iterations, bench_now_ns() - start, total);
+    cuStrChain_destroy(&chain);
+}
+
+void bench_strchain(void)
+{
+    static const bench_strchain_case cases[] = {
+        { "16 x 1 KiB", 16, 1024 },
+        { "256 x 1 KiB", 256, 1024 },
+        { "4096 x 1 KiB", 4096, 1024 },
+        { "64 x 64 KiB", 64, 64 * 1024 },
+        { "4096 x 48 B", 4096, 48 },
+    };
+    static char text[128 * 1024];
+    cuStr *bodies[BENCH_STRCHAIN_BODIES];
+    char label[64];
+    size_t i;
+    char path[] = "/tmp/cu_bench_strchain_XXXXXX";
+    int fd = mkstemp(path);
+
+    for (i = 0; i < sizeof text; i++)
+        text[i] = (char)('a' + i % 26);
+    for (i = 0; i < BENCH_STRCHAIN_BODIES; i++) {
+        if ((bodies[i] = cuStr_new(-1)) != NULL)
+            cuStr_set_fromarray(bodies[i], text + i, 64 * 1024);
+    }
+    /* Every response overwrites the start of a temporary file, which stays
+     * in the page cache
+     */
+    if (fd >= 0)
+        unlink(path);
+    for (i = 0; i < sizeof cases / sizeof cases[0] && fd >= 0; i++) {
+        snprintf(label, sizeof label, "%s, cuStr_append + write", cases[i].name);
+        bench_append_write(fd, bodies, &cases[i], label);
+        snprintf(label, sizeof label, "%s, cuStrChain + writev", cases[i].name);
+        bench_chain_write(fd, bodies, &cases[i], label);
+    }
+    for (i = 0; i < BENCH_STRCHAIN_BODIES; i++)
+        cuStr_destroy(&bodies[i]);
+    if (fd >= 0)
+        close(fd);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRCHAIN_H
+#define CU_INCLUDE_BENCH_STRCHAIN_H
+
+void bench_strchain(void);
+
+#endif /* CU_INCLUDE_BENCH_STRCHAIN_H */
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strcmp.h"
+#include "../cutil_strcmp.h"
+#include "../cutil_simd.h"
+
+#define BENCH_STRCMP_BYTES  ((size_t)64 << 20)
+
+/* Equal strings, so every comparison runs to the end */
+static void bench_equal_size(size_t n)
+{
+    static const struct {
+        const char *name;
+        unsigned mask;
+    } kernels[] = {
+        { "scalar", 0 },
+        { "sse2", CU_CPU_SSE2 },
+        { "avx2", ~0U },
+    };
+    char label[64];
+    cuStr *cus1 = cuStr_new((int)n), *cus2 = cuStr_new((int)n);
+    size_t i, k, iterations = BENCH_STRCMP_BYTES / n, equal = 0;
+    uint64_t start;
+
+    if (!cus1 || !cus2)
+        goto end;
+    for (i = 0; i < n; i++)
+        cuStr_append_array(cus1, "k", 1);
+    cuStr_set_fromarray(cus2, cuStr_cstr(cus1), (unsigned)n);
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        equal += cuStr_cmp(cus1, cus2) == 0;
+    snprintf(label, sizeof label, "cuStr_cmp %zu bytes", n);
+    bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+
+    for (k = 0; k < sizeof kernels / sizeof kernels[0]; k++) {
+        cu_cpu_set_mask(kernels[k].mask);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            equal += cuStr_equal(cus1, cus2);
+        snprintf(label, sizeof label, "cuStr_equal %zu bytes, %s", n,
+                 kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start,
+                           iterations * n);
+    }
+    cu_cpu_set_mask(~0U);
+
+    if (equal != 4 * iterations)
+        printf("unexpected: strings compared unequal\n");
+end:
+    cuStr_destroy(&cus1);
+    cuStr_destroy(&cus2);
+}
+
+void bench_strcmp(void)
+{
+    size_t n;
+
+    for (n = 8; n <= 65536; n *= 8)
+        bench_equal_size(n);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRCMP_H
+#define CU_INCLUDE_BENCH_STRCMP_H
+
+void bench_strcmp(void);
+
+#endif /* CU_INCLUDE_BENCH_STRCMP_H */
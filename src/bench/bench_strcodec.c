@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strcodec.h"
+#include "../cutil_strcodec.h"
+#include "../cutil_simd.h"
+
+#define BENCH_CODEC_BYTES   ((size_t)64 << 10)
+#define BENCH_CODEC_TOTAL   ((size_t)256 << 20)     // per kernel
+#define BENCH_HEXDUMP_BYTES ((size_t)1 << 20)
+
+static const struct {
+    const char *name;
+    unsigned mask;
+} kernels[] = {
+    { "scalar", 0 },
+    { "ssse3", CU_CPU_SSE2 | CU_CPU_SSSE3 },
+    { "avx2", ~0U },
+};
+
+/* Baselines: a call to the C library per byte */
+static void bench_hex_snprintf(char *dst, const char *src, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        snprintf(dst + 2 * i, 3, "%02x", (unsigned char)src[i]);
+}
+
+static void bench_hex_sscanf(char *dst, const char *src, size_t n)
+{
+    unsigned v;
+    size_t i;
+    for (i = 0; i + 2 <= n; i += 2) {
+        sscanf(src + i, "%2x", &v);
+        dst[i / 2] = (char)v;
+    }
+}
+
+/* The old cuStr_hexdump(), minus the sign extension */
+static void bench_hexdump_fprintf(FILE *f, const cuStr *cus, int bytesperline)
+{
+    size_t i;
+
+    for (i = 0; i < cuStr_len(cus); i++)
+        fprintf(f, "%02x%c", (unsigned char)cuStr_cstr(cus)[i],
+                !((i + 1) % bytesperline) ? '\n' : ' ');
+    if (i % bytesperline)
+        fprintf(f, "\n");
+}
+
+static void bench_codec(const char *name, const char *src, char *dst, size_t n,
+                        size_t (*codec)(char *, const char *, size_t))
+{
+    char label[64];
+    size_t i, k, iterations = BENCH_CODEC_TOTAL / n;
+    uint64_t start;
+
+    for (k = 0; k < sizeof kernels / sizeof kernels[0]; k++) {
+        cu_cpu_set_mask(kernels[k].mask);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            codec(dst, src, n);
+        snprintf(label, sizeof label, "%s %zu KiB, %s", name, n >> 10,
+                 kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start,
+                           iterations * n);
+    }
+    cu_cpu_set_mask(~0U);
+}
+
+void bench_strcodec(void)
+{
+    char *src = malloc(BENCH_HEXDUMP_BYTES), *hex = malloc(2 * BENCH_CODEC_BYTES);
+    char *b64 = malloc(CUMEM_BASE64_ENCODED_LEN(BENCH_CODEC_BYTES));
+    char *dst = malloc(2 * BENCH_CODEC_BYTES);
+    cuStr *cus = cuStr_new(-1);
+    FILE *null = fopen("/dev/null", "w");
+    size_t i, iterations;
+    uint64_t start;
+
+    if (!src || !hex || !b64 || !dst || !cus || !null)
+        goto end;
+    for (i = 0; i < BENCH_HEXDUMP_BYTES; i++)
+        src[i] = (char)(i * 7 + i / 251);
+    cuMem_hex_encode(hex, src, BENCH_CODEC_BYTES);
+    cuMem_base64_encode(b64, src, BENCH_CODEC_BYTES);
+
+    iterations = BENCH_CODEC_TOTAL / BENCH_CODEC_BYTES / 64;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        bench_hex_snprintf(dst, src, BENCH_CODEC_BYTES);
+    bench_report_bytes("hex encode 64 KiB, snprintf per byte", iterations,
+                       bench_now_ns() - start, iterations * BENCH_CODEC_BYTES);
+    bench_codec("cuMem_hex_encode", src, dst, BENCH_CODEC_BYTES, cuMem_hex_encode);
+
+    iterations = 4;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        bench_hex_sscanf(dst, hex, 2 * BENCH_CODEC_BYTES);
+    bench_report_bytes("hex decode 128 KiB, sscanf per byte", iterations,
+                       bench_now_ns() - start, iterations * 2 * BENCH_CODEC_BYTES);
+    bench_codec("cuMem_hex_decode", hex, dst, 2 * BENCH_CODEC_BYTES, cuMem_hex_decode);
+
+    bench_codec("cuMem_base64_encode", src, dst, BENCH_CODEC_BYTES, cuMem_base64_encode);
+    bench_codec("cuMem_base64_decode", b64, dst,
+                CUMEM_BASE64_ENCODED_LEN(BENCH_CODEC_BYTES), cuMem_base64_decode);
+
+    /* To /dev/null, so that formatting is what is measured */
+    cuStr_set_fromarray(cus, src, (unsigned)BENCH_HEXDUMP_BYTES);
+    iterations = 4;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        bench_hexdump_fprintf(null, cus, 16);
+    bench_report_bytes("hexdump 1 MiB, fprintf per byte", iterations,
+                       bench_now_ns() - start, iterations * BENCH_HEXDUMP_BYTES);
+    iterations = 64;
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        cuStr_hexdump(null, cus, 16);
+    bench_report_bytes("hexdump 1 MiB, cuStr_hexdump", iterations,
+                       bench_now_ns() - start, iterations * BENCH_HEXDUMP_BYTES);
+end:
+    if (null)
+        fclose(null);
+    cuStr_destroy(&cus);
+    free(src);
+    free(hex);
+    free(b64);
+    free(dst);
+}
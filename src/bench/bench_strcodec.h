@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRCODEC_H
+#define CU_INCLUDE_BENCH_STRCODEC_H
+
+void bench_strcodec(void);
+
+#endif /* CU_INCLUDE_BENCH_STRCODEC_H */
@@ -0,0 +1,82 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+#include "bench_strfile.h"
+#include "../cutil_strfile.h"
+#include "../cutil_strsearch.h"
+
+#define BENCH_STRFILE_BYTES ((size_t)64 << 20)
+#define BENCH_STRFILE_RUNS  5
+
+/* Baseline: fread() into a temporary buffer, then copy into a cuStr */
+static cuStr *bench_load_fread(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    cuStr *cus = NULL;
+    char *buf;
+    long size;
+
+    if (!f)
+        return NULL;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0
+        && fseek(f, 0, SEEK_SET) == 0 && (buf = malloc((size_t)size)) != NULL) {
+        if (fread(buf, 1, (size_t)size, f) == (size_t)size
+            && (cus = cuStr_new(0)) != NULL)
+            cuStr_set_fromarray(cus, buf, (unsigned)size);
+        free(buf);
+    }
+    fclose(f);
+    return cus;
+}
+
+/* Load the file and count its lines, which touches every page */
+static void bench_load(const char *name, const char *path, unsigned flags,
+                       int use_fread)
+{
+    size_t i, lines = 0;
+    uint64_t start;
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRFILE_RUNS; i++) {
+        cuStr *cus = use_fread ? bench_load_fread(path)
+                               : cuStr_map_file(path, flags);
+        if (!cus)
+            return;
+        lines += cuMem_count_byte(cuStr_cstr(cus), cuStr_len(cus), '\n');
+        cuStr_destroy(&cus);
+    }
+    bench_report_bytes(name, BENCH_STRFILE_RUNS, bench_now_ns() - start,
+                       BENCH_STRFILE_RUNS * BENCH_STRFILE_BYTES);
+    if (lines != BENCH_STRFILE_RUNS * (BENCH_STRFILE_BYTES / 64))
+        printf("unexpected: %zu lines\n", lines);
+}
+
+void bench_strfile(void)
+{
+    char path[] = "/tmp/cu_bench_strfile_XXXXXX", line[64];
+    FILE *f;
+    size_t i;
+    int fd;
+
+    if ((fd = mkstemp(path)) < 0 || (f = fdopen(fd, "wb")) == NULL)
+        return;
+    memset(line, 'x', sizeof line - 1);
+    line[sizeof line - 1] = '\n';
+    for (i = 0; i < BENCH_STRFILE_BYTES / sizeof line; i++)
+        fwrite(line, 1, sizeof line, f);
+    if (fclose(f) == 0) {
+        /* The file is in the page cache after being written */
+        bench_load("64 MiB, fread + set_fromarray", path, 0, 1);
+        bench_load("64 MiB, cuStr_map_file read", path, CUSTR_MAP_READ, 0);
+        bench_load("64 MiB, cuStr_map_file", path, 0, 0);
+        bench_load("64 MiB, cuStr_map_file sequential", path,
+                   CUSTR_MAP_SEQUENTIAL, 0);
+        bench_load("64 MiB, cuStr_map_file hugepage", path,
+                   CUSTR_MAP_SEQUENTIAL | CUSTR_MAP_HUGEPAGE, 0);
+    }
+    unlink(path);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRFILE_H
+#define CU_INCLUDE_BENCH_STRFILE_H
+
+void bench_strfile(void);
+
+#endif /* CU_INCLUDE_BENCH_STRFILE_H */
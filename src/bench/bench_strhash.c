@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strhash.h"
+#include "../cutil_strhash.h"
+
+#define BENCH_STRHASH_BYTES ((size_t)64 << 20)
+
+/* Baseline: byte at a time FNV-1a */
+static uint64_t bench_fnv1a(const char *p, size_t n)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (n--) {
+        h ^= (unsigned char)*p++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void bench_hash_size(size_t n)
+{
+    char label[64];
+    char *keys;
+    size_t i, iterations, nkeys = 64;
+    uint64_t start, sum = 0;
+
+    /* Rotate through a few keys so the loop is not hashing one constant */
+    if ((keys = malloc(n + nkeys)) == NULL)
+        return;
+    for (i = 0; i < n + nkeys; i++)
+        keys[i] = (char)('a' + i % 26);
+    iterations = BENCH_STRHASH_BYTES / n;
+    if (iterations > 4000000)
+        iterations = 4000000;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        sum += bench_fnv1a(keys + i % nkeys, n);
+    snprintf(label, sizeof label, "fnv1a %zu bytes", n);
+    bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        sum += cuMem_hash(keys + i % nkeys, n, 0);
+    snprintf(label, sizeof label, "cuMem_hash %zu bytes", n);
+    bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+
+    if (sum == 0)
+        printf("unexpected: hash sum is 0\n");
+    free(keys);
+}
+
+/* The second and later cuStr_hash() calls on an unchanged string */
+static void bench_hash_cached(void)
+{
+    cuStr *cus = cuStr_new(0);
+    size_t i, iterations = 10000000;
+    uint64_t start, sum = 0;
+
+    if (!cus)
+        return;
+    for (i = 0; i < 256; i++)
+        cuStr_append(cus, "k");
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        sum += cuStr_hash(cus);
+    bench_report("cuStr_hash 256 bytes, cached", iterations,
+                 bench_now_ns() - start, NULL);
+
+    if (sum == 0)
+        printf("unexpected: hash sum is 0\n");
+    cuStr_destroy(&cus);
+}
+
+void bench_strhash(void)
+{
+    size_t n;
+
+    for (n = 4; n <= 32; n *= 2)
+        bench_hash_size(n);
+    for (n = 256; n <= 65536; n *= 16)
+        bench_hash_size(n);
+    bench_hash_cached();
+}
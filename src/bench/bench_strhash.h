@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRHASH_H
+#define CU_INCLUDE_BENCH_STRHASH_H
+
+void bench_strhash(void);
+
+#endif /* CU_INCLUDE_BENCH_STRHASH_H */
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include "bench.h"
+#include "bench_string.h"
+#include "../cutil_string.h"
+
+#define BENCH_SSO_ITERATIONS 1000000
+
+/* Create, fill and destroy a short string. initial_sz selects where the
+ * string starts: -1 uses the inline buffer, CUSTR_DEFAULT_CHUNK_SIZE forces a
+ * heap buffer (which is what every cuStr_new() did before the inline buffer
+ * was added).
+ */
+static void bench_short_lifecycle(const char *name, int initial_sz)
+{
+    bench_allocs before, delta;
+    uint64_t start, elapsed;
+    size_t i, total_len = 0;
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_SSO_ITERATIONS; i++) {
+        cuStr *cus = cuStr_new(initial_sz);
+        if (!cus)
+            break;
+        cuStr_set(cus, "content-length");
+        cuStr_append(cus, ": 42");
+        total_len += cuStr_len(cus);
+        cuStr_destroy(&cus);
+    }
+    elapsed = bench_now_ns() - start;
+
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    bench_report(name, i, elapsed, &delta);
+
+    if (total_len != i * 18)
+        printf("%s: unexpected total length %zu\n", name, total_len);
+}
+
+void bench_sso(void)
+{
+    bench_short_lifecycle("short string, heap buffer", CUSTR_DEFAULT_CHUNK_SIZE);
+    bench_short_lifecycle("short string, inline buffer", -1);
+}
+
+/* Build one large string from many small appends. With geometric growth the
+ * cost per append should stay flat as n grows (i.e. linear overall).
+ */
+static void bench_append_n(const char *name, unsigned flags, size_t n)
+{
+    char label[64];
+    bench_allocs before, delta;
+    uint64_t start, elapsed;
+    size_t i;
+    cuStr *cus = cuStr_new(-1);
+
+    if (!cus)
+        return;
+    cuStr_set_resize_strategy(cus, flags);
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < n; i++)
+        cuStr_append_array(cus, "01234567", 8);
+    elapsed = bench_now_ns() - start;
+
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    snprintf(label, sizeof label, "%s, %zu appends", name, n);
+    bench_report(label, n, elapsed, &delta);
+
+    cuStr_destroy(&cus);
+}
+
+void bench_growth(void)
+{
+    size_t n;
+
+    for (n = 125000; n <= 1000000; n *= 2)
+        bench_append_n("chunked growth", CUSTR_RESIZE_UP_CHUNKED, n);
+    for (n = 125000; n <= 1000000; n *= 2)
+        bench_append_n("geometric growth",
+                       CUSTR_RESIZE_UP_CHUNKED | CUSTR_RESIZE_UP_GEOMETRIC, n);
+}
+
+#define BENCH_PRINTF_ITERATIONS 1000000
+
+/* "%d%c" is the format used by the look_and_say() hot loop. The two-pass
+ * variant measures with vsnprintf(NULL, 0, ...) first, which is what
+ * cuStr_printf_append() used to do on every call.
+ */
+static void bench_printf_append(const char *name, int measure_first)
+{
+    char scratch[1];
+    uint64_t start, elapsed;
+    size_t i, measured = 0;
+    cuStr *cus = cuStr_new(-1);
+
+    if (!cus)
+        return;
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_PRINTF_ITERATIONS; i++) {
+        if ((i & 1023) == 0)
+            cuStr_clear(cus);
+        if (measure_first)
+            measured += snprintf(scratch, 0, "%d%c", (int)(i & 7), '1');
+        cuStr_printf_append(cus, "%d%c", (int)(i & 7), '1');
+    }
+    elapsed = bench_now_ns() - start;
+    if (measure_first && measured != 2 * BENCH_PRINTF_ITERATIONS)
+        printf("%s: unexpected measured length %zu\n", name, measured);
+    bench_report(name, BENCH_PRINTF_ITERATIONS, elapsed, NULL);
+
+    cuStr_destroy(&cus);
+}
+
+void bench_printf(void)
+{
+    bench_printf_append("printf_append \"%d%c\", two-pass", 1);
+    bench_printf_append("printf_append \"%d%c\", single-pass", 0);
+}
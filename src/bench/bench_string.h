@@ -0,0 +1,8 @@
+#ifndef CU_INCLUDE_BENCH_STRING_H
+#define CU_INCLUDE_BENCH_STRING_H
+
+void bench_sso(void);
+void bench_growth(void);
+void bench_printf(void);
+
+#endif /* CU_INCLUDE_BENCH_STRING_H */
@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include "bench.h"
+#include "bench_strlog.h"
+#include "../cutil_strlog.h"
+
+#define BENCH_STRLOG_RECORDS    1000000     // in total, split among threads
+#define BENCH_STRLOG_THREADS    64
+#define BENCH_STRLOG_FLUSH      (64 * 1024) // the mutex variant writes this much
+
+/* Baseline: format into a thread's cuStr, then append it under a mutex to
+ * a shared cuStr that is written out whenever it fills
+ */
+typedef struct bench_strlog_shared {
+    pthread_mutex_t lock;
+    cuStr *out;
+    cuStrLogBuffer *buf;
+    int fd;
+    int stop;
+} bench_strlog_shared;
+
+typedef struct bench_strlog_worker {
+    pthread_t thread;
+    bench_strlog_shared *shared;
+    int id;
+    size_t records;
+} bench_strlog_worker;
+
+static void *bench_strlog_mutex_run(void *arg)
+{
+    bench_strlog_worker *w = arg;
+    bench_strlog_shared *s = w->shared;
+    cuStr *line = cuStr_new(-1);
+    size_t i;
+
+    for (i = 0; i < w->records && line; i++) {
+        cuStr_printf(line, "worker %d: request %zu done in %d us\n", w->id, i,
+                     (int)(i % 997));
+        pthread_mutex_lock(&s->lock);
+        cuStr_append_array(s->out, cuStr_cstr(line), (unsigned)cuStr_len(line));
+        if (cuStr_len(s->out) >= BENCH_STRLOG_FLUSH) {
+            if (write(s->fd, cuStr_cstr(s->out), cuStr_len(s->out)) < 0)
+                perror("write");
+            cuStr_clear(s->out);
+        }
+        pthread_mutex_unlock(&s->lock);
+    }
+    cuStr_destroy(&line);
+    return NULL;
+}
+
+static void *bench_strlog_ring_run(void *arg)
+{
+    bench_strlog_worker *w = arg;
+    size_t i;
+
+    for (i = 0; i < w->records; i++)
+        cuStrLogBuffer_printf(w->shared->buf, "worker %d: request %zu done in %d us\n",
+                              w->id, i, (int)(i % 997));
+    return NULL;
+}
+
+static void *bench_strlog_consumer_run(void *arg)
+{
+    bench_strlog_shared *s = arg;
+    ssize_t n;
+
+    for (;;) {
+        int stop = __atomic_load_n(&s->stop, __ATOMIC_ACQUIRE);
+        if ((n = cuStrLogBuffer_drain(s->buf, s->fd)) < 0)
+            break;
+        if (n == 0) {
+            if (stop)
+                break;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void bench_strlog_case(bench_strlog_shared *s, size_t nthreads,
+                              void *(*run)(void *), const char *name)
+{
+    static bench_strlog_worker workers[BENCH_STRLOG_THREADS];
+    pthread_t consumer;
+    char label[64];
+    size_t t, started;
+    uint64_t start;
+
+    s->stop = 0;
+    if (s->buf && pthread_create(&consumer, NULL, bench_strlog_consumer_run, s) != 0)
+        return;
+    start = bench_now_ns();
+    for (started = 0; started < nthreads; started++) {
+        workers[started].shared = s;
+        workers[started].id = (int)started;
+        workers[started].records = BENCH_STRLOG_RECORDS / nthreads;
+        if (pthread_create(&workers[started].thread, NULL, run, &workers[started]) != 0)
+            break;
+    }
+    for (t = 0; t < started; t++)
+        pthread_join(workers[t].thread, NULL);
+    if (s->buf) {
+        __atomic_store_n(&s->stop, 1, __ATOMIC_RELEASE);
+        pthread_join(consumer, NULL);
+    } else if (cuStr_len(s->out)) {
+        if (write(s->fd, cuStr_cstr(s->out), cuStr_len(s->out)) < 0)
+            perror("write");
+        cuStr_clear(s->out);
+    }
+    snprintf(label, sizeof label, "%s, %zu threads", name, nthreads);
+    bench_report(label, started * (BENCH_STRLOG_RECORDS / nthreads),
+                 bench_now_ns() - start, NULL);
+}
+
+void bench_strlog(void)
+{
+    bench_strlog_shared s;
+    size_t nthreads;
+
+    s.fd = open("/dev/null", O_WRONLY);
+    s.out = cuStr_new(BENCH_STRLOG_FLUSH + 256);
+    s.buf = NULL;
+    if (s.fd < 0 || !s.out || pthread_mutex_init(&s.lock, NULL) != 0)
+        goto end;
+
+    /* To /dev/null, so that the cost of sharing is what is measured */
+    for (nthreads = 1; nthreads <= BENCH_STRLOG_THREADS; nthreads *= 2) {
+        s.buf = NULL;
+        bench_strlog_case(&s, nthreads, bench_strlog_mutex_run,
+                          "cuStr_printf + mutex append");
+        if ((s.buf = cuStrLogBuffer_new(1 << 20)) == NULL)
+            break;
+        bench_strlog_case(&s, nthreads, bench_strlog_ring_run,
+                          "cuStrLogBuffer_printf");
+        cuStrLogBuffer_destroy(&s.buf);
+    }
+    pthread_mutex_destroy(&s.lock);
+end:
+    cuStr_destroy(&s.out);
+    if (s.fd >= 0)
+        close(s.fd);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRLOG_H
+#define CU_INCLUDE_BENCH_STRLOG_H
+
+void bench_strlog(void);
+
+#endif /* CU_INCLUDE_BENCH_STRLOG_H */
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strmap.h"
+#include "../cutil_strmap.h"
+#include "../cutil_strhash.h"
+
+#ifndef BENCH_STRMAP_MAX
+#define BENCH_STRMAP_MAX 10000000
+#endif
+
+#define BENCH_STRMAP_KEY 16
+
+/* Lookups and erases visit the keys in a different order from the inserts,
+ * so the chained nodes are not walked in allocation order. 7919 is prime,
+ * and so coprime with every power of 10.
+ */
+#define BENCH_STRMAP_AT(i, n) (((i) * 7919) % (n))
+
+/* Baseline: the chained table of cuStr keys that cuStrMap replaces, with a
+ * node and a cuStr allocated per entry
+ */
+typedef struct bench_chain_node {
+    struct bench_chain_node *next;
+    cuStr *key;
+    void *value;
+} bench_chain_node;
+
+typedef struct bench_chain {
+    bench_chain_node **buckets;
+    size_t mask;
+    size_t size;
+} bench_chain;
+
+static bench_chain_node **bench_chain_find(bench_chain *t, const char *key,
+                                           size_t len)
+{
+    uint64_t hash = cuMem_hash(key, len, CUSTR_HASH_SEED);
+    bench_chain_node **p = &t->buckets[hash & t->mask];
+
+    while (*p && !(cuStr_len((*p)->key) == len
+                   && memcmp(cuStr_cstr((*p)->key), key, len) == 0))
+        p = &(*p)->next;
+    return p;
+}
+
+static void bench_chain_grow(bench_chain *t)
+{
+    size_t i, mask = t->mask * 2 + 1;
+    bench_chain_node **buckets = calloc(mask + 1, sizeof *buckets);
+
+    for (i = 0; i <= t->mask; i++) {
+        bench_chain_node *node = t->buckets[i], *next;
+        for (; node; node = next) {
+            uint64_t hash = cuStr_hash(node->key);
+            next = node->next;
+            node->next = buckets[hash & mask];
+            buckets[hash & mask] = node;
+        }
+    }
+    free(t->buckets);
+    t->buckets = buckets;
+    t->mask = mask;
+}
+
+static void bench_chain_put(bench_chain *t, const char *key, size_t len,
+                            void *value)
+{
+    bench_chain_node **p = bench_chain_find(t, key, len);
+
+    if (*p == NULL) {
+        bench_chain_node *node = malloc(sizeof *node);
+        node->key = cuStr_new((int)len);
+        cuStr_set_fromarray(node->key, key, (unsigned)len);
+        node->next = NULL;
+        *p = node;
+        if (++t->size > t->mask)
+            bench_chain_grow(t);
+        p = bench_chain_find(t, key, len);
+    }
+    (*p)->value = value;
+}
+
+static void bench_chain_erase(bench_chain *t, const char *key, size_t len)
+{
+    bench_chain_node **p = bench_chain_find(t, key, len), *node = *p;
+
+    if (node) {
+        *p = node->next;
+        cuStr_destroy(&node->key);
+        free(node);
+        t->size--;
+    }
+}
+
+static void bench_report_phase(const char *what, size_t n, uint64_t start,
+                               const bench_allocs *before)
+{
+    char label[64];
+    bench_allocs delta;
+
+    snprintf(label, sizeof label, "%s %zu", what, n);
+    if (before) {
+        delta.mallocs = bench_alloc_count.mallocs - before->mallocs;
+        delta.reallocs = bench_alloc_count.reallocs - before->reallocs;
+        delta.frees = bench_alloc_count.frees - before->frees;
+    }
+    bench_report(label, n, bench_now_ns() - start, before ? &delta : NULL);
+}
+
+static void bench_strmap_size(const char *keys, const unsigned char *lens,
+                              size_t n)
+{
+    cuStrMap *map = cuStrMap_new(0);
+    bench_chain chain;
+    bench_allocs before;
+    size_t i, j, found = 0;
+    uint64_t start;
+
+    chain.mask = 15;
+    chain.size = 0;
+    chain.buckets = calloc(chain.mask + 1, sizeof *chain.buckets);
+    if (!map || !chain.buckets)
+        goto end;
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < n; i++)
+        bench_chain_put(&chain, keys + i * BENCH_STRMAP_KEY, lens[i], &found);
+    bench_report_phase("chained insert", n, start, &before);
+    start = bench_now_ns();
+    for (i = 0; i < n; i++) {
+        j = BENCH_STRMAP_AT(i, n);
+        found += *bench_chain_find(&chain, keys + j * BENCH_STRMAP_KEY,
+                                   lens[j]) != NULL;
+    }
+    bench_report_phase("chained lookup", n, start, NULL);
+    start = bench_now_ns();
+    for (i = 0; i < n; i++) {
+        j = BENCH_STRMAP_AT(i, n);
+        bench_chain_erase(&chain, keys + j * BENCH_STRMAP_KEY, lens[j]);
+    }
+    bench_report_phase("chained erase", n, start, NULL);
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < n; i++)
+        cuStrMap_put_array(map, keys + i * BENCH_STRMAP_KEY, lens[i], &found);
+    bench_report_phase("cuStrMap insert", n, start, &before);
+    start = bench_now_ns();
+    for (i = 0; i < n; i++) {
+        j = BENCH_STRMAP_AT(i, n);
+        found += cuStrMap_get_array(map, keys + j * BENCH_STRMAP_KEY,
+                                    lens[j]) != NULL;
+    }
+    bench_report_phase("cuStrMap lookup", n, start, NULL);
+    start = bench_now_ns();
+    for (i = 0; i < n; i++) {
+        j = BENCH_STRMAP_AT(i, n);
+        cuStrMap_erase_array(map, keys + j * BENCH_STRMAP_KEY, lens[j]);
+    }
+    bench_report_phase("cuStrMap erase", n, start, NULL);
+
+    if (found != 2 * n || chain.size != 0 || cuStrMap_size(map) != 0)
+        printf("unexpected: lookups missed\n");
+end:
+    free(chain.buckets);
+    cuStrMap_destroy(&map);
+}
+
+void bench_strmap(void)
+{
+    char *keys = malloc((size_t)BENCH_STRMAP_MAX * BENCH_STRMAP_KEY);
+    unsigned char *lens = malloc(BENCH_STRMAP_MAX);
+    size_t i, n;
+
+    if (!keys || !lens)
+        goto end;
+    /* Scatter the ids so that neighbouring keys do not share a prefix */
+    for (i = 0; i < BENCH_STRMAP_MAX; i++)
+        lens[i] = (unsigned char)snprintf(keys + i * BENCH_STRMAP_KEY,
+                                          BENCH_STRMAP_KEY, "key:%zx",
+                                          (i * 2654435761u) & 0xFFFFFFFFu);
+    for (n = 1000; n <= BENCH_STRMAP_MAX; n *= 10)
+        bench_strmap_size(keys, lens, n);
+end:
+    free(keys);
+    free(lens);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRMAP_H
+#define CU_INCLUDE_BENCH_STRMAP_H
+
+void bench_strmap(void);
+
+#endif /* CU_INCLUDE_BENCH_STRMAP_H */
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strmatch.h"
+#include "../cutil_strmatch.h"
+#include "../cutil_strsearch.h"
+#include "../cutil_simd.h"
+
+#define BENCH_MATCH_TEXT    ((size_t)1 << 20)
+#define BENCH_MATCH_TOTAL   ((size_t)64 << 20)      // bytes per run
+#define BENCH_MATCH_MAX     1024
+
+static const struct {
+    const char *name;
+    unsigned mask;
+} kernels[] = {
+    { "scalar", 0 },
+    { "ssse3", CU_CPU_SSE2 | CU_CPU_SSSE3 },
+    { "avx2", ~0U },
+};
+
+static const size_t counts[] = { 1, 8, 32, 64, 256, 1024 };
+
+static int bench_count_match(void *ctx, size_t id, size_t offset)
+{
+    (void)id;
+    (void)offset;
+    ++*(size_t *)ctx;
+    return 0;
+}
+
+/* Random words of 4 to 11 letters. The text is made of them, with one
+ * word in 64 taken from the pattern set.
+ */
+static void bench_word(char *w, size_t *len, unsigned *seed)
+{
+    size_t k;
+
+    *seed = *seed * 1103515245 + 12345;
+    *len = 4 + (*seed >> 16) % 8;
+    for (k = 0; k < *len; k++) {
+        *seed = *seed * 1103515245 + 12345;
+        w[k] = (char)('a' + (*seed >> 16) % 26);
+    }
+}
+
+void bench_strmatch(void)
+{
+    static char words[BENCH_MATCH_MAX][12];
+    const char *patterns[BENCH_MATCH_MAX];
+    size_t lengths[BENCH_MATCH_MAX], c, k, i, p, n, iterations, found;
+    char *text = malloc(BENCH_MATCH_TEXT + 16), label[64];
+    unsigned seed = 7;
+    uint64_t start;
+
+    if (!text)
+        return;
+    for (i = 0; i < BENCH_MATCH_MAX; i++) {
+        bench_word(words[i], &lengths[i], &seed);
+        patterns[i] = words[i];
+    }
+
+    for (c = 0; c < sizeof counts / sizeof counts[0]; c++) {
+        cuStrMatcher *m;
+
+        n = counts[c];
+        for (i = 0; i < BENCH_MATCH_TEXT;) {
+            char w[12];
+            size_t len;
+
+            seed = seed * 1103515245 + 12345;
+            if ((seed >> 16) % 64 == 0) {
+                p = (seed >> 8) % n;
+                memcpy(text + i, patterns[p], lengths[p]);
+                i += lengths[p];
+            } else {
+                bench_word(w, &len, &seed);
+                memcpy(text + i, w, len);
+                i += len;
+            }
+            text[i++] = ' ';
+        }
+
+        /* Baseline: one search per pattern, each over the whole text */
+        iterations = BENCH_MATCH_TOTAL / BENCH_MATCH_TEXT / n;
+        if (iterations == 0)
+            iterations = 1;
+        start = bench_now_ns();
+        found = 0;
+        for (i = 0; i < iterations; i++) {
+            for (p = 0; p < n; p++) {
+                const char *s = text, *end = text + BENCH_MATCH_TEXT, *hit;
+                while ((hit = cuMem_find(s, (size_t)(end - s), patterns[p], lengths[p])) != NULL) {
+                    found++;
+                    s = hit + 1;
+                }
+            }
+        }
+        snprintf(label, sizeof label, "%zu patterns, cuMem_find loop", n);
+        bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * BENCH_MATCH_TEXT);
+
+        if ((m = cuStrMatcher_new_arrays(patterns, lengths, n)) == NULL)
+            break;
+        iterations = BENCH_MATCH_TOTAL / BENCH_MATCH_TEXT / 4;
+        for (k = 0; k < sizeof kernels / sizeof kernels[0]; k++) {
+            cu_cpu_set_mask(kernels[k].mask);
+            start = bench_now_ns();
+            found = 0;
+            for (i = 0; i < iterations; i++)
+                cuStrMatcher_scan_array(m, text, BENCH_MATCH_TEXT, bench_count_match, &found);
+            snprintf(label, sizeof label, "%zu patterns, cuStrMatcher %s", n, kernels[k].name);
+            bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * BENCH_MATCH_TEXT);
+        }
+        cu_cpu_set_mask(~0U);
+        cuStrMatcher_destroy(&m);
+    }
+    free(text);
+}
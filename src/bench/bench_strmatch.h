@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRMATCH_H
+#define CU_INCLUDE_BENCH_STRMATCH_H
+
+void bench_strmatch(void);
+
+#endif /* CU_INCLUDE_BENCH_STRMATCH_H */
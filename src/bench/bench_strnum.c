@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "bench.h"
+#include "bench_strnum.h"
+#include "../cutil_strnum.h"
+
+#define BENCH_STRNUM_ITERATIONS 1000000
+
+static void bench_append_int(const char *name, int use_printf)
+{
+    uint64_t start, elapsed;
+    int64_t v = -5000000;
+    size_t i;
+    cuStr *cus = cuStr_new(-1);
+
+    if (!cus)
+        return;
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRNUM_ITERATIONS; i++) {
+        if ((i & 1023) == 0)
+            cuStr_clear(cus);
+        if (use_printf)
+            cuStr_printf_append(cus, "%" PRId64, v);
+        else
+            cuStr_append_i64(cus, v);
+        v += 7919;
+    }
+    elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_STRNUM_ITERATIONS, elapsed, NULL);
+
+    cuStr_destroy(&cus);
+}
+
+static void bench_append_dbl(const char *name, int use_printf)
+{
+    uint64_t start, elapsed;
+    double v = 0.1;
+    size_t i;
+    cuStr *cus = cuStr_new(-1);
+
+    if (!cus)
+        return;
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRNUM_ITERATIONS; i++) {
+        if ((i & 1023) == 0)
+            cuStr_clear(cus);
+        if (use_printf)
+            cuStr_printf_append(cus, "%.17g", v);
+        else
+            cuStr_append_double(cus, v);
+        v = v * 1.0001 + 0.37;
+    }
+    elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_STRNUM_ITERATIONS, elapsed, NULL);
+
+    cuStr_destroy(&cus);
+}
+
+static void bench_parse(const char *name, const char *text, int use_libc)
+{
+    uint64_t start, elapsed;
+    double sum = 0;
+    size_t i;
+    cuStr *cus = cuStr_new(-1);
+
+    if (!cus)
+        return;
+    cuStr_set(cus, text);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRNUM_ITERATIONS; i++) {
+        double d;
+        if (use_libc)
+            d = strtod(cuStr_cstr(cus), NULL);
+        else
+            cuStr_parse_double(cus, 0, &d);
+        sum += d;
+    }
+    elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_STRNUM_ITERATIONS, elapsed, NULL);
+    if (sum == 0)
+        printf("%s: unexpected sum\n", name);
+
+    cuStr_destroy(&cus);
+}
+
+void bench_strnum(void)
+{
+    bench_append_int("append int64, printf \"%\" PRId64", 1);
+    bench_append_int("append int64, cuStr_append_i64", 0);
+    bench_append_dbl("append double, printf \"%.17g\"", 1);
+    bench_append_dbl("append double, cuStr_append_double", 0);
+    bench_parse("parse double, strtod", "12345.6789", 1);
+    bench_parse("parse double, cuStr_parse_double", "12345.6789", 0);
+}
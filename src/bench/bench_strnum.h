@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRNUM_H
+#define CU_INCLUDE_BENCH_STRNUM_H
+
+void bench_strnum(void);
+
+#endif /* CU_INCLUDE_BENCH_STRNUM_H */
@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "bench.h"
+#include "bench_strpool.h"
+#include "../cutil_strpool.h"
+
+#define BENCH_STRPOOL_FIELDS    1000000     // strings in the workload
+#define BENCH_STRPOOL_NAMES     1000        // distinct names among them
+#define BENCH_STRPOOL_KEY       32
+
+typedef struct bench_strpool_worker {
+    pthread_t thread;
+    cuStrPool *pool;
+    const char *names;
+    const unsigned char *lens;
+    size_t first, count, interned;
+} bench_strpool_worker;
+
+static void bench_make_names(char *names, unsigned char *lens)
+{
+    size_t i;
+
+    for (i = 0; i < BENCH_STRPOOL_NAMES; i++)
+        lens[i] = (unsigned char)snprintf(names + i * BENCH_STRPOOL_KEY,
+                                          BENCH_STRPOOL_KEY,
+                                          i % 4 ? "x-field-%zu" : "x-long-header-field-%zu",
+                                          i);
+}
+
+/* The name used by the i-th string of the workload */
+#define BENCH_STRPOOL_NAME(i) (((i) * 7919) % BENCH_STRPOOL_NAMES)
+
+static void bench_copy_vs_intern(const char *names, const unsigned char *lens)
+{
+    cuStr **copies = malloc(BENCH_STRPOOL_FIELDS * sizeof *copies);
+    const cuStr **handles = malloc(BENCH_STRPOOL_FIELDS * sizeof *handles);
+    cuStrPool *pool = cuStrPool_new(0);
+    cuStr *name = cuStr_new(BENCH_STRPOOL_KEY);
+    bench_allocs before, delta;
+    size_t i, k, equal = 0;
+    uint64_t start;
+
+    if (!copies || !handles || !pool || !name)
+        goto end;
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRPOOL_FIELDS; i++) {
+        k = BENCH_STRPOOL_NAME(i);
+        cuStr_set_fromarray(name, names + k * BENCH_STRPOOL_KEY, lens[k]);
+        copies[i] = cuStr_copy(name);
+    }
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    bench_report("cuStr_copy per field", BENCH_STRPOOL_FIELDS,
+                 bench_now_ns() - start, &delta);
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRPOOL_FIELDS; i++) {
+        k = BENCH_STRPOOL_NAME(i);
+        cuStr_set_fromarray(name, names + k * BENCH_STRPOOL_KEY, lens[k]);
+        handles[i] = cuStrPool_intern(pool, name);
+    }
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    bench_report("cuStrPool_intern per field", BENCH_STRPOOL_FIELDS,
+                 bench_now_ns() - start, &delta);
+
+    /* Find every field with the same name as the first one */
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRPOOL_FIELDS; i++)
+        equal += cuStr_cmp(copies[i], copies[0]) == 0;
+    bench_report("cuStr_cmp on copies", BENCH_STRPOOL_FIELDS,
+                 bench_now_ns() - start, NULL);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRPOOL_FIELDS; i++)
+        equal += handles[i] == handles[0];
+    bench_report("pointer == on handles", BENCH_STRPOOL_FIELDS,
+                 bench_now_ns() - start, NULL);
+
+    if (equal != 2 * (BENCH_STRPOOL_FIELDS / BENCH_STRPOOL_NAMES))
+        printf("unexpected: %zu equal fields\n", equal);
+    for (i = 0; i < BENCH_STRPOOL_FIELDS; i++)
+        cuStr_destroy(&copies[i]);
+end:
+    free(copies);
+    free(handles);
+    cuStrPool_destroy(&pool);
+    cuStr_destroy(&name);
+}
+
+static void *bench_strpool_worker_run(void *arg)
+{
+    bench_strpool_worker *w = arg;
+    size_t i, k;
+
+    for (i = w->first; i < w->first + w->count; i++) {
+        k = BENCH_STRPOOL_NAME(i);
+        w->interned += cuStrPool_intern_array(w->pool,
+                                              w->names + k * BENCH_STRPOOL_KEY,
+                                              w->lens[k]) != NULL;
+    }
+    return NULL;
+}
+
+static void bench_intern_threads(const char *names, const unsigned char *lens,
+                                 size_t nthreads)
+{
+    bench_strpool_worker workers[8];
+    cuStrPool *pool = cuStrPool_new(CUSTRPOOL_THREADSAFE);
+    char label[64];
+    size_t t, started, interned = 0;
+    uint64_t start;
+
+    if (!pool)
+        return;
+    start = bench_now_ns();
+    for (started = 0; started < nthreads; started++) {
+        bench_strpool_worker *w = &workers[started];
+        w->pool = pool;
+        w->names = names;
+        w->lens = lens;
+        w->count = BENCH_STRPOOL_FIELDS / nthreads;
+        w->first = started * w->count;
+        w->interned = 0;
+        if (pthread_create(&w->thread, NULL, bench_strpool_worker_run, w) != 0)
+            break;
+    }
+    for (t = 0; t < started; t++) {
+        pthread_join(workers[t].thread, NULL);
+        interned += workers[t].interned;
+    }
+    snprintf(label, sizeof label, "cuStrPool_intern %zu threads", nthreads);
+    bench_report(label, interned, bench_now_ns() - start, NULL);
+    cuStrPool_destroy(&pool);
+}
+
+void bench_strpool(void)
+{
+    static char names[BENCH_STRPOOL_NAMES * BENCH_STRPOOL_KEY];
+    static unsigned char lens[BENCH_STRPOOL_NAMES];
+    size_t nthreads;
+
+    bench_make_names(names, lens);
+    bench_copy_vs_intern(names, lens);
+    for (nthreads = 1; nthreads <= 8; nthreads *= 2)
+        bench_intern_threads(names, lens, nthreads);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRPOOL_H
+#define CU_INCLUDE_BENCH_STRPOOL_H
+
+void bench_strpool(void);
+
+#endif /* CU_INCLUDE_BENCH_STRPOOL_H */
@@ -0,0 +1,108 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench.h"
+#include "bench_strreader.h"
+#include "../cutil_strreader.h"
+
+#define BENCH_STRREADER_BYTES   ((size_t)128 << 20)
+
+/* Baseline: getline() and a new cuStr for every line */
+static size_t bench_lines_getline(const char *path, size_t *bytes)
+{
+    FILE *f = fopen(path, "r");
+    char *line = NULL;
+    size_t cap = 0, lines = 0;
+    ssize_t n;
+
+    if (!f)
+        return 0;
+    while ((n = getline(&line, &cap, f)) > 0) {
+        cuStr *cus = cuStr_new(-1);
+        if (!cus)
+            break;
+        cuStr_set_fromarray(cus, line, (unsigned)(n - (line[n - 1] == '\n')));
+        *bytes += cuStr_len(cus);
+        lines++;
+        cuStr_destroy(&cus);
+    }
+    free(line);
+    fclose(f);
+    return lines;
+}
+
+static size_t bench_lines_reader(const char *path, size_t *bytes, int use_views)
+{
+    int fd = open(path, O_RDONLY);
+    cuStrReader *reader;
+    cuStr *cus = cuStr_new(-1);
+    cuStrView view;
+    size_t lines = 0;
+
+    if (fd < 0 || !cus || (reader = cuStrReader_new(fd, 0)) == NULL) {
+        if (fd >= 0)
+            close(fd);
+        cuStr_destroy(&cus);
+        return 0;
+    }
+    if (use_views) {
+        while (cuStrReader_next(reader, '\n', &view) == 1) {
+            *bytes += view.len;
+            lines++;
+        }
+    } else {
+        while (cuStrReader_read(reader, '\n', cus) == 1) {
+            *bytes += cuStr_len(cus);
+            lines++;
+        }
+    }
+    cuStrReader_destroy(&reader);
+    cuStr_destroy(&cus);
+    close(fd);
+    return lines;
+}
+
+void bench_strreader(void)
+{
+    static const char *const names[] = {
+        "128 MiB lines, getline + cuStr_new",
+        "128 MiB lines, cuStrReader_read",
+        "128 MiB lines, cuStrReader_next",
+    };
+    char path[] = "/tmp/cu_bench_strreader_XXXXXX", line[256];
+    size_t i, written = 0, lines = 0, n, bytes;
+    uint64_t start;
+    FILE *f;
+    int fd, k;
+
+    if ((fd = mkstemp(path)) < 0 || (f = fdopen(fd, "w")) == NULL)
+        return;
+    /* Lines of 20 to 200 bytes */
+    memset(line, 'x', sizeof line);
+    for (i = 0; written < BENCH_STRREADER_BYTES; i++, lines++) {
+        n = 20 + (i * 7919) % 181;
+        line[n] = '\n';
+        fwrite(line, 1, n + 1, f);
+        line[n] = 'x';
+        written += n + 1;
+    }
+    if (fclose(f) != 0) {
+        unlink(path);
+        return;
+    }
+
+    for (k = 0; k < 3; k++) {
+        bytes = 0;
+        start = bench_now_ns();
+        n = k == 0 ? bench_lines_getline(path, &bytes)
+                   : bench_lines_reader(path, &bytes, k == 2);
+        bench_report_bytes(names[k], n, bench_now_ns() - start, written);
+        if (n != lines || bytes != written - lines)
+            printf("unexpected: %zu lines, %zu bytes\n", n, bytes);
+    }
+    unlink(path);
+}
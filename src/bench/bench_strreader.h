@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRREADER_H
+#define CU_INCLUDE_BENCH_STRREADER_H
+
+void bench_strreader(void);
+
+#endif /* CU_INCLUDE_BENCH_STRREADER_H */
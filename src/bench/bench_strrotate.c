@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strrotate.h"
+#include "../cutil_strrotate.h"
+#include "../cutil_simd.h"
+
+#define BENCH_ROTATE_BYTES  ((size_t)32 << 20)
+
+static size_t bench_gcd(size_t a, size_t b)
+{
+    while (b) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Baseline: the juggling rotation that cuStr_rotate() used to do, which
+ * walks through the buffer shift bytes at a time
+ */
+static void bench_rotate_juggle(char *p, size_t n, size_t shift)
+{
+    size_t g = bench_gcd(n, shift), i;
+
+    for (i = 0; i < g; i++) {
+        char tmp = p[i];
+        size_t j = i;
+        for (;;) {
+            size_t k = j + shift;
+            if (k >= n)
+                k -= n;
+            if (k == i)
+                break;
+            p[j] = p[k];
+            j = k;
+        }
+        p[j] = tmp;
+    }
+}
+
+static void bench_rotate_case(char *buf, size_t n, size_t shift)
+{
+    static const struct {
+        const char *name;
+        unsigned mask;
+    } kernels[] = {
+        { "scalar", 0 },
+        { "sse2", CU_CPU_SSE2 },
+        { "ssse3", CU_CPU_SSE2 | CU_CPU_SSSE3 },
+        { "avx2", ~0U },
+    };
+    char label[64];
+    size_t i, k, iterations = BENCH_ROTATE_BYTES / n;
+    uint64_t start;
+
+    if (iterations == 0)
+        iterations = 1;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        bench_rotate_juggle(buf, n, shift);
+    snprintf(label, sizeof label, "juggle %zu by %zu", n, shift);
+    bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+
+    /* Below the scratch limit every kernel takes the memmove() path */
+    for (k = 0; k < sizeof kernels / sizeof kernels[0]; k++) {
+        if (k > 0 && (shift <= CUMEM_ROTATE_SCRATCH
+                      || n - shift <= CUMEM_ROTATE_SCRATCH))
+            break;
+        cu_cpu_set_mask(kernels[k].mask);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            cuMem_rotate(buf, n, shift);
+        snprintf(label, sizeof label, "cuMem_rotate %zu by %zu, %s", n, shift,
+                 shift <= CUMEM_ROTATE_SCRATCH || n - shift <= CUMEM_ROTATE_SCRATCH
+                 ? "scratch" : kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start,
+                           iterations * n);
+    }
+    cu_cpu_set_mask(~0U);
+}
+
+void bench_strrotate(void)
+{
+    static const size_t lengths[] = { 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+    char *buf = malloc(lengths[2]);
+    size_t i, k, n, shift;
+
+    if (!buf)
+        return;
+    for (i = 0; i < lengths[2]; i++)
+        buf[i] = (char)i;
+
+    for (k = 0; k < sizeof lengths / sizeof lengths[0]; k++) {
+        n = lengths[k];
+        /* Up to the scratch limit, just past it and on to a third of the
+         * length
+         */
+        for (shift = 1; shift < CUMEM_ROTATE_SCRATCH; shift *= 16)
+            bench_rotate_case(buf, n, shift);
+        bench_rotate_case(buf, n, CUMEM_ROTATE_SCRATCH);
+        bench_rotate_case(buf, n, CUMEM_ROTATE_SCRATCH + 1);
+        for (shift = CUMEM_ROTATE_SCRATCH * 8; shift < n / 3; shift *= 8)
+            bench_rotate_case(buf, n, shift);
+        bench_rotate_case(buf, n, n / 3);
+    }
+    free(buf);
+}
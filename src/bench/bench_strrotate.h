@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRROTATE_H
+#define CU_INCLUDE_BENCH_STRROTATE_H
+
+void bench_strrotate(void);
+
+#endif /* CU_INCLUDE_BENCH_STRROTATE_H */
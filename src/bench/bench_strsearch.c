@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strsearch.h"
+#include "../cutil_strsearch.h"
+#include "../cutil_simd.h"
+
+/* Each size is scanned repeatedly until about this many bytes have been
+ * searched
+ */
+#define BENCH_SEARCH_BYTES  ((size_t)256 << 20)
+
+static const struct {
+    const char *name;
+    unsigned mask;
+} bench_kernels[] = {
+    { "scalar/memchr", 0 },
+    { "sse2", CU_CPU_SSE2 },
+    { "avx2", ~0U },
+};
+
+/* The needle never occurs in the haystack, so each search is a full scan */
+static void bench_search_size(const char *hay, size_t n)
+{
+    static const char needle[] = "needle";
+    char label[64];
+    size_t k, i, iterations = BENCH_SEARCH_BYTES / n;
+    size_t found;
+    uint64_t start;
+
+    if (iterations == 0)
+        iterations = 1;
+
+    for (k = 0; k < sizeof bench_kernels / sizeof bench_kernels[0]; k++) {
+        cu_cpu_set_mask(bench_kernels[k].mask);
+
+        found = 0;
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            found += cuMem_find_byte(hay, n, 'z') != NULL;
+        snprintf(label, sizeof label, "find_byte %zuK, %s", n >> 10,
+                 bench_kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start,
+                           iterations * n);
+
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            found += cuMem_find(hay, n, needle, sizeof needle - 1) != NULL;
+        snprintf(label, sizeof label, "find %zuK, %s", n >> 10,
+                 bench_kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start,
+                           iterations * n);
+
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            found += cuMem_rfind(hay, n, needle, sizeof needle - 1) != NULL;
+        snprintf(label, sizeof label, "rfind %zuK, %s", n >> 10,
+                 bench_kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start,
+                           iterations * n);
+
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            found += cuMem_count_byte(hay, n, 'e');
+        snprintf(label, sizeof label, "count_byte %zuK, %s", n >> 10,
+                 bench_kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start,
+                           iterations * n);
+
+        if (found == 0)
+            printf("unexpected: no matches counted\n");
+    }
+    cu_cpu_set_mask(~0U);
+}
+
+void bench_strsearch(void)
+{
+    size_t n, i;
+    char *hay;
+
+    for (n = (size_t)1 << 10; n <= (size_t)1 << 30; n <<= 5) {
+        if ((hay = malloc(n)) == NULL) {
+            printf("search %zuK: skipped (out of memory)\n", n >> 10);
+            continue;
+        }
+        /* Text with lots of near misses for "needle" */
+        for (i = 0; i < n; i++)
+            hay[i] = "needlxneedl needlneedle"[i % 22];
+        bench_search_size(hay, n);
+        free(hay);
+    }
+}
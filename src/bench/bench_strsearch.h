@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRSEARCH_H
+#define CU_INCLUDE_BENCH_STRSEARCH_H
+
+void bench_strsearch(void);
+
+#endif /* CU_INCLUDE_BENCH_STRSEARCH_H */
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strutf8.h"
+#include "../cutil_strutf8.h"
+#include "../cutil_simd.h"
+
+#define BENCH_UTF8_BYTES    ((size_t)1 << 20)
+#define BENCH_UTF8_TOTAL    ((size_t)256 << 20)     // per kernel
+
+static const struct {
+    const char *name;
+    unsigned mask;
+} kernels[] = {
+    { "scalar", 0 },
+    { "sse2", CU_CPU_SSE2 },
+    { "ssse3", CU_CPU_SSE2 | CU_CPU_SSSE3 },
+    { "avx2", ~0U },
+};
+
+/* Corpora: words of each script separated by ASCII spaces and punctuation,
+ * as in real text
+ */
+static const struct {
+    const char *name;
+    const char *words[4];
+} corpora[] = {
+    { "ascii", { "the ", "quick brown ", "fox, ", "jumps. " } },
+    { "latin", { "caf\xc3\xa9 ", "na\xc3\xafve ", "stra\xc3\x9f" "e ", "the end. " } },
+    { "cyrillic", { "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 ",
+                    "\xd0\xbc\xd0\xb8\xd1\x80, ",
+                    "\xd0\xb4\xd0\xbe\xd0\xbc ", "\xd0\xb8 " } },
+    { "cjk", { "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", "\xe3\x81\xae",
+               "\xe6\x96\x87\xe7\xab\xa0\xe3\x80\x82", " " } },
+    { "emoji", { "ok \xf0\x9f\x98\x80 ", "\xf0\x9f\x91\x8d", " yes ",
+                 "\xf0\x9f\x8e\x89\xf0\x9f\x8e\x89 " } },
+};
+
+/* Baseline: the byte at a time check we used to run on every payload */
+static bool bench_utf8_validate_bytewise(const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    size_t i = 0, k, len;
+    unsigned long cp;
+
+    while (i < n) {
+        if (s[i] < 0x80) {
+            i++;
+            continue;
+        }
+        if (s[i] >= 0xC2 && s[i] <= 0xDF)
+            len = 2, cp = s[i] & 0x1F;
+        else if (s[i] >= 0xE0 && s[i] <= 0xEF)
+            len = 3, cp = s[i] & 0x0F;
+        else if (s[i] >= 0xF0 && s[i] <= 0xF4)
+            len = 4, cp = s[i] & 0x07;
+        else
+            return false;
+        if (n - i < len)
+            return false;
+        for (k = 1; k < len; k++) {
+            if ((s[i + k] & 0xC0) != 0x80)
+                return false;
+            cp = cp << 6 | (s[i + k] & 0x3F);
+        }
+        if ((len == 3 && cp < 0x800) || (len == 4 && cp < 0x10000)
+            || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+            return false;
+        i += len;
+    }
+    return true;
+}
+
+static size_t bench_make_corpus(char *p, size_t k)
+{
+    size_t n = 0, w = 0, len;
+
+    for (;;) {
+        const char *word = corpora[k].words[(w++ * 7) % 4];
+        len = strlen(word);
+        if (n + len > BENCH_UTF8_BYTES)
+            return n;
+        memcpy(p + n, word, len);
+        n += len;
+    }
+}
+
+static void bench_utf8_corpus(const char *name, const char *text, size_t n,
+                              uint16_t *u16, uint32_t *u32, char *back)
+{
+    char label[64];
+    size_t i, k, n16, n32, iterations = BENCH_UTF8_TOTAL / n;
+    uint64_t start;
+    size_t valid = 0;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations / 4; i++)
+        valid += bench_utf8_validate_bytewise(text, n);
+    snprintf(label, sizeof label, "validate %s, bytewise", name);
+    bench_report_bytes(label, iterations / 4, bench_now_ns() - start,
+                       iterations / 4 * n);
+
+    for (k = 0; k < sizeof kernels / sizeof kernels[0]; k++) {
+        cu_cpu_set_mask(kernels[k].mask);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            valid += cuMem_utf8_validate(text, n);
+        snprintf(label, sizeof label, "validate %s, %s", name, kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+    }
+    for (k = 0; k < sizeof kernels / sizeof kernels[0]; k += 3) {
+        cu_cpu_set_mask(kernels[k].mask);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            valid += cuMem_utf8_length(text, n) > 0;
+        snprintf(label, sizeof label, "length %s, %s", name, kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+    }
+    if (valid != iterations / 4 + 4 * iterations + 2 * iterations)
+        printf("unexpected: %s is not valid\n", name);
+
+    /* Transcoding, measured in bytes of UTF-8 */
+    iterations /= 4;
+    for (k = 0; k < sizeof kernels / sizeof kernels[0]; k += 3) {
+        cu_cpu_set_mask(kernels[k].mask);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            n16 = cuMem_utf8_to_utf16(u16, text, n);
+        snprintf(label, sizeof label, "utf8 to utf16 %s, %s", name, kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            cuMem_utf16_to_utf8(back, u16, n16);
+        snprintf(label, sizeof label, "utf16 to utf8 %s, %s", name, kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            n32 = cuMem_utf8_to_utf32(u32, text, n);
+        snprintf(label, sizeof label, "utf8 to utf32 %s, %s", name, kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+            cuMem_utf32_to_utf8(back, u32, n32);
+        snprintf(label, sizeof label, "utf32 to utf8 %s, %s", name, kernels[k].name);
+        bench_report_bytes(label, iterations, bench_now_ns() - start, iterations * n);
+    }
+    cu_cpu_set_mask(~0U);
+}
+
+void bench_strutf8(void)
+{
+    char *text = malloc(BENCH_UTF8_BYTES), *back = malloc(BENCH_UTF8_BYTES);
+    uint16_t *u16 = malloc(BENCH_UTF8_BYTES * sizeof *u16);
+    uint32_t *u32 = malloc(BENCH_UTF8_BYTES * sizeof *u32);
+    size_t k, n;
+
+    if (text && back && u16 && u32) {
+        for (k = 0; k < sizeof corpora / sizeof corpora[0]; k++) {
+            n = bench_make_corpus(text, k);
+            bench_utf8_corpus(corpora[k].name, text, n, u16, u32, back);
+        }
+    }
+    free(text);
+    free(back);
+    free(u16);
+    free(u32);
+}
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_strview.h"
+#include "../cutil_strview.h"
+
+#define BENCH_STRVIEW_LINES 200000
+#define BENCH_STRVIEW_FIELDS 12
+
+/* A log line with a dozen space separated fields */
+static const char bench_line[] =
+    "127.0.0.1 - [10/Oct/2000:13:55:36 -0700] GET /apache_pb.gif "
+    "HTTP/1.0 200 2326 http://www.example.com/start.html Mozilla/4.08 -";
+
+/* Baseline: every field copied into a string of its own */
+static void bench_split_copy(void)
+{
+    cuStr *fields[BENCH_STRVIEW_FIELDS];
+    bench_allocs before, delta;
+    size_t i, k, n, total = 0;
+    uint64_t start;
+
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRVIEW_LINES; i++) {
+        const char *p = bench_line, *sp;
+        for (n = 0; n < BENCH_STRVIEW_FIELDS; n++) {
+            sp = strchr(p, ' ');
+            if (!sp)
+                sp = p + strlen(p);
+            fields[n] = cuStr_new(-1);
+            cuStr_set_fromarray(fields[n], p, (unsigned)(sp - p));
+            total += cuStr_len(fields[n]);
+            if (*sp == '\0') {
+                n++;
+                break;
+            }
+            p = sp + 1;
+        }
+        for (k = 0; k < n; k++)
+            cuStr_destroy(&fields[k]);
+    }
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    bench_report("split line, cuStr per field", BENCH_STRVIEW_LINES,
+                 bench_now_ns() - start, &delta);
+    if (total != BENCH_STRVIEW_LINES * (sizeof bench_line - BENCH_STRVIEW_FIELDS))
+        printf("unexpected: %zu bytes in fields\n", total);
+}
+
+static void bench_split_view(void)
+{
+    cuStrView fields[BENCH_STRVIEW_FIELDS], line, field;
+    bench_allocs before, delta;
+    cuStrSplit it;
+    size_t i, n, total = 0;
+    uint64_t start;
+
+    line = cuStrView_make(bench_line, sizeof bench_line - 1);
+    before = bench_alloc_count;
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRVIEW_LINES; i++) {
+        cuStrSplit_init(&it, line, cuStrView_make(" ", 1));
+        for (n = 0; n < BENCH_STRVIEW_FIELDS && cuStrSplit_next(&it, &field); n++) {
+            fields[n] = field;
+            total += fields[n].len;
+        }
+    }
+    delta.mallocs = bench_alloc_count.mallocs - before.mallocs;
+    delta.reallocs = bench_alloc_count.reallocs - before.reallocs;
+    delta.frees = bench_alloc_count.frees - before.frees;
+    bench_report("split line, cuStrView per field", BENCH_STRVIEW_LINES,
+                 bench_now_ns() - start, &delta);
+    if (total != BENCH_STRVIEW_LINES * (sizeof bench_line - BENCH_STRVIEW_FIELDS))
+        printf("unexpected: %zu bytes in fields\n", total);
+}
+
+static void bench_tokenize_view(void)
+{
+    cuStrView line, token;
+    cuStrTok tok;
+    size_t i, n = 0;
+    uint64_t start;
+
+    line = cuStrView_make(bench_line, sizeof bench_line - 1);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRVIEW_LINES; i++) {
+        cuStrTok_init(&tok, line, " []", 3);
+        while (cuStrTok_next(&tok, &token))
+            n++;
+    }
+    bench_report("tokenize line, cuStrTok", BENCH_STRVIEW_LINES,
+                 bench_now_ns() - start, NULL);
+    if (n != BENCH_STRVIEW_LINES * BENCH_STRVIEW_FIELDS)
+        printf("unexpected: %zu tokens\n", n);
+}
+
+void bench_strview(void)
+{
+    bench_split_copy();
+    bench_split_view();
+    bench_tokenize_view();
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRVIEW_H
+#define CU_INCLUDE_BENCH_STRVIEW_H
+
+void bench_strview(void);
+
+#endif /* CU_INCLUDE_BENCH_STRVIEW_H */
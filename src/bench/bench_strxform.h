@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_BENCH_STRXFORM_H
+#define CU_INCLUDE_BENCH_STRXFORM_H
+
+void bench_strxform(void);
+
+#endif /* CU_INCLUDE_BENCH_STRXFORM_H */
@@ -0,0 +1,158 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_arena.h"
+
+struct cuArenaBlock {
+    cuArenaBlock *next;     // previously filled block
+    size_t size;            // usable bytes after the (aligned) header
+    size_t used;
+};
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#define cuArenaALIGN_UP(n) \
+    (((n) + (CUARENA_ALIGNMENT - 1)) & ~(size_t)(CUARENA_ALIGNMENT - 1))
+
+#define cuArenaBLOCK_DATA(b) \
+    ((char *)(b) + cuArenaALIGN_UP(sizeof (cuArenaBlock)))
+
+/* Pointer to the first free byte of the current block
+ */
+#define cuArenaTOP(b) (cuArenaBLOCK_DATA(b) + (b)->used)
+
+static cuArenaBlock *cuArena_add_block(cuArena *arena, size_t min_sz)
+{
+    cuArenaBlock *b;
+    size_t sz = arena->block_size > min_sz ? arena->block_size : min_sz;
+
+    b = malloc(cuArenaALIGN_UP(sizeof (cuArenaBlock)) + sz);
+    if (!b)
+        return NULL;
+    b->size = sz;
+    b->used = 0;
+    b->next = arena->head;
+    arena->head = b;
+    return b;
+}
+
+/* True if p (of size sz) is the most recent allocation in the current block,
+ * i.e. it can be resized or released in place
+ */
+static int cuArena_is_top(const cuArena *arena, const void *p, size_t sz)
+{
+    return arena->head && p
+           && (const char *)p + cuArenaALIGN_UP(sz) == cuArenaTOP(arena->head);
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuArena *cuArena_new(size_t block_size)
+{
+    cuArena *arena;
+
+    if ((arena = malloc(sizeof *arena)) != NULL) {
+        arena->head = NULL;
+        arena->block_size = block_size ? block_size
+                                       : CUARENA_DEFAULT_BLOCK_SIZE;
+    }
+    return arena;
+}
+
+void cuArena_destroy(cuArena **arena)
+{
+    assert(arena != NULL); // pre-condition
+
+    if (*arena) {
+        cuArenaBlock *b = (*arena)->head;
+        while (b) {
+            cuArenaBlock *next = b->next;
+            free(b);
+            b = next;
+        }
+        free(*arena);
+    }
+    *arena = NULL;
+}
+
+void cuArena_reset(cuArena *arena)
+{
+    cuArenaBlock *b;
+
+    assert(arena != NULL); // pre-condition
+
+    if (!arena->head)
+        return;
+
+    /* Keep the current block (the most recent, and so usually the largest)
+     * for reuse and give all the others back
+     */
+    b = arena->head->next;
+    while (b) {
+        cuArenaBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->head->next = NULL;
+    arena->head->used = 0;
+}
+
+void *cuArena_alloc(cuArena *arena, size_t sz)
+{
+    cuArenaBlock *b;
+    char *p;
+
+    assert(arena != NULL); // pre-condition
+
+    sz = cuArenaALIGN_UP(sz ? sz : 1);
+
+    b = arena->head;
+    if (!b || b->size - b->used < sz) {
+        if ((b = cuArena_add_block(arena, sz)) == NULL)
+            return NULL;
+    }
+    p = cuArenaTOP(b);
+    b->used += sz;
+    return p;
+}
+
+void *cuArena_realloc(cuArena *arena, void *p, size_t old_sz, size_t new_sz)
+{
+    void *new_p;
+
+    assert(arena != NULL); // pre-condition
+
+    if (!p)
+        return cuArena_alloc(arena, new_sz);
+
+    if (cuArena_is_top(arena, p, old_sz)) {
+        /* Last allocation: grow or shrink in place if the block has room */
+        cuArenaBlock *b = arena->head;
+        size_t offset = (char *)p - cuArenaBLOCK_DATA(b);
+        size_t sz = cuArenaALIGN_UP(new_sz ? new_sz : 1);
+
+        if (b->size - offset >= sz) {
+            b->used = offset + sz;
+            return p;
+        }
+    } else if (new_sz <= old_sz) {
+        return p;
+    }
+
+    if ((new_p = cuArena_alloc(arena, new_sz)) == NULL)
+        return NULL;
+    memcpy(new_p, p, old_sz < new_sz ? old_sz : new_sz);
+    return new_p;
+}
+
+void cuArena_free(cuArena *arena, void *p, size_t sz)
+{
+    assert(arena != NULL); // pre-condition
+
+    if (cuArena_is_top(arena, p, sz ? sz : 1))
+        arena->head->used = (char *)p - cuArenaBLOCK_DATA(arena->head);
+}
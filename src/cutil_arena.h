@@ -0,0 +1,33 @@
+#ifndef CU_INCLUDE_ARENA_H
+#define CU_INCLUDE_ARENA_H
+
+#include <stddef.h>
+
+/* A cuArena is a bump (region) allocator: allocations are carved out of
+ * large blocks and are all released together by cuArena_reset() or
+ * cuArena_destroy(). Only the most recent allocation can be grown, shrunk or
+ * freed in place; freeing anything else is a no-op until the next reset.
+ */
+
+#ifndef CUARENA_DEFAULT_BLOCK_SIZE
+#   define CUARENA_DEFAULT_BLOCK_SIZE  (64 * 1024)
+#endif
+#ifndef CUARENA_ALIGNMENT
+#   define CUARENA_ALIGNMENT           16
+#endif
+
+typedef struct cuArenaBlock cuArenaBlock;
+
+typedef struct cuArena {
+    cuArenaBlock *head;     // block currently being allocated from
+    size_t block_size;
+} cuArena;
+
+cuArena *cuArena_new(size_t block_size);
+void cuArena_destroy(cuArena **arena);
+void cuArena_reset(cuArena *arena);
+void *cuArena_alloc(cuArena *arena, size_t sz);
+void *cuArena_realloc(cuArena *arena, void *p, size_t old_sz, size_t new_sz);
+void cuArena_free(cuArena *arena, void *p, size_t sz);
+
+#endif /* CU_INCLUDE_ARENA_H */
@@ -1,39 +1,566 @@
+#include <assert.h>
 #include "cutil_math.h"
+#include "cutil_simd.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+/* Count trailing zeros; x must not be 0 */
+static unsigned cu_ctz32(uint32_t x)
+{
+#ifdef __GNUC__
+    return __builtin_ctz(x);
+#else
+    unsigned n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static unsigned cu_ctz64(uint64_t x)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(x);
+#else
+    return (uint32_t)x ? cu_ctz32((uint32_t)x) : 32 + cu_ctz32((uint32_t)(x >> 32));
+#endif
+}
+
+/* Binary GCD algorithm
+ * c.f. Knuth, TAOCP Vol. 2, 3rd Ed. (1998), p. 338
+ *
+ * All the trailing zeros are shifted out at once with CTZ rather than one
+ * bit per iteration. The zeros of the next u are counted from the
+ * difference, which has the same trailing zeros as its absolute value, so
+ * that the count does not wait on the min/abs step; setting the top bit
+ * keeps CTZ defined when the difference is 0 on the last iteration.
+ */
+static uint32_t cu_gcd32(uint32_t u, uint32_t v)
+{
+    unsigned shift, uz, vz;
+
+    if (u == 0) return v;
+    if (v == 0) return u;
+
+    uz = cu_ctz32(u);
+    vz = cu_ctz32(v);
+    shift = uz < vz ? uz : vz;
+    v >>= vz;
+    do {
+        uint32_t d, m;
+        u >>= uz;
+        d = u - v;
+        uz = cu_ctz32(d | 0x80000000u);
+        /* v = min(u, v), u = |u - v| without a branch, which would be
+         * mispredicted half of the time
+         */
+        m = 0 - (uint32_t)(u < v);
+        v += d & m;
+        u = (d ^ m) - m;
+    } while (u);
+
+    return v << shift;
+}
+
+static uint64_t cu_gcd64(uint64_t u, uint64_t v)
+{
+    unsigned shift, uz, vz;
+
+    if (u == 0) return v;
+    if (v == 0) return u;
+
+    uz = cu_ctz64(u);
+    vz = cu_ctz64(v);
+    shift = uz < vz ? uz : vz;
+    v >>= vz;
+    do {
+        uint64_t d, m;
+        u >>= uz;
+        d = u - v;
+        uz = cu_ctz64(d | 0x8000000000000000ULL);
+        /* v = min(u, v), u = |u - v| without a branch, which would be
+         * mispredicted half of the time
+         */
+        m = 0 - (uint64_t)(u < v);
+        v += d & m;
+        u = (d ^ m) - m;
+    } while (u);
+
+    return v << shift;
+}
+
+/* 64 x 64 -> 128 bit multiply; returns the low half and stores the high
+ * half in *hi
+ */
+static uint64_t cu_mul128(uint64_t a, uint64_t b, uint64_t *hi)
+{
+#ifdef __SIZEOF_INT128__
+    cu_uint128 r = (cu_uint128)a * b;
+    *hi = (uint64_t)(r >> 64);
+    return (uint64_t)r;
+#else
+    uint64_t ha = a >> 32, hb = b >> 32;
+    uint64_t la = (uint32_t)a, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), lo;
+
+    *hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl);
+    lo = t + (rm1 << 32);
+    *hi += lo < t;
+    return lo;
+#endif
+}
+
+#ifndef __SIZEOF_INT128__
+/* (a + b) mod m for a, b < m, without overflowing */
+static uint64_t cu_addmod(uint64_t a, uint64_t b, uint64_t m)
+{
+    return a >= m - b ? a - (m - b) : a + b;
+}
+#endif
+
+/* Montgomery reduction of the 128 bit hi:lo, which must be below n * 2^64.
+ * With q = lo * n^-1, q * n has the same low half as hi:lo, so the result
+ * is the difference of the high halves, corrected into range. This form
+ * works for every odd n, where the usual (t + q * n) / 2^64 can overflow
+ * for n >= 2^63.
+ */
+static uint64_t cuMontgomery_redc(const cuMontgomery *mont, uint64_t hi,
+                                  uint64_t lo)
+{
+    uint64_t q = lo * mont->n_inv, qn_hi;
+
+    cu_mul128(q, mont->n, &qn_hi);
+    return hi >= qn_hi ? hi - qn_hi : hi - qn_hi + mont->n;
+}
+
+/* n - 1 = d * 2^s with d odd, in Montgomery form throughout */
+static int cu_miller_rabin(const cuMontgomery *mont, uint64_t a, uint64_t d,
+                           unsigned s)
+{
+    uint64_t minus_one = mont->n - mont->one, x;
+
+    x = cuMontgomery_pow(mont, cuMontgomery_to(mont, a), d);
+    if (x == mont->one || x == minus_one)
+        return 1;
+    while (--s) {
+        x = cuMontgomery_mul(mont, x, x);
+        if (x == minus_one)
+            return 1;
+    }
+    return 0;
+}
+
+static unsigned cu_abs(int a)
+{
+    /* Negate in unsigned so that INT_MIN does not overflow */
+    return a < 0 ? 0U - (unsigned)a : (unsigned)a;
+}
+
+#ifdef CU_SIMD_X86
+
+/* Trailing zeros of each 64 bit lane. The lowest set bit is a power of 2,
+ * so converting it to float puts the count in the exponent; it lies in one
+ * of the two 32 bit halves and the other converts to 0. Lanes that are 0
+ * give a count too large for a shift, which vpsrlvq turns into 0.
+ */
+CU_TARGET_AVX2
+static __m256i cu_ctz64_avx2(__m256i x)
+{
+    const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i low = _mm256_and_si256(x, _mm256_sub_epi64(_mm256_setzero_si256(), x));
+    __m256i e = _mm256_castps_si256(_mm256_cvtepi32_ps(low));
+    __m256i e_lo, e_hi;
+
+    /* The sign bit is set for bit 31, so mask it off with the exponent */
+    e = _mm256_and_si256(_mm256_srli_epi32(e, 23), _mm256_set1_epi32(0xFF));
+    e_lo = _mm256_and_si256(e, lo32);
+    e_hi = _mm256_srli_epi64(e, 32);
+    e_hi = _mm256_add_epi64(e_hi, _mm256_andnot_si256(
+               _mm256_cmpeq_epi64(e_hi, _mm256_setzero_si256()),
+               _mm256_set1_epi64x(32)));
+    return _mm256_sub_epi64(_mm256_or_si256(e_lo, e_hi), _mm256_set1_epi64x(127));
+}
+
+/* The scalar algorithm on two vectors of four lanes at once; a single
+ * vector leaves the core waiting on the latency of each step. A lane is
+ * done once v is 0, and from then on the blends leave it alone.
+ */
+#define cuGCD_LANES 8
+
+CU_TARGET_AVX2
+static void cu_gcd64_avx2(__m256i *a, __m256i *b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i u[2], v[2], shift[2];
+    int k;
+
+    for (k = 0; k < 2; k++) {
+        __m256i any_zero = _mm256_or_si256(_mm256_cmpeq_epi64(a[k], zero),
+                                           _mm256_cmpeq_epi64(b[k], zero));
+        /* With a 0 argument the answer is a | b, so start from u = a | b
+         * and v = 0
+         */
+        u[k] = _mm256_or_si256(a[k], b[k]);
+        shift[k] = cu_ctz64_avx2(u[k]);
+        u[k] = _mm256_blendv_epi8(a[k], u[k], any_zero);
+        v[k] = _mm256_andnot_si256(any_zero, b[k]);
+        u[k] = _mm256_srlv_epi64(u[k], cu_ctz64_avx2(u[k]));
+    }
+
+    for (;;) {
+        __m256i done[2];
+
+        done[0] = _mm256_cmpeq_epi64(v[0], zero);
+        done[1] = _mm256_cmpeq_epi64(v[1], zero);
+        if (_mm256_movemask_epi8(_mm256_and_si256(done[0], done[1])) == -1)
+            break;
+        for (k = 0; k < 2; k++) {
+            __m256i u_gt_v, min, max;
+            v[k] = _mm256_srlv_epi64(v[k], cu_ctz64_avx2(v[k]));
+            /* No unsigned 64 bit compare in AVX2, so compare with the sign
+             * bits flipped
+             */
+            u_gt_v = _mm256_cmpgt_epi64(_mm256_xor_si256(u[k], bias),
+                                        _mm256_xor_si256(v[k], bias));
+            min = _mm256_blendv_epi8(u[k], v[k], u_gt_v);
+            max = _mm256_blendv_epi8(v[k], u[k], u_gt_v);
+            u[k] = _mm256_blendv_epi8(min, u[k], done[k]);
+            v[k] = _mm256_blendv_epi8(_mm256_sub_epi64(max, min), v[k], done[k]);
+        }
+    }
+    a[0] = _mm256_sllv_epi64(u[0], shift[0]);
+    a[1] = _mm256_sllv_epi64(u[1], shift[1]);
+}
+
+CU_TARGET_AVX2
+static void gcd_pairs_u64_avx2(const uint64_t *a, const uint64_t *b,
+                               uint64_t *out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + cuGCD_LANES <= n; i += cuGCD_LANES) {
+        __m256i va[2], vb[2];
+        va[0] = _mm256_loadu_si256((const __m256i *)(a + i));
+        va[1] = _mm256_loadu_si256((const __m256i *)(a + i + 4));
+        vb[0] = _mm256_loadu_si256((const __m256i *)(b + i));
+        vb[1] = _mm256_loadu_si256((const __m256i *)(b + i + 4));
+        cu_gcd64_avx2(va, vb);
+        _mm256_storeu_si256((__m256i *)(out + i), va[0]);
+        _mm256_storeu_si256((__m256i *)(out + i + 4), va[1]);
+    }
+    for (; i < n; i++)
+        out[i] = cu_gcd64(a[i], b[i]);
+}
+
+#endif /* CU_SIMD_X86 */
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
 
 unsigned gcd(int a, int b)
 {
-    /* Binary GCD algorithm
-     * c.f. Knuth, TAOCP Vol. 2, 3rd Ed. (1998), p. 338
+    return cu_gcd32(cu_abs(a), cu_abs(b));
+}
+
+uint64_t gcd_u64(uint64_t a, uint64_t b)
+{
+    return cu_gcd64(a, b);
+}
+
+#ifdef __SIZEOF_INT128__
+cu_uint128 gcd_u128(cu_uint128 u, cu_uint128 v)
+{
+    unsigned shift;
+
+    if (u == 0) return v;
+    if (v == 0) return u;
+
+    /* Once both fit in 64 bits, finish with the faster version */
+    shift = (uint64_t)(u | v) ? cu_ctz64((uint64_t)(u | v))
+                              : 64 + cu_ctz64((uint64_t)((u | v) >> 64));
+    u >>= shift;
+    v >>= shift;
+    while ((u | v) >> 64) {
+        cu_uint128 d;
+        if (u == 0 || v == 0)
+            return (u | v) << shift;
+        u >>= (uint64_t)u ? cu_ctz64((uint64_t)u) : 64 + cu_ctz64((uint64_t)(u >> 64));
+        v >>= (uint64_t)v ? cu_ctz64((uint64_t)v) : 64 + cu_ctz64((uint64_t)(v >> 64));
+        d = v - u;
+        if (v < u) {
+            u = v;
+            d = 0 - d;
+        }
+        v = d;
+    }
+    return (cu_uint128)cu_gcd64((uint64_t)u, (uint64_t)v) << shift;
+}
+#endif
+
+unsigned lcm(int a, int b)
+{
+    unsigned u = cu_abs(a), v = cu_abs(b);
+
+    if (u == 0 || v == 0)
+        return 0;
+    return u / cu_gcd32(u, v) * v;
+}
+
+uint64_t lcm_u64(uint64_t a, uint64_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return a / cu_gcd64(a, b) * b;
+}
+
+uint64_t gcd_array_u64(const uint64_t *v, size_t n)
+{
+    uint64_t g = 0;
+    size_t i;
+
+    assert(v != NULL || n == 0); // pre-condition
+
+    /* The running gcd soon gets small, and then one division brings each
+     * value below it so the binary GCD has only a few bits left to do.
+     * That beats any vector version, as there is no vector division.
+     * Stop early once it is 1, since it cannot get any smaller.
      */
-    unsigned shift, u, v;
+    for (i = 0; i < n && g != 1; i++)
+        g = cu_gcd64(g, g ? v[i] % g : v[i]);
+    return g;
+}
+
+void gcd_pairs_u64(const uint64_t *a, const uint64_t *b, uint64_t *out,
+                   size_t n)
+{
+    size_t i;
+
+    assert((a != NULL && b != NULL && out != NULL) || n == 0); // pre-condition
+
+#ifdef CU_SIMD_X86
+    if (cu_cpu_features() & CU_CPU_AVX2) {
+        gcd_pairs_u64_avx2(a, b, out, n);
+        return;
+    }
+#endif
+    for (i = 0; i < n; i++)
+        out[i] = cu_gcd64(a[i], b[i]);
+}
+
+int64_t gcd_ext_i64(int64_t a, int64_t b, int64_t *x, int64_t *y)
+{
+    int64_t x0 = 1, x1 = 0, y0 = 0, y1 = 1;
 
-    if (a == 0) return b;
-    if (b == 0) return a;
+    assert(x != NULL && y != NULL); // pre-condition
+    assert(a != INT64_MIN && b != INT64_MIN); // pre-condition
 
-    u = a < 0 ? -a : a;
-    v = b < 0 ? -b : b;
+    while (b != 0) {
+        int64_t q = a / b, t;
+        t = a - q * b; a = b; b = t;
+        t = x0 - q * x1; x0 = x1; x1 = t;
+        t = y0 - q * y1; y0 = y1; y1 = t;
+    }
+    if (a < 0) {
+        a = -a;
+        x0 = -x0;
+        y0 = -y0;
+    }
+    *x = x0;
+    *y = y0;
+    return a;
+}
 
-    /* Can also calculate shift using Intel CTZ (count trailing zeros)
-     * but keeping code portable...
+int modinv_u64(uint64_t a, uint64_t m, uint64_t *inv)
+{
+    /* Extended Euclid on magnitudes only. The coefficients alternate in
+     * sign, so r_i = (-1)^(i+1) * s_i * a (mod m), and none of them can be
+     * larger than m.
      */
-    for (shift = 0; ((u | v) & 1) == 0; shift++) {
-        u >>= 1;
-        v >>= 1;
+    uint64_t r0 = m, r1, s0 = 0, s1 = 1;
+    int odd = 1;
+
+    assert(inv != NULL); // pre-condition
+    assert(m > 1); // pre-condition
+
+    r1 = a % m;
+    while (r1 != 0) {
+        uint64_t q = r0 / r1, t;
+        t = r0 - q * r1; r0 = r1; r1 = t;
+        t = s0 + q * s1; s0 = s1; s1 = t;
+        odd = !odd;
     }
-    while (!(u & 1))    // While u is even, halve it
-        u >>= 1;
+    if (r0 != 1)
+        return -1;
+    /* r0 is r_(i-1) with the coefficient s0 */
+    *inv = odd ? m - s0 : s0;
+    return 0;
+}
 
-    do {
-        while ((v & 1) == 0)    // alternatively, could shift by CTZ
-            v >>= 1;
-        if (v < u) {
-            unsigned t = u;
-            u = v;
-            v = t;
+uint64_t mulmod_u64(uint64_t a, uint64_t b, uint64_t m)
+{
+    assert(m > 0); // pre-condition
+
+#ifdef __SIZEOF_INT128__
+    return (uint64_t)((cu_uint128)a * b % m);
+#else
+    {
+        uint64_t r = 0;
+        a %= m;
+        b %= m;
+        /* Double and add, one bit of b at a time */
+        while (b) {
+            if (b & 1)
+                r = cu_addmod(r, a, m);
+            a = cu_addmod(a, a, m);
+            b >>= 1;
         }
-        v -= u;
-    } while (v);
+        return r;
+    }
+#endif
+}
 
-    return u << shift;
+uint64_t modpow_u64(uint64_t base, uint64_t exp, uint64_t m)
+{
+    cuMontgomery mont;
+    uint64_t r;
+
+    assert(m > 0); // pre-condition
+
+    if (m == 1)
+        return 0;
+    if (cuMontgomery_init(&mont, m) == 0) {
+        return cuMontgomery_from(&mont,
+                                 cuMontgomery_pow(&mont, cuMontgomery_to(&mont, base), exp));
+    }
+
+    /* Montgomery form needs an odd modulus */
+    r = 1;
+    base %= m;
+    while (exp) {
+        if (exp & 1)
+            r = mulmod_u64(r, base, m);
+        base = mulmod_u64(base, base, m);
+        exp >>= 1;
+    }
+    return r;
+}
+
+int is_prime_u64(uint64_t n)
+{
+    /* These bases are enough for every n < 2^64 (Jim Sinclair, 2011) */
+    static const uint64_t bases[] = {
+        2, 325, 9375, 28178, 450775, 9780504, 1795265022
+    };
+    static const unsigned small[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    cuMontgomery mont;
+    uint64_t d;
+    unsigned i, s;
+
+    /* Trial division settles small n and most composites cheaply */
+    for (i = 0; i < sizeof small / sizeof small[0]; i++) {
+        if (n % small[i] == 0)
+            return n == small[i];
+    }
+    if (n < 37 * 37)
+        return n > 1;
+
+    cuMontgomery_init(&mont, n);
+    s = cu_ctz64(n - 1);
+    d = (n - 1) >> s;
+    for (i = 0; i < sizeof bases / sizeof bases[0]; i++) {
+        uint64_t a = bases[i] % n;
+        if (a != 0 && !cu_miller_rabin(&mont, a, d, s))
+            return 0;
+    }
+    return 1;
 }
 
+uint64_t next_prime_u64(uint64_t n)
+{
+    if (n <= 2)
+        return 2;
+    /* 2^64 - 59 is the largest prime below 2^64 */
+    if (n > 0xFFFFFFFFFFFFFFC5ULL)
+        return 0;
+    for (n |= 1; !is_prime_u64(n); n += 2)
+        ;
+    return n;
+}
+
+int cuMontgomery_init(cuMontgomery *mont, uint64_t n)
+{
+    uint64_t inv, r;
+    int i;
+
+    assert(mont != NULL); // pre-condition
+
+    if (n < 3 || (n & 1) == 0)
+        return -1;
+
+    /* Newton's iteration doubles the correct low bits each time, starting
+     * from 5 bits
+     */
+    inv = (3 * n) ^ 2;
+    for (i = 0; i < 4; i++)
+        inv *= 2 - n * inv;
+
+    /* 2^64 mod n, then its square for 2^128 mod n */
+    r = (0 - n) % n;
+    mont->one = r;
+#ifdef __SIZEOF_INT128__
+    r = (uint64_t)((cu_uint128)r * r % n);
+#else
+    for (i = 0; i < 64; i++)
+        r = cu_addmod(r, r, n);
+#endif
+
+    mont->n = n;
+    mont->n_inv = inv;
+    mont->r2 = r;
+    return 0;
+}
+
+uint64_t cuMontgomery_to(const cuMontgomery *mont, uint64_t a)
+{
+    assert(mont != NULL); // pre-condition
+    return cuMontgomery_mul(mont, a % mont->n, mont->r2);
+}
+
+uint64_t cuMontgomery_from(const cuMontgomery *mont, uint64_t a)
+{
+    assert(mont != NULL); // pre-condition
+    return cuMontgomery_redc(mont, 0, a);
+}
+
+uint64_t cuMontgomery_mul(const cuMontgomery *mont, uint64_t a, uint64_t b)
+{
+    uint64_t hi, lo;
+
+    assert(mont != NULL); // pre-condition
+
+    lo = cu_mul128(a, b, &hi);
+    return cuMontgomery_redc(mont, hi, lo);
+}
+
+uint64_t cuMontgomery_pow(const cuMontgomery *mont, uint64_t a, uint64_t exp)
+{
+    uint64_t r;
+
+    assert(mont != NULL); // pre-condition
+
+    r = mont->one;
+    while (exp) {
+        if (exp & 1)
+            r = cuMontgomery_mul(mont, r, a);
+        a = cuMontgomery_mul(mont, a, a);
+        exp >>= 1;
+    }
+    return r;
+}
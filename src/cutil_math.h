@@ -1,6 +1,69 @@
 #ifndef CU_INCLUDE_MATH_H
 #define CU_INCLUDE_MATH_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 cu_uint128;
+#endif
+
+/* Greatest common divisor. gcd(0, 0) is 0 and the sign of the arguments is
+ * ignored.
+ */
 unsigned gcd(int a, int b);
+uint64_t gcd_u64(uint64_t a, uint64_t b);
+#ifdef __SIZEOF_INT128__
+cu_uint128 gcd_u128(cu_uint128 a, cu_uint128 b);
+#endif
+
+/* Least common multiple, 0 if either argument is 0. The result must fit in
+ * the return type.
+ */
+unsigned lcm(int a, int b);
+uint64_t lcm_u64(uint64_t a, uint64_t b);
+
+/* The gcd of all n values, 0 for an empty array */
+uint64_t gcd_array_u64(const uint64_t *v, size_t n);
+/* out[i] = gcd(a[i], b[i]) for each i below n. out may be a or b. */
+void gcd_pairs_u64(const uint64_t *a, const uint64_t *b, uint64_t *out,
+                   size_t n);
+
+/* Extended Euclid: returns g = gcd(a, b) >= 0 and sets *x and *y so that
+ * a * x + b * y = g. a and b must not be INT64_MIN.
+ */
+int64_t gcd_ext_i64(int64_t a, int64_t b, int64_t *x, int64_t *y);
+/* Sets *inv to the inverse of a modulo m (m > 1); returns -1 if there is
+ * none, i.e. when gcd(a, m) != 1
+ */
+int modinv_u64(uint64_t a, uint64_t m, uint64_t *inv);
+
+/* a * b mod m and base^exp mod m for any m > 0 */
+uint64_t mulmod_u64(uint64_t a, uint64_t b, uint64_t m);
+uint64_t modpow_u64(uint64_t base, uint64_t exp, uint64_t m);
+
+/* Deterministic Miller-Rabin, exact for every 64 bit n */
+int is_prime_u64(uint64_t n);
+/* The smallest prime >= n, or 0 if there is none below 2^64 */
+uint64_t next_prime_u64(uint64_t n);
+
+/* Montgomery form for repeated multiplication modulo a fixed odd n > 1:
+ * a multiplication costs three 64x64 bit multiplies instead of a 128 bit
+ * division. Values are converted in with cuMontgomery_to() and out with
+ * cuMontgomery_from(); in between, mul and pow take and return Montgomery
+ * form values, which are always below n.
+ */
+typedef struct cuMontgomery {
+    uint64_t n;
+    uint64_t n_inv;     // n^-1 mod 2^64
+    uint64_t r2;        // 2^128 mod n
+    uint64_t one;       // 1 in Montgomery form, 2^64 mod n
+} cuMontgomery;
+
+int cuMontgomery_init(cuMontgomery *mont, uint64_t n);
+uint64_t cuMontgomery_to(const cuMontgomery *mont, uint64_t a);
+uint64_t cuMontgomery_from(const cuMontgomery *mont, uint64_t a);
+uint64_t cuMontgomery_mul(const cuMontgomery *mont, uint64_t a, uint64_t b);
+uint64_t cuMontgomery_pow(const cuMontgomery *mont, uint64_t a, uint64_t exp);
 
 #endif /* CU_INCLUDE_MATH_H */
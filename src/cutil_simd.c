@@ -0,0 +1,34 @@
+#include "cutil_simd.h"
+
+/* Set once detection has run so that zero can mean "not detected yet" */
+#define CU_CPU_DETECTED (1U << 31)
+
+static unsigned cu_cpu_detected;
+static unsigned cu_cpu_mask = ~0U;
+
+unsigned cu_cpu_features(void)
+{
+    /* Detection is idempotent, so racing threads just store the same
+     * value
+     */
+    if (!cu_cpu_detected) {
+        unsigned features = CU_CPU_DETECTED;
+#ifdef CU_SIMD_X86
+        __builtin_cpu_init();
+        features |= CU_CPU_SSE2;
+        if (__builtin_cpu_supports("ssse3"))
+            features |= CU_CPU_SSSE3;
+        if (__builtin_cpu_supports("sse4.2"))
+            features |= CU_CPU_SSE42;
+        if (__builtin_cpu_supports("avx2"))
+            features |= CU_CPU_AVX2;
+#endif
+        cu_cpu_detected = features;
+    }
+    return cu_cpu_detected & cu_cpu_mask & ~CU_CPU_DETECTED;
+}
+
+void cu_cpu_set_mask(unsigned mask)
+{
+    cu_cpu_mask = mask;
+}
@@ -0,0 +1,30 @@
+#ifndef CU_INCLUDE_SIMD_H
+#define CU_INCLUDE_SIMD_H
+
+/* SIMD kernels are built for x86 with GCC or Clang. SSE2 is the baseline
+ * there; kernels for later extensions are compiled with a target attribute
+ * and only called when cu_cpu_features() reports them. Other platforms use
+ * the scalar code.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) \
+    && defined(__SSE2__)
+#   define CU_SIMD_X86 1
+#   include <immintrin.h>
+#   define CU_TARGET_SSSE3  __attribute__((target("ssse3")))
+#   define CU_TARGET_SSE42  __attribute__((target("sse4.2")))
+#   define CU_TARGET_AVX2   __attribute__((target("avx2")))
+#endif
+
+#define CU_CPU_SSE2     (1U << 0)
+#define CU_CPU_SSSE3    (1U << 1)
+#define CU_CPU_SSE42    (1U << 2)
+#define CU_CPU_AVX2     (1U << 3)
+
+unsigned cu_cpu_features(void);
+
+/* Restrict the features that kernels may use, e.g. to test or benchmark
+ * the fallbacks. ~0U allows everything the CPU supports.
+ */
+void cu_cpu_set_mask(unsigned mask);
+
+#endif /* CU_INCLUDE_SIMD_H */
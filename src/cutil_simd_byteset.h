@@ -0,0 +1,59 @@
+#ifndef CU_INCLUDE_SIMD_BYTESET_H
+#define CU_INCLUDE_SIMD_BYTESET_H
+
+#include "cutil_simd.h"
+
+/* Private to the library: a set of bytes as a bitmap of 256 bits in 32
+ * rows of 8. Byte c is in the set if bit c >> 4 & 7 of row (c & 15) is
+ * set, in the first 16 rows for c below 0x80 and in the second 16
+ * otherwise, so that each half of the rows is one 16 byte lookup.
+ */
+
+#ifdef CU_SIMD_X86
+
+/* 0xFF for the bytes of v not in the set, 0 for those in it */
+CU_TARGET_SSSE3
+static inline __m128i cu_byteset_absent_ssse3(__m128i v, __m128i rows_low,
+                                              __m128i rows_high)
+{
+    const __m128i index = _mm_set1_epi8((char)0x8F);
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i high = _mm_xor_si128(v, _mm_set1_epi8((char)0x80));
+    const __m128i nibble = _mm_and_si128(_mm_srli_epi16(v, 4),
+                                         _mm_set1_epi8(0x0F));
+    __m128i row, bit;
+
+    row = _mm_or_si128(_mm_shuffle_epi8(rows_low, _mm_and_si128(v, index)),
+                       _mm_shuffle_epi8(rows_high,
+                                        _mm_and_si128(high, index)));
+    bit = _mm_shuffle_epi8(bits, nibble);
+    return _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128());
+}
+
+/* The same with the rows in both 128-bit lanes */
+CU_TARGET_AVX2
+static inline __m256i cu_byteset_absent_avx2(__m256i v, __m256i rows_low,
+                                             __m256i rows_high)
+{
+    const __m256i index = _mm256_set1_epi8((char)0x8F);
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i high = _mm256_xor_si256(v, _mm256_set1_epi8((char)0x80));
+    const __m256i nibble = _mm256_and_si256(_mm256_srli_epi16(v, 4),
+                                            _mm256_set1_epi8(0x0F));
+    __m256i row, bit;
+
+    row = _mm256_or_si256(
+        _mm256_shuffle_epi8(rows_low, _mm256_and_si256(v, index)),
+        _mm256_shuffle_epi8(rows_high, _mm256_and_si256(high, index)));
+    bit = _mm256_shuffle_epi8(bits, nibble);
+    row = _mm256_and_si256(row, bit);
+    return _mm256_cmpeq_epi8(row, _mm256_setzero_si256());
+}
+
+#endif /* CU_SIMD_X86 */
+
+#endif /* CU_INCLUDE_SIMD_BYTESET_H */
@@ -0,0 +1,235 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include "cutil_strcache.h"
+#include "cutil_string.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#   define cuStrCacheTHREAD _Thread_local
+#else
+#   define cuStrCacheTHREAD __thread
+#endif
+
+/* List 0 holds headers, the others blocks of 32, 64, ...
+ * CUSTR_CACHE_MAX_SIZE bytes
+ */
+#define cuStrCacheMIN_SHIFT 5
+#define cuStrCacheMIN_SIZE  ((size_t)1 << cuStrCacheMIN_SHIFT)
+#define cuStrCacheLISTS     20
+
+#if CUSTR_CACHE_MAX_SIZE > (1L << (cuStrCacheLISTS + cuStrCacheMIN_SHIFT - 2))
+#   error "CUSTR_CACHE_MAX_SIZE is too large"
+#endif
+
+/* Free blocks are linked through their first word */
+typedef struct cuStrCacheList {
+    void *head;
+    size_t count;
+} cuStrCacheList;
+
+typedef struct cuStrCacheThread {
+    cuStrCacheList lists[cuStrCacheLISTS];
+    int state;              // 0 new, 1 registered, -1 exiting
+} cuStrCacheThread;
+
+static cuStrCacheTHREAD cuStrCacheThread cuStrCache_self;
+
+static pthread_mutex_t cuStrCache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t cuStrCache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t cuStrCache_key;
+static cuStrCacheList cuStrCache_depot[cuStrCacheLISTS];
+
+#ifdef CUSTR_CACHE
+static int cuStrCache_on = 1;
+#else
+static int cuStrCache_on = 0;
+#endif
+
+static unsigned cuStrCache_log2(size_t sz)
+{
+    unsigned n = 0;
+    while (sz >>= 1)
+        n++;
+    return n;
+}
+
+/* The list for blocks of exactly sz bytes, or -1 if they aren't cached */
+static int cuStrCache_list(size_t sz)
+{
+    if (sz == sizeof(cuStr))
+        return 0;
+    if (sz < cuStrCacheMIN_SIZE || sz > CUSTR_CACHE_MAX_SIZE || (sz & (sz - 1)))
+        return -1;
+    return (int)(cuStrCache_log2(sz) - cuStrCacheMIN_SHIFT) + 1;
+}
+
+static void *cuStrCache_pop(cuStrCacheList *list)
+{
+    void *p = list->head;
+
+    list->head = *(void **)p;
+    list->count--;
+    return p;
+}
+
+static void cuStrCache_push(cuStrCacheList *list, void *p)
+{
+    *(void **)p = list->head;
+    list->head = p;
+    list->count++;
+}
+
+/* Move up to n blocks from one list to the other, freeing those that the
+ * destination has no room for
+ */
+static void cuStrCache_move(cuStrCacheList *to, cuStrCacheList *from, size_t n,
+                            size_t limit)
+{
+    while (n-- && from->head) {
+        void *p = cuStrCache_pop(from);
+        if (to->count < limit)
+            cuStrCache_push(to, p);
+        else
+            free(p);
+    }
+}
+
+/* Runs when a thread that used the cache exits */
+static void cuStr_cache_thread_exit(void *arg)
+{
+    cuStrCacheThread *t = arg;
+    size_t i;
+
+    pthread_mutex_lock(&cuStrCache_lock);
+    for (i = 0; i < cuStrCacheLISTS; i++)
+        cuStrCache_move(&cuStrCache_depot[i], &t->lists[i], t->lists[i].count,
+                        CUSTR_CACHE_DEPOT_BLOCKS);
+    pthread_mutex_unlock(&cuStrCache_lock);
+    /* Blocks freed by later destructors go straight to free() */
+    t->state = -1;
+}
+
+static void cuStr_cache_init(void)
+{
+    pthread_key_create(&cuStrCache_key, cuStr_cache_thread_exit);
+}
+
+static void cuStr_cache_register(cuStrCacheThread *t)
+{
+    pthread_once(&cuStrCache_once, cuStr_cache_init);
+    pthread_setspecific(cuStrCache_key, t);
+    t->state = 1;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+void cuStr_cache_enable(bool enable)
+{
+    __atomic_store_n(&cuStrCache_on, enable, __ATOMIC_RELAXED);
+}
+
+bool cuStr_cache_enabled(void)
+{
+    return __atomic_load_n(&cuStrCache_on, __ATOMIC_RELAXED);
+}
+
+void cuStr_cache_trim(void)
+{
+    size_t i;
+
+    for (i = 0; i < cuStrCacheLISTS; i++) {
+        while (cuStrCache_self.lists[i].head)
+            free(cuStrCache_pop(&cuStrCache_self.lists[i]));
+    }
+    pthread_mutex_lock(&cuStrCache_lock);
+    for (i = 0; i < cuStrCacheLISTS; i++) {
+        while (cuStrCache_depot[i].head)
+            free(cuStrCache_pop(&cuStrCache_depot[i]));
+    }
+    pthread_mutex_unlock(&cuStrCache_lock);
+}
+
+size_t cuStr_cache_size(size_t sz)
+{
+    size_t class_sz = cuStrCacheMIN_SIZE;
+
+    if (!cuStr_cache_enabled() || sz > CUSTR_CACHE_MAX_SIZE)
+        return sz;
+    while (class_sz < sz)
+        class_sz <<= 1;
+    return class_sz;
+}
+
+bool cuStr_cache_holds(size_t sz)
+{
+    return cuStrCache_list(sz) >= 0;
+}
+
+void *cuStr_cache_alloc(size_t sz)
+{
+    cuStrCacheList *list;
+    int i;
+
+    if (!cuStr_cache_enabled() || (i = cuStrCache_list(sz)) < 0
+        || cuStrCache_self.state < 0)
+        return malloc(sz);
+
+    /* Refill from the depot, half a cache at a time */
+    list = &cuStrCache_self.lists[i];
+    if (!list->head) {
+        if (cuStrCache_self.state == 0)
+            cuStr_cache_register(&cuStrCache_self);
+        pthread_mutex_lock(&cuStrCache_lock);
+        cuStrCache_move(list, &cuStrCache_depot[i], CUSTR_CACHE_BLOCKS / 2,
+                        CUSTR_CACHE_BLOCKS);
+        pthread_mutex_unlock(&cuStrCache_lock);
+        if (!list->head)
+            return malloc(sz);
+    }
+    return cuStrCache_pop(list);
+}
+
+void cuStr_cache_free(void *p, size_t sz)
+{
+    cuStrCacheList *list;
+    int i;
+
+    if (!p)
+        return;
+    if (!cuStr_cache_enabled() || (i = cuStrCache_list(sz)) < 0
+        || cuStrCache_self.state < 0) {
+        free(p);
+        return;
+    }
+    if (cuStrCache_self.state == 0)
+        cuStr_cache_register(&cuStrCache_self);
+
+    /* Full: pass the older half on to the depot */
+    list = &cuStrCache_self.lists[i];
+    if (list->count >= CUSTR_CACHE_BLOCKS) {
+        cuStrCacheList older;
+        void **last = list->head;
+        size_t n;
+
+        for (n = 1; n < CUSTR_CACHE_BLOCKS / 2; n++)
+            last = *last;
+        older.head = *last;
+        older.count = list->count - n;
+        *last = NULL;
+        list->count = n;
+
+        pthread_mutex_lock(&cuStrCache_lock);
+        cuStrCache_move(&cuStrCache_depot[i], &older, older.count,
+                        CUSTR_CACHE_DEPOT_BLOCKS);
+        pthread_mutex_unlock(&cuStrCache_lock);
+    }
+    cuStrCache_push(list, p);
+}
@@ -0,0 +1,54 @@
+#ifndef CU_INCLUDE_STRCACHE_H
+#define CU_INCLUDE_STRCACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* An optional cache for the memory of heap strings (those without an
+ * arena). Buffers are rounded up to a power-of-2 size class and, with
+ * cuStr headers, kept on per-thread free lists when released, so that
+ * short-lived strings stop going to malloc() and free(). A thread keeps at
+ * most CUSTR_CACHE_BLOCKS blocks of each class and passes the rest, and
+ * all of them when it exits, to a depot shared by all threads.
+ *
+ * The cache starts enabled when the library is built with CUSTR_CACHE
+ * defined, and disabled otherwise.
+ */
+
+/* Buffers of up to this many bytes, '\0' included, are cached */
+#ifndef CUSTR_CACHE_MAX_SIZE
+#   define CUSTR_CACHE_MAX_SIZE     16384
+#endif
+
+/* Blocks of each class a thread keeps */
+#ifndef CUSTR_CACHE_BLOCKS
+#   define CUSTR_CACHE_BLOCKS       64
+#endif
+
+/* Blocks of each class the depot keeps; more are freed */
+#ifndef CUSTR_CACHE_DEPOT_BLOCKS
+#   define CUSTR_CACHE_DEPOT_BLOCKS 1024
+#endif
+
+/* Switch the cache on or off. Strings can be created with it in one state
+ * and destroyed in the other, but switching while other threads use
+ * strings is not safe.
+ */
+void cuStr_cache_enable(bool enable);
+bool cuStr_cache_enabled(void);
+/* Free what the calling thread and the depot hold */
+void cuStr_cache_trim(void);
+
+/* Called by the string functions for heap memory. cuStr_cache_size() is the
+ * size to allocate for a block of at least sz bytes; cuStr_cache_free()
+ * must get the size the block was allocated with.
+ */
+size_t cuStr_cache_size(size_t sz);
+/* Whether blocks of exactly sz bytes go to the cache when it is on; others
+ * are plain malloc() blocks, which can be realloc()'ed
+ */
+bool cuStr_cache_holds(size_t sz);
+void *cuStr_cache_alloc(size_t sz);
+void cuStr_cache_free(void *p, size_t sz);
+
+#endif /* CU_INCLUDE_STRCACHE_H */
@@ -0,0 +1,186 @@
+#define _XOPEN_SOURCE 700   // IOV_MAX
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/uio.h>
+#include "cutil_strchain.h"
+
+#ifndef IOV_MAX
+#   define IOV_MAX 1024
+#endif
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+/* Copies are carved out of pieces of at least this size */
+#define cuStrChainCOPY_BLOCK 1024
+
+static int cuStrChain_push(cuStrChain *chain, const char *ptr, size_t len)
+{
+    if (chain->count == chain->capacity) {
+        size_t capacity = chain->capacity ? chain->capacity * 2 : 16;
+        cuStrChainSegment *segments = realloc(chain->segments,
+                                              capacity * sizeof *segments);
+        if (!segments)
+            return -1;
+        chain->segments = segments;
+        chain->capacity = capacity;
+    }
+    chain->segments[chain->count].ptr = ptr;
+    chain->segments[chain->count].len = len;
+    chain->count++;
+    chain->pending += len;
+    return 0;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStrChain *cuStrChain_new(void)
+{
+    cuStrChain *chain;
+
+    if ((chain = malloc(sizeof *chain)) == NULL)
+        return NULL;
+    if ((chain->arena = cuArena_new(0)) == NULL) {
+        free(chain);
+        return NULL;
+    }
+    chain->segments = NULL;
+    chain->capacity = 0;
+    chain->count = chain->next = chain->next_off = chain->pending = 0;
+    chain->inline_end = NULL;
+    chain->inline_left = 0;
+    return chain;
+}
+
+void cuStrChain_destroy(cuStrChain **chain)
+{
+    assert(chain != NULL); // pre-condition
+
+    if (*chain) {
+        cuArena_destroy(&(*chain)->arena);
+        free((*chain)->segments);
+        free(*chain);
+    }
+    *chain = NULL;
+}
+
+void cuStrChain_clear(cuStrChain *chain)
+{
+    assert(chain != NULL); // pre-condition
+
+    cuArena_reset(chain->arena);
+    chain->count = chain->next = chain->next_off = chain->pending = 0;
+    chain->inline_end = NULL;
+    chain->inline_left = 0;
+}
+
+size_t cuStrChain_len(const cuStrChain *chain)
+{
+    assert(chain != NULL); // pre-condition
+    return chain->pending;
+}
+
+int cuStrChain_add(cuStrChain *chain, const cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+
+    return cuStrChain_add_array(chain, cuStr_cstr(cus), cuStr_len(cus));
+}
+
+int cuStrChain_add_array(cuStrChain *chain, const char *arr, size_t len)
+{
+    assert(chain != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if (len == 0)
+        return 0;
+    if (len <= CUSTRCHAIN_INLINE)
+        return cuStrChain_copy_array(chain, arr, len);
+    return cuStrChain_push(chain, arr, len);
+}
+
+int cuStrChain_add_view(cuStrChain *chain, cuStrView v)
+{
+    return cuStrChain_add_array(chain, v.ptr, v.len);
+}
+
+int cuStrChain_copy_array(cuStrChain *chain, const char *arr, size_t len)
+{
+    cuStrChainSegment *last;
+    char *copy;
+
+    assert(chain != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if (len == 0)
+        return 0;
+    if (len > chain->inline_left) {
+        size_t sz = len > cuStrChainCOPY_BLOCK ? len : cuStrChainCOPY_BLOCK;
+        if ((copy = cuArena_alloc(chain->arena, sz)) == NULL)
+            return -1;
+        chain->inline_end = copy;
+        chain->inline_left = sz;
+    }
+    copy = chain->inline_end;
+    memcpy(copy, arr, len);
+    chain->inline_end += len;
+    chain->inline_left -= len;
+
+    /* Right after the previous copy: make that segment longer */
+    last = chain->count > chain->next ? &chain->segments[chain->count - 1] : NULL;
+    if (last && last->ptr + last->len == copy) {
+        last->len += len;
+        chain->pending += len;
+        return 0;
+    }
+    return cuStrChain_push(chain, copy, len);
+}
+
+int cuStrChain_write(cuStrChain *chain, int fd)
+{
+    struct iovec iov[IOV_MAX < 1024 ? IOV_MAX : 1024];
+    size_t i, n;
+    ssize_t written;
+
+    assert(chain != NULL); // pre-condition
+
+    while (chain->next < chain->count) {
+        /* The first segment may have been written in part */
+        for (i = chain->next, n = 0;
+             i < chain->count && n < sizeof iov / sizeof iov[0]; i++, n++) {
+            iov[n].iov_base = (void *)chain->segments[i].ptr;
+            iov[n].iov_len = chain->segments[i].len;
+        }
+        iov[0].iov_base = (char *)iov[0].iov_base + chain->next_off;
+        iov[0].iov_len -= chain->next_off;
+
+        written = writev(fd, iov, (int)n);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 1;
+            return -1;
+        }
+
+        /* Skip the segments that went out in full */
+        chain->pending -= (size_t)written;
+        written += (ssize_t)chain->next_off;
+        while (chain->next < chain->count
+               && (size_t)written >= chain->segments[chain->next].len) {
+            written -= (ssize_t)chain->segments[chain->next].len;
+            chain->next++;
+        }
+        chain->next_off = (size_t)written;
+    }
+    /* Everything written: start over, keeping the memory */
+    cuStrChain_clear(chain);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef CU_INCLUDE_STRCHAIN_H
+#define CU_INCLUDE_STRCHAIN_H
+
+#include <stddef.h>
+#include "cutil_string.h"
+#include "cutil_strview.h"
+#include "cutil_arena.h"
+
+/* Segments of up to this many bytes are copied into the chain rather than
+ * referenced, and runs of them are merged into one segment
+ */
+#ifndef CUSTRCHAIN_INLINE
+#   define CUSTRCHAIN_INLINE   64
+#endif
+
+typedef struct cuStrChainSegment {
+    const char *ptr;
+    size_t len;
+} cuStrChainSegment;
+
+/* Builds output from references to existing buffers, to be written with
+ * writev() without first copying everything into one string. Referenced
+ * memory (a cuStr's contents, say) must not change or be freed until it
+ * has been written or the chain is cleared.
+ */
+typedef struct cuStrChain {
+    cuStrChainSegment *segments;
+    size_t count, capacity;
+    size_t next;            // first segment not completely written
+    size_t next_off;        // bytes of it already written
+    size_t pending;         // bytes not yet written
+    cuArena *arena;         // copies of short segments
+    char *inline_end;       // end of the last copy, to merge the next one
+    size_t inline_left;     // room after inline_end in its allocation
+} cuStrChain;
+
+cuStrChain *cuStrChain_new(void);
+void cuStrChain_destroy(cuStrChain **chain);
+/* Forget all segments, written or not, and free the copies */
+void cuStrChain_clear(cuStrChain *chain);
+/* Bytes added but not yet written */
+size_t cuStrChain_len(const cuStrChain *chain);
+
+/* Add a reference to the bytes, or a copy if they are short. These
+ * return 0, or -1 if out of memory.
+ */
+int cuStrChain_add(cuStrChain *chain, const cuStr *cus);
+int cuStrChain_add_array(cuStrChain *chain, const char *arr, size_t len);
+int cuStrChain_add_view(cuStrChain *chain, cuStrView v);
+/* Always add a copy, e.g. of a temporary */
+int cuStrChain_copy_array(cuStrChain *chain, const char *arr, size_t len);
+
+/* Write the pending bytes to fd with as few writev() calls as possible,
+ * at most IOV_MAX segments each. Returns 0 once everything has been
+ * written, 1 if a non-blocking fd would block (call again to resume
+ * where it stopped) and -1 with errno set on error.
+ */
+int cuStrChain_write(cuStrChain *chain, int fd);
+
+#endif /* CU_INCLUDE_STRCHAIN_H */
@@ -0,0 +1,290 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_strcmp.h"
+#include "cutil_simd.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+static uint64_t cuMem_load64(const char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static uint32_t cuMem_load32(const char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+/* Equality of up to 16 bytes without a loop: two overlapping loads cover
+ * every length from 4 to 16
+ */
+static bool cuMem_equal_short(const char *a, const char *b, size_t n)
+{
+    if (n >= 8) {
+        return ((cuMem_load64(a) ^ cuMem_load64(b))
+                | (cuMem_load64(a + n - 8) ^ cuMem_load64(b + n - 8))) == 0;
+    } else if (n >= 4) {
+        return ((cuMem_load32(a) ^ cuMem_load32(b))
+                | (cuMem_load32(a + n - 4) ^ cuMem_load32(b + n - 4))) == 0;
+    }
+    while (n--) {
+        if (a[n] != b[n])
+            return false;
+    }
+    return true;
+}
+
+static size_t cuMem_mismatch_scalar(const char *a, const char *b, size_t n)
+{
+    size_t i = 0;
+
+    /* A word at a time until there is a difference */
+    for (; i + 8 <= n; i += 8) {
+        if (cuMem_load64(a + i) != cuMem_load64(b + i))
+            break;
+    }
+    for (; i < n; i++) {
+        if (a[i] != b[i])
+            return i;
+    }
+    return n;
+}
+
+#ifdef CU_SIMD_X86
+
+static size_t cuMem_mismatch_sse2(const char *a, const char *b, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xFFFFu;
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + cuMem_mismatch_scalar(a + i, b + i, n - i);
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_mismatch_avx2(const char *a, const char *b, size_t n)
+{
+    size_t i = 0;
+
+    /* Two vectors per iteration; exit as soon as either differs */
+    for (; i + 64 <= n; i += 64) {
+        __m256i eq0 = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(a + i)),
+            _mm256_loadu_si256((const __m256i *)(b + i)));
+        __m256i eq1 = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(a + i + 32)),
+            _mm256_loadu_si256((const __m256i *)(b + i + 32)));
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(
+                            _mm256_and_si256(eq0, eq1));
+        if (mask) {
+            mask = ~(unsigned)_mm256_movemask_epi8(eq0);
+            if (mask)
+                return i + __builtin_ctz(mask);
+            mask = ~(unsigned)_mm256_movemask_epi8(eq1);
+            return i + 32 + __builtin_ctz(mask);
+        }
+    }
+    for (; i + 32 <= n; i += 32) {
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(a + i)),
+            _mm256_loadu_si256((const __m256i *)(b + i))));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + cuMem_mismatch_scalar(a + i, b + i, n - i);
+}
+
+/* Equality only needs to know whether there is a difference, not where, so
+ * differences are OR'ed together and tested once per 64 bytes. The tail is
+ * handled with loads that overlap bytes already compared.
+ */
+static bool cuMem_equal_sse2_17_32(const char *a, const char *b, size_t n)
+{
+    __m128i x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)a),
+                               _mm_loadu_si128((const __m128i *)b));
+    __m128i x1 = _mm_xor_si128(
+        _mm_loadu_si128((const __m128i *)(a + n - 16)),
+        _mm_loadu_si128((const __m128i *)(b + n - 16)));
+    __m128i x = _mm_or_si128(x0, x1);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) == 0xFFFF;
+}
+
+CU_TARGET_AVX2
+static bool cuMem_equal_avx2(const char *a, const char *b, size_t n)
+{
+    __m256i x;
+    size_t i;
+
+    if (n <= 64) {
+        x = _mm256_or_si256(
+            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)a),
+                             _mm256_loadu_si256((const __m256i *)b)),
+            _mm256_xor_si256(
+                _mm256_loadu_si256((const __m256i *)(a + n - 32)),
+                _mm256_loadu_si256((const __m256i *)(b + n - 32))));
+        return _mm256_testz_si256(x, x);
+    }
+
+    for (i = 0; i + 64 <= n; i += 64) {
+        x = _mm256_or_si256(
+            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)),
+                             _mm256_loadu_si256((const __m256i *)(b + i))),
+            _mm256_xor_si256(
+                _mm256_loadu_si256((const __m256i *)(a + i + 32)),
+                _mm256_loadu_si256((const __m256i *)(b + i + 32))));
+        if (!_mm256_testz_si256(x, x))
+            return false;
+    }
+    if (i < n) {
+        a += n - 64;
+        b += n - 64;
+        x = _mm256_or_si256(
+            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)a),
+                             _mm256_loadu_si256((const __m256i *)b)),
+            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + 32)),
+                             _mm256_loadu_si256((const __m256i *)(b + 32))));
+        return _mm256_testz_si256(x, x);
+    }
+    return true;
+}
+
+#endif /* CU_SIMD_X86 */
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+size_t cuMem_mismatch(const char *a, const char *b, size_t n)
+{
+    if (a == b)
+        return n;
+    if (n < 16)
+        return cuMem_mismatch_scalar(a, b, n);
+#ifdef CU_SIMD_X86
+    {
+        unsigned features = cu_cpu_features();
+        if (features & CU_CPU_AVX2)
+            return cuMem_mismatch_avx2(a, b, n);
+        if (features & CU_CPU_SSE2)
+            return cuMem_mismatch_sse2(a, b, n);
+    }
+#endif
+    return cuMem_mismatch_scalar(a, b, n);
+}
+
+bool cuMem_equal(const char *a, const char *b, size_t n)
+{
+    if (n <= 16)
+        return cuMem_equal_short(a, b, n);
+#ifdef CU_SIMD_X86
+    {
+        unsigned features = cu_cpu_features();
+        if (n > 32 && (features & CU_CPU_AVX2))
+            return cuMem_equal_avx2(a, b, n);
+        if (n <= 32 && (features & CU_CPU_SSE2))
+            return cuMem_equal_sse2_17_32(a, b, n);
+    }
+#endif
+    return cuMem_mismatch(a, b, n) == n;
+}
+
+int cuMem_compare(const char *a, size_t a_len, const char *b, size_t b_len)
+{
+    size_t n = a_len < b_len ? a_len : b_len;
+    size_t i = n ? cuMem_mismatch(a, b, n) : 0;
+
+    if (i < n)
+        return (int)(unsigned char)a[i] - (int)(unsigned char)b[i];
+    if (a_len != b_len)
+        return a_len < b_len ? -1 : 1;
+    return 0;
+}
+
+bool cuStr_equal(const cuStr *cus1, const cuStr *cus2)
+{
+    uint64_t h1, h2;
+
+    assert(cus1 != NULL && cus2 != NULL); // pre-conditions
+
+    /* Cached hashes that differ settle it without reading the contents.
+     * Other threads may be filling them in, see cuStr_hash().
+     */
+    h1 = __atomic_load_n(&cus1->hash, __ATOMIC_RELAXED);
+    h2 = __atomic_load_n(&cus2->hash, __ATOMIC_RELAXED);
+    if (h1 != 0 && h2 != 0 && h1 != h2)
+        return false;
+    return cuStr_equal_array(cus1, cus2->mem, cus2->elements_used);
+}
+
+bool cuStr_equal_array(const cuStr *cus, const char *arr, size_t len)
+{
+    assert(cus != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    /* Different lengths can never be equal, so check that first */
+    if (cus->elements_used != len)
+        return false;
+    return len == 0 || cuMem_equal(cus->mem, arr, len);
+}
+
+int cuStr_compare(const cuStr *cus1, const cuStr *cus2)
+{
+    assert(cus1 != NULL && cus2 != NULL); // pre-conditions
+
+    return cuStr_compare_array(cus1, cus2->mem, cus2->elements_used);
+}
+
+int cuStr_compare_array(const cuStr *cus, const char *arr, size_t len)
+{
+    assert(cus != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    return cuMem_compare(cus->mem, cus->elements_used, arr, len);
+}
+
+bool cuStr_starts_with(const cuStr *cus, const cuStr *prefix)
+{
+    assert(prefix != NULL); // pre-condition
+
+    return cuStr_starts_with_array(cus, prefix->mem, prefix->elements_used);
+}
+
+bool cuStr_starts_with_array(const cuStr *cus, const char *arr, size_t len)
+{
+    assert(cus != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if (len > cus->elements_used)
+        return false;
+    return len == 0 || cuMem_equal(cus->mem, arr, len);
+}
+
+bool cuStr_ends_with(const cuStr *cus, const cuStr *suffix)
+{
+    assert(suffix != NULL); // pre-condition
+
+    return cuStr_ends_with_array(cus, suffix->mem, suffix->elements_used);
+}
+
+bool cuStr_ends_with_array(const cuStr *cus, const char *arr, size_t len)
+{
+    assert(cus != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if (len > cus->elements_used)
+        return false;
+    return len == 0
+           || cuMem_equal(cus->mem + cus->elements_used - len, arr, len);
+}
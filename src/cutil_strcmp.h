@@ -0,0 +1,28 @@
+#ifndef CU_INCLUDE_STRCMP_H
+#define CU_INCLUDE_STRCMP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "cutil_string.h"
+
+/* Comparisons over the full length of the strings, including any embedded
+ * '\0' bytes. Ordering is lexicographic on unsigned bytes, with a string
+ * ordered before any longer string it is a prefix of.
+ */
+bool cuStr_equal(const cuStr *cus1, const cuStr *cus2);
+bool cuStr_equal_array(const cuStr *cus, const char *arr, size_t len);
+int cuStr_compare(const cuStr *cus1, const cuStr *cus2);
+int cuStr_compare_array(const cuStr *cus, const char *arr, size_t len);
+bool cuStr_starts_with(const cuStr *cus, const cuStr *prefix);
+bool cuStr_starts_with_array(const cuStr *cus, const char *arr, size_t len);
+bool cuStr_ends_with(const cuStr *cus, const cuStr *suffix);
+bool cuStr_ends_with_array(const cuStr *cus, const char *arr, size_t len);
+
+/* The same over raw memory. cuMem_mismatch() returns the index of the first
+ * differing byte, or n if there is none.
+ */
+size_t cuMem_mismatch(const char *a, const char *b, size_t n);
+bool cuMem_equal(const char *a, const char *b, size_t n);
+int cuMem_compare(const char *a, size_t a_len, const char *b, size_t b_len);
+
+#endif /* CU_INCLUDE_STRCMP_H */
@@ -0,0 +1,608 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_strcodec.h"
+#include "cutil_simd.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+/* The two hex digits of every byte value */
+static const char cuMem_hex_pairs[513] =
+    "000102030405060708090a0b0c0d0e0f"
+    "101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f"
+    "303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f"
+    "505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f"
+    "707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f"
+    "909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+    "b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+    "d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+    "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+static const char cuMem_hex_digits[17] = "0123456789abcdef";
+
+/* The value of each hex digit, or -1 */
+static const signed char cuMem_hex_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static const char cuMem_base64_chars[65] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdef"
+    "ghijklmnopqrstuvwxyz0123456789+/";
+
+/* The value of each base64 character, or -1 */
+static const signed char cuMem_base64_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+/* Scalar kernels, used when no SIMD is available and for what the vector
+ * kernels leave. Those process whole blocks and return the input length
+ * they used, stopping early at a block that is not valid.
+ */
+static size_t cuMem_hex_encode_scalar(char *dst, const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        memcpy(dst + 2 * i, cuMem_hex_pairs + 2 * s[i], 2);
+    return 2 * n;
+}
+
+static size_t cuMem_hex_decode_scalar(char *dst, const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    size_t i;
+
+    if (n % 2)
+        return CUMEM_DECODE_ERROR;
+    for (i = 0; i < n; i += 2) {
+        int hi = cuMem_hex_values[s[i]], lo = cuMem_hex_values[s[i + 1]];
+        if ((hi | lo) < 0)
+            return CUMEM_DECODE_ERROR;
+        dst[i / 2] = (char)(hi << 4 | lo);
+    }
+    return n / 2;
+}
+
+static size_t cuMem_base64_encode_scalar(char *dst, const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    char *p = dst;
+    uint32_t v;
+    size_t i;
+
+    for (i = 0; i + 3 <= n; i += 3) {
+        v = (uint32_t)s[i] << 16 | (uint32_t)s[i + 1] << 8 | s[i + 2];
+        p[0] = cuMem_base64_chars[v >> 18];
+        p[1] = cuMem_base64_chars[v >> 12 & 63];
+        p[2] = cuMem_base64_chars[v >> 6 & 63];
+        p[3] = cuMem_base64_chars[v & 63];
+        p += 4;
+    }
+    if (i < n) {
+        v = (uint32_t)s[i] << 16;
+        if (i + 1 < n)
+            v |= (uint32_t)s[i + 1] << 8;
+        p[0] = cuMem_base64_chars[v >> 18];
+        p[1] = cuMem_base64_chars[v >> 12 & 63];
+        p[2] = i + 1 < n ? cuMem_base64_chars[v >> 6 & 63] : '=';
+        p[3] = '=';
+        p += 4;
+    }
+    return (size_t)(p - dst);
+}
+
+/* Padding may only end the last group, and the bits it leaves unused must
+ * be zero, so that every output has exactly one encoding
+ */
+static size_t cuMem_base64_decode_scalar(char *dst, const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    char *p = dst;
+    int a, b, c, d;
+    size_t i;
+
+    if (n % 4)
+        return CUMEM_DECODE_ERROR;
+    for (i = 0; i < n; i += 4) {
+        a = cuMem_base64_values[s[i]];
+        b = cuMem_base64_values[s[i + 1]];
+        c = cuMem_base64_values[s[i + 2]];
+        d = cuMem_base64_values[s[i + 3]];
+        if ((a | b | c | d) < 0)
+            break;
+        p[0] = (char)(a << 2 | b >> 4);
+        p[1] = (char)(b << 4 | c >> 2);
+        p[2] = (char)(c << 6 | d);
+        p += 3;
+    }
+    if (i == n)
+        return (size_t)(p - dst);
+    if (i + 4 != n || (a | b) < 0 || s[i + 3] != '=')
+        return CUMEM_DECODE_ERROR;
+    if (s[i + 2] == '=') {
+        if (b & 15)
+            return CUMEM_DECODE_ERROR;
+        *p++ = (char)(a << 2 | b >> 4);
+    } else {
+        if (c < 0 || (c & 3))
+            return CUMEM_DECODE_ERROR;
+        *p++ = (char)(a << 2 | b >> 4);
+        *p++ = (char)(b << 4 | c >> 2);
+    }
+    return (size_t)(p - dst);
+}
+
+#ifdef CU_SIMD_X86
+
+/* The bytes from lo to hi, both ASCII, as a mask */
+static __m128i cuMem_range_sse2(__m128i c, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8((char)(lo - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8((char)(hi + 1)), c));
+}
+
+/* Hex digits to their values; returns 0 if any byte is not a digit */
+static int cuMem_hex_values_sse2(__m128i c, __m128i *values)
+{
+    const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    const __m128i digit = cuMem_range_sse2(c, '0', '9');
+    const __m128i alpha = cuMem_range_sse2(lower, 'a', 'f');
+    const __m128i from_digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    const __m128i from_alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+
+    *values = _mm_or_si128(_mm_and_si128(digit, from_digit),
+                           _mm_and_si128(alpha, from_alpha));
+    return _mm_movemask_epi8(_mm_or_si128(digit, alpha)) == 0xFFFF;
+}
+
+/* Base64 characters to their values by range; returns 0 if any byte is
+ * outside the alphabet, padding included
+ */
+static int cuMem_base64_values_sse2(__m128i c, __m128i *values)
+{
+    const __m128i upper = cuMem_range_sse2(c, 'A', 'Z');
+    const __m128i lower = cuMem_range_sse2(c, 'a', 'z');
+    const __m128i digit = cuMem_range_sse2(c, '0', '9');
+    const __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+    const __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+    __m128i shift, valid;
+
+    shift = _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                         _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    shift = _mm_or_si128(shift,
+                         _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    shift = _mm_or_si128(shift,
+                         _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+    shift = _mm_or_si128(shift,
+                         _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+    *values = _mm_add_epi8(c, shift);
+    valid = _mm_or_si128(_mm_or_si128(upper, lower), digit);
+    valid = _mm_or_si128(valid, _mm_or_si128(plus, slash));
+    return _mm_movemask_epi8(valid) == 0xFFFF;
+}
+
+/* Each nibble picks its digit with pshufb, and interleaving the high and
+ * low digits puts them in order
+ */
+CU_TARGET_SSSE3
+static size_t cuMem_hex_encode_ssse3(char *dst, const char *src, size_t n)
+{
+    const __m128i digits = _mm_loadu_si128((const __m128i *)cuMem_hex_digits);
+    const __m128i low4 = _mm_set1_epi8(0x0f);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), low4);
+        __m128i hi = _mm_shuffle_epi8(digits, high);
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, low4));
+        __m128i *out = (__m128i *)(dst + 2 * i);
+
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_hex_encode_avx2(char *dst, const char *src, size_t n)
+{
+    const __m256i digits = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)cuMem_hex_digits));
+    const __m256i low4 = _mm256_set1_epi8(0x0f);
+    size_t i;
+
+    /* Interleaving works within 128-bit lanes, so first move bytes 8-15
+     * to the upper lane and bytes 16-23 to the lower one
+     */
+    for (i = 0; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i high, hi, lo;
+        __m256i *out = (__m256i *)(dst + 2 * i);
+
+        v = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0));
+        high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low4);
+        hi = _mm256_shuffle_epi8(digits, high);
+        lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, low4));
+        _mm256_storeu_si256(out, _mm256_unpacklo_epi8(hi, lo));
+        _mm256_storeu_si256(out + 1, _mm256_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+/* pmaddubsw joins each pair of digit values into a byte */
+CU_TARGET_SSSE3
+static size_t cuMem_hex_decode_ssse3(char *dst, const char *src, size_t n)
+{
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    __m128i a, b;
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        const __m128i *in = (const __m128i *)(src + i);
+
+        if (!cuMem_hex_values_sse2(_mm_loadu_si128(in), &a)
+            || !cuMem_hex_values_sse2(_mm_loadu_si128(in + 1), &b))
+            break;
+        _mm_storeu_si128((__m128i *)(dst + i / 2),
+                         _mm_packus_epi16(_mm_maddubs_epi16(a, weights),
+                                          _mm_maddubs_epi16(b, weights)));
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static __m256i cuMem_range_avx2(__m256i c, char lo, char hi)
+{
+    return _mm256_and_si256(
+        _mm256_cmpgt_epi8(c, _mm256_set1_epi8((char)(lo - 1))),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(hi + 1)), c));
+}
+
+CU_TARGET_AVX2
+static int cuMem_hex_values_avx2(__m256i c, __m256i *values)
+{
+    const __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    const __m256i digit = cuMem_range_avx2(c, '0', '9');
+    const __m256i alpha = cuMem_range_avx2(lower, 'a', 'f');
+    const __m256i from_digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    const __m256i from_alpha = _mm256_sub_epi8(lower,
+                                               _mm256_set1_epi8('a' - 10));
+
+    *values = _mm256_or_si256(_mm256_and_si256(digit, from_digit),
+                              _mm256_and_si256(alpha, from_alpha));
+    return _mm256_movemask_epi8(_mm256_or_si256(digit, alpha)) == -1;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_hex_decode_avx2(char *dst, const char *src, size_t n)
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    __m256i a, b;
+    size_t i;
+
+    for (i = 0; i + 64 <= n; i += 64) {
+        const __m256i *in = (const __m256i *)(src + i);
+
+        if (!cuMem_hex_values_avx2(_mm256_loadu_si256(in), &a)
+            || !cuMem_hex_values_avx2(_mm256_loadu_si256(in + 1), &b))
+            break;
+        /* Packing is per lane too: put the quarters back in order */
+        a = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights),
+                                _mm256_maddubs_epi16(b, weights));
+        a = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(dst + i / 2), a);
+    }
+    return i;
+}
+
+/* Spread each group of 3 bytes over 4 bytes of 6 bits, then add the
+ * offset of its range in the alphabet, looked up with pshufb. This is the
+ * method of Muła and Lemire.
+ */
+CU_TARGET_SSSE3
+static size_t cuMem_base64_encode_ssse3(char *dst, const char *src, size_t n)
+{
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                        4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '+' - 62,
+                                          '/' - 63, 'A', 0, 0);
+    __m128i v, t, range, low;
+    size_t i;
+
+    /* 12 bytes are used from each 16 loaded */
+    for (i = 0; i + 16 <= n; i += 12) {
+        v = _mm_loadu_si128((const __m128i *)(src + i));
+        v = _mm_shuffle_epi8(v, spread);
+        t = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)),
+                            _mm_set1_epi32(0x04000040));
+        v = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)),
+                            _mm_set1_epi32(0x01000010));
+        v = _mm_or_si128(t, v);
+        /* 0-25 -> 13, 26-51 -> 0, 52-61 -> 1-10, 62 -> 11, 63 -> 12 */
+        range = _mm_subs_epu8(v, _mm_set1_epi8(51));
+        low = _mm_cmpgt_epi8(_mm_set1_epi8(26), v);
+        range = _mm_or_si128(range, _mm_and_si128(low, _mm_set1_epi8(13)));
+        v = _mm_add_epi8(v, _mm_shuffle_epi8(offsets, range));
+        _mm_storeu_si128((__m128i *)(dst + i / 3 * 4), v);
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_base64_encode_avx2(char *dst, const char *src, size_t n)
+{
+    const __m256i spread = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1,
+                                           10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '+' - 62,
+                                             '/' - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '+' - 62,
+                                             '/' - 63, 'A', 0, 0);
+    const __m256i high_bits = _mm256_set1_epi32(0x0fc0fc00);
+    const __m256i low_bits = _mm256_set1_epi32(0x003f03f0);
+    __m256i v, t, range, low;
+    size_t i;
+
+    /* 12 bytes for each lane, loaded separately */
+    for (i = 0; i + 28 <= n; i += 24) {
+        v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(src + i))),
+            _mm_loadu_si128((const __m128i *)(src + i + 12)), 1);
+        v = _mm256_shuffle_epi8(v, spread);
+        t = _mm256_mulhi_epu16(_mm256_and_si256(v, high_bits),
+                               _mm256_set1_epi32(0x04000040));
+        v = _mm256_mullo_epi16(_mm256_and_si256(v, low_bits),
+                               _mm256_set1_epi32(0x01000010));
+        v = _mm256_or_si256(t, v);
+        range = _mm256_subs_epu8(v, _mm256_set1_epi8(51));
+        low = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), v);
+        range = _mm256_or_si256(range,
+                                _mm256_and_si256(low, _mm256_set1_epi8(13)));
+        v = _mm256_add_epi8(v, _mm256_shuffle_epi8(offsets, range));
+        _mm256_storeu_si256((__m256i *)(dst + i / 3 * 4), v);
+    }
+    return i;
+}
+
+/* Join 4 values of 6 bits into 3 bytes: pmaddubsw makes pairs of 12 bits,
+ * pmaddwd the 24-bit groups, and pshufb puts their bytes in order
+ */
+CU_TARGET_SSSE3
+static size_t cuMem_base64_decode_ssse3(char *dst, const char *src, size_t n)
+{
+    const __m128i order = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                        14, 13, 12, -1, -1, -1, -1);
+    __m128i v;
+    size_t i;
+    int tail;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        v = _mm_loadu_si128((const __m128i *)(src + i));
+        if (!cuMem_base64_values_sse2(v, &v))
+            break;
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        v = _mm_shuffle_epi8(v, order);
+        _mm_storel_epi64((__m128i *)(dst + i / 4 * 3), v);
+        tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+        memcpy(dst + i / 4 * 3 + 8, &tail, 4);
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static int cuMem_base64_values_avx2(__m256i c, __m256i *values)
+{
+    const __m256i upper = cuMem_range_avx2(c, 'A', 'Z');
+    const __m256i lower = cuMem_range_avx2(c, 'a', 'z');
+    const __m256i digit = cuMem_range_avx2(c, '0', '9');
+    const __m256i plus = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+'));
+    const __m256i slash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'));
+    __m256i shift, t, valid;
+
+    shift = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+    t = _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'));
+    shift = _mm256_or_si256(shift, t);
+    t = _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0'));
+    shift = _mm256_or_si256(shift, t);
+    t = _mm256_and_si256(plus, _mm256_set1_epi8(62 - '+'));
+    shift = _mm256_or_si256(shift, t);
+    t = _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/'));
+    shift = _mm256_or_si256(shift, t);
+    *values = _mm256_add_epi8(c, shift);
+    valid = _mm256_or_si256(_mm256_or_si256(upper, lower), digit);
+    valid = _mm256_or_si256(valid, _mm256_or_si256(plus, slash));
+    return _mm256_movemask_epi8(valid) == -1;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_base64_decode_avx2(char *dst, const char *src, size_t n)
+{
+    const __m256i order = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                           14, 13, 12, -1, -1, -1, -1,
+                                           2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                           14, 13, 12, -1, -1, -1, -1);
+    const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    __m256i v;
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        char *out = dst + i / 4 * 3;
+
+        v = _mm256_loadu_si256((const __m256i *)(src + i));
+        if (!cuMem_base64_values_avx2(v, &v))
+            break;
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        /* 12 bytes in each lane; move them together */
+        v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, order), compact);
+        _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(v));
+        _mm_storel_epi64((__m128i *)(out + 16),
+                         _mm256_extracti128_si256(v, 1));
+    }
+    return i;
+}
+
+#endif /* CU_SIMD_X86 */
+
+/* Append what encode or decode writes for n bytes of input, at most max */
+static cuStr *cuStr_codec_append(cuStr *cus, const char *src, size_t n,
+                                 size_t max,
+                                 size_t (*codec)(char *, const char *, size_t))
+{
+    size_t len;
+
+    assert(cus != NULL); // pre-condition
+    assert(src != NULL || n == 0); // pre-condition
+
+    if (!cuStr_grow(cus, max))
+        return NULL;
+    len = codec(cus->mem + cus->elements_used, src, n);
+    if (len == CUMEM_DECODE_ERROR) {
+        if (cus->mem)
+            cus->mem[cus->elements_used] = '\0';
+        return NULL;
+    }
+    return cuStr_commit(cus, len);
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+size_t cuMem_hex_encode(char *dst, const char *src, size_t n)
+{
+    size_t done = 0;
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        done = cuMem_hex_encode_avx2(dst, src, n);
+    else if (features & CU_CPU_SSSE3)
+        done = cuMem_hex_encode_ssse3(dst, src, n);
+#endif
+    return 2 * done
+           + cuMem_hex_encode_scalar(dst + 2 * done, src + done, n - done);
+}
+
+size_t cuMem_hex_decode(char *dst, const char *src, size_t n)
+{
+    size_t done = 0, rest;
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        done = cuMem_hex_decode_avx2(dst, src, n);
+    else if (features & CU_CPU_SSSE3)
+        done = cuMem_hex_decode_ssse3(dst, src, n);
+#endif
+    rest = cuMem_hex_decode_scalar(dst + done / 2, src + done, n - done);
+    return rest == CUMEM_DECODE_ERROR ? rest : done / 2 + rest;
+}
+
+size_t cuMem_base64_encode(char *dst, const char *src, size_t n)
+{
+    size_t done = 0;
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        done = cuMem_base64_encode_avx2(dst, src, n);
+    else if (features & CU_CPU_SSSE3)
+        done = cuMem_base64_encode_ssse3(dst, src, n);
+#endif
+    return done / 3 * 4 + cuMem_base64_encode_scalar(dst + done / 3 * 4,
+                                                      src + done, n - done);
+}
+
+size_t cuMem_base64_decode(char *dst, const char *src, size_t n)
+{
+    size_t done = 0, rest;
+
+    if (n % 4)
+        return CUMEM_DECODE_ERROR;
+#ifdef CU_SIMD_X86
+    {
+        unsigned features = cu_cpu_features();
+        if (features & CU_CPU_AVX2)
+            done = cuMem_base64_decode_avx2(dst, src, n);
+        else if (features & CU_CPU_SSSE3)
+            done = cuMem_base64_decode_ssse3(dst, src, n);
+    }
+#endif
+    rest = cuMem_base64_decode_scalar(dst + done / 4 * 3, src + done, n - done);
+    return rest == CUMEM_DECODE_ERROR ? rest : done / 4 * 3 + rest;
+}
+
+cuStr *cuStr_hex_encode(cuStr *cus, const char *src, size_t n)
+{
+    return cuStr_codec_append(cus, src, n, CUMEM_HEX_ENCODED_LEN(n),
+                              cuMem_hex_encode);
+}
+
+cuStr *cuStr_hex_decode(cuStr *cus, const char *src, size_t n)
+{
+    return cuStr_codec_append(cus, src, n, n / 2, cuMem_hex_decode);
+}
+
+cuStr *cuStr_base64_encode(cuStr *cus, const char *src, size_t n)
+{
+    return cuStr_codec_append(cus, src, n, CUMEM_BASE64_ENCODED_LEN(n),
+                              cuMem_base64_encode);
+}
+
+cuStr *cuStr_base64_decode(cuStr *cus, const char *src, size_t n)
+{
+    return cuStr_codec_append(cus, src, n, n / 4 * 3, cuMem_base64_decode);
+}
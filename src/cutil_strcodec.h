@@ -0,0 +1,39 @@
+#ifndef CU_INCLUDE_STRCODEC_H
+#define CU_INCLUDE_STRCODEC_H
+
+#include <stddef.h>
+#include "cutil_string.h"
+
+/* Returned by the cuMem decode functions for invalid input */
+#define CUMEM_DECODE_ERROR ((size_t)-1)
+
+/* Characters needed to encode n bytes */
+#define CUMEM_HEX_ENCODED_LEN(n)    ((n) * 2)
+#define CUMEM_BASE64_ENCODED_LEN(n) (((n) + 2) / 3 * 4)
+
+/* Hex is encoded with lowercase digits and decoded in either case. Base64
+ * uses the standard alphabet of RFC 4648 with '=' padding, which decoding
+ * requires, and rejects anything else, whitespace included.
+ */
+
+/* Append the encoding of the n bytes at src. Returns cus, or NULL if out of
+ * memory.
+ */
+cuStr *cuStr_hex_encode(cuStr *cus, const char *src, size_t n);
+cuStr *cuStr_base64_encode(cuStr *cus, const char *src, size_t n);
+/* Append the bytes encoded in the n characters at src. Returns cus, or
+ * NULL if out of memory or src is not valid, leaving cus unchanged.
+ */
+cuStr *cuStr_hex_decode(cuStr *cus, const char *src, size_t n);
+cuStr *cuStr_base64_decode(cuStr *cus, const char *src, size_t n);
+
+/* The same over raw memory; dst must have room for the encoded length, or
+ * for n / 2 and n / 4 * 3 bytes when decoding. These return the length
+ * written, or CUMEM_DECODE_ERROR.
+ */
+size_t cuMem_hex_encode(char *dst, const char *src, size_t n);
+size_t cuMem_hex_decode(char *dst, const char *src, size_t n);
+size_t cuMem_base64_encode(char *dst, const char *src, size_t n);
+size_t cuMem_base64_decode(char *dst, const char *src, size_t n);
+
+#endif /* CU_INCLUDE_STRCODEC_H */
@@ -0,0 +1,177 @@
+#define _DEFAULT_SOURCE     // MAP_ANONYMOUS and madvise() on glibc
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include "cutil_strfile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/stat.h>
+#   include <sys/mman.h>
+#   define CU_HAVE_MMAP
+#endif
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#ifdef CU_HAVE_MMAP
+
+#ifndef MAP_ANONYMOUS
+#   define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Read the rest of fd into cus. size is what fstat() reported, which is
+ * only a hint: 0 for pipes and many special files.
+ */
+static cuStr *cuStr_read_fd(cuStr *cus, int fd, size_t size)
+{
+    if (size && !cuStr_reserve(cus, size))
+        return NULL;
+
+    for (;;) {
+        size_t avail = cuStr_max_elements(cus) - cuStr_len(cus);
+        ssize_t n;
+
+        /* Only grow once the expected size has been read */
+        if (avail == 0) {
+            if (!cuStr_grow(cus, 4096))
+                return NULL;
+            avail = cuStr_max_elements(cus) - cuStr_len(cus);
+        }
+        n = read(fd, cus->mem + cuStr_len(cus), avail);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return NULL;
+        }
+        if (n == 0)
+            return cus;
+        cuStr_commit(cus, (size_t)n);
+    }
+}
+
+/* Map size bytes of fd followed by at least one zero byte, so the contents
+ * are '\0' terminated even when size is a multiple of the page size: the
+ * file is mapped over the start of an anonymous mapping one byte longer
+ */
+static char *cuStr_map_fd(int fd, size_t size, size_t *map_len, unsigned flags)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t len = (size + 1 + page - 1) / page * page;
+    void *p;
+
+    if (len < size)
+        return NULL;
+    p = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    if (mmap(p, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int err = errno;
+        munmap(p, len);
+        errno = err;
+        return NULL;
+    }
+
+    /* Only hints: failures don't matter */
+#ifdef MADV_SEQUENTIAL
+    if (flags & CUSTR_MAP_SEQUENTIAL)
+        madvise(p, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_HUGEPAGE
+    if (flags & CUSTR_MAP_HUGEPAGE)
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+    (void)flags;
+
+    *map_len = len;
+    return p;
+}
+
+#endif /* CU_HAVE_MMAP */
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStr *cuStr_map_file(const char *path, unsigned flags)
+{
+#ifdef CU_HAVE_MMAP
+    struct stat st;
+    cuStr *cus;
+    char *mem;
+    size_t map_len;
+    int fd, err;
+
+    assert(path != NULL); // pre-condition
+
+    if ((cus = cuStr_new(0)) == NULL)
+        return NULL;
+    if ((fd = open(path, O_RDONLY)) < 0)
+        goto fail;
+    if (fstat(fd, &st) != 0)
+        goto fail;
+    if ((uintmax_t)st.st_size >= SIZE_MAX) {
+        errno = EFBIG;
+        goto fail;
+    }
+
+    /* Empty files can't be mapped, and they need no memory anyway */
+    if (S_ISREG(st.st_mode) && st.st_size > 0 && !(flags & CUSTR_MAP_READ)
+        && (mem = cuStr_map_fd(fd, (size_t)st.st_size, &map_len, flags)) != NULL) {
+        cus->mem = mem;
+        cus->max_elements = cus->elements_used = (size_t)st.st_size;
+        cus->map_len = map_len;
+    } else if (!cuStr_read_fd(cus, fd, (size_t)st.st_size)) {
+        goto fail;
+    }
+    close(fd);
+    return cus;
+
+fail:
+    err = errno;
+    if (fd >= 0)
+        close(fd);
+    cuStr_destroy(&cus);
+    errno = err;
+    return NULL;
+#else
+    /* Plain C: one read of the size that fseek() reports */
+    FILE *f;
+    cuStr *cus;
+    long size;
+
+    assert(path != NULL); // pre-condition
+
+    (void)flags;
+    if ((f = fopen(path, "rb")) == NULL)
+        return NULL;
+    if ((cus = cuStr_new(0)) != NULL
+        && fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0
+        && fseek(f, 0, SEEK_SET) == 0 && cuStr_reserve(cus, (size_t)size)
+        && fread(cus->mem, 1, (size_t)size, f) == (size_t)size) {
+        cuStr_commit(cus, (size_t)size);
+    } else {
+        cuStr_destroy(&cus);
+    }
+    fclose(f);
+    return cus;
+#endif
+}
+
+void cuStr_unmap_file(cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+
+#ifdef CU_HAVE_MMAP
+    if (cus->map_len)
+        munmap(cus->mem, cus->map_len);
+#endif
+    cus->mem = NULL;
+    cus->map_len = 0;
+    cus->max_elements = cus->elements_used = 0;
+}
@@ -0,0 +1,27 @@
+#ifndef CU_INCLUDE_STRFILE_H
+#define CU_INCLUDE_STRFILE_H
+
+#include "cutil_string.h"
+
+/* Hints for cuStr_map_file() */
+#define CUSTR_MAP_SEQUENTIAL    (1U << 0)   // read mostly front to back
+#define CUSTR_MAP_HUGEPAGE      (1U << 1)   // back with huge pages if possible
+#define CUSTR_MAP_READ          (1U << 2)   // read into memory, don't map
+
+/* The whole file at path as a read-only string. The file is mapped into
+ * memory, so its contents are neither copied nor duplicated outside the
+ * page cache; if it can't be mapped (e.g. a pipe, or a system without
+ * mmap()), it is read into a buffer of the file's size instead. Either
+ * way the string is '\0' terminated and may be larger than 4 GiB.
+ *
+ * The string must not be changed, only read, copied and destroyed;
+ * cuStr_destroy() unmaps it. A mapped file that is truncated while mapped
+ * faults on access, as with any mapping. Returns NULL and leaves errno set
+ * on failure.
+ */
+cuStr *cuStr_map_file(const char *path, unsigned flags);
+
+/* Called by cuStr_destroy() to release a mapped string's memory */
+void cuStr_unmap_file(cuStr *cus);
+
+#endif /* CU_INCLUDE_STRFILE_H */
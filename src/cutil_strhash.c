@@ -0,0 +1,138 @@
+#include <string.h>
+#include <assert.h>
+#include "cutil_strhash.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+static const uint64_t cuHash_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+/* Full 64x64 -> 128 bit multiply, returning the low half in *a and the high
+ * half in *b
+ */
+static void cuHash_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 cuHash_u128;
+    cuHash_u128 r = (cuHash_u128)*a * *b;
+
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), lo, hi;
+
+    hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl);
+    lo = t + (rm1 << 32);
+    hi += lo < t;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static uint64_t cuHash_mix(uint64_t a, uint64_t b)
+{
+    cuHash_mum(&a, &b);
+    return a ^ b;
+}
+
+static uint64_t cuHash_read8(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static uint64_t cuHash_read4(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+/* 1 to 3 bytes, read as first, middle and last */
+static uint64_t cuHash_read3(const unsigned char *p, size_t n)
+{
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[n >> 1] << 8) | p[n - 1];
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+uint64_t cuMem_hash(const char *data, size_t n, uint64_t seed)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t a, b;
+
+    assert(data != NULL || n == 0); // pre-condition
+
+    seed ^= cuHash_mix(seed ^ cuHash_secret[0], cuHash_secret[1]);
+    if (n <= 16) {
+        if (n >= 4) {
+            /* Two pairs of overlapping 4 byte reads cover 4 to 16 bytes */
+            size_t off = (n >> 3) << 2;
+            a = (cuHash_read4(p) << 32) | cuHash_read4(p + off);
+            b = (cuHash_read4(p + n - 4) << 32) | cuHash_read4(p + n - 4 - off);
+        } else if (n > 0) {
+            a = cuHash_read3(p, n);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = n;
+
+        if (i > 48) {
+            /* Three independent lanes keep the multipliers busy */
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = cuHash_mix(cuHash_read8(p) ^ cuHash_secret[1],
+                                  cuHash_read8(p + 8) ^ seed);
+                see1 = cuHash_mix(cuHash_read8(p + 16) ^ cuHash_secret[2],
+                                  cuHash_read8(p + 24) ^ see1);
+                see2 = cuHash_mix(cuHash_read8(p + 32) ^ cuHash_secret[3],
+                                  cuHash_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = cuHash_mix(cuHash_read8(p) ^ cuHash_secret[1],
+                              cuHash_read8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = cuHash_read8(p + i - 16);
+        b = cuHash_read8(p + i - 8);
+    }
+    a ^= cuHash_secret[1];
+    b ^= seed;
+    cuHash_mum(&a, &b);
+    return cuHash_mix(a ^ cuHash_secret[0] ^ n, b ^ cuHash_secret[1]);
+}
+
+uint64_t cuStr_hash(const cuStr *cus)
+{
+    uint64_t h;
+
+    assert(cus != NULL); // pre-condition
+
+    if ((h = __atomic_load_n(&cus->hash, __ATOMIC_RELAXED)) != 0)
+        return h;
+    h = cuMem_hash(cus->mem, cus->elements_used, CUSTR_HASH_SEED);
+    /* The cache is not part of the observable state of the string, so it is
+     * updated through a const pointer, atomically as other threads may be
+     * hashing the same string. 0 marks "not computed", so a hash of 0 is
+     * simply recomputed each time.
+     */
+    __atomic_store_n(&((cuStr *)cus)->hash, h, __ATOMIC_RELAXED);
+    return h;
+}
@@ -0,0 +1,26 @@
+#ifndef CU_INCLUDE_STRHASH_H
+#define CU_INCLUDE_STRHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cutil_string.h"
+
+/* Seed used by cuStr_hash() */
+#ifndef CUSTR_HASH_SEED
+#define CUSTR_HASH_SEED 0
+#endif
+
+/* Fast non-cryptographic 64-bit hash (wyhash) over the full length of the
+ * string, including any embedded '\0' bytes. Do not use it where an
+ * attacker can choose the keys unless the seed is secret.
+ *
+ * cuStr_hash() caches the value in the cuStr; every function that changes
+ * the contents drops it. It equals
+ * cuMem_hash(cuStr_cstr(cus), cuStr_len(cus), CUSTR_HASH_SEED). The cache
+ * is read and written atomically, so threads may hash, compare and intern
+ * the same string as long as none of them changes it.
+ */
+uint64_t cuStr_hash(const cuStr *cus);
+uint64_t cuMem_hash(const char *p, size_t n, uint64_t seed);
+
+#endif /* CU_INCLUDE_STRHASH_H */
@@ -5,7 +5,11 @@
 #include <assert.h>
 #include <limits.h>
 #include "cutil_string.h"
-#include "cutil_math.h"
+#include "cutil_strrotate.h"
+#include "cutil_strstats.h"
+#include "cutil_strfile.h"
+#include "cutil_strcodec.h"
+#include "cutil_strcache.h"
 
 const char *empty_str = "";
 
@@ -18,27 +22,120 @@ const char *empty_str = "";
  */
 #define cuStrCHUNKED_SZ(i, z) (((i) / (z) + 1) * z)
 
+/* True if the string's contents are held in its inline (sso) buffer
+ */
+#define cuStrIS_INLINE(cus) ((cus)->mem == (cus)->sso)
+
+/* True if the contents are a read-only file mapping (see cuStr_map_file()),
+ * which nothing may change
+ */
+#define cuStrIS_MAPPED(cus) ((cus)->map_len != 0)
+
+/* Every function that changes the contents must drop the cached hash
+ */
+#define cuStrINVALIDATE_HASH(cus) ((cus)->hash = 0)
+
+/* cuStr_hexdump() formats this much output on the stack per write
+ */
+#define cuStrHEXDUMP_BUFFER 4096
+
+/* A string's memory comes from its arena if it has one and from the heap
+ * otherwise. Sizes are those of the whole block, i.e. including the '\0'.
+ * This is also where allocations are counted for cuStr_stats_snapshot().
+ */
+static void *cuStr_mem_alloc(cuArena *arena, size_t sz)
+{
+    cuStrSTAT(CUSTR_STAT_ALLOC, 1);
+    cuStrSTAT(CUSTR_STAT_CAPACITY, sz);
+    return arena ? cuArena_alloc(arena, sz) : cuStr_cache_alloc(sz);
+}
+
+/* With the cache, heap buffers in its size classes move between classes
+ * instead of being reallocated. Larger ones are never cached, so they keep
+ * realloc(), which may grow them in place.
+ */
+static void *cuStr_mem_realloc(cuArena *arena, void *p, size_t old_sz,
+                               size_t new_sz)
+{
+    void *new_p;
+
+    if (arena) {
+        new_p = cuArena_realloc(arena, p, old_sz, new_sz);
+    } else if (cuStr_cache_enabled()
+               && (cuStr_cache_holds(old_sz) || cuStr_cache_holds(new_sz))) {
+        if ((new_p = cuStr_cache_alloc(new_sz)) != NULL) {
+            if (p)
+                memcpy(new_p, p, old_sz < new_sz ? old_sz : new_sz);
+            cuStr_cache_free(p, old_sz);
+        }
+    } else {
+        new_p = realloc(p, new_sz);
+    }
+
+    cuStrSTAT(CUSTR_STAT_REALLOC, 1);
+    cuStrSTAT(CUSTR_STAT_CAPACITY, new_sz);
+    /* A block that moved had its contents copied */
+    if (new_p && new_p != p)
+        cuStrSTAT(CUSTR_STAT_COPY, old_sz < new_sz ? old_sz : new_sz);
+    return new_p;
+}
+
+static void cuStr_mem_free(cuArena *arena, void *p, size_t sz)
+{
+    if (p)
+        cuStrSTAT(CUSTR_STAT_FREE, 1);
+    if (arena)
+        cuArena_free(arena, p, sz);
+    else
+        cuStr_cache_free(p, sz);
+}
+
+/* The size to allocate for a block of at least sz bytes: heap blocks are
+ * rounded up to a size class when the cache is on
+ */
+static size_t cuStr_mem_size(cuArena *arena, size_t sz)
+{
+    return arena ? sz : cuStr_cache_size(sz);
+}
+
 static struct cuStr *cuStr_init(struct cuStr *cus, int sz, bool use_exact_sz)
 {
     assert(cus != NULL); // pre-condition
 
     cus->elements_used = 0;
+    cus->hash = 0;
+    cus->map_len = 0;
+    cus->resize_flags = CUSTR_RESIZE_UP_GEOMETRIC;
+    cus->growth_factor = CUSTR_DEFAULT_GROWTH_FACTOR;
+    cus->growth_policy = NULL;
 
     if (sz == 0) {
         cus->mem = NULL;
         cus->max_elements = 0;
     }
     else {
-        if (!use_exact_sz || sz < 1) {
-            sz = sz == -1 ? CUSTR_DEFAULT_INITIAL_MEM
-                          : cuStrCHUNKED_SZ(sz, CUSTR_DEFAULT_CHUNK_SIZE);
+        size_t capacity;
+
+        if (sz < 0)
+            sz = CUSTR_DEFAULT_INITIAL_MEM;
+        else if (!use_exact_sz && sz > CUSTR_SSO_CAPACITY)
+            sz = cuStrCHUNKED_SZ(sz, CUSTR_DEFAULT_CHUNK_SIZE);
+
+        if (sz <= CUSTR_SSO_CAPACITY) {
+            /* Short strings live in the inline buffer so no allocation is
+             * needed until they outgrow it
+             */
+            cus->mem = cus->sso;
+            capacity = CUSTR_SSO_CAPACITY;
         }
-
         /* Allocate memory, always with an extra element for '\0'
          */
-        if ((cus->mem = malloc((sz + 1) * sizeof cus->mem)) == NULL) {
-            cus->max_elements = 0;
-            return NULL;
+        else {
+            capacity = cuStr_mem_size(cus->arena, (size_t)sz + 1) - 1;
+            if ((cus->mem = cuStr_mem_alloc(cus->arena, capacity + 1)) == NULL) {
+                cus->max_elements = 0;
+                return NULL;
+            }
         }
 
         /* Always NUL terminate so a call to cuStrcstr(), for example, won't
@@ -46,85 +143,143 @@ static struct cuStr *cuStr_init(struct cuStr *cus, int sz, bool use_exact_sz)
          * populated with anything.
          */
         cus->mem[0] = '\0';
-        cus->max_elements = sz;
+        cus->max_elements = capacity;
     }
 
     cuStr_set_chunksize(cus, CUSTR_DEFAULT_CHUNK_SIZE);
     return cus;
 }
 
+/* Move the contents from the heap into the inline buffer and release the
+ * heap memory. The contents must fit, i.e. elements_used <= CUSTR_SSO_CAPACITY
+ */
+static cuStr *cuStr_move_inline(cuStr *cus)
+{
+    char *heap_mem = cus->mem;
+
+    assert(!cuStrIS_INLINE(cus));                       // pre-condition
+    assert(cus->elements_used <= CUSTR_SSO_CAPACITY);   // pre-condition
+
+    if (heap_mem) {
+        memcpy(cus->sso, heap_mem, cus->elements_used);
+        cuStrSTAT(CUSTR_STAT_COPY, cus->elements_used);
+    }
+    cus->sso[cus->elements_used] = '\0';
+    cuStr_mem_free(cus->arena, heap_mem, cus->max_elements + 1);
+    cus->mem = cus->sso;
+    cus->max_elements = CUSTR_SSO_CAPACITY;
+    return cus;
+}
+
 static cuStr *cuStr_dealloc_mem(cuStr *cus)
 {
-    free(cus->mem);
+    if (!cuStrIS_INLINE(cus) && cus->mem) {
+        cuStrSTAT(CUSTR_STAT_WASTE, cus->max_elements - cus->elements_used);
+        cuStr_mem_free(cus->arena, cus->mem, cus->max_elements + 1);
+    }
     cus->mem = NULL;
     cus->max_elements = cus->elements_used = 0;
+    cuStrINVALIDATE_HASH(cus);
     return cus;
 }
 
-static cuStr *cuStr_resize(cuStr *cus, unsigned max_elements)
+/* Capacity to grow to when at least 'required' elements are needed,
+ * according to the string's resize strategy
+ */
+static size_t cuStr_grow_size(const cuStr *cus, size_t required)
 {
-    size_t len;
+    size_t len = required;
 
-    assert(cus != NULL); // pre-condition
+    if ((cus->resize_flags & CUSTR_RESIZE_UP_CUSTOM) && cus->growth_policy) {
+        len = cus->growth_policy(cus, required);
+        return len > required ? len : required;
+    }
 
-    if (max_elements == cus->max_elements) {
-        return cus;
-    } else if (max_elements == 0) {
-        return cuStr_dealloc_mem(cus);
-    } else if (max_elements > cus->max_elements) {
-        if (cus->resize_flags & CUSTR_RESIZE_UP_CHUNKED) {
-            len = cuStrCHUNKED_SZ(max_elements, cus->chunk_size);
-        } else {
-            assert(cus->resize_flags & CUSTR_RESIZE_UP_EXACT);
-            len = max_elements;
-        }
+    if (cus->resize_flags & CUSTR_RESIZE_UP_GEOMETRIC) {
+        /* Split the multiplication so that it can't overflow */
+        size_t grown = cus->max_elements / 100 * cus->growth_factor
+                       + cus->max_elements % 100 * cus->growth_factor / 100;
+        if (grown > len)
+            len = grown;
+    }
+
+    if (cus->resize_flags & CUSTR_RESIZE_UP_CHUNKED) {
+        len = cuStrCHUNKED_SZ(len, cus->chunk_size);
     } else {
-        len = max_elements;
+        assert(cus->resize_flags & (CUSTR_RESIZE_UP_EXACT
+                                    | CUSTR_RESIZE_UP_GEOMETRIC));
+    }
+    return len;
+}
+
+/* Set the capacity to exactly len elements (plus the '\0'), moving between
+ * the inline buffer and allocated memory as needed
+ */
+static cuStr *cuStr_set_capacity(cuStr *cus, size_t len)
+{
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
+
+    if (len <= CUSTR_SSO_CAPACITY) {
+        /* Fits in the inline buffer. Truncate if shrinking below the
+         * current length.
+         */
+        if (cus->elements_used > len) {
+            cus->elements_used = len;
+            cus->mem[len] = '\0';
+            cuStrINVALIDATE_HASH(cus);
+        }
+        if (cuStrIS_INLINE(cus))
+            return cus;
+        return cuStr_move_inline(cus);
     }
 
-    len += 1;   // Always allow room for '\0'
+    len = cuStr_mem_size(cus->arena, len + 1);  // Always allow room for '\0'
 
-    char *new_mem = realloc(cus->mem, len);
-    if (!new_mem)
+    char *new_mem;
+    if (cuStrIS_INLINE(cus)) {
+        /* Outgrown the inline buffer: move to the heap */
+        if ((new_mem = cuStr_mem_alloc(cus->arena, len)) == NULL)
+            return NULL;
+        memcpy(new_mem, cus->sso, cus->elements_used + 1);
+        cuStrSTAT(CUSTR_STAT_COPY, cus->elements_used + 1);
+    } else if ((new_mem = cuStr_mem_realloc(cus->arena, cus->mem,
+                                            cus->max_elements + 1, len)) == NULL) {
         return NULL;
+    }
+    /* A string without memory (see cuStr_new(0)) had no terminator yet */
+    new_mem[cus->elements_used] = '\0';
     cus->mem = new_mem;
     cus->max_elements = len - 1; // -1 because there is extra space for '\0'
     return cus;
 }
 
-inline static void cuStr_rotate_lr(cuStr *cus, int shift, int n)
+static cuStr *cuStr_resize(cuStr *cus, size_t max_elements)
 {
-    int i;
-    int g_cd;
-
-    char *arr = cus->mem;
+    assert(cus != NULL); // pre-condition
 
-    assert(arr != NULL);
+    if (max_elements == cus->max_elements) {
+        return cus;
+    } else if (max_elements == 0) {
+        return cuStr_dealloc_mem(cus);
+    } else if (max_elements > cus->max_elements) {
+        return cuStr_set_capacity(cus, cuStr_grow_size(cus, max_elements));
+    }
+    return cuStr_set_capacity(cus, max_elements);
+}
 
-    /* in-place "juggle" algorithm for rotation
-     */
+static cuStr *cuStr_new_sized(cuArena *arena, int sz, bool use_exact_sz)
+{
+    struct cuStr *cus;
 
-    g_cd = gcd(shift, n);
-    for (i = 0; i < g_cd; i++) {
-        int j;
-        char tmp = arr[i];
-        j = i;
-        while (1) {
-            int k = j - shift;
-            if (shift < 0) {
-                if (k >= n)
-                    k -= n;
-            } else {
-                if (k < 0)
-                    k += n;
-            }
-            if (k == i)
-                break;
-            arr[j] = arr[k];
-            j = k;
+    if ((cus = cuStr_mem_alloc(arena, sizeof *cus)) != NULL) {
+        cus->arena = arena;
+        if (!cuStr_init(cus, sz, use_exact_sz)) {
+            cuStr_mem_free(arena, cus, sizeof *cus);
+            cus = NULL;
         }
-        arr[j] = tmp;
     }
+
+    return cus;
 }
 
 /* ===========================================================================
@@ -133,16 +288,17 @@ inline static void cuStr_rotate_lr(cuStr *cus, int shift, int n)
 
 cuStr *cuStr_new(int sz)
 {
-    struct cuStr *cus;
+    return cuStr_new_in(NULL, sz);
+}
 
-    if ((cus = malloc(sizeof *cus)) != NULL) {
-        if (!cuStr_init(cus, sz, false)) {
-            free(cus);
-            cus = NULL;
-        }
-    }
+cuStr *cuStr_new_in(cuArena *arena, int sz)
+{
+    return cuStr_new_sized(arena, sz, false);
+}
 
-    return cus;
+cuStr *cuStr_new_exact_in(cuArena *arena, int sz)
+{
+    return cuStr_new_sized(arena, sz, true);
 }
 
 cuStr *cuStr_copy(const cuStr *cus)
@@ -151,22 +307,33 @@ cuStr *cuStr_copy(const cuStr *cus)
 
     assert(cus != NULL); // pre-condition
 
-    if ((cuStrcopy = malloc(sizeof *cuStrcopy)) != NULL) {
-        /* copy everything except the memory pointer to ensure that the copy
-         * has the same flags, chunk size etc as the original
+    /* cuStr_init() takes an int; a mapped file in particular can be larger */
+    if (cus->max_elements > INT_MAX)
+        return NULL;
+
+    if ((cuStrcopy = cuStr_mem_alloc(cus->arena, sizeof *cuStrcopy)) != NULL) {
+        /* The copy has the same arena, flags, chunk size etc as the
+         * original; the struct is not copied whole as other threads may be
+         * caching its hash
          */
-        memcpy(cuStrcopy, cus, sizeof (*cuStrcopy));
+        cuStrcopy->arena = cus->arena;
         cuStrcopy->mem = NULL;
         if (!cuStr_init(cuStrcopy, cus->max_elements, true)) {
-            free(cuStrcopy);
+            cuStr_mem_free(cus->arena, cuStrcopy, sizeof *cuStrcopy);
             cuStrcopy = NULL;
             return NULL;
         }
+        cuStrcopy->resize_flags = cus->resize_flags;
+        cuStrcopy->chunk_size = cus->chunk_size;
+        cuStrcopy->growth_factor = cus->growth_factor;
+        cuStrcopy->growth_policy = cus->growth_policy;
 
         if (cus->mem == NULL) {
             assert(cus->elements_used == 0);
         } else {
             memcpy(cuStrcopy->mem, cus->mem, cus->elements_used + 1);
+            cuStrSTAT(CUSTR_STAT_COPY, cus->elements_used + 1);
+            cuStrcopy->hash = __atomic_load_n(&cus->hash, __ATOMIC_RELAXED);
             cuStrcopy->elements_used = cus->elements_used;
         }
     }
@@ -193,21 +360,84 @@ size_t cuStr_chunksize(const cuStr *cus)
     return cus->chunk_size;
 }
 
-void cuStrset_resize_strategy(cuStr *cus, unsigned flags)
+void cuStr_set_resize_strategy(cuStr *cus, unsigned flags)
 {
     assert(cus != NULL); // pre-condition
 
     cus->resize_flags = flags;
 }
 
+void cuStr_set_growth_factor(cuStr *cus, unsigned percent)
+{
+    assert(cus != NULL); // pre-condition
+
+    /* Anything less than 100% would never grow geometrically */
+    if (percent <= 100) {
+        cus->resize_flags &= ~CUSTR_RESIZE_UP_GEOMETRIC;
+    } else {
+        cus->growth_factor = percent;
+        cus->resize_flags |= CUSTR_RESIZE_UP_GEOMETRIC;
+    }
+}
+
+void cuStr_set_growth_policy(cuStr *cus, cuStrGrowthPolicy policy)
+{
+    assert(cus != NULL); // pre-condition
+
+    cus->growth_policy = policy;
+    if (policy)
+        cus->resize_flags |= CUSTR_RESIZE_UP_CUSTOM;
+    else
+        cus->resize_flags &= ~CUSTR_RESIZE_UP_CUSTOM;
+}
+
+cuStr *cuStr_reserve(cuStr *cus, size_t n)
+{
+    assert(cus != NULL); // pre-condition
+
+    if (n <= cus->max_elements)
+        return cus;
+    return cuStr_set_capacity(cus, n);
+}
+
+cuStr *cuStr_grow(cuStr *cus, size_t n)
+{
+    assert(cus != NULL); // pre-condition
+
+    if (cus->elements_used + n <= cus->max_elements)
+        return cus;
+    return cuStr_resize(cus, cus->elements_used + n);
+}
+
+cuStr *cuStr_commit(cuStr *cus, size_t n)
+{
+    assert(cus != NULL); // pre-condition
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
+    assert(cus->elements_used + n <= cus->max_elements); // pre-condition
+
+    if (n) {
+        cus->elements_used += n;
+        cus->mem[cus->elements_used] = '\0';
+        cuStrINVALIDATE_HASH(cus);
+    }
+    return cus;
+}
+
 
 void cuStr_destroy(cuStr **cus)
 {
     assert(cus != NULL); // pre-condition
 
     if (*cus) {
-        free((*cus)->mem);
-        free(*cus);
+        cuArena *arena = (*cus)->arena;
+        if (cuStrIS_MAPPED(*cus)) {
+            cuStr_unmap_file(*cus);
+        } else if (!cuStrIS_INLINE(*cus) && (*cus)->mem) {
+            cuStrSTAT(CUSTR_STAT_WASTE,
+                      (*cus)->max_elements - (*cus)->elements_used);
+            cuStr_mem_free(arena, (*cus)->mem, (*cus)->max_elements + 1);
+        }
+        cuStr_mem_free(arena, *cus, sizeof **cus);
     }
     *cus = NULL;
 }
@@ -239,11 +469,13 @@ const char *cuStr_cstr(const cuStr *cus)
 cuStr *cuStr_clear(cuStr *cus)
 {
     assert(cus != NULL); // pre-condition
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
 
     if (cus->mem) {
         cus->mem[0] = '\0';
     }
     cus->elements_used = 0;
+    cuStrINVALIDATE_HASH(cus);
 
     return cus;
 }
@@ -251,6 +483,7 @@ cuStr *cuStr_clear(cuStr *cus)
 cuStr *cuStr_shrinktofit(cuStr *cus)
 {
     assert(cus != NULL); // pre-condition
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
 
     if (cus->max_elements > cus->elements_used) {
         char *newmem;
@@ -260,8 +493,15 @@ cuStr *cuStr_shrinktofit(cuStr *cus)
             return cuStr_dealloc_mem(cus);
         }
 
+        if (cuStrIS_INLINE(cus)) {
+            return cus;     // the inline buffer can't shrink
+        } else if (newlen <= CUSTR_SSO_CAPACITY) {
+            return cuStr_move_inline(cus);
+        }
+
         newlen++; // Room for \0
-        if ((newmem = realloc(cus->mem, newlen)) == NULL) {
+        if ((newmem = cuStr_mem_realloc(cus->arena, cus->mem,
+                                        cus->max_elements + 1, newlen)) == NULL) {
             return NULL;    // TODO: Indicate error somehow
         }
         cus->mem = newmem;
@@ -285,6 +525,7 @@ cuStr *cuStr_set_fromarray(cuStr *cus, const char *from, unsigned len)
 {
     assert(cus != NULL);   // pre-condition
     assert(from != NULL); // pre-condition
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
 
     if (len > cus->max_elements) {
         cuStr *tmp = cuStr_resize(cus, len);
@@ -294,6 +535,7 @@ cuStr *cuStr_set_fromarray(cuStr *cus, const char *from, unsigned len)
     memcpy(cus->mem, from, len);
     cus->elements_used = len;
     cus->mem[len] = '\0';
+    cuStrINVALIDATE_HASH(cus);
     return cus;
 }
 
@@ -311,109 +553,158 @@ cuStr *cuStr_append_array(cuStr *cus, const char *arr, unsigned len)
 
     assert(cus != NULL);    // pre-condition
     assert(arr != NULL); // pre-condition
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
 
     newlen = len + cus->elements_used;
     if (newlen > cus->max_elements) {
-        if (!cuStr_resize(cus, len + cus->max_elements))
+        if (!cuStr_resize(cus, newlen))
             return NULL; // TODO: should we destroy the original byte array?
     }
     memcpy(cus->mem + cus->elements_used, arr, len);
     cus->mem[newlen] = '\0';
     cus->elements_used = newlen;
+    cuStrINVALIDATE_HASH(cus);
     return cus;
 }
 
 int cuStr_printf(cuStr *cus, const char *format, ...)
 {
-    /* Limitation: vsnprintf() returns an int so the max size that
-     * this function can set the byte array to is limited by that
-     * (also considering that we always want to be able to have space
-     * for a NULL terminating character. Therefore we can't do anything more
-     * than INT_MAX - 1.
-     * For vsnprintf() to calculate how much room is needed, i.e. by passing
-     * NULL as the destination, requires at least c99.
-     */
-    size_t len;
     va_list args;
     int written_count;
 
     assert(cus != NULL && format != NULL); // pre-conditions
 
     va_start(args, format);
-    written_count = vsnprintf(NULL, 0, format, args);
-    va_end(args);
-
-    if (written_count < 0)
-        return written_count;
-
-    len = written_count;
-
-    if (cus->max_elements < len) {
-        if (!cuStr_resize(cus, len))
-            return -1;
-    }
-
-    len++;  // Additional room for the '\0' has been allocated by cuStr_resize()
-
-    va_start(args, format);
-    written_count = vsnprintf((char *)cus->mem, len, format, args);
-    if (written_count < 0)
-        return written_count;
-    cus->elements_used = written_count;
+    written_count = cuStr_vprintf(cus, format, args);
     va_end(args);
     return written_count;
 }
 
 int cuStr_printf_append(cuStr *cus, const char *format, ...)
 {
-    size_t len;
     va_list args;
     int written_count;
 
     assert(cus != NULL && format != NULL); // pre-conditions
 
     va_start(args, format);
-    written_count = vsnprintf(NULL, 0, format, args);
+    written_count = cuStr_vprintf_append(cus, format, args);
     va_end(args);
+    return written_count;
+}
 
-    if (written_count < 0)
-        return written_count;
+int cuStr_vprintf(cuStr *cus, const char *format, va_list args)
+{
+    assert(cus != NULL && format != NULL); // pre-conditions
+
+    /* If formatting fails the string is left empty */
+    cuStr_clear(cus);
+    return cuStr_vprintf_append(cus, format, args);
+}
+
+int cuStr_vprintf_append(cuStr *cus, const char *format, va_list args)
+{
+    /* Limitation: vsnprintf() returns an int so the max size that
+     * this function can set the byte array to is limited by that
+     * (also considering that we always want to be able to have space
+     * for a NULL terminating character. Therefore we can't do anything more
+     * than INT_MAX - 1.
+     *
+     * The output is formatted straight into the spare capacity. Only if it
+     * didn't fit is the string resized (vsnprintf() has told us by how
+     * much) and the output formatted a second time.
+     */
+    size_t avail;
+    va_list args_retry;
+    int written_count;
+
+    assert(cus != NULL && format != NULL); // pre-conditions
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
 
-    len = written_count + cus->elements_used;
+    va_copy(args_retry, args);
 
-    if (cus->max_elements < len) {
-        if (!cuStr_resize(cus, len))
+    /* With no memory, vsnprintf() just calculates the length (c99) */
+    avail = cus->mem ? cus->max_elements - cus->elements_used + 1 : 0;
+    written_count = vsnprintf(cus->mem ? cus->mem + cus->elements_used : NULL,
+                              avail, format, args);
+
+    if (written_count > 0 && (size_t)written_count >= avail) {
+        /* Truncated: restore the terminator that vsnprintf() overwrote in
+         * case the resize fails, then format again
+         */
+        if (cus->mem)
+            cus->mem[cus->elements_used] = '\0';
+        if (!cuStr_resize(cus, cus->elements_used + written_count)) {
+            va_end(args_retry);
             return -1;
+        }
+        written_count = vsnprintf(cus->mem + cus->elements_used,
+                                  written_count + 1, format, args_retry);
     }
+    va_end(args_retry);
 
-    len++;  // Additional room for the '\0' has been allocated by cuStr_resize()
-
-    va_start(args, format);
-    written_count = vsnprintf((char *)cus->mem + cus->elements_used, len,
-                              format, args);
-    if (written_count < 0)
+    if (written_count < 0) {
+        if (cus->mem)
+            cus->mem[cus->elements_used] = '\0';
         return written_count;
+    }
     cus->elements_used += written_count;
-    va_end(args);
+    if (written_count)
+        cuStrINVALIDATE_HASH(cus);
     return written_count;
 }
 
 void cuStr_hexdump(FILE *f, cuStr *cus, int bytesperline)
 {
-    size_t i;
+    char buf[cuStrHEXDUMP_BUFFER], *p;
+    size_t i = 0, j, k, col = 0, len = 0, line;
 
     assert(f != NULL);  // pre-condition
     assert(cus != NULL); // pre-condition
 
     if (bytesperline < 1)
         bytesperline = 8;
-
-    for (i = 0; i < cus->elements_used; i++) {
-        fprintf(f, "%02x%c", cus->mem[i],
-                !((i + 1) % bytesperline) ? '\n' : ' ' );
+    line = (size_t)bytesperline;
+
+    /* Lines are formatted into buf, which is written out whenever it fills */
+    while (i < cus->elements_used) {
+        k = line - col;
+        if (k > cus->elements_used - i)
+            k = cus->elements_used - i;
+        if (k > (sizeof buf - len) / 3)
+            k = (sizeof buf - len) / 3;
+        if (k == 0) {
+            fwrite(buf, 1, len, f);
+            len = 0;
+            continue;
+        }
+        /* Encode behind where the digits go, then spread them out with a
+         * space after each pair
+         */
+        p = buf + len;
+        cuMem_hex_encode(p + k, cus->mem + i, k);
+        for (j = 0; j < k; j++) {
+            p[3 * j] = p[k + 2 * j];
+            p[3 * j + 1] = p[k + 2 * j + 1];
+            p[3 * j + 2] = ' ';
+        }
+        i += k;
+        col += k;
+        len += 3 * k;
+        if (col == line) {
+            buf[len - 1] = '\n';
+            col = 0;
+        }
+    }
+    if (col) {
+        if (len == sizeof buf) {
+            fwrite(buf, 1, len, f);
+            len = 0;
+        }
+        buf[len++] = '\n';
     }
-    if (i % bytesperline)
-        fprintf(f, "\n");
+    if (len)
+        fwrite(buf, 1, len, f);
 }
 
 char cuStr_at(const cuStr *cus, unsigned pos)
@@ -462,12 +753,12 @@ int cuStr_cmp(const cuStr *cus1, const cuStr *cus2)
     return memcmp(cus1->mem, cus2->mem, cus1->elements_used);
 }
 
-void cuStr_rotate(cuStr *cus, int shift, unsigned n)
+void cuStr_rotate(cuStr *cus, ptrdiff_t shift, size_t n)
 {
-    bool go_left;
+    size_t left;
 
-    if (cus->elements_used < 2)
-        return;
+    assert(cus != NULL); // pre-condition
+    assert(!cuStrIS_MAPPED(cus)); // pre-condition
 
     if (n > cus->elements_used)
         n = cus->elements_used;
@@ -479,19 +770,17 @@ void cuStr_rotate(cuStr *cus, int shift, unsigned n)
     if (n < 2)
         return;
 
+    /* Negative shifts rotate left, positive ones right. The magnitude is
+     * taken in size_t so that the most negative value does not overflow.
+     */
     if (shift < 0) {
-        go_left = 1;
-        shift = -shift;
+        left = (0 - (size_t)shift) % n;
     } else {
-        go_left = 0;
+        left = (n - (size_t)shift % n) % n;
     }
-
-    shift %= n;
-    if (shift == 0)
+    if (left == 0)
         return;
 
-    if (go_left)
-        cuStr_rotate_lr(cus, -shift, n);
-    else
-        cuStr_rotate_lr(cus, shift, n);
+    cuStrINVALIDATE_HASH(cus);
+    cuMem_rotate(cus->mem, n, left);
 }
@@ -4,15 +4,47 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include "types.h"
+#include "cutil_arena.h"
 
 #define CUSTR_RESIZE_UP_EXACT       (1U << 0)
 #define CUSTR_RESIZE_UP_CHUNKED     (1U << 1)
+#define CUSTR_RESIZE_UP_GEOMETRIC   (1U << 2)   // combines with the above
+#define CUSTR_RESIZE_UP_CUSTOM      (1U << 3)   // set by cuStr_set_growth_policy()
 
 #ifndef CUSTR_DEFAULT_CHUNK_SIZE
 #   define CUSTR_DEFAULT_CHUNK_SIZE    255
 #endif
-#define CUSTR_DEFAULT_INITIAL_MEM      CUSTR_DEFAULT_CHUNK_SIZE
+
+/* Growth factor, in percent, applied to the capacity when a string using
+ * CUSTR_RESIZE_UP_GEOMETRIC (the default) has to grow
+ */
+#ifndef CUSTR_DEFAULT_GROWTH_FACTOR
+#   define CUSTR_DEFAULT_GROWTH_FACTOR 150
+#endif
+
+/* Strings of up to CUSTR_SSO_CAPACITY bytes are stored inline in the cuStr
+ * itself and only move to the heap once they outgrow it. Define it as 0 to
+ * disable the inline buffer.
+ */
+#ifndef CUSTR_SSO_CAPACITY
+#   define CUSTR_SSO_CAPACITY          23
+#endif
+
+#if CUSTR_SSO_CAPACITY > 0
+#   define CUSTR_DEFAULT_INITIAL_MEM   CUSTR_SSO_CAPACITY
+#else
+#   define CUSTR_DEFAULT_INITIAL_MEM   CUSTR_DEFAULT_CHUNK_SIZE
+#endif
+
+struct cuStr;
+
+/* Returns the capacity to grow to when at least 'required' elements are
+ * needed. Values smaller than 'required' are ignored.
+ */
+typedef size_t (*cuStrGrowthPolicy)(const struct cuStr *cus, size_t required);
 
 typedef struct cuStr {
     size_t max_elements;
@@ -20,13 +52,36 @@ typedef struct cuStr {
     char *mem;
     unsigned resize_flags;
     unsigned chunk_size;
+    unsigned growth_factor;             // percent
+    cuStrGrowthPolicy growth_policy;
+    char sso[CUSTR_SSO_CAPACITY + 1];   // inline storage; mem == sso when used
+    cuArena *arena;     // NULL if allocated from the heap
+    uint64_t hash;      // cached cuStr_hash(), 0 if not computed
+    size_t map_len;     // mem is a read-only file mapping of this size, or 0
 } cuStr;
 
 cuStr *cuStr_new(int sz);
+/* Allocate the string and its buffer from arena. The string lives until the
+ * arena is reset or destroyed; cuStr_destroy() on it is optional.
+ */
+cuStr *cuStr_new_in(cuArena *arena, int sz);
+/* The same with room for exactly sz bytes, not rounded up to a chunk, for
+ * strings that are not going to grow
+ */
+cuStr *cuStr_new_exact_in(cuArena *arena, int sz);
 cuStr *cuStr_copy(const cuStr *cus);
 void cuStr_set_chunksize (cuStr *cus, unsigned sz);
 size_t cuStr_chunksize(const cuStr *cus);
 void cuStr_set_resize_strategy(cuStr *cus, unsigned flags);
+void cuStr_set_growth_factor(cuStr *cus, unsigned percent);
+void cuStr_set_growth_policy(cuStr *cus, cuStrGrowthPolicy policy);
+cuStr *cuStr_reserve(cuStr *cus, size_t n);
+/* Make room for at least n more elements, growing by the resize strategy.
+ * The new space is at mem + elements_used.
+ */
+cuStr *cuStr_grow(cuStr *cus, size_t n);
+/* Add n bytes, already written at mem + elements_used, to the length */
+cuStr *cuStr_commit(cuStr *cus, size_t n);
 void cuStr_destroy(cuStr **cus);
 bool cuStr_isfull(const cuStr *cus);
 size_t cuStr_max_elements(const cuStr *cus);
@@ -40,11 +95,14 @@ cuStr *cuStr_append(cuStr *cus, const char *str);
 cuStr *cuStr_append_array(cuStr *cus, const char *arr, unsigned len);
 int cuStr_printf(cuStr *cus, const char *format, ...);
 int cuStr_printf_append(cuStr *cus, const char *format, ...);
+int cuStr_vprintf(cuStr *cus, const char *format, va_list args);
+int cuStr_vprintf_append(cuStr *cus, const char *format, va_list args);
 void cuStr_hexdump(FILE *f, cuStr *cus, int bytesperline);
 char cuStr_at(const cuStr *cus, unsigned pos);
 int cuStr_strcmp(const cuStr *cus1, const cuStr *cus2);
 int cuStr_strcmp_cstr(const cuStr *cus, const char *s);
 int cuStr_cmp(const cuStr *cus1, const cuStr *cus2);
-void cuStr_rotate(cuStr *cus, int shift, unsigned n);
+/* Rotate the first n characters right by shift, or left if it is negative */
+void cuStr_rotate(cuStr *cus, ptrdiff_t shift, size_t n);
 
 #endif /* CU_INCLUDE_STRING_H */
@@ -0,0 +1,282 @@
+#define _XOPEN_SOURCE 700   // IOV_MAX
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <assert.h>
+#include <sched.h>
+#include <sys/uio.h>
+#include "cutil_strlog.h"
+
+#ifndef IOV_MAX
+#   define IOV_MAX 1024
+#endif
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#define cuStrLogCACHE_LINE  64
+#define cuStrLogMIN_CAPACITY 4096
+#define cuStrLogMAX_CAPACITY ((size_t)1 << 31)
+#define cuStrLogBATCH (IOV_MAX < 1024 ? IOV_MAX : 1024)
+
+/* Every record starts with an 8-byte header at an 8-byte boundary: the
+ * size of its slot in the low 32 bits, the length of its contents above
+ * them and a flag in the top bit, set when it is published. Room that
+ * producers give up is published as records of length 0.
+ */
+#define cuStrLogPUBLISHED   ((uint64_t)1 << 63)
+#define cuStrLogSLOT(h)     ((size_t)((h) & 0xFFFFFFFFU))
+#define cuStrLogLEN(h)      ((size_t)((h) >> 32 & 0x7FFFFFFFU))
+#define cuStrLogHEADER      sizeof(uint64_t)
+
+/* head and tail only grow; their difference is the room in use. Producers
+ * share head and the consumer owns tail, so each has a cache line.
+ */
+struct cuStrLogBuffer {
+    char *ring;
+    size_t capacity;
+    char pad0[cuStrLogCACHE_LINE];
+    uint64_t head;          // bytes reserved
+    char pad1[cuStrLogCACHE_LINE - sizeof(uint64_t)];
+    uint64_t tail;          // bytes freed by the consumer
+    size_t drain_off;       // bytes of the record at tail already written
+};
+
+static uint64_t *cuStrLog_header(cuStrLogBuffer *buf, uint64_t pos)
+{
+    return (uint64_t *)(buf->ring + (pos & (buf->capacity - 1)));
+}
+
+/* Wait until the consumer has freed the ring up to end - capacity. Its
+ * writes to the room it frees happen before ours.
+ */
+static void cuStrLog_wait(cuStrLogBuffer *buf, uint64_t end)
+{
+    while (end - __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE) > buf->capacity)
+        sched_yield();
+}
+
+/* The consumer hands out freed room zeroed, so that no stale header looks
+ * published
+ */
+static void cuStrLog_free(cuStrLogBuffer *buf, uint64_t tail, size_t n)
+{
+    size_t off = (size_t)(tail & (buf->capacity - 1));
+
+    if (n == 0)
+        return;
+    if (off + n <= buf->capacity) {
+        memset(buf->ring + off, 0, n);
+    } else {
+        memset(buf->ring + off, 0, buf->capacity - off);
+        memset(buf->ring, 0, off + n - buf->capacity);
+    }
+    __atomic_store_n(&buf->tail, tail + n, __ATOMIC_RELEASE);
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStrLogBuffer *cuStrLogBuffer_new(size_t capacity)
+{
+    cuStrLogBuffer *buf;
+    size_t cap = cuStrLogMIN_CAPACITY;
+
+    if (capacity > cuStrLogMAX_CAPACITY)
+        return NULL;
+    while (cap < capacity)
+        cap *= 2;
+    if ((buf = malloc(sizeof *buf)) == NULL)
+        return NULL;
+    if ((buf->ring = calloc(1, cap)) == NULL) {
+        free(buf);
+        return NULL;
+    }
+    buf->capacity = cap;
+    buf->head = buf->tail = 0;
+    buf->drain_off = 0;
+    return buf;
+}
+
+void cuStrLogBuffer_destroy(cuStrLogBuffer **buf)
+{
+    assert(buf != NULL); // pre-condition
+
+    if (*buf) {
+        free((*buf)->ring);
+        free(*buf);
+    }
+    *buf = NULL;
+}
+
+char *cuStrLogBuffer_reserve(cuStrLogBuffer *buf, size_t len)
+{
+    uint64_t pos;
+    size_t slot, off;
+
+    assert(buf != NULL); // pre-condition
+
+    /* A slot of up to half the ring fits once it is moved to the start;
+     * a larger one could land across the end on every try
+     */
+    if (len > buf->capacity / 2 - cuStrLogHEADER)
+        return NULL;
+    slot = (cuStrLogHEADER + len + 7) & ~(size_t)7;
+
+    for (;;) {
+        pos = __atomic_fetch_add(&buf->head, slot, __ATOMIC_RELAXED);
+        cuStrLog_wait(buf, pos + slot);
+        off = (size_t)(pos & (buf->capacity - 1));
+        if (off + slot <= buf->capacity) {
+            uint64_t *header = cuStrLog_header(buf, pos);
+            __atomic_store_n(header, (uint64_t)slot, __ATOMIC_RELAXED);
+            return (char *)(header + 1);
+        }
+        /* It would run past the end of the ring: give the room back as
+         * one empty record up to the end and one from the start, and try
+         * again
+         */
+        __atomic_store_n(cuStrLog_header(buf, pos),
+                         cuStrLogPUBLISHED | (buf->capacity - off),
+                         __ATOMIC_RELEASE);
+        __atomic_store_n(cuStrLog_header(buf, 0),
+                         cuStrLogPUBLISHED | (off + slot - buf->capacity),
+                         __ATOMIC_RELEASE);
+    }
+}
+
+void cuStrLogBuffer_publish(cuStrLogBuffer *buf, char *record, size_t len)
+{
+    uint64_t *header = (uint64_t *)record - 1;
+    uint64_t slot;
+
+    assert(buf != NULL && record != NULL); // pre-conditions
+    (void)buf;
+
+    slot = __atomic_load_n(header, __ATOMIC_RELAXED);
+    assert(len + cuStrLogHEADER <= slot); // pre-condition
+    __atomic_store_n(header, cuStrLogPUBLISHED | (uint64_t)len << 32 | slot,
+                     __ATOMIC_RELEASE);
+}
+
+int cuStrLogBuffer_write(cuStrLogBuffer *buf, const cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+
+    return cuStrLogBuffer_write_array(buf, cuStr_cstr(cus), cuStr_len(cus));
+}
+
+int cuStrLogBuffer_write_array(cuStrLogBuffer *buf, const char *arr,
+                               size_t len)
+{
+    char *record;
+
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if ((record = cuStrLogBuffer_reserve(buf, len)) == NULL)
+        return -1;
+    if (len)
+        memcpy(record, arr, len);
+    cuStrLogBuffer_publish(buf, record, len);
+    return 0;
+}
+
+int cuStrLogBuffer_printf(cuStrLogBuffer *buf, const char *format, ...)
+{
+    va_list args;
+    int rc;
+
+    va_start(args, format);
+    rc = cuStrLogBuffer_vprintf(buf, format, args);
+    va_end(args);
+    return rc;
+}
+
+int cuStrLogBuffer_vprintf(cuStrLogBuffer *buf, const char *format,
+                           va_list args)
+{
+    char line[CUSTRLOGBUFFER_LINE], *record;
+    va_list copy;
+    int n;
+
+    assert(format != NULL); // pre-condition
+
+    /* Most lines are short: format them once, then reserve exactly */
+    va_copy(copy, args);
+    n = vsnprintf(line, sizeof line, format, copy);
+    va_end(copy);
+    if (n < 0)
+        return -1;
+    if ((size_t)n < sizeof line)
+        return cuStrLogBuffer_write_array(buf, line, (size_t)n);
+
+    if ((record = cuStrLogBuffer_reserve(buf, (size_t)n + 1)) == NULL)
+        return -1;
+    vsnprintf(record, (size_t)n + 1, format, args);
+    cuStrLogBuffer_publish(buf, record, (size_t)n);
+    return 0;
+}
+
+ssize_t cuStrLogBuffer_drain(cuStrLogBuffer *buf, int fd)
+{
+    struct iovec iov[cuStrLogBATCH];
+    size_t spans[cuStrLogBATCH];    // room freed with each iov entry
+    uint64_t tail, scan, header;
+    size_t n = 0, k = 0, freed = 0, len;
+    ssize_t total = 0, written = 0;
+
+    assert(buf != NULL); // pre-condition
+
+    /* Collect the records published in a row from tail. Empty ones are
+     * freed along with the record before them.
+     */
+    tail = scan = buf->tail;
+    while (n < cuStrLogBATCH && scan - tail < buf->capacity) {
+        header = __atomic_load_n(cuStrLog_header(buf, scan), __ATOMIC_ACQUIRE);
+        if (!(header & cuStrLogPUBLISHED))
+            break;
+        if ((len = cuStrLogLEN(header)) != 0) {
+            iov[n].iov_base = (char *)cuStrLog_header(buf, scan) + cuStrLogHEADER;
+            iov[n].iov_len = len;
+            spans[n++] = cuStrLogSLOT(header);
+        } else if (n) {
+            spans[n - 1] += cuStrLogSLOT(header);
+        } else {
+            freed += cuStrLogSLOT(header);
+        }
+        scan += cuStrLogSLOT(header);
+    }
+    if (n) {
+        iov[0].iov_base = (char *)iov[0].iov_base + buf->drain_off;
+        iov[0].iov_len -= buf->drain_off;
+    }
+
+    while (k < n) {
+        written = writev(fd, iov + k, (int)(n - k));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        total += written;
+        /* Free what went out in full; remember how much of the next */
+        while (k < n && (size_t)written >= iov[k].iov_len) {
+            written -= (ssize_t)iov[k].iov_len;
+            freed += spans[k++];
+            buf->drain_off = 0;
+        }
+        if (k < n) {
+            iov[k].iov_base = (char *)iov[k].iov_base + written;
+            iov[k].iov_len -= (size_t)written;
+            buf->drain_off += (size_t)written;
+        }
+    }
+    cuStrLog_free(buf, tail, freed);
+    return written < 0 && total == 0 ? -1 : total;
+}
@@ -0,0 +1,61 @@
+#ifndef CU_INCLUDE_STRLOG_H
+#define CU_INCLUDE_STRLOG_H
+
+#include <stddef.h>
+#include <stdarg.h>
+#include <sys/types.h>
+#include "cutil_string.h"
+
+/* cuStrLogBuffer_printf() formats lines of up to this many bytes on the
+ * stack and copies them in; longer ones are formatted a second time, in
+ * place
+ */
+#ifndef CUSTRLOGBUFFER_LINE
+#   define CUSTRLOGBUFFER_LINE  256
+#endif
+
+/* A bounded ring of log records for many producer threads and a single
+ * consumer. A producer reserves room for a record with one atomic
+ * fetch-and-add, fills it in without any lock and publishes it; the
+ * consumer writes out the records published so far, in reservation order,
+ * and frees their room. Records from one thread keep their order.
+ *
+ * When the ring is full, producers wait (yielding the CPU) for the
+ * consumer, which must therefore run on a thread of its own.
+ */
+typedef struct cuStrLogBuffer cuStrLogBuffer;
+
+/* The capacity is rounded up to a power of 2 of at least 4096 bytes. Each
+ * record takes its length plus 8 bytes, rounded up to a multiple of 8. A
+ * record that would run past the end of the ring is moved to its start,
+ * wasting the room it first got, so records are limited to half the
+ * capacity, header included, and should be well below that.
+ */
+cuStrLogBuffer *cuStrLogBuffer_new(size_t capacity);
+/* Records not yet drained are lost */
+void cuStrLogBuffer_destroy(cuStrLogBuffer **buf);
+
+/* Room for a record of up to len bytes, to be filled in and passed to
+ * cuStrLogBuffer_publish() with its final length. Returns NULL if the
+ * record can never fit, that is if its slot is over half the capacity.
+ */
+char *cuStrLogBuffer_reserve(cuStrLogBuffer *buf, size_t len);
+void cuStrLogBuffer_publish(cuStrLogBuffer *buf, char *record, size_t len);
+
+/* Add a record; these return 0, or -1 if it is too long for the ring */
+int cuStrLogBuffer_write(cuStrLogBuffer *buf, const cuStr *cus);
+int cuStrLogBuffer_write_array(cuStrLogBuffer *buf, const char *arr,
+                               size_t len);
+int cuStrLogBuffer_printf(cuStrLogBuffer *buf, const char *format, ...);
+int cuStrLogBuffer_vprintf(cuStrLogBuffer *buf, const char *format,
+                           va_list args);
+
+/* Consumer only: write the records published so far, up to the first one
+ * still being filled in, to fd with writev() and free their room. Returns
+ * the number of bytes written, 0 if there was nothing to write, or -1 with
+ * errno set if nothing could be written. What is not written stays in the
+ * ring for the next call, so a non-blocking fd is fine.
+ */
+ssize_t cuStrLogBuffer_drain(cuStrLogBuffer *buf, int fd);
+
+#endif /* CU_INCLUDE_STRLOG_H */
@@ -0,0 +1,443 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_strmap.h"
+#include "cutil_strhash.h"
+#include "cutil_simd.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#define cuStrMapGROUP       16
+#define cuStrMapEMPTY       ((signed char)-128)
+#define cuStrMapDELETED     ((signed char)-2)
+#define cuStrMapNOT_FOUND   ((size_t)-1)
+
+/* The top 57 bits of the hash pick where probing starts and the low 7 bits
+ * are kept in the control byte of a full slot
+ */
+#define cuStrMapH1(hash) ((size_t)((hash) >> 7))
+#define cuStrMapH2(hash) ((signed char)((hash) & 0x7F))
+
+/* Load factor of 7/8 */
+#define cuStrMapMAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+static unsigned cuStrMap_ctz(unsigned mask)
+{
+#ifdef __GNUC__
+    return __builtin_ctz(mask);
+#else
+    unsigned n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Leading zeros of a 16 bit group mask */
+static unsigned cuStrMap_clz16(unsigned mask)
+{
+#ifdef __GNUC__
+    return __builtin_clz(mask) - (sizeof(unsigned) * 8 - 16);
+#else
+    unsigned n = 0;
+    while (!(mask & 0x8000u)) {
+        mask <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Bit i of the result is set if control byte i of the group equals h2.
+ * SSE2 is the baseline wherever CU_SIMD_X86 is defined, so the choice is
+ * made at compile time.
+ */
+static unsigned cuStrMap_match(const signed char *group, signed char h2)
+{
+#ifdef CU_SIMD_X86
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+#else
+    unsigned mask = 0, i;
+    for (i = 0; i < cuStrMapGROUP; i++)
+        mask |= (unsigned)(group[i] == h2) << i;
+    return mask;
+#endif
+}
+
+/* Empty or deleted slots are the only ones with the sign bit set */
+static unsigned cuStrMap_match_free(const signed char *group)
+{
+#ifdef CU_SIMD_X86
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+    unsigned mask = 0, i;
+    for (i = 0; i < cuStrMapGROUP; i++)
+        mask |= (unsigned)(group[i] < 0) << i;
+    return mask;
+#endif
+}
+
+static void cuStrMap_set_ctrl(cuStrMap *map, size_t i, signed char c)
+{
+    map->ctrl[i] = c;
+    /* Keep the copy of the first group - 1 bytes in step so a group can be
+     * loaded at any position without wrapping
+     */
+    if (i < cuStrMapGROUP - 1)
+        map->ctrl[map->capacity + i] = c;
+}
+
+static const char *cuStrMap_slot_key(const cuStrMapSlot *slot)
+{
+    return slot->key_len <= CUSTRMAP_INLINE_KEY ? slot->key.bytes
+                                                : slot->key.heap;
+}
+
+static void cuStrMap_slot_free(cuStrMapSlot *slot)
+{
+    if (slot->key_len > CUSTRMAP_INLINE_KEY)
+        free(slot->key.heap);
+}
+
+/* Probing moves a group further each time (triangular numbers), which
+ * visits every group when the capacity is a power of 2
+ */
+static size_t cuStrMap_find(const cuStrMap *map, const char *key, size_t len,
+                            uint64_t hash)
+{
+    size_t mask = map->capacity - 1, pos, stride = 0;
+    signed char h2 = cuStrMapH2(hash);
+
+    if (map->capacity == 0)
+        return cuStrMapNOT_FOUND;
+
+    pos = cuStrMapH1(hash) & mask;
+    for (;;) {
+        const signed char *group = map->ctrl + pos;
+        unsigned match = cuStrMap_match(group, h2);
+
+        while (match) {
+            size_t i = (pos + cuStrMap_ctz(match)) & mask;
+            const cuStrMapSlot *slot = map->slots + i;
+            if (slot->key_len == len
+                && memcmp(cuStrMap_slot_key(slot), key, len) == 0)
+                return i;
+            match &= match - 1;
+        }
+        /* An empty slot ends the probe sequence of every key */
+        if (cuStrMap_match(group, cuStrMapEMPTY))
+            return cuStrMapNOT_FOUND;
+        stride += cuStrMapGROUP;
+        pos = (pos + stride) & mask;
+    }
+}
+
+/* The first empty or deleted slot on the probe sequence of hash */
+static size_t cuStrMap_find_free(const cuStrMap *map, uint64_t hash)
+{
+    size_t mask = map->capacity - 1, pos = cuStrMapH1(hash) & mask;
+    size_t stride = 0;
+
+    for (;;) {
+        unsigned match = cuStrMap_match_free(map->ctrl + pos);
+        if (match)
+            return (pos + cuStrMap_ctz(match)) & mask;
+        stride += cuStrMapGROUP;
+        pos = (pos + stride) & mask;
+    }
+}
+
+/* Move every entry into new tables of the given capacity. This also drops
+ * the deleted markers.
+ */
+static int cuStrMap_rehash(cuStrMap *map, size_t capacity)
+{
+    cuStrMap old = *map;
+    size_t i;
+
+    assert(capacity >= cuStrMapGROUP && (capacity & (capacity - 1)) == 0);
+    assert(cuStrMapMAX_LOAD(capacity) >= map->size);
+
+    map->ctrl = malloc(capacity + cuStrMapGROUP - 1);
+    map->slots = malloc(capacity * sizeof *map->slots);
+    if (!map->ctrl || !map->slots) {
+        free(map->ctrl);
+        free(map->slots);
+        *map = old;
+        return -1;
+    }
+    memset(map->ctrl, cuStrMapEMPTY, capacity + cuStrMapGROUP - 1);
+    map->capacity = capacity;
+    map->growth_left = cuStrMapMAX_LOAD(capacity) - map->size;
+
+    for (i = 0; i < old.capacity; i++) {
+        const cuStrMapSlot *slot = old.slots + i;
+        uint64_t hash;
+        size_t to;
+
+        if (old.ctrl[i] < 0)
+            continue;
+        hash = cuMem_hash(cuStrMap_slot_key(slot), slot->key_len,
+                          CUSTR_HASH_SEED);
+        to = cuStrMap_find_free(map, hash);
+        cuStrMap_set_ctrl(map, to, cuStrMapH2(hash));
+        map->slots[to] = *slot;
+    }
+    free(old.ctrl);
+    free(old.slots);
+    return 0;
+}
+
+/* The smallest capacity that holds n entries */
+static size_t cuStrMap_capacity_for(size_t n)
+{
+    size_t capacity = cuStrMapGROUP;
+
+    while (cuStrMapMAX_LOAD(capacity) < n)
+        capacity *= 2;
+    return capacity;
+}
+
+static bool cuStrMap_erase_hashed(cuStrMap *map, const char *key, size_t len,
+                                  uint64_t hash)
+{
+    size_t i = cuStrMap_find(map, key, len, hash), mask = map->capacity - 1;
+    unsigned empty_before, empty_after;
+
+    if (i == cuStrMapNOT_FOUND)
+        return false;
+
+    cuStrMap_slot_free(map->slots + i);
+    map->size--;
+
+    /* If no 16 byte window through this slot was ever full, no probe can
+     * have moved past it, so it can go straight back to empty
+     */
+    empty_before = cuStrMap_match(map->ctrl + ((i - cuStrMapGROUP) & mask),
+                                  cuStrMapEMPTY);
+    empty_after = cuStrMap_match(map->ctrl + i, cuStrMapEMPTY);
+    if (empty_before && empty_after
+        && cuStrMap_clz16(empty_before) + cuStrMap_ctz(empty_after)
+           < cuStrMapGROUP) {
+        cuStrMap_set_ctrl(map, i, cuStrMapEMPTY);
+        map->growth_left++;
+    } else {
+        cuStrMap_set_ctrl(map, i, cuStrMapDELETED);
+    }
+    return true;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStrMap *cuStrMap_new(size_t n)
+{
+    cuStrMap *map;
+
+    if ((map = malloc(sizeof *map)) != NULL) {
+        memset(map, 0, sizeof *map);
+        if (n > 0 && cuStrMap_reserve(map, n) != 0) {
+            free(map);
+            map = NULL;
+        }
+    }
+
+    return map;
+}
+
+void cuStrMap_destroy(cuStrMap **map)
+{
+    assert(map != NULL); // pre-condition
+
+    if (*map) {
+        cuStrMap_clear(*map);
+        free((*map)->ctrl);
+        free((*map)->slots);
+        free(*map);
+    }
+    *map = NULL;
+}
+
+size_t cuStrMap_size(const cuStrMap *map)
+{
+    assert(map != NULL); // pre-condition
+    return map->size;
+}
+
+void cuStrMap_clear(cuStrMap *map)
+{
+    size_t i;
+
+    assert(map != NULL); // pre-condition
+
+    if (map->capacity == 0)
+        return;
+    for (i = 0; i < map->capacity; i++) {
+        if (map->ctrl[i] >= 0)
+            cuStrMap_slot_free(map->slots + i);
+    }
+    memset(map->ctrl, cuStrMapEMPTY, map->capacity + cuStrMapGROUP - 1);
+    map->size = 0;
+    map->growth_left = cuStrMapMAX_LOAD(map->capacity);
+}
+
+int cuStrMap_reserve(cuStrMap *map, size_t n)
+{
+    size_t capacity;
+
+    assert(map != NULL); // pre-condition
+
+    capacity = cuStrMap_capacity_for(n);
+    if (capacity <= map->capacity)
+        return 0;
+    return cuStrMap_rehash(map, capacity);
+}
+
+int cuStrMap_put(cuStrMap *map, const cuStr *key, void *value)
+{
+    assert(map != NULL && key != NULL); // pre-conditions
+
+    return cuStrMap_put_hashed(map, cuStr_cstr(key), cuStr_len(key),
+                               cuStr_hash(key), value);
+}
+
+int cuStrMap_put_array(cuStrMap *map, const char *key, size_t len,
+                       void *value)
+{
+    assert(map != NULL); // pre-condition
+    assert(key != NULL || len == 0); // pre-condition
+
+    return cuStrMap_put_hashed(map, key, len,
+                               cuMem_hash(key, len, CUSTR_HASH_SEED), value);
+}
+
+int cuStrMap_put_hashed(cuStrMap *map, const char *key, size_t len,
+                        uint64_t hash, void *value)
+{
+    cuStrMapSlot *slot;
+    size_t i;
+
+    assert(map != NULL); // pre-condition
+    assert(key != NULL || len == 0); // pre-condition
+
+    if ((i = cuStrMap_find(map, key, len, hash)) != cuStrMapNOT_FOUND) {
+        map->slots[i].value = value;
+        return 0;
+    }
+
+    if (map->capacity == 0) {
+        if (cuStrMap_rehash(map, cuStrMapGROUP) != 0)
+            return -1;
+    }
+    i = cuStrMap_find_free(map, hash);
+    if (map->growth_left == 0 && map->ctrl[i] == cuStrMapEMPTY) {
+        /* Out of empty slots. If deleted ones make up much of the load,
+         * rehashing at the same capacity is enough.
+         */
+        size_t capacity = map->capacity;
+        if (map->size + 1 > cuStrMapMAX_LOAD(capacity) / 2)
+            capacity *= 2;
+        if (cuStrMap_rehash(map, capacity) != 0)
+            return -1;
+        i = cuStrMap_find_free(map, hash);
+    }
+
+    slot = map->slots + i;
+    if (len > CUSTRMAP_INLINE_KEY) {
+        if ((slot->key.heap = malloc(len + 1)) == NULL)
+            return -1;
+        memcpy(slot->key.heap, key, len);
+        slot->key.heap[len] = '\0';
+    } else {
+        memcpy(slot->key.bytes, key, len);
+        slot->key.bytes[len] = '\0';
+    }
+    slot->key_len = len;
+    slot->value = value;
+
+    if (map->ctrl[i] == cuStrMapEMPTY)
+        map->growth_left--;
+    cuStrMap_set_ctrl(map, i, cuStrMapH2(hash));
+    map->size++;
+    return 0;
+}
+
+void **cuStrMap_get(const cuStrMap *map, const cuStr *key)
+{
+    size_t i;
+
+    assert(map != NULL && key != NULL); // pre-conditions
+
+    i = cuStrMap_find(map, cuStr_cstr(key), cuStr_len(key), cuStr_hash(key));
+    return i == cuStrMapNOT_FOUND ? NULL : &map->slots[i].value;
+}
+
+void **cuStrMap_get_array(const cuStrMap *map, const char *key, size_t len)
+{
+    size_t i;
+
+    assert(map != NULL); // pre-condition
+    assert(key != NULL || len == 0); // pre-condition
+
+    i = cuStrMap_find(map, key, len, cuMem_hash(key, len, CUSTR_HASH_SEED));
+    return i == cuStrMapNOT_FOUND ? NULL : &map->slots[i].value;
+}
+
+void **cuStrMap_get_hashed(const cuStrMap *map, const char *key, size_t len,
+                          uint64_t hash)
+{
+    size_t i;
+
+    assert(map != NULL); // pre-condition
+    assert(key != NULL || len == 0); // pre-condition
+
+    i = cuStrMap_find(map, key, len, hash);
+    return i == cuStrMapNOT_FOUND ? NULL : &map->slots[i].value;
+}
+
+bool cuStrMap_erase(cuStrMap *map, const cuStr *key)
+{
+    assert(map != NULL && key != NULL); // pre-conditions
+
+    return cuStrMap_erase_hashed(map, cuStr_cstr(key), cuStr_len(key),
+                                 cuStr_hash(key));
+}
+
+bool cuStrMap_erase_array(cuStrMap *map, const char *key, size_t len)
+{
+    assert(map != NULL); // pre-condition
+    assert(key != NULL || len == 0); // pre-condition
+
+    return cuStrMap_erase_hashed(map, key, len,
+                                 cuMem_hash(key, len, CUSTR_HASH_SEED));
+}
+
+bool cuStrMap_next(const cuStrMap *map, size_t *pos, const char **key,
+                   size_t *len, void **value)
+{
+    size_t i;
+
+    assert(map != NULL && pos != NULL); // pre-conditions
+
+    for (i = *pos; i < map->capacity; i++) {
+        if (map->ctrl[i] >= 0) {
+            const cuStrMapSlot *slot = map->slots + i;
+            if (key)
+                *key = cuStrMap_slot_key(slot);
+            if (len)
+                *len = slot->key_len;
+            if (value)
+                *value = slot->value;
+            *pos = i + 1;
+            return true;
+        }
+    }
+    *pos = map->capacity;
+    return false;
+}
@@ -0,0 +1,75 @@
+#ifndef CU_INCLUDE_STRMAP_H
+#define CU_INCLUDE_STRMAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "cutil_string.h"
+
+/* Keys of up to CUSTRMAP_INLINE_KEY bytes are stored in the slot itself;
+ * longer keys are copied to the heap.
+ */
+#ifndef CUSTRMAP_INLINE_KEY
+#define CUSTRMAP_INLINE_KEY 15
+#endif
+
+/* A copy of the key, always followed by a '\0' */
+typedef struct cuStrMapSlot {
+    size_t key_len;
+    union {
+        char *heap;
+        char bytes[CUSTRMAP_INLINE_KEY + 1];
+    } key;
+    void *value;
+} cuStrMapSlot;
+
+/* Hash map from strings to pointers using open addressing. A control byte
+ * per slot holds 7 bits of the key's hash, or marks it empty or deleted,
+ * and lookups compare a group of 16 control bytes at a time. Keys compare
+ * over their full length, including any embedded '\0' bytes.
+ */
+typedef struct cuStrMap {
+    signed char *ctrl;      // capacity + 15 bytes; the first 15 repeat at the end
+    cuStrMapSlot *slots;
+    size_t capacity;        // power of 2, or 0 before the first insert
+    size_t size;
+    size_t growth_left;     // inserts into empty slots before a rehash
+} cuStrMap;
+
+cuStrMap *cuStrMap_new(size_t n);
+void cuStrMap_destroy(cuStrMap **map);
+size_t cuStrMap_size(const cuStrMap *map);
+void cuStrMap_clear(cuStrMap *map);
+/* Make room for n entries without rehashing */
+int cuStrMap_reserve(cuStrMap *map, size_t n);
+
+/* Insert or replace; returns 0 or -1 if out of memory */
+int cuStrMap_put(cuStrMap *map, const cuStr *key, void *value);
+int cuStrMap_put_array(cuStrMap *map, const char *key, size_t len,
+                       void *value);
+
+/* A pointer to the value stored for key, or NULL if there is none. The
+ * pointer is valid until the next insert or erase.
+ */
+void **cuStrMap_get(const cuStrMap *map, const cuStr *key);
+void **cuStrMap_get_array(const cuStrMap *map, const char *key, size_t len);
+
+/* The same with the key's hash supplied by the caller, who may already have
+ * it. It must equal cuMem_hash(key, len, CUSTR_HASH_SEED).
+ */
+int cuStrMap_put_hashed(cuStrMap *map, const char *key, size_t len,
+                        uint64_t hash, void *value);
+void **cuStrMap_get_hashed(const cuStrMap *map, const char *key, size_t len,
+                          uint64_t hash);
+
+/* Returns true if the key was present */
+bool cuStrMap_erase(cuStrMap *map, const cuStr *key);
+bool cuStrMap_erase_array(cuStrMap *map, const char *key, size_t len);
+
+/* Visit every entry in an unspecified order: start with *pos = 0 and call
+ * until it returns false. The map must not change during the iteration.
+ */
+bool cuStrMap_next(const cuStrMap *map, size_t *pos, const char **key,
+                   size_t *len, void **value);
+
+#endif /* CU_INCLUDE_STRMAP_H */
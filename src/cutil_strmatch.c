@@ -0,0 +1,569 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "cutil_strmatch.h"
+#include "cutil_simd.h"
+#include "cutil_simd_byteset.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#define cuStrMatchBUCKETS       8
+
+/* The prefilter is given up for the rest of a scan after this many calls
+ * in a row that skip fewer than cuStrMatchSHORT_SKIP bytes, as the
+ * automaton is then faster on its own
+ */
+#define cuStrMatchSHORT_SKIP    8
+#define cuStrMatchMAX_MISSES    32
+
+/* Build time state: the trie with its transitions completed in place, the
+ * failure links, the breadth first order of the states and the patterns
+ * that end at each state
+ */
+typedef struct cuStrMatchBuild {
+    uint32_t *trie;             // nstates rows of nclasses; 0 is no child
+    uint32_t *fail;
+    uint32_t *order;
+    uint32_t *own;              // first pattern ending at the state, + 1
+    uint32_t *own_next;         // next pattern ending at the same state, + 1
+    uint32_t *count;            // matches at the state, with its fail chain
+    uint32_t *depth;
+    uint32_t *renumber;
+    size_t nstates;
+} cuStrMatchBuild;
+
+static void cuStrMatch_build_free(cuStrMatchBuild *b)
+{
+    free(b->trie);
+    free(b->fail);
+    free(b->order);
+    free(b->own);
+    free(b->own_next);
+    free(b->count);
+    free(b->depth);
+    free(b->renumber);
+}
+
+/* A class for each byte used by the patterns, in byte order */
+static void cuStrMatcher_set_classes(cuStrMatcher *m,
+                                     const char *const *patterns,
+                                     const size_t *lengths, size_t n)
+{
+    size_t i, k;
+
+    for (i = 0; i < n; i++) {
+        for (k = 0; k < lengths[i]; k++)
+            m->classes[(unsigned char)patterns[i][k]] = 1;
+    }
+    m->nclasses = 1;
+    for (i = 0; i < 256; i++) {
+        if (m->classes[i])
+            m->classes[i] = (unsigned char)m->nclasses++;
+    }
+    m->width = m->nclasses + 1;
+}
+
+static bool cuStrMatch_build_trie(cuStrMatchBuild *b, const cuStrMatcher *m,
+                                  const char *const *patterns, size_t n)
+{
+    const size_t w = m->nclasses;
+    size_t i, k, total = 1;
+
+    /* The final rows, with their depth, are indexed with 32 bits */
+    for (i = 0; i < n; i++) {
+        if (m->lengths[i] > UINT32_MAX / m->width - total)
+            return false;
+        total += m->lengths[i];
+    }
+    b->trie = calloc(total * w, sizeof *b->trie);
+    b->own = calloc(total, sizeof *b->own);
+    b->own_next = malloc((n ? n : 1) * sizeof *b->own_next);
+    b->depth = calloc(total, sizeof *b->depth);
+    if (!b->trie || !b->own || !b->own_next || !b->depth)
+        return false;
+
+    b->nstates = 1;
+    for (i = n; i-- > 0;) {
+        uint32_t s = 0;
+        for (k = 0; k < m->lengths[i]; k++) {
+            unsigned char c = m->classes[(unsigned char)patterns[i][k]];
+            uint32_t *t = &b->trie[s * w + c];
+            if (*t == 0) {
+                b->depth[b->nstates] = (uint32_t)k + 1;
+                *t = (uint32_t)b->nstates++;
+            }
+            s = *t;
+        }
+        /* Built from the last pattern so that each list is in id order */
+        b->own_next[i] = b->own[s];
+        b->own[s] = (uint32_t)i + 1;
+    }
+    return true;
+}
+
+/* Failure links in breadth first order; each missing transition becomes
+ * the one of the failure state, which is shallower and so done already
+ */
+static bool cuStrMatch_build_links(cuStrMatchBuild *b, size_t w)
+{
+    size_t head = 0, tail = 0, c;
+    uint32_t i;
+
+    b->fail = calloc(b->nstates, sizeof *b->fail);
+    b->order = malloc(b->nstates * sizeof *b->order);
+    b->count = calloc(b->nstates, sizeof *b->count);
+    if (!b->fail || !b->order || !b->count)
+        return false;
+
+    b->order[tail++] = 0;
+    while (head < tail) {
+        uint32_t s = b->order[head++];
+        uint32_t *row = &b->trie[s * w];
+
+        for (i = b->own[s]; i != 0; i = b->own_next[i - 1])
+            b->count[s]++;
+        if (s != 0)
+            b->count[s] += b->count[b->fail[s]];
+        for (c = 0; c < w; c++) {
+            if (row[c] != 0) {
+                b->fail[row[c]] = s == 0 ? 0 : b->trie[b->fail[s] * w + c];
+                b->order[tail++] = row[c];
+            } else if (s != 0) {
+                row[c] = b->trie[b->fail[s] * w + c];
+            }
+        }
+    }
+    return true;
+}
+
+/* The final table: states without matches first, in breadth first order
+ * with the root at 0, then the ones with matches. Each row ends with the
+ * depth of its state. Each match state lists its own patterns and then
+ * those of its failure state.
+ */
+static bool cuStrMatcher_set_table(cuStrMatcher *m, cuStrMatchBuild *b)
+{
+    const size_t nc = m->nclasses, w = m->width;
+    size_t i, c, id = 0, nmatch, nout = 0, k = 0;
+    uint32_t p;
+
+    b->renumber = malloc(b->nstates * sizeof *b->renumber);
+    if (!b->renumber)
+        return false;
+    for (i = 0; i < b->nstates; i++) {
+        if (b->count[b->order[i]] == 0)
+            b->renumber[b->order[i]] = (uint32_t)id++;
+    }
+    m->match_row = (uint32_t)(id * w);
+    nmatch = b->nstates - id;
+    for (i = 0; i < b->nstates; i++) {
+        if (b->count[b->order[i]] != 0) {
+            b->renumber[b->order[i]] = (uint32_t)id++;
+            nout += b->count[b->order[i]];
+        }
+    }
+
+    m->next = malloc(b->nstates * w * sizeof *m->next);
+    m->out_start = malloc((nmatch + 1) * sizeof *m->out_start);
+    m->out = malloc((nout ? nout : 1) * sizeof *m->out);
+    if (!m->next || !m->out_start || !m->out)
+        return false;
+
+    for (i = 0; i < b->nstates; i++) {
+        uint32_t *row = &m->next[b->renumber[i] * w];
+        for (c = 0; c < nc; c++)
+            row[c] = (uint32_t)(b->renumber[b->trie[i * nc + c]] * w);
+        row[nc] = b->depth[i];
+    }
+    nout = 0;
+    for (i = 0; i < b->nstates; i++) {
+        uint32_t s = b->order[i], f = b->fail[s];
+        if (b->count[s] == 0)
+            continue;
+        m->out_start[k++] = (uint32_t)nout;
+        for (p = b->own[s]; p != 0; p = b->own_next[p - 1])
+            m->out[nout++] = p - 1;
+        if (s != 0 && b->count[f] != 0) {
+            size_t fk = (b->renumber[f] * w - m->match_row) / w;
+            memcpy(m->out + nout, m->out + m->out_start[fk],
+                   b->count[f] * sizeof *m->out);
+            nout += b->count[f];
+        }
+    }
+    m->out_start[k] = (uint32_t)nout;
+    return true;
+}
+
+/* The bytes that start patterns, as a table and as a byte set of
+ * cutil_simd_byteset.h. Small sets also get Teddy masks: a pattern in
+ * bucket k sets bit k of the masks for the low and high nibbles of each of
+ * its first teddy_len bytes, and patterns with the same first bytes share
+ * a bucket.
+ */
+static void cuStrMatcher_set_prefilter(cuStrMatcher *m,
+                                       const char *const *patterns, size_t n)
+{
+    size_t i, k, shortest = (size_t)-1;
+
+    for (i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)patterns[i][0];
+        m->start[c] = 1;
+        m->start_rows[(c & 0x0F) | (c >> 3 & 0x10)] |=
+            (unsigned char)(1U << (c >> 4 & 7));
+        if (m->lengths[i] < shortest)
+            shortest = m->lengths[i];
+    }
+    if (n == 0 || n > CUSTRMATCH_TEDDY_MAX)
+        return;
+
+    m->teddy_len = shortest < 3 ? (unsigned)shortest : 3;
+    for (i = 0; i < n; i++) {
+        unsigned hash = 0, bit;
+        for (k = 0; k < m->teddy_len; k++)
+            hash = hash * 31 + (unsigned char)patterns[i][k];
+        bit = 1U << hash % cuStrMatchBUCKETS;
+        for (k = 0; k < m->teddy_len; k++) {
+            unsigned char c = (unsigned char)patterns[i][k];
+            m->teddy[k][0][c & 0x0F] |= (unsigned char)bit;
+            m->teddy[k][1][c >> 4] |= (unsigned char)bit;
+        }
+    }
+}
+
+#ifdef CU_SIMD_X86
+
+/* These return the first position from i at which a pattern may start, or
+ * where the bytes left are too few for a whole block
+ */
+CU_TARGET_SSSE3
+static size_t cuStrMatcher_teddy_ssse3(const cuStrMatcher *m, const char *s,
+                                       size_t n, size_t i)
+{
+    const __m128i low4 = _mm_set1_epi8(0x0F);
+    const size_t len = m->teddy_len;
+    __m128i lo[3], hi[3];
+    size_t k;
+
+    for (k = 0; k < 3; k++) {
+        lo[k] = _mm_loadu_si128((const __m128i *)m->teddy[k][0]);
+        hi[k] = _mm_loadu_si128((const __m128i *)m->teddy[k][1]);
+    }
+    for (; i + 16 + len - 1 <= n; i += 16) {
+        __m128i r = _mm_set1_epi8(-1);
+        unsigned mask;
+
+        for (k = 0; k < len; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(s + i + k));
+            __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), low4);
+            __m128i low = _mm_and_si128(v, low4);
+            r = _mm_and_si128(r, _mm_shuffle_epi8(lo[k], low));
+            r = _mm_and_si128(r, _mm_shuffle_epi8(hi[k], high));
+        }
+        r = _mm_cmpeq_epi8(r, _mm_setzero_si128());
+        mask = ~(unsigned)_mm_movemask_epi8(r) & 0xFFFF;
+        if (mask)
+            return i + (size_t)__builtin_ctz(mask);
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuStrMatcher_teddy_avx2(const cuStrMatcher *m, const char *s,
+                                      size_t n, size_t i)
+{
+    const __m256i low4 = _mm256_set1_epi8(0x0F);
+    const size_t len = m->teddy_len;
+    __m256i lo[3], hi[3];
+    size_t k;
+
+    for (k = 0; k < 3; k++) {
+        __m128i t = _mm_loadu_si128((const __m128i *)m->teddy[k][0]);
+        lo[k] = _mm256_broadcastsi128_si256(t);
+        t = _mm_loadu_si128((const __m128i *)m->teddy[k][1]);
+        hi[k] = _mm256_broadcastsi128_si256(t);
+    }
+    for (; i + 32 + len - 1 <= n; i += 32) {
+        __m256i r = _mm256_set1_epi8(-1);
+        unsigned mask;
+
+        for (k = 0; k < len; k++) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(s + i + k));
+            __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low4);
+            __m256i low = _mm256_and_si256(v, low4);
+            r = _mm256_and_si256(r, _mm256_shuffle_epi8(lo[k], low));
+            r = _mm256_and_si256(r, _mm256_shuffle_epi8(hi[k], high));
+        }
+        r = _mm256_cmpeq_epi8(r, _mm256_setzero_si256());
+        mask = ~(unsigned)_mm256_movemask_epi8(r);
+        if (mask)
+            return i + (size_t)__builtin_ctz(mask);
+    }
+    return i;
+}
+
+/* Membership in the byte set of first bytes */
+CU_TARGET_SSSE3
+static size_t cuStrMatcher_start_ssse3(const cuStrMatcher *m, const char *s,
+                                       size_t n, size_t i)
+{
+    const __m128i *rows = (const __m128i *)m->start_rows;
+    const __m128i rows_low = _mm_loadu_si128(rows);
+    const __m128i rows_high = _mm_loadu_si128(rows + 1);
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        unsigned mask;
+
+        v = cu_byteset_absent_ssse3(v, rows_low, rows_high);
+        mask = ~(unsigned)_mm_movemask_epi8(v) & 0xFFFF;
+        if (mask)
+            return i + (size_t)__builtin_ctz(mask);
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuStrMatcher_start_avx2(const cuStrMatcher *m, const char *s,
+                                      size_t n, size_t i)
+{
+    const __m128i *rows = (const __m128i *)m->start_rows;
+    const __m256i rows_low = _mm256_broadcastsi128_si256(_mm_loadu_si128(rows));
+    const __m256i rows_high =
+        _mm256_broadcastsi128_si256(_mm_loadu_si128(rows + 1));
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        unsigned mask;
+
+        v = cu_byteset_absent_avx2(v, rows_low, rows_high);
+        mask = ~(unsigned)_mm256_movemask_epi8(v);
+        if (mask)
+            return i + (size_t)__builtin_ctz(mask);
+    }
+    return i;
+}
+
+#endif /* CU_SIMD_X86 */
+
+/* The first position from i at which a pattern starts, or n. Teddy finds
+ * candidates, which the table of first bytes then checks.
+ */
+static size_t cuStrMatcher_skip(const cuStrMatcher *m, const char *s, size_t n,
+                                size_t i)
+{
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_SSSE3) {
+        const bool avx2 = (features & CU_CPU_AVX2) != 0;
+        const size_t tail = (avx2 ? 32 : 16)
+                            + (m->teddy_len ? m->teddy_len - 1 : 0);
+
+        while (i + tail <= n) {
+            if (m->teddy_len && avx2)
+                i = cuStrMatcher_teddy_avx2(m, s, n, i);
+            else if (m->teddy_len)
+                i = cuStrMatcher_teddy_ssse3(m, s, n, i);
+            else if (avx2)
+                i = cuStrMatcher_start_avx2(m, s, n, i);
+            else
+                i = cuStrMatcher_start_ssse3(m, s, n, i);
+            if (i + tail > n || m->start[(unsigned char)s[i]])
+                break;
+            i++;
+        }
+    }
+#endif
+    while (i < n && !m->start[(unsigned char)s[i]])
+        i++;
+    return i;
+}
+
+/* Reports the matches of a match state ending before offset end. Returns
+ * true if fn stops the scan.
+ */
+static inline bool cuStrMatcher_report(const cuStrMatcher *m, uint32_t st,
+                                       size_t end, cuStrMatchFn fn, void *ctx,
+                                       size_t *count)
+{
+    size_t row = (st - m->match_row) / m->width, k;
+
+    for (k = m->out_start[row]; k < m->out_start[row + 1]; k++) {
+        ++*count;
+        if (fn(ctx, m->out[k], end - m->lengths[m->out[k]]) != 0)
+            return true;
+    }
+    return false;
+}
+
+/* Runs the automaton from *state over s, whose first byte is at offset
+ * base of the input. cand is the next position at which the prefilter
+ * allows a pattern to start and live is one past the last one passed. A
+ * match under way started depth bytes back; once that is before live, no
+ * match can have started between there and cand, so the scan goes back to
+ * the root and skips to cand. A prefilter that keeps stopping after a few
+ * bytes is dropped.
+ */
+static size_t cuStrMatcher_run(const cuStrMatcher *m, uint32_t *state,
+                               const char *s, size_t n, size_t base,
+                               cuStrMatchFn fn, void *ctx)
+{
+    const uint32_t *next = m->next;
+    const size_t depth = m->nclasses;
+    uint32_t st = *state;
+    size_t i = 0, count = 0, live = 0, misses = 0, cand;
+
+    cand = cuStrMatcher_skip(m, s, n, 0);
+    while (i < n) {
+        if (i == cand) {
+            live = i + 1;
+            cand = cuStrMatcher_skip(m, s, n, i + 1);
+            misses = cand - i < cuStrMatchSHORT_SKIP ? misses + 1 : 0;
+            if (misses > cuStrMatchMAX_MISSES)
+                break;
+        } else if (live + next[st + depth] <= i) {
+            st = 0;
+            i = cand;
+            continue;
+        }
+        st = next[st + m->classes[(unsigned char)s[i++]]];
+        if (st >= m->match_row
+            && cuStrMatcher_report(m, st, base + i, fn, ctx, &count)) {
+            *state = st;
+            return count;
+        }
+    }
+    while (i < n) {
+        st = next[st + m->classes[(unsigned char)s[i++]]];
+        if (st >= m->match_row
+            && cuStrMatcher_report(m, st, base + i, fn, ctx, &count))
+            break;
+    }
+    *state = st;
+    return count;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStrMatcher *cuStrMatcher_new_arrays(const char *const *patterns,
+                                      const size_t *lengths, size_t n)
+{
+    cuStrMatchBuild b;
+    cuStrMatcher *m;
+    size_t i;
+
+    assert(patterns != NULL || n == 0); // pre-condition
+    assert(lengths != NULL || n == 0); // pre-condition
+
+    memset(&b, 0, sizeof b);
+    if ((m = calloc(1, sizeof *m)) == NULL)
+        return NULL;
+    m->npatterns = n;
+    if ((m->lengths = malloc((n ? n : 1) * sizeof *m->lengths)) == NULL)
+        goto fail;
+    for (i = 0; i < n; i++) {
+        assert(lengths[i] > 0 && patterns[i] != NULL); // pre-condition
+        m->lengths[i] = lengths[i];
+    }
+
+    cuStrMatcher_set_classes(m, patterns, lengths, n);
+    if (!cuStrMatch_build_trie(&b, m, patterns, n)
+        || !cuStrMatch_build_links(&b, m->nclasses)
+        || !cuStrMatcher_set_table(m, &b))
+        goto fail;
+    cuStrMatcher_set_prefilter(m, patterns, n);
+    cuStrMatch_build_free(&b);
+    return m;
+
+fail:
+    cuStrMatch_build_free(&b);
+    cuStrMatcher_destroy(&m);
+    return NULL;
+}
+
+cuStrMatcher *cuStrMatcher_new(const cuStr *const *patterns, size_t n)
+{
+    const char **arrays;
+    size_t *lengths, i;
+    cuStrMatcher *m = NULL;
+
+    assert(patterns != NULL || n == 0); // pre-condition
+
+    arrays = malloc((n ? n : 1) * sizeof *arrays);
+    lengths = malloc((n ? n : 1) * sizeof *lengths);
+    if (arrays && lengths) {
+        for (i = 0; i < n; i++) {
+            arrays[i] = cuStr_cstr(patterns[i]);
+            lengths[i] = cuStr_len(patterns[i]);
+        }
+        m = cuStrMatcher_new_arrays(arrays, lengths, n);
+    }
+    free(arrays);
+    free(lengths);
+    return m;
+}
+
+void cuStrMatcher_destroy(cuStrMatcher **matcher)
+{
+    assert(matcher != NULL); // pre-condition
+
+    if (*matcher) {
+        free((*matcher)->next);
+        free((*matcher)->out_start);
+        free((*matcher)->out);
+        free((*matcher)->lengths);
+        free(*matcher);
+    }
+    *matcher = NULL;
+}
+
+size_t cuStrMatcher_scan_array(const cuStrMatcher *matcher, const char *s,
+                               size_t n, cuStrMatchFn fn, void *ctx)
+{
+    uint32_t state = 0;
+
+    assert(matcher != NULL); // pre-condition
+    assert(s != NULL || n == 0); // pre-condition
+    assert(fn != NULL); // pre-condition
+
+    return cuStrMatcher_run(matcher, &state, s, n, 0, fn, ctx);
+}
+
+size_t cuStrMatcher_scan(const cuStrMatcher *matcher, const cuStr *cus,
+                         cuStrMatchFn fn, void *ctx)
+{
+    assert(cus != NULL); // pre-condition
+
+    return cuStrMatcher_scan_array(matcher, cus->mem, cus->elements_used,
+                                   fn, ctx);
+}
+
+void cuStrMatchStream_init(cuStrMatchStream *stream,
+                           const cuStrMatcher *matcher)
+{
+    assert(stream != NULL); // pre-condition
+    assert(matcher != NULL); // pre-condition
+
+    stream->matcher = matcher;
+    stream->state = 0;
+    stream->offset = 0;
+}
+
+size_t cuStrMatchStream_feed(cuStrMatchStream *stream, const char *s, size_t n,
+                             cuStrMatchFn fn, void *ctx)
+{
+    size_t count;
+
+    assert(stream != NULL && stream->matcher != NULL); // pre-condition
+    assert(s != NULL || n == 0); // pre-condition
+    assert(fn != NULL); // pre-condition
+
+    count = cuStrMatcher_run(stream->matcher, &stream->state, s, n,
+                             stream->offset, fn, ctx);
+    stream->offset += n;
+    return count;
+}
@@ -0,0 +1,78 @@
+#ifndef CU_INCLUDE_STRMATCH_H
+#define CU_INCLUDE_STRMATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cutil_string.h"
+
+/* Sets of up to CUSTRMATCH_TEDDY_MAX patterns skip ahead with a Teddy
+ * fingerprint of their first bytes; larger sets skip to the bytes that
+ * start a pattern.
+ */
+#ifndef CUSTRMATCH_TEDDY_MAX
+#   define CUSTRMATCH_TEDDY_MAX     64
+#endif
+
+/* Finds every occurrence of a set of patterns in one pass (Aho-Corasick).
+ * The automaton is a table of transitions over classes of bytes: the bytes
+ * that appear in the patterns each have a class and all others share
+ * class 0, so a row is a few dozen entries rather than 256. Entries hold
+ * the row offset of the next state, and the states with matches come
+ * last, so that a step is one load and one compare. The last entry of a
+ * row is the depth of its state, which tells the scan when no match under
+ * way can have started where the prefilter allows one.
+ */
+typedef struct cuStrMatcher {
+    uint32_t *next;             // rows of width entries
+    uint32_t nclasses;
+    uint32_t width;             // nclasses + 1 for the depth
+    uint32_t match_row;         // offset of the first state with matches
+    uint32_t *out_start;        // per state with matches, into out
+    uint32_t *out;              // pattern ids
+    size_t *lengths;            // per pattern
+    size_t npatterns;
+    unsigned char classes[256];
+    unsigned char start[256];   // 1 for the first bytes of patterns
+    unsigned char start_rows[32];       // the same as a bitmap for SIMD
+    unsigned char teddy[3][2][16];      // low and high nibble masks
+    unsigned teddy_len;         // fingerprint length, 0 without Teddy
+} cuStrMatcher;
+
+/* Called for each match with the pattern's index and the offset of its
+ * first byte. Returning non-zero stops the scan.
+ */
+typedef int (*cuStrMatchFn)(void *ctx, size_t id, size_t offset);
+
+/* Compile n patterns, none of them empty; the id of each match is its
+ * index. Returns NULL if out of memory.
+ */
+cuStrMatcher *cuStrMatcher_new(const cuStr *const *patterns, size_t n);
+cuStrMatcher *cuStrMatcher_new_arrays(const char *const *patterns,
+                                      const size_t *lengths, size_t n);
+void cuStrMatcher_destroy(cuStrMatcher **matcher);
+
+/* Report every match, overlapping ones included, in the order of the
+ * position of their last byte; matches that end together are reported
+ * longest first. Returns the number of matches reported.
+ */
+size_t cuStrMatcher_scan(const cuStrMatcher *matcher, const cuStr *cus,
+                         cuStrMatchFn fn, void *ctx);
+size_t cuStrMatcher_scan_array(const cuStrMatcher *matcher, const char *s,
+                               size_t n, cuStrMatchFn fn, void *ctx);
+
+/* The same over input that arrives in pieces, finding matches that span
+ * them. Offsets count from the start of the stream. After fn stops a
+ * scan the stream has to be started again.
+ */
+typedef struct cuStrMatchStream {
+    const cuStrMatcher *matcher;
+    uint32_t state;
+    size_t offset;              // bytes fed so far
+} cuStrMatchStream;
+
+void cuStrMatchStream_init(cuStrMatchStream *stream,
+                           const cuStrMatcher *matcher);
+size_t cuStrMatchStream_feed(cuStrMatchStream *stream, const char *s, size_t n,
+                             cuStrMatchFn fn, void *ctx);
+
+#endif /* CU_INCLUDE_STRMATCH_H */
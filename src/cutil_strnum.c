@@ -0,0 +1,601 @@
+#define _GNU_SOURCE         // strtod_l() on glibc
+
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <assert.h>
+#include "cutil_strnum.h"
+
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+#   define CUSTRNUM_HAVE_STRTOD_L
+#   ifdef __APPLE__
+#       include <xlocale.h>
+#   endif
+#endif
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+static const char cuStrnum_digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static unsigned cuStrnum_count_digits(uint64_t v)
+{
+    unsigned n = 1;
+
+    for (;;) {
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+/* Write the digits of v so that the last one is at end[-1]. Two digits are
+ * produced per division using the digit pair table.
+ */
+static void cuStrnum_write_u64(char *end, uint64_t v)
+{
+    while (v >= 100) {
+        unsigned i = (unsigned)(v % 100) * 2;
+        v /= 100;
+        end -= 2;
+        memcpy(end, cuStrnum_digit_pairs + i, 2);
+    }
+    if (v >= 10) {
+        end -= 2;
+        memcpy(end, cuStrnum_digit_pairs + v * 2, 2);
+    } else {
+        *--end = (char)('0' + v);
+    }
+}
+
+/* Shortest double to decimal conversion using Grisu2.
+ * c.f. F. Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers", PLDI 2010. The digits produced always read back as the
+ * same double and are the shortest such digits in all but a few cases.
+ */
+
+#define cuDBL_SIGNIFICAND_SIZE  52
+#define cuDBL_EXPONENT_BIAS     (0x3FF + cuDBL_SIGNIFICAND_SIZE)
+#define cuDBL_HIDDEN_BIT        ((uint64_t)1 << cuDBL_SIGNIFICAND_SIZE)
+#define cuDBL_SIGNIFICAND_MASK  (cuDBL_HIDDEN_BIT - 1)
+#define cuDBL_EXPONENT_MASK     ((uint64_t)0x7FF << cuDBL_SIGNIFICAND_SIZE)
+#define cuDBL_SIGN_MASK         ((uint64_t)1 << 63)
+
+/* Longest output: "-0.000001234567890123456" or "-1.2345678901234567e-308"
+ */
+#define cuDBL_MAX_CHARS         25
+
+typedef struct cuDiyFp {
+    uint64_t f;
+    int e;
+} cuDiyFp;
+
+/* 10^k for k = -348, -340, ..., 340, as normalized 64 bit significands and
+ * binary exponents
+ */
+static const uint64_t cuStrnum_cached_f[] = {
+    UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76),
+    UINT64_C(0xcf42894a5dce35ea), UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+    UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f), UINT64_C(0xbe5691ef416bd60c),
+    UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+    UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57),
+    UINT64_C(0xc21094364dfb5637), UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+    UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5), UINT64_C(0xb23867fb2a35b28e),
+    UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+    UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126),
+    UINT64_C(0xb5b5ada8aaff80b8), UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+    UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd), UINT64_C(0xa6dfbd9fb8e5b88f),
+    UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+    UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06),
+    UINT64_C(0xaa242499697392d3), UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+    UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c), UINT64_C(0x9c40000000000000),
+    UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+    UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068),
+    UINT64_C(0x9f4f2726179a2245), UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+    UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a), UINT64_C(0x924d692ca61be758),
+    UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+    UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d),
+    UINT64_C(0x952ab45cfa97a0b3), UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+    UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece), UINT64_C(0x88fcf317f22241e2),
+    UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+    UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410),
+    UINT64_C(0x8bab8eefb6409c1a), UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+    UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429), UINT64_C(0x80444b5e7aa7cf85),
+    UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+    UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b),
+};
+
+static const int16_t cuStrnum_cached_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t cuStrnum_pow10[] = {
+    UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000),
+    UINT64_C(10000), UINT64_C(100000), UINT64_C(1000000),
+    UINT64_C(10000000), UINT64_C(100000000), UINT64_C(1000000000),
+    UINT64_C(10000000000), UINT64_C(100000000000),
+    UINT64_C(1000000000000), UINT64_C(10000000000000),
+    UINT64_C(100000000000000), UINT64_C(1000000000000000),
+    UINT64_C(10000000000000000), UINT64_C(100000000000000000),
+    UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+};
+
+static cuDiyFp cuDiyFp_make(uint64_t f, int e)
+{
+    cuDiyFp r;
+    r.f = f;
+    r.e = e;
+    return r;
+}
+
+static cuDiyFp cuDiyFp_from_bits(uint64_t u)
+{
+    int biased_e = (int)((u & cuDBL_EXPONENT_MASK) >> cuDBL_SIGNIFICAND_SIZE);
+    uint64_t significand = u & cuDBL_SIGNIFICAND_MASK;
+
+    if (biased_e != 0)
+        return cuDiyFp_make(significand + cuDBL_HIDDEN_BIT,
+                            biased_e - cuDBL_EXPONENT_BIAS);
+    return cuDiyFp_make(significand, 1 - cuDBL_EXPONENT_BIAS);   // subnormal
+}
+
+static cuDiyFp cuDiyFp_normalize(cuDiyFp x)
+{
+    while (!(x.f & ((uint64_t)1 << 63))) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+static cuDiyFp cuDiyFp_normalize_boundary(cuDiyFp x)
+{
+    while (!(x.f & (cuDBL_HIDDEN_BIT << 1))) {
+        x.f <<= 1;
+        x.e--;
+    }
+    x.f <<= 64 - cuDBL_SIGNIFICAND_SIZE - 2;
+    x.e -= 64 - cuDBL_SIGNIFICAND_SIZE - 2;
+    return x;
+}
+
+/* The boundaries m- and m+ halfway to the neighbouring doubles, normalized
+ * to the same exponent
+ */
+static void cuDiyFp_boundaries(cuDiyFp v, cuDiyFp *minus, cuDiyFp *plus)
+{
+    cuDiyFp pl = cuDiyFp_normalize_boundary(cuDiyFp_make((v.f << 1) + 1,
+                                                         v.e - 1));
+    cuDiyFp mi = v.f == cuDBL_HIDDEN_BIT
+                 ? cuDiyFp_make((v.f << 2) - 1, v.e - 2)
+                 : cuDiyFp_make((v.f << 1) - 1, v.e - 1);
+
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *minus = mi;
+    *plus = pl;
+}
+
+/* Upper 64 bits of the 128 bit product, rounded
+ */
+static cuDiyFp cuDiyFp_mul(cuDiyFp x, cuDiyFp y)
+{
+    const uint64_t M32 = 0xFFFFFFFFu;
+    uint64_t a = x.f >> 32, b = x.f & M32;
+    uint64_t c = y.f >> 32, d = y.f & M32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+
+    tmp += 1U << 31;    // round
+    return cuDiyFp_make(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32),
+                        x.e + y.e + 64);
+}
+
+/* Cached power c_k = 10^-K such that e + e(c_k) + 64 lands in [-60, -32]
+ */
+static cuDiyFp cuDiyFp_cached_power(int e, int *K)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    unsigned index;
+
+    if (dk - k > 0.0)
+        k++;
+    index = (unsigned)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+    return cuDiyFp_make(cuStrnum_cached_f[index], cuStrnum_cached_e[index]);
+}
+
+static unsigned cuStrnum_count_digits32(uint32_t n)
+{
+    unsigned k = 1;
+
+    while (k < 10 && n >= cuStrnum_pow10[k])
+        k++;
+    return k;
+}
+
+static void cuStrnum_grisu_round(char *buffer, int len, uint64_t delta,
+                                 uint64_t rest, uint64_t ten_kappa,
+                                 uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa
+           && (rest + ten_kappa < wp_w
+               || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int cuStrnum_digit_gen(cuDiyFp W, cuDiyFp Mp, uint64_t delta,
+                              char *buffer, int *K)
+{
+    const cuDiyFp one = cuDiyFp_make((uint64_t)1 << -Mp.e, Mp.e);
+    const uint64_t wp_w = Mp.f - W.f;
+    uint32_t p1 = (uint32_t)(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = (int)cuStrnum_count_digits32(p1);
+    int len = 0;
+
+    while (kappa > 0) {
+        uint32_t div = (uint32_t)cuStrnum_pow10[kappa - 1];
+        uint32_t d = p1 / div;
+        uint64_t tmp;
+
+        p1 %= div;
+        if (d || len)
+            buffer[len++] = (char)('0' + d);
+        kappa--;
+        tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            cuStrnum_grisu_round(buffer, len, delta, tmp,
+                                 cuStrnum_pow10[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+
+    for (;;) {
+        char d;
+
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> -one.e);
+        if (d || len)
+            buffer[len++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            int index = -kappa;
+            *K += kappa;
+            cuStrnum_grisu_round(buffer, len, delta, p2, one.f,
+                                 wp_w * (index < 20 ? cuStrnum_pow10[index] : 0));
+            return len;
+        }
+    }
+}
+
+/* Digits of the (positive, finite, non-zero) double in bits, written to
+ * buffer. The value is digits * 10^K.
+ */
+static int cuStrnum_grisu2(uint64_t bits, char *buffer, int *K)
+{
+    const cuDiyFp v = cuDiyFp_from_bits(bits);
+    cuDiyFp w_m, w_p, c_mk, W, Wp, Wm;
+
+    cuDiyFp_boundaries(v, &w_m, &w_p);
+    c_mk = cuDiyFp_cached_power(w_p.e, K);
+    W = cuDiyFp_mul(cuDiyFp_normalize(v), c_mk);
+    Wp = cuDiyFp_mul(w_p, c_mk);
+    Wm = cuDiyFp_mul(w_m, c_mk);
+    Wm.f++;
+    Wp.f--;
+    return cuStrnum_digit_gen(W, Wp, Wp.f - Wm.f, buffer, K);
+}
+
+static int cuStrnum_write_exponent(char *p, int e)
+{
+    char *start = p;
+
+    *p++ = 'e';
+    if (e < 0) {
+        *p++ = '-';
+        e = -e;
+    } else {
+        *p++ = '+';
+    }
+    if (e >= 100) {
+        *p++ = (char)('0' + e / 100);
+        e %= 100;
+        memcpy(p, cuStrnum_digit_pairs + e * 2, 2);
+        p += 2;
+    } else if (e >= 10) {
+        memcpy(p, cuStrnum_digit_pairs + e * 2, 2);
+        p += 2;
+    } else {
+        *p++ = (char)('0' + e);
+    }
+    return (int)(p - start);
+}
+
+/* Lay out len digits (already at buffer) with value digits * 10^k, in
+ * place, the way JavaScript's Number.prototype.toString() does: plain
+ * notation for 1e-7 < |v| < 1e21 and exponent notation otherwise. Returns
+ * the resulting length.
+ */
+static int cuStrnum_prettify(char *buffer, int len, int k)
+{
+    const int kk = len + k;    // 10^(kk - 1) <= v < 10^kk
+    int i;
+
+    if (len <= kk && kk <= 21) {
+        /* 1234e7 -> 12340000000 */
+        for (i = len; i < kk; i++)
+            buffer[i] = '0';
+        return kk;
+    } else if (0 < kk && kk <= 21) {
+        /* 1234e-2 -> 12.34 */
+        memmove(buffer + kk + 1, buffer + kk, len - kk);
+        buffer[kk] = '.';
+        return len + 1;
+    } else if (-6 < kk && kk <= 0) {
+        /* 1234e-6 -> 0.001234 */
+        const int offset = 2 - kk;
+        memmove(buffer + offset, buffer, len);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        for (i = 2; i < offset; i++)
+            buffer[i] = '0';
+        return len + offset;
+    } else if (len == 1) {
+        /* 1e30 */
+        return 1 + cuStrnum_write_exponent(buffer + 1, kk - 1);
+    }
+    /* 1234e30 -> 1.234e+33 */
+    memmove(buffer + 2, buffer + 1, len - 1);
+    buffer[1] = '.';
+    return len + 1 + cuStrnum_write_exponent(buffer + len + 1, kk - 1);
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStr *cuStr_append_u64(cuStr *cus, uint64_t value)
+{
+    unsigned n;
+
+    assert(cus != NULL); // pre-condition
+
+    n = cuStrnum_count_digits(value);
+    if (!cuStr_grow(cus, n))
+        return NULL;
+    cuStrnum_write_u64(cus->mem + cus->elements_used + n, value);
+    return cuStr_commit(cus, n);
+}
+
+cuStr *cuStr_append_i64(cuStr *cus, int64_t value)
+{
+    uint64_t u;
+    unsigned n;
+    char *p;
+
+    assert(cus != NULL); // pre-condition
+
+    if (value >= 0)
+        return cuStr_append_u64(cus, (uint64_t)value);
+
+    u = 0 - (uint64_t)value;
+    n = cuStrnum_count_digits(u) + 1;
+    if (!cuStr_grow(cus, n))
+        return NULL;
+    p = cus->mem + cus->elements_used;
+    *p = '-';
+    cuStrnum_write_u64(p + n, u);
+    return cuStr_commit(cus, n);
+}
+
+cuStr *cuStr_append_double(cuStr *cus, double value)
+{
+    uint64_t bits;
+    char *p, *start;
+    int len, K;
+
+    assert(cus != NULL); // pre-condition
+
+    if (!cuStr_grow(cus, cuDBL_MAX_CHARS))
+        return NULL;
+    start = p = cus->mem + cus->elements_used;
+
+    memcpy(&bits, &value, sizeof bits);
+    if (bits & cuDBL_SIGN_MASK) {
+        /* no sign for NaN, as for printf() with glibc */
+        if ((bits & cuDBL_EXPONENT_MASK) != cuDBL_EXPONENT_MASK
+            || !(bits & cuDBL_SIGNIFICAND_MASK))
+            *p++ = '-';
+        bits &= ~cuDBL_SIGN_MASK;
+    }
+
+    if ((bits & cuDBL_EXPONENT_MASK) == cuDBL_EXPONENT_MASK) {
+        len = 3;
+        memcpy(p, (bits & cuDBL_SIGNIFICAND_MASK) ? "nan" : "inf", 3);
+    } else if (bits == 0) {
+        len = 1;
+        *p = '0';
+    } else {
+        len = cuStrnum_grisu2(bits, p, &K);
+        len = cuStrnum_prettify(p, len, K);
+    }
+    return cuStr_commit(cus, (size_t)(p - start) + len);
+}
+
+size_t cuStr_parse_i64(const cuStr *cus, size_t pos, int64_t *value)
+{
+    const char *s, *p, *end;
+    uint64_t u = 0, limit;
+    bool negative = false;
+
+    assert(cus != NULL && value != NULL); // pre-conditions
+
+    if (pos >= cus->elements_used)
+        return 0;
+    s = p = cus->mem + pos;
+    end = cus->mem + cus->elements_used;
+
+    if (*p == '-' || *p == '+')
+        negative = *p++ == '-';
+    limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+
+    if (p == end || (unsigned)(*p - '0') > 9)
+        return 0;
+    for (; p < end && (unsigned)(*p - '0') <= 9; p++) {
+        unsigned d = (unsigned)(*p - '0');
+        if (u > (limit - d) / 10)
+            return 0;   // overflow
+        u = u * 10 + d;
+    }
+
+    *value = negative ? (int64_t)(0 - u) : (int64_t)u;
+    return (size_t)(p - s);
+}
+
+/* strtod() in the "C" locale, as cuStr_append_double() always writes a
+ * '.'. Without strtod_l() it is the current locale's.
+ */
+static double cuStrnum_strtod(const char *s, char **end)
+{
+#ifdef CUSTRNUM_HAVE_STRTOD_L
+    static locale_t c_locale;
+    locale_t loc = __atomic_load_n(&c_locale, __ATOMIC_ACQUIRE);
+
+    if (!loc) {
+        locale_t expected = (locale_t)0;
+        if ((loc = newlocale(LC_ALL_MASK, "C", (locale_t)0)) == (locale_t)0)
+            return strtod(s, end);
+        /* Racing threads keep the first one */
+        if (!__atomic_compare_exchange_n(&c_locale, &expected, loc, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            freelocale(loc);
+            loc = expected;
+        }
+    }
+    return strtod_l(s, end, loc);
+#else
+    return strtod(s, end);
+#endif
+}
+
+size_t cuStr_parse_double(const cuStr *cus, size_t pos, double *value)
+{
+    /* Exact powers of ten for the fast path
+     */
+    static const double exact_pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char *s, *p, *end;
+    uint64_t mantissa = 0;
+    int digits = 0, exp10 = 0, any_digits = 0;
+    bool negative = false;
+
+    assert(cus != NULL && value != NULL); // pre-conditions
+
+    if (pos >= cus->elements_used)
+        return 0;
+    s = p = cus->mem + pos;
+    end = cus->mem + cus->elements_used;
+
+    if (*p == '-' || *p == '+')
+        negative = *p++ == '-';
+
+    /* Scan [digits][.digits][e[sign]digits], collecting up to 19 significant
+     * digits
+     */
+    for (; p < end && (unsigned)(*p - '0') <= 9; p++, any_digits = 1) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (unsigned)(*p - '0');
+            if (mantissa)
+                digits++;
+        } else {
+            digits++;
+            exp10++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && (unsigned)(*p - '0') <= 9; p++, any_digits = 1) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (unsigned)(*p - '0');
+                if (mantissa)
+                    digits++;
+                exp10--;
+            } else {
+                digits++;
+            }
+        }
+    }
+
+    if (!any_digits) {
+        /* Possibly "inf" or "nan" */
+        char *strtod_end;
+        if (p == end || (*p != 'i' && *p != 'I' && *p != 'n' && *p != 'N'))
+            return 0;
+        *value = cuStrnum_strtod(s, &strtod_end);
+        return (size_t)(strtod_end - s);
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool exp_negative = false;
+        int e = 0;
+
+        if (q < end && (*q == '-' || *q == '+'))
+            exp_negative = *q++ == '-';
+        if (q < end && (unsigned)(*q - '0') <= 9) {
+            for (; q < end && (unsigned)(*q - '0') <= 9; q++) {
+                if (e < 100000)
+                    e = e * 10 + (*q - '0');
+            }
+            exp10 += exp_negative ? -e : e;
+            p = q;
+        }
+    }
+
+    /* Clinger's fast path: the mantissa and the power of ten are both exact
+     * doubles, so a single multiplication or division is correctly rounded
+     */
+    if (digits <= 19 && mantissa <= ((uint64_t)1 << 53)
+        && exp10 >= -22 && exp10 <= 22) {
+        double d = (double)mantissa;
+        d = exp10 < 0 ? d / exact_pow10[-exp10] : d * exact_pow10[exp10];
+        *value = negative ? -d : d;
+    } else {
+        /* The string is always NUL terminated, and strtod() in the "C"
+         * locale accepts everything that was scanned above. In a locale
+         * with another decimal point it may stop early, and then the value
+         * is not that of the scanned text.
+         */
+        char *strtod_end;
+        double d = cuStrnum_strtod(s, &strtod_end);
+        if (strtod_end != p)
+            return 0;
+        *value = d;
+    }
+    return (size_t)(p - s);
+}
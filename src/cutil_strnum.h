@@ -0,0 +1,24 @@
+#ifndef CU_INCLUDE_STRNUM_H
+#define CU_INCLUDE_STRNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cutil_string.h"
+
+/* Append numbers as decimal text without going through printf(). Doubles
+ * are written with the fewest digits that read back as the same value.
+ */
+cuStr *cuStr_append_i64(cuStr *cus, int64_t value);
+cuStr *cuStr_append_u64(cuStr *cus, uint64_t value);
+cuStr *cuStr_append_double(cuStr *cus, double value);
+
+/* Parse a number starting at pos. Returns the number of characters used,
+ * or 0 if there isn't a number at pos (or an integer doesn't fit).
+ * Doubles use '.' whatever the locale, as long as the C library has
+ * strtod_l(); without it, those that need strtod() fail in a locale with
+ * another decimal point.
+ */
+size_t cuStr_parse_i64(const cuStr *cus, size_t pos, int64_t *value);
+size_t cuStr_parse_double(const cuStr *cus, size_t pos, double *value);
+
+#endif /* CU_INCLUDE_STRNUM_H */
@@ -0,0 +1,173 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <pthread.h>
+#include "cutil_strpool.h"
+#include "cutil_strmap.h"
+#include "cutil_strhash.h"
+#include "cutil_arena.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+typedef struct cuStrPoolShard {
+    pthread_mutex_t lock;
+    cuStrMap *map;          // contents -> interned cuStr
+    cuArena *arena;         // the interned cuStrs and their contents
+} cuStrPoolShard;
+
+struct cuStrPool {
+    unsigned flags;
+    cuStrPoolShard shards[CUSTRPOOL_SHARDS];
+};
+
+/* The map uses the low bits of the hash, so pick the shard from the top */
+#define cuStrPoolSHARD(pool, hash) \
+    (&(pool)->shards[((hash) >> 48) % CUSTRPOOL_SHARDS])
+
+static void cuStrPool_lock(cuStrPool *pool, cuStrPoolShard *shard)
+{
+    if (pool->flags & CUSTRPOOL_THREADSAFE)
+        pthread_mutex_lock(&shard->lock);
+}
+
+static void cuStrPool_unlock(cuStrPool *pool, cuStrPoolShard *shard)
+{
+    if (pool->flags & CUSTRPOOL_THREADSAFE)
+        pthread_mutex_unlock(&shard->lock);
+}
+
+static const cuStr *cuStrPool_intern_hashed(cuStrPool *pool, const char *arr,
+                                            size_t len, uint64_t hash)
+{
+    cuStrPoolShard *shard = cuStrPoolSHARD(pool, hash);
+    cuStr *cus = NULL;
+    void **found;
+
+    cuStrPool_lock(pool, shard);
+    if ((found = cuStrMap_get_hashed(shard->map, arr, len, hash)) != NULL) {
+        cus = *found;
+    } else if (len <= INT_MAX
+               && (cus = cuStr_new_exact_in(shard->arena, (int)len)) != NULL) {
+        cuStr_set_fromarray(cus, arr, (unsigned)len);
+        /* Fill in the cached hash now, so that cuStr_hash() on a handle
+         * never writes to it
+         */
+        cus->hash = hash;
+        if (cuStrMap_put_hashed(shard->map, arr, len, hash, cus) != 0)
+            cus = NULL;
+    }
+    cuStrPool_unlock(pool, shard);
+
+    return cus;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStrPool *cuStrPool_new(unsigned flags)
+{
+    cuStrPool *pool;
+    size_t i;
+
+    if ((pool = malloc(sizeof *pool)) == NULL)
+        return NULL;
+
+    memset(pool, 0, sizeof *pool);
+    pool->flags = flags;
+    for (i = 0; i < CUSTRPOOL_SHARDS; i++) {
+        cuStrPoolShard *shard = &pool->shards[i];
+        if ((shard->arena = cuArena_new(0)) == NULL
+            || (shard->map = cuStrMap_new(0)) == NULL
+            || pthread_mutex_init(&shard->lock, NULL) != 0) {
+            cuArena_destroy(&shard->arena);
+            cuStrMap_destroy(&shard->map);
+            while (i--) {
+                pthread_mutex_destroy(&pool->shards[i].lock);
+                cuStrMap_destroy(&pool->shards[i].map);
+                cuArena_destroy(&pool->shards[i].arena);
+            }
+            free(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void cuStrPool_destroy(cuStrPool **pool)
+{
+    size_t i;
+
+    assert(pool != NULL); // pre-condition
+
+    if (*pool) {
+        for (i = 0; i < CUSTRPOOL_SHARDS; i++) {
+            cuStrPoolShard *shard = &(*pool)->shards[i];
+            cuStrMap_destroy(&shard->map);
+            cuArena_destroy(&shard->arena);
+            pthread_mutex_destroy(&shard->lock);
+        }
+        free(*pool);
+    }
+    *pool = NULL;
+}
+
+size_t cuStrPool_size(cuStrPool *pool)
+{
+    size_t i, n = 0;
+
+    assert(pool != NULL); // pre-condition
+
+    for (i = 0; i < CUSTRPOOL_SHARDS; i++) {
+        cuStrPoolShard *shard = &pool->shards[i];
+        cuStrPool_lock(pool, shard);
+        n += cuStrMap_size(shard->map);
+        cuStrPool_unlock(pool, shard);
+    }
+    return n;
+}
+
+const cuStr *cuStrPool_intern(cuStrPool *pool, const cuStr *cus)
+{
+    assert(pool != NULL && cus != NULL); // pre-conditions
+
+    return cuStrPool_intern_hashed(pool, cuStr_cstr(cus), cuStr_len(cus),
+                                   cuStr_hash(cus));
+}
+
+const cuStr *cuStrPool_intern_array(cuStrPool *pool, const char *arr,
+                                    size_t len)
+{
+    assert(pool != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    return cuStrPool_intern_hashed(pool, arr, len,
+                                   cuMem_hash(arr, len, CUSTR_HASH_SEED));
+}
+
+const cuStr *cuStrPool_lookup_array(cuStrPool *pool, const char *arr,
+                                    size_t len)
+{
+    uint64_t hash;
+    cuStrPoolShard *shard;
+    void **found;
+    const cuStr *cus;
+
+    assert(pool != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    hash = cuMem_hash(arr, len, CUSTR_HASH_SEED);
+    shard = cuStrPoolSHARD(pool, hash);
+    cuStrPool_lock(pool, shard);
+    found = cuStrMap_get_hashed(shard->map, arr, len, hash);
+    cus = found ? *found : NULL;
+    cuStrPool_unlock(pool, shard);
+
+    return cus;
+}
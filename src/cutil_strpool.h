@@ -0,0 +1,39 @@
+#ifndef CU_INCLUDE_STRPOOL_H
+#define CU_INCLUDE_STRPOOL_H
+
+#include <stddef.h>
+#include "cutil_string.h"
+
+/* A cuStrPool interns strings: it keeps one copy of each distinct content
+ * and hands out that copy for every string with the same bytes. Handles
+ * from the same pool are equal exactly when the pointers are equal.
+ *
+ * Handles are owned by the pool and must not be changed or destroyed; they
+ * stay valid until cuStrPool_destroy(). The interned strings are carved
+ * out of arenas, so a new string only allocates when an arena block fills
+ * up or, for the table's copy of the key, when it is longer than
+ * CUSTRMAP_INLINE_KEY.
+ */
+
+/* Allow several threads to intern into the pool at once */
+#define CUSTRPOOL_THREADSAFE    (1U << 0)
+
+/* The table is split in shards, each with its own lock */
+#ifndef CUSTRPOOL_SHARDS
+#   define CUSTRPOOL_SHARDS     16
+#endif
+
+typedef struct cuStrPool cuStrPool;
+
+cuStrPool *cuStrPool_new(unsigned flags);
+void cuStrPool_destroy(cuStrPool **pool);
+size_t cuStrPool_size(cuStrPool *pool);
+/* The canonical handle for the contents, or NULL if out of memory */
+const cuStr *cuStrPool_intern(cuStrPool *pool, const cuStr *cus);
+const cuStr *cuStrPool_intern_array(cuStrPool *pool, const char *arr,
+                                    size_t len);
+/* The handle if the contents have been interned, otherwise NULL */
+const cuStr *cuStrPool_lookup_array(cuStrPool *pool, const char *arr,
+                                    size_t len);
+
+#endif /* CU_INCLUDE_STRPOOL_H */
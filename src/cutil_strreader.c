@@ -0,0 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include "cutil_strreader.h"
+#include "cutil_strsearch.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+/* Move the unread bytes to the front and read more after them. Returns 1
+ * if anything was read, 0 at end of input and -1 on error.
+ */
+static int cuStrReader_fill(cuStrReader *reader)
+{
+    ssize_t n;
+
+    if (reader->eof)
+        return 0;
+    if (reader->start > 0) {
+        memmove(reader->buf, reader->buf + reader->start,
+                reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    assert(reader->end < reader->capacity);
+
+    do {
+        n = read(reader->fd, reader->buf + reader->end,
+                 reader->capacity - reader->end);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return -1;
+    if (n == 0) {
+        reader->eof = 1;
+        return 0;
+    }
+    reader->end += (size_t)n;
+    return 1;
+}
+
+/* The position of the next delimiter in the buffer, or NULL. Bytes that
+ * have been searched once are not searched again after a refill.
+ */
+static const char *cuStrReader_scan(cuStrReader *reader, char delim)
+{
+    const char *from = reader->buf + reader->start + reader->scanned;
+    const char *match = cuMem_find_byte(from, reader->buf + reader->end - from,
+                                        delim);
+
+    reader->scanned = match ? 0 : reader->end - reader->start;
+    return match;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStrReader *cuStrReader_new(int fd, size_t buffer_size)
+{
+    cuStrReader *reader;
+
+    if (buffer_size == 0)
+        buffer_size = CUSTRREADER_BUFFER_SIZE;
+    if ((reader = malloc(sizeof *reader)) == NULL)
+        return NULL;
+    if ((reader->buf = malloc(buffer_size)) == NULL) {
+        free(reader);
+        return NULL;
+    }
+    reader->fd = fd;
+    reader->capacity = buffer_size;
+    reader->start = reader->end = reader->scanned = 0;
+    reader->eof = 0;
+    return reader;
+}
+
+void cuStrReader_destroy(cuStrReader **reader)
+{
+    assert(reader != NULL); // pre-condition
+
+    if (*reader) {
+        free((*reader)->buf);
+        free(*reader);
+    }
+    *reader = NULL;
+}
+
+int cuStrReader_next(cuStrReader *reader, char delim, cuStrView *record)
+{
+    const char *match;
+    int r;
+
+    assert(reader != NULL && record != NULL); // pre-conditions
+
+    while ((match = cuStrReader_scan(reader, delim)) == NULL) {
+        /* A record as long as the buffer: make room for more of it */
+        if (reader->start == 0 && reader->end == reader->capacity) {
+            char *buf = realloc(reader->buf, reader->capacity * 2);
+            if (!buf)
+                return -1;
+            reader->buf = buf;
+            reader->capacity *= 2;
+        }
+        if ((r = cuStrReader_fill(reader)) < 0)
+            return -1;
+        if (r == 0) {
+            /* The last record has no delimiter after it */
+            if (reader->start == reader->end)
+                return 0;
+            *record = cuStrView_make(reader->buf + reader->start,
+                                     reader->end - reader->start);
+            reader->start = reader->end;
+            reader->scanned = 0;
+            return 1;
+        }
+    }
+    *record = cuStrView_make(reader->buf + reader->start,
+                             (size_t)(match - (reader->buf + reader->start)));
+    reader->start += record->len + 1;
+    return 1;
+}
+
+int cuStrReader_read(cuStrReader *reader, char delim, cuStr *out)
+{
+    const char *match;
+    cuStrView part;
+    int r;
+
+    assert(reader != NULL && out != NULL); // pre-conditions
+
+    cuStr_clear(out);
+    for (;;) {
+        match = cuStrReader_scan(reader, delim);
+        if (match || reader->eof) {
+            part = cuStrView_make(reader->buf + reader->start,
+                                  match ? (size_t)(match - (reader->buf + reader->start))
+                                        : reader->end - reader->start);
+            if (!cuStr_append_view(out, part))
+                return -1;
+            reader->start += part.len + (match != NULL);
+            reader->scanned = 0;
+            /* At the end, a record must have had some bytes in it */
+            return match || cuStr_len(out) > 0 ? 1 : 0;
+        }
+
+        /* Keep what there is of a long record and read on, rather than
+         * growing the buffer
+         */
+        if (reader->end - reader->start > reader->capacity / 2) {
+            part = cuStrView_make(reader->buf + reader->start,
+                                  reader->end - reader->start);
+            if (!cuStr_append_view(out, part))
+                return -1;
+            reader->start = reader->end;
+            reader->scanned = 0;
+        }
+        if ((r = cuStrReader_fill(reader)) < 0)
+            return -1;
+    }
+}
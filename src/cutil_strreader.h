@@ -0,0 +1,41 @@
+#ifndef CU_INCLUDE_STRREADER_H
+#define CU_INCLUDE_STRREADER_H
+
+#include <stddef.h>
+#include "cutil_string.h"
+#include "cutil_strview.h"
+
+#ifndef CUSTRREADER_BUFFER_SIZE
+#   define CUSTRREADER_BUFFER_SIZE     (256 * 1024)
+#endif
+
+/* Reads delimiter separated records (lines, '\0' separated lists, ...)
+ * from a file descriptor through one reusable buffer, so that records cost
+ * no allocations. The buffer only grows if cuStrReader_next() meets a
+ * record longer than the buffer.
+ */
+typedef struct cuStrReader {
+    int fd;
+    char *buf;
+    size_t capacity;
+    size_t start, end;      // buf[start, end) has not been returned yet
+    size_t scanned;         // bytes from start known to hold no delimiter
+    int eof;
+} cuStrReader;
+
+/* buffer_size 0 uses CUSTRREADER_BUFFER_SIZE. The reader doesn't own fd. */
+cuStrReader *cuStrReader_new(int fd, size_t buffer_size);
+void cuStrReader_destroy(cuStrReader **reader);
+
+/* Both return 1 with the next record without its delimiter, 0 at the end
+ * of the input or -1 on a read error or if out of memory. The last record
+ * doesn't need a delimiter after it.
+ *
+ * cuStrReader_next() points the view into the reader's buffer; it is valid
+ * until the next call. cuStrReader_read() sets out to the record instead,
+ * reusing its capacity.
+ */
+int cuStrReader_next(cuStrReader *reader, char delim, cuStrView *record);
+int cuStrReader_read(cuStrReader *reader, char delim, cuStr *out);
+
+#endif /* CU_INCLUDE_STRREADER_H */
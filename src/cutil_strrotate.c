@@ -0,0 +1,174 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_strrotate.h"
+#include "cutil_simd.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+static uint64_t cuMem_bswap64(uint64_t v)
+{
+#ifdef __GNUC__
+    return __builtin_bswap64(v);
+#else
+    v = ((v & 0x00FF00FF00FF00FFULL) << 8) | ((v >> 8) & 0x00FF00FF00FF00FFULL);
+    v = ((v & 0x0000FFFF0000FFFFULL) << 16) | ((v >> 16) & 0x0000FFFF0000FFFFULL);
+    return (v << 32) | (v >> 32);
+#endif
+}
+
+/* Each kernel swaps blocks from both ends towards the middle, reversing the
+ * bytes of each block, and leaves what is too short for two blocks to the
+ * next smaller kernel
+ */
+static void cuMem_reverse_scalar(char *lo, char *hi)
+{
+    while (hi - lo >= 16) {
+        uint64_t a, b;
+        memcpy(&a, lo, sizeof a);
+        memcpy(&b, hi - 8, sizeof b);
+        a = cuMem_bswap64(a);
+        b = cuMem_bswap64(b);
+        memcpy(lo, &b, sizeof b);
+        memcpy(hi - 8, &a, sizeof a);
+        lo += 8;
+        hi -= 8;
+    }
+    while (hi - lo > 1) {
+        char tmp = *lo;
+        *lo++ = *--hi;
+        *hi = tmp;
+    }
+}
+
+#ifdef CU_SIMD_X86
+
+/* Without pshufb: swap the bytes of each word, then the words of each half,
+ * then the halves
+ */
+static __m128i cuMem_reverse16_sse2(__m128i v)
+{
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+static void cuMem_reverse_sse2(char *lo, char *hi)
+{
+    while (hi - lo >= 32) {
+        __m128i a = _mm_loadu_si128((const __m128i *)lo);
+        __m128i b = _mm_loadu_si128((const __m128i *)(hi - 16));
+        _mm_storeu_si128((__m128i *)lo, cuMem_reverse16_sse2(b));
+        _mm_storeu_si128((__m128i *)(hi - 16), cuMem_reverse16_sse2(a));
+        lo += 16;
+        hi -= 16;
+    }
+    cuMem_reverse_scalar(lo, hi);
+}
+
+CU_TARGET_SSSE3
+static void cuMem_reverse_ssse3(char *lo, char *hi)
+{
+    const __m128i rev = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                      7, 6, 5, 4, 3, 2, 1, 0);
+
+    while (hi - lo >= 32) {
+        __m128i a = _mm_loadu_si128((const __m128i *)lo);
+        __m128i b = _mm_loadu_si128((const __m128i *)(hi - 16));
+        _mm_storeu_si128((__m128i *)lo, _mm_shuffle_epi8(b, rev));
+        _mm_storeu_si128((__m128i *)(hi - 16), _mm_shuffle_epi8(a, rev));
+        lo += 16;
+        hi -= 16;
+    }
+    cuMem_reverse_scalar(lo, hi);
+}
+
+/* vpshufb only shuffles within each 128 bit lane, so the lanes are swapped
+ * afterwards
+ */
+CU_TARGET_AVX2
+static void cuMem_reverse_avx2(char *lo, char *hi)
+{
+    const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                         7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8,
+                                         7, 6, 5, 4, 3, 2, 1, 0);
+
+    while (hi - lo >= 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)lo);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(hi - 32));
+        a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, rev),
+                                     _MM_SHUFFLE(1, 0, 3, 2));
+        b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, rev),
+                                     _MM_SHUFFLE(1, 0, 3, 2));
+        _mm256_storeu_si256((__m256i *)lo, b);
+        _mm256_storeu_si256((__m256i *)(hi - 32), a);
+        lo += 32;
+        hi -= 32;
+    }
+    cuMem_reverse_ssse3(lo, hi);
+}
+
+#endif /* CU_SIMD_X86 */
+
+typedef void (*cuMem_reverse_fn)(char *lo, char *hi);
+
+static cuMem_reverse_fn cuMem_reverse_kernel(void)
+{
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        return cuMem_reverse_avx2;
+    if (features & CU_CPU_SSSE3)
+        return cuMem_reverse_ssse3;
+    if (features & CU_CPU_SSE2)
+        return cuMem_reverse_sse2;
+#endif
+    return cuMem_reverse_scalar;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+void cuMem_reverse(char *p, size_t n)
+{
+    assert(p != NULL || n == 0); // pre-condition
+
+    if (n > 1)
+        cuMem_reverse_kernel()(p, p + n);
+}
+
+void cuMem_rotate(char *p, size_t n, size_t shift)
+{
+    char scratch[CUMEM_ROTATE_SCRATCH];
+    size_t rest;
+
+    assert(p != NULL || n == 0); // pre-condition
+
+    if (n < 2 || (shift %= n) == 0)
+        return;
+
+    rest = n - shift;
+    if (shift <= sizeof scratch) {
+        /* Save the bytes that wrap around, slide the rest down */
+        memcpy(scratch, p, shift);
+        memmove(p, p + shift, rest);
+        memcpy(p + rest, scratch, shift);
+    } else if (rest <= sizeof scratch) {
+        memcpy(scratch, p + shift, rest);
+        memmove(p + rest, p, shift);
+        memcpy(p, scratch, rest);
+    } else {
+        /* Reversal makes two sequential passes over the data, where the
+         * juggling algorithm strides through it shift bytes at a time
+         */
+        cuMem_reverse_fn reverse = cuMem_reverse_kernel();
+        reverse(p, p + shift);
+        reverse(p + shift, p + n);
+        reverse(p, p + n);
+    }
+}
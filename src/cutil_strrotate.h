@@ -0,0 +1,21 @@
+#ifndef CU_INCLUDE_STRROTATE_H
+#define CU_INCLUDE_STRROTATE_H
+
+#include <stddef.h>
+
+/* Shifts of up to CUMEM_ROTATE_SCRATCH bytes, in either direction, are
+ * moved through a buffer on the stack with a single memmove(). Larger
+ * rotations reverse the two parts and then the whole range.
+ */
+#ifndef CUMEM_ROTATE_SCRATCH
+#   define CUMEM_ROTATE_SCRATCH 4096
+#endif
+
+/* Rotate the n bytes at p left by shift positions, so that p[shift % n]
+ * becomes p[0]
+ */
+void cuMem_rotate(char *p, size_t n, size_t shift);
+/* Reverse the n bytes at p */
+void cuMem_reverse(char *p, size_t n);
+
+#endif /* CU_INCLUDE_STRROTATE_H */
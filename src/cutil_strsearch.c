@@ -0,0 +1,475 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_strsearch.h"
+#include "cutil_simd.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+/* Scalar kernels, used when no SIMD is available and for the tails that
+ * are too short for a vector
+ */
+
+static const char *cuMem_find_byte_scalar(const char *s, size_t n, char c)
+{
+    return n ? memchr(s, c, n) : NULL;
+}
+
+static const char *cuMem_rfind_byte_scalar(const char *s, size_t n, char c)
+{
+    while (n--) {
+        if (s[n] == c)
+            return s + n;
+    }
+    return NULL;
+}
+
+static size_t cuMem_count_byte_scalar(const char *s, size_t n, char c)
+{
+    size_t i, count = 0;
+
+    for (i = 0; i < n; i++)
+        count += s[i] == c;
+    return count;
+}
+
+/* For the substring kernels 2 <= nn <= n. Candidates are checked on their
+ * first and last bytes before comparing the rest.
+ */
+static const char *cuMem_find_scalar(const char *s, size_t n,
+                                     const char *nd, size_t nn)
+{
+    const char *p = s, *end = s + n - nn + 1;
+
+    while ((p = memchr(p, nd[0], end - p)) != NULL) {
+        if (p[nn - 1] == nd[nn - 1] && memcmp(p + 1, nd + 1, nn - 2) == 0)
+            return p;
+        if (++p == end)
+            break;
+    }
+    return NULL;
+}
+
+static const char *cuMem_rfind_scalar(const char *s, size_t n,
+                                      const char *nd, size_t nn)
+{
+    size_t i = n - nn + 1;
+
+    while (i--) {
+        if (s[i] == nd[0] && s[i + nn - 1] == nd[nn - 1]
+            && memcmp(s + i + 1, nd + 1, nn - 2) == 0)
+            return s + i;
+    }
+    return NULL;
+}
+
+#ifdef CU_SIMD_X86
+
+static const char *cuMem_find_byte_sse2(const char *s, size_t n, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(s + i));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask)
+            return s + i + __builtin_ctz(mask);
+    }
+    return cuMem_find_byte_scalar(s + i, n - i, c);
+}
+
+CU_TARGET_AVX2
+static const char *cuMem_find_byte_avx2(const char *s, size_t n, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    size_t i = 0;
+
+    /* Two vectors per iteration, checking them together */
+    for (; i + 64 <= n; i += 64) {
+        __m256i eq0 = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(s + i)), needle);
+        __m256i eq1 = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(s + i + 32)), needle);
+        if (_mm256_movemask_epi8(_mm256_or_si256(eq0, eq1))) {
+            unsigned mask = (unsigned)_mm256_movemask_epi8(eq0);
+            if (mask)
+                return s + i + __builtin_ctz(mask);
+            mask = (unsigned)_mm256_movemask_epi8(eq1);
+            return s + i + 32 + __builtin_ctz(mask);
+        }
+    }
+    for (; i + 32 <= n; i += 32) {
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(s + i)), needle));
+        if (mask)
+            return s + i + __builtin_ctz(mask);
+    }
+    return cuMem_find_byte_scalar(s + i, n - i, c);
+}
+
+static const char *cuMem_rfind_byte_sse2(const char *s, size_t n, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+
+    for (; n >= 16; n -= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(s + n - 16));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask)
+            return s + n - 16 + (31 - __builtin_clz(mask));
+    }
+    return cuMem_rfind_byte_scalar(s, n, c);
+}
+
+CU_TARGET_AVX2
+static const char *cuMem_rfind_byte_avx2(const char *s, size_t n, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+
+    for (; n >= 32; n -= 32) {
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i *)(s + n - 32)), needle));
+        if (mask)
+            return s + n - 32 + (31 - __builtin_clz(mask));
+    }
+    return cuMem_rfind_byte_scalar(s, n, c);
+}
+
+/* Counting subtracts the 0/-1 comparison results from per-byte counters,
+ * which are summed with psadbw before they can overflow (255 iterations)
+ */
+static size_t cuMem_count_byte_sse2(const char *s, size_t n, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i total = _mm_setzero_si128();
+    uint64_t sums[2];
+    size_t i = 0;
+
+    while (i + 16 <= n) {
+        __m128i acc = _mm_setzero_si128();
+        unsigned k;
+        for (k = 0; k < 255 && i + 16 <= n; k++, i += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i *)(s + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(block, needle));
+        }
+        total = _mm_add_epi64(total, _mm_sad_epu8(acc, zero));
+    }
+    _mm_storeu_si128((__m128i *)sums, total);
+    return (size_t)(sums[0] + sums[1])
+           + cuMem_count_byte_scalar(s + i, n - i, c);
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_count_byte_avx2(const char *s, size_t n, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i total = _mm256_setzero_si256();
+    uint64_t sums[4];
+    size_t i = 0;
+
+    while (i + 32 <= n) {
+        __m256i acc = _mm256_setzero_si256();
+        unsigned k;
+        for (k = 0; k < 255 && i + 32 <= n; k++, i += 32) {
+            __m256i block = _mm256_loadu_si256((const __m256i *)(s + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(block, needle));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, zero));
+    }
+    _mm256_storeu_si256((__m256i *)sums, total);
+    return (size_t)(sums[0] + sums[1] + sums[2] + sums[3])
+           + cuMem_count_byte_scalar(s + i, n - i, c);
+}
+
+/* Substring search: compare the needle's first and last bytes against a
+ * vector of candidate positions at once and only memcmp() the middle of
+ * the candidates where both matched. c.f. W. Muła, "SIMD-friendly algorithms
+ * for substring searching" (2016)
+ */
+static const char *cuMem_find_sse2(const char *s, size_t n,
+                                   const char *nd, size_t nn)
+{
+    const __m128i first = _mm_set1_epi8(nd[0]);
+    const __m128i last = _mm_set1_epi8(nd[nn - 1]);
+    const size_t end = n - nn + 1;   // number of candidate positions
+    size_t i;
+
+    for (i = 0; i + 16 <= end; i += 16) {
+        __m128i bf = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i bl = _mm_loadu_si128((const __m128i *)(s + i + nn - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last)));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (memcmp(s + i + bit + 1, nd + 1, nn - 2) == 0)
+                return s + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return i < end ? cuMem_find_scalar(s + i, n - i, nd, nn) : NULL;
+}
+
+CU_TARGET_AVX2
+static const char *cuMem_find_avx2(const char *s, size_t n,
+                                   const char *nd, size_t nn)
+{
+    const __m256i first = _mm256_set1_epi8(nd[0]);
+    const __m256i last = _mm256_set1_epi8(nd[nn - 1]);
+    const size_t end = n - nn + 1;
+    size_t i;
+
+    for (i = 0; i + 32 <= end; i += 32) {
+        __m256i bf = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i bl = _mm256_loadu_si256((const __m256i *)(s + i + nn - 1));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, last)));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (memcmp(s + i + bit + 1, nd + 1, nn - 2) == 0)
+                return s + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return i < end ? cuMem_find_scalar(s + i, n - i, nd, nn) : NULL;
+}
+
+static const char *cuMem_rfind_sse2(const char *s, size_t n,
+                                    const char *nd, size_t nn)
+{
+    const __m128i first = _mm_set1_epi8(nd[0]);
+    const __m128i last = _mm_set1_epi8(nd[nn - 1]);
+    size_t end = n - nn + 1;
+
+    for (; end >= 16; end -= 16) {
+        const char *p = s + end - 16;
+        __m128i bf = _mm_loadu_si128((const __m128i *)p);
+        __m128i bl = _mm_loadu_si128((const __m128i *)(p + nn - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last)));
+        while (mask) {
+            unsigned bit = 31 - __builtin_clz(mask);
+            if (memcmp(p + bit + 1, nd + 1, nn - 2) == 0)
+                return p + bit;
+            mask &= ~(1U << bit);
+        }
+    }
+    return end ? cuMem_rfind_scalar(s, end + nn - 1, nd, nn) : NULL;
+}
+
+CU_TARGET_AVX2
+static const char *cuMem_rfind_avx2(const char *s, size_t n,
+                                    const char *nd, size_t nn)
+{
+    const __m256i first = _mm256_set1_epi8(nd[0]);
+    const __m256i last = _mm256_set1_epi8(nd[nn - 1]);
+    size_t end = n - nn + 1;
+
+    for (; end >= 32; end -= 32) {
+        const char *p = s + end - 32;
+        __m256i bf = _mm256_loadu_si256((const __m256i *)p);
+        __m256i bl = _mm256_loadu_si256((const __m256i *)(p + nn - 1));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, last)));
+        while (mask) {
+            unsigned bit = 31 - __builtin_clz(mask);
+            if (memcmp(p + bit + 1, nd + 1, nn - 2) == 0)
+                return p + bit;
+            mask &= ~(1U << bit);
+        }
+    }
+    return end ? cuMem_rfind_scalar(s, end + nn - 1, nd, nn) : NULL;
+}
+
+#endif /* CU_SIMD_X86 */
+
+/* Convert a match to a position in the string */
+static size_t cuStr_match_pos(const cuStr *cus, const char *match)
+{
+    return match ? (size_t)(match - cus->mem) : CUSTR_NPOS;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+const char *cuMem_find_byte(const char *s, size_t n, char c)
+{
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        return cuMem_find_byte_avx2(s, n, c);
+    if (features & CU_CPU_SSE2)
+        return cuMem_find_byte_sse2(s, n, c);
+#endif
+    return cuMem_find_byte_scalar(s, n, c);
+}
+
+const char *cuMem_rfind_byte(const char *s, size_t n, char c)
+{
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        return cuMem_rfind_byte_avx2(s, n, c);
+    if (features & CU_CPU_SSE2)
+        return cuMem_rfind_byte_sse2(s, n, c);
+#endif
+    return cuMem_rfind_byte_scalar(s, n, c);
+}
+
+size_t cuMem_count_byte(const char *s, size_t n, char c)
+{
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        return cuMem_count_byte_avx2(s, n, c);
+    if (features & CU_CPU_SSE2)
+        return cuMem_count_byte_sse2(s, n, c);
+#endif
+    return cuMem_count_byte_scalar(s, n, c);
+}
+
+const char *cuMem_find(const char *s, size_t n, const char *needle,
+                       size_t needle_len)
+{
+    if (needle_len == 0)
+        return s;
+    if (needle_len > n)
+        return NULL;
+    if (needle_len == 1)
+        return cuMem_find_byte(s, n, needle[0]);
+#ifdef CU_SIMD_X86
+    {
+        unsigned features = cu_cpu_features();
+        if (features & CU_CPU_AVX2)
+            return cuMem_find_avx2(s, n, needle, needle_len);
+        if (features & CU_CPU_SSE2)
+            return cuMem_find_sse2(s, n, needle, needle_len);
+    }
+#endif
+    return cuMem_find_scalar(s, n, needle, needle_len);
+}
+
+const char *cuMem_rfind(const char *s, size_t n, const char *needle,
+                        size_t needle_len)
+{
+    if (needle_len == 0)
+        return s + n;
+    if (needle_len > n)
+        return NULL;
+    if (needle_len == 1)
+        return cuMem_rfind_byte(s, n, needle[0]);
+#ifdef CU_SIMD_X86
+    {
+        unsigned features = cu_cpu_features();
+        if (features & CU_CPU_AVX2)
+            return cuMem_rfind_avx2(s, n, needle, needle_len);
+        if (features & CU_CPU_SSE2)
+            return cuMem_rfind_sse2(s, n, needle, needle_len);
+    }
+#endif
+    return cuMem_rfind_scalar(s, n, needle, needle_len);
+}
+
+size_t cuMem_count(const char *s, size_t n, const char *needle,
+                   size_t needle_len)
+{
+    const char *end = s + n, *p;
+    size_t count = 0;
+
+    if (needle_len == 0)
+        return 0;
+    if (needle_len == 1)
+        return cuMem_count_byte(s, n, needle[0]);
+
+    while ((p = cuMem_find(s, end - s, needle, needle_len)) != NULL) {
+        count++;
+        s = p + needle_len;
+    }
+    return count;
+}
+
+size_t cuStr_find_byte(const cuStr *cus, char c, size_t pos)
+{
+    assert(cus != NULL); // pre-condition
+
+    if (pos >= cus->elements_used)
+        return CUSTR_NPOS;
+    return cuStr_match_pos(cus, cuMem_find_byte(cus->mem + pos,
+                                                cus->elements_used - pos, c));
+}
+
+size_t cuStr_rfind_byte(const cuStr *cus, char c, size_t pos)
+{
+    assert(cus != NULL); // pre-condition
+
+    if (cus->elements_used == 0)
+        return CUSTR_NPOS;
+    if (pos >= cus->elements_used)
+        pos = cus->elements_used - 1;
+    return cuStr_match_pos(cus, cuMem_rfind_byte(cus->mem, pos + 1, c));
+}
+
+size_t cuStr_find(const cuStr *cus, const cuStr *needle, size_t pos)
+{
+    assert(needle != NULL); // pre-condition
+
+    return cuStr_find_array(cus, needle->mem, needle->elements_used, pos);
+}
+
+size_t cuStr_find_array(const cuStr *cus, const char *arr, size_t len,
+                        size_t pos)
+{
+    assert(cus != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if (pos > cus->elements_used || len > cus->elements_used - pos)
+        return CUSTR_NPOS;
+    if (len == 0)
+        return pos;
+    return cuStr_match_pos(cus, cuMem_find(cus->mem + pos,
+                                           cus->elements_used - pos,
+                                           arr, len));
+}
+
+size_t cuStr_rfind(const cuStr *cus, const cuStr *needle, size_t pos)
+{
+    assert(needle != NULL); // pre-condition
+
+    return cuStr_rfind_array(cus, needle->mem, needle->elements_used, pos);
+}
+
+size_t cuStr_rfind_array(const cuStr *cus, const char *arr, size_t len,
+                         size_t pos)
+{
+    assert(cus != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if (len > cus->elements_used)
+        return CUSTR_NPOS;
+    if (pos > cus->elements_used - len)
+        pos = cus->elements_used - len;
+    if (len == 0)
+        return pos;
+    return cuStr_match_pos(cus, cuMem_rfind(cus->mem, pos + len, arr, len));
+}
+
+size_t cuStr_count(const cuStr *cus, const cuStr *needle)
+{
+    assert(needle != NULL); // pre-condition
+
+    return cuStr_count_array(cus, needle->mem, needle->elements_used);
+}
+
+size_t cuStr_count_array(const cuStr *cus, const char *arr, size_t len)
+{
+    assert(cus != NULL); // pre-condition
+    assert(arr != NULL || len == 0); // pre-condition
+
+    if (cus->elements_used == 0)
+        return 0;
+    return cuMem_count(cus->mem, cus->elements_used, arr, len);
+}
@@ -0,0 +1,39 @@
+#ifndef CU_INCLUDE_STRSEARCH_H
+#define CU_INCLUDE_STRSEARCH_H
+
+#include <stddef.h>
+#include "cutil_string.h"
+
+/* Returned by the find functions when there is no match */
+#define CUSTR_NPOS ((size_t)-1)
+
+/* Searches cover the full length of the string, including any embedded
+ * '\0' bytes. find searches forwards from pos; rfind searches backwards
+ * for a match starting at or before pos (use CUSTR_NPOS for the end). count
+ * returns the number of non-overlapping matches.
+ */
+size_t cuStr_find_byte(const cuStr *cus, char c, size_t pos);
+size_t cuStr_rfind_byte(const cuStr *cus, char c, size_t pos);
+size_t cuStr_find(const cuStr *cus, const cuStr *needle, size_t pos);
+size_t cuStr_find_array(const cuStr *cus, const char *arr, size_t len,
+                        size_t pos);
+size_t cuStr_rfind(const cuStr *cus, const cuStr *needle, size_t pos);
+size_t cuStr_rfind_array(const cuStr *cus, const char *arr, size_t len,
+                         size_t pos);
+size_t cuStr_count(const cuStr *cus, const cuStr *needle);
+size_t cuStr_count_array(const cuStr *cus, const char *arr, size_t len);
+
+/* The same searches over raw memory. The find functions return NULL if
+ * there is no match.
+ */
+const char *cuMem_find_byte(const char *s, size_t n, char c);
+const char *cuMem_rfind_byte(const char *s, size_t n, char c);
+const char *cuMem_find(const char *s, size_t n, const char *needle,
+                       size_t needle_len);
+const char *cuMem_rfind(const char *s, size_t n, const char *needle,
+                        size_t needle_len);
+size_t cuMem_count_byte(const char *s, size_t n, char c);
+size_t cuMem_count(const char *s, size_t n, const char *needle,
+                   size_t needle_len);
+
+#endif /* CU_INCLUDE_STRSEARCH_H */
@@ -0,0 +1,192 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "cutil_strstats.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#   define cuStrStatsTHREAD _Thread_local
+#else
+#   define cuStrStatsTHREAD __thread
+#endif
+
+/* A thread's counters. Only the owner writes them, but snapshots read them
+ * from other threads, so both sides use relaxed atomics.
+ */
+typedef struct cuStrStatsThread {
+    cuStrStats stats;
+    struct cuStrStatsThread *prev, *next;
+    int registered;
+} cuStrStatsThread;
+
+static cuStrStatsTHREAD cuStrStatsThread cuStrStats_self;
+
+static pthread_mutex_t cuStrStats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t cuStrStats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t cuStrStats_key;
+static cuStrStatsThread *cuStrStats_threads;    // running threads
+static cuStrStats cuStrStats_exited;            // sum of exited threads
+
+static cuStrStatsHook cuStrStats_hook;
+static void *cuStrStats_hook_ctx;
+
+#define cuStrStatsLOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define cuStrStatsSTORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+
+/* Add the counters in from to sum */
+static void cuStr_stats_add(cuStrStats *sum, const cuStrStats *from)
+{
+    uint64_t peak = cuStrStatsLOAD(&from->peak_capacity);
+
+    sum->allocs += cuStrStatsLOAD(&from->allocs);
+    sum->reallocs += cuStrStatsLOAD(&from->reallocs);
+    sum->frees += cuStrStatsLOAD(&from->frees);
+    sum->bytes_copied += cuStrStatsLOAD(&from->bytes_copied);
+    sum->wasted_capacity += cuStrStatsLOAD(&from->wasted_capacity);
+    if (peak > sum->peak_capacity)
+        sum->peak_capacity = peak;
+}
+
+/* Runs when a registered thread exits */
+static void cuStr_stats_thread_exit(void *arg)
+{
+    cuStrStatsThread *t = arg;
+
+    pthread_mutex_lock(&cuStrStats_lock);
+    cuStr_stats_add(&cuStrStats_exited, &t->stats);
+    if (t->prev)
+        t->prev->next = t->next;
+    else
+        cuStrStats_threads = t->next;
+    if (t->next)
+        t->next->prev = t->prev;
+    pthread_mutex_unlock(&cuStrStats_lock);
+}
+
+static void cuStr_stats_init(void)
+{
+    pthread_key_create(&cuStrStats_key, cuStr_stats_thread_exit);
+}
+
+/* Link the calling thread's counters into the list on its first event */
+static void cuStr_stats_register(cuStrStatsThread *t)
+{
+    pthread_once(&cuStrStats_once, cuStr_stats_init);
+    pthread_mutex_lock(&cuStrStats_lock);
+    t->prev = NULL;
+    t->next = cuStrStats_threads;
+    if (t->next)
+        t->next->prev = t;
+    cuStrStats_threads = t;
+    pthread_mutex_unlock(&cuStrStats_lock);
+    pthread_setspecific(cuStrStats_key, t);
+    t->registered = 1;
+}
+
+static void cuStr_stats_atexit(void)
+{
+    cuStrStats stats;
+
+    if (cuStrStats_hook) {
+        cuStr_stats_snapshot(&stats);
+        cuStrStats_hook(&stats, cuStrStats_hook_ctx);
+    }
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+void cuStr_stats_count(int event, uint64_t n)
+{
+    cuStrStats *s = &cuStrStats_self.stats;
+    uint64_t *counter;
+
+    if (!cuStrStats_self.registered)
+        cuStr_stats_register(&cuStrStats_self);
+
+    switch (event) {
+    case CUSTR_STAT_ALLOC:      counter = &s->allocs; n = 1; break;
+    case CUSTR_STAT_REALLOC:    counter = &s->reallocs; n = 1; break;
+    case CUSTR_STAT_FREE:       counter = &s->frees; n = 1; break;
+    case CUSTR_STAT_COPY:       counter = &s->bytes_copied; break;
+    case CUSTR_STAT_WASTE:      counter = &s->wasted_capacity; break;
+    case CUSTR_STAT_CAPACITY:
+        if (n > s->peak_capacity)
+            cuStrStatsSTORE(&s->peak_capacity, n);
+        return;
+    default:
+        assert(0 && "unknown cuStr stats event");
+        return;
+    }
+    cuStrStatsSTORE(counter, *counter + n);
+}
+
+void cuStr_stats_snapshot(cuStrStats *stats)
+{
+    const cuStrStatsThread *t;
+
+    assert(stats != NULL); // pre-condition
+
+    pthread_mutex_lock(&cuStrStats_lock);
+    *stats = cuStrStats_exited;
+    for (t = cuStrStats_threads; t; t = t->next)
+        cuStr_stats_add(stats, &t->stats);
+    pthread_mutex_unlock(&cuStrStats_lock);
+}
+
+void cuStr_stats_reset(void)
+{
+    cuStrStatsThread *t;
+
+    /* The counters of other threads are reset under their feet, so an
+     * event counted at the same time may be lost
+     */
+    pthread_mutex_lock(&cuStrStats_lock);
+    memset(&cuStrStats_exited, 0, sizeof cuStrStats_exited);
+    for (t = cuStrStats_threads; t; t = t->next) {
+        cuStrStatsSTORE(&t->stats.allocs, 0);
+        cuStrStatsSTORE(&t->stats.reallocs, 0);
+        cuStrStatsSTORE(&t->stats.frees, 0);
+        cuStrStatsSTORE(&t->stats.bytes_copied, 0);
+        cuStrStatsSTORE(&t->stats.peak_capacity, 0);
+        cuStrStatsSTORE(&t->stats.wasted_capacity, 0);
+    }
+    pthread_mutex_unlock(&cuStrStats_lock);
+}
+
+void cuStr_stats_dump(FILE *f, const cuStrStats *stats)
+{
+    assert(f != NULL && stats != NULL); // pre-conditions
+
+    fprintf(f, "cuStr allocs:          %llu\n"
+               "cuStr reallocs:        %llu\n"
+               "cuStr frees:           %llu\n"
+               "cuStr bytes copied:    %llu\n"
+               "cuStr peak capacity:   %llu\n"
+               "cuStr wasted capacity: %llu\n",
+            (unsigned long long)stats->allocs,
+            (unsigned long long)stats->reallocs,
+            (unsigned long long)stats->frees,
+            (unsigned long long)stats->bytes_copied,
+            (unsigned long long)stats->peak_capacity,
+            (unsigned long long)stats->wasted_capacity);
+}
+
+void cuStr_stats_set_dump_hook(cuStrStatsHook hook, void *ctx)
+{
+    static int registered;
+
+    pthread_mutex_lock(&cuStrStats_lock);
+    cuStrStats_hook = hook;
+    cuStrStats_hook_ctx = ctx;
+    if (hook && !registered)
+        registered = atexit(cuStr_stats_atexit) == 0;
+    pthread_mutex_unlock(&cuStrStats_lock);
+}
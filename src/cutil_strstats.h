@@ -0,0 +1,56 @@
+#ifndef CU_INCLUDE_STRSTATS_H
+#define CU_INCLUDE_STRSTATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Counters of the memory work done by cuStr, to tune chunk sizes and growth
+ * factors from real workloads. They are only kept when the library is
+ * built with CUSTR_STATS defined; otherwise the snapshot is all zeros and
+ * the counting compiles away.
+ *
+ * Each thread counts into its own copy without locking. A snapshot adds up
+ * the counters of the running threads and of those that have exited.
+ */
+typedef struct cuStrStats {
+    uint64_t allocs;            // buffers and cuStr headers allocated
+    uint64_t reallocs;
+    uint64_t frees;
+    uint64_t bytes_copied;      // moved by resize, copy and shrinktofit
+    uint64_t peak_capacity;     // largest buffer, in bytes
+    uint64_t wasted_capacity;   // unused bytes of buffers when released
+} cuStrStats;
+
+/* The events counted by cuStr_stats_count() */
+enum {
+    CUSTR_STAT_ALLOC,
+    CUSTR_STAT_REALLOC,
+    CUSTR_STAT_FREE,
+    CUSTR_STAT_COPY,        // n bytes copied
+    CUSTR_STAT_CAPACITY,    // a buffer of n bytes now exists
+    CUSTR_STAT_WASTE        // a buffer was released with n bytes unused
+};
+
+#ifdef CUSTR_STATS
+#   define cuStrSTAT(event, n) cuStr_stats_count((event), (n))
+#else
+#   define cuStrSTAT(event, n) ((void)0)
+#endif
+
+/* Called by the string functions; use cuStrSTAT() so that the calls
+ * disappear without CUSTR_STATS
+ */
+void cuStr_stats_count(int event, uint64_t n);
+
+void cuStr_stats_snapshot(cuStrStats *stats);
+/* Zero the counters of every thread */
+void cuStr_stats_reset(void);
+void cuStr_stats_dump(FILE *f, const cuStrStats *stats);
+
+/* Have hook called with the final counters when the process exits, e.g.
+ * to log them. Without a hook nothing is reported.
+ */
+typedef void (*cuStrStatsHook)(const cuStrStats *stats, void *ctx);
+void cuStr_stats_set_dump_hook(cuStrStatsHook hook, void *ctx);
+
+#endif /* CU_INCLUDE_STRSTATS_H */
@@ -0,0 +1,1019 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_strutf8.h"
+#include "cutil_simd.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#define cuMemUTF8_ASCII_MASK    UINT64_C(0x8080808080808080)
+
+static void cuMem_store16(char *p, uint32_t v)
+{
+    uint16_t u = (uint16_t)v;
+    memcpy(p, &u, sizeof u);
+}
+
+static void cuMem_store32(char *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof v);
+}
+
+static int cuMem_utf8_is_cont(unsigned char c)
+{
+    return (c & 0xC0) == 0x80;
+}
+
+/* Byte by byte, following table 3-7 of the Unicode standard, after skipping
+ * words of ASCII
+ */
+static bool cuMem_utf8_validate_scalar(const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    size_t i = 0;
+
+    while (i < n) {
+        unsigned char c = s[i], lo = 0x80, hi = 0xBF;
+        uint64_t w;
+
+        if (c < 0x80) {
+            if (i + 8 <= n) {
+                memcpy(&w, s + i, sizeof w);
+                if (!(w & cuMemUTF8_ASCII_MASK)) {
+                    i += 8;
+                    continue;
+                }
+            }
+            i++;
+        } else if (c >= 0xC2 && c <= 0xDF) {
+            if (n - i < 2 || !cuMem_utf8_is_cont(s[i + 1]))
+                return false;
+            i += 2;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            if (c == 0xE0)
+                lo = 0xA0;      // overlong
+            else if (c == 0xED)
+                hi = 0x9F;      // surrogates
+            if (n - i < 3 || s[i + 1] < lo || s[i + 1] > hi
+                || !cuMem_utf8_is_cont(s[i + 2]))
+                return false;
+            i += 3;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            if (c == 0xF0)
+                lo = 0x90;      // overlong
+            else if (c == 0xF4)
+                hi = 0x8F;      // above U+10FFFF
+            if (n - i < 4 || s[i + 1] < lo || s[i + 1] > hi
+                || !cuMem_utf8_is_cont(s[i + 2])
+                || !cuMem_utf8_is_cont(s[i + 3]))
+                return false;
+            i += 4;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t cuMem_utf8_length_scalar(const char *s, size_t n)
+{
+    size_t i, count = 0;
+
+    for (i = 0; i < n; i++)
+        count += !cuMem_utf8_is_cont((unsigned char)s[i]);
+    return count;
+}
+
+/* Decode the character at s, which must be valid */
+static size_t cuMem_utf8_decode(const unsigned char *s, uint32_t *cp)
+{
+    if (s[0] < 0xE0) {
+        *cp = (uint32_t)(s[0] & 0x1F) << 6 | (s[1] & 0x3F);
+        return 2;
+    }
+    if (s[0] < 0xF0) {
+        *cp = (uint32_t)(s[0] & 0x0F) << 12 | (uint32_t)(s[1] & 0x3F) << 6
+              | (s[2] & 0x3F);
+        return 3;
+    }
+    *cp = (uint32_t)(s[0] & 0x07) << 18 | (uint32_t)(s[1] & 0x3F) << 12
+          | (uint32_t)(s[2] & 0x3F) << 6 | (s[3] & 0x3F);
+    return 4;
+}
+
+/* Encode a code point, which must be valid; returns its length */
+static size_t cuMem_utf8_encode(char *p, uint32_t cp)
+{
+    if (cp < 0x80) {
+        p[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        p[0] = (char)(0xC0 | cp >> 6);
+        p[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        p[0] = (char)(0xE0 | cp >> 12);
+        p[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        p[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    p[0] = (char)(0xF0 | cp >> 18);
+    p[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    p[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    p[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* A kernel checks whole blocks and stops after the last one, which may end
+ * inside a character. Back up to where that character starts so that the
+ * scalar code checks it whole.
+ */
+static size_t cuMem_utf8_char_start(const char *s, size_t i)
+{
+    size_t k;
+
+    for (k = 0; k < 3 && i > 0; k++) {
+        if (!cuMem_utf8_is_cont((unsigned char)s[i - 1]))
+            break;
+        i--;
+    }
+    if (i > 0 && (unsigned char)s[i - 1] >= 0xC0)
+        i--;
+    return i;
+}
+
+#ifdef CU_SIMD_X86
+
+/* The lookup tables of Keiser and Lemire, "Validating UTF-8 in less than
+ * one instruction per byte". Each error a pair of bytes can show has a bit,
+ * set in the entries for the high nibble of the first byte, its low nibble
+ * and the high nibble of the second byte; a bit set in all three is an
+ * error. Three and four byte sequences are then checked for continuation
+ * bytes where they need them.
+ */
+#define cuMemUTF8_TOO_SHORT     (1 << 0)    // lead without a continuation
+#define cuMemUTF8_TOO_LONG      (1 << 1)    // ASCII followed by a continuation
+#define cuMemUTF8_OVERLONG_3    (1 << 2)
+#define cuMemUTF8_TOO_LARGE     (1 << 3)
+#define cuMemUTF8_SURROGATE     (1 << 4)
+#define cuMemUTF8_OVERLONG_2    (1 << 5)
+#define cuMemUTF8_TOO_LARGE_1000 (1 << 6)
+#define cuMemUTF8_OVERLONG_4    (1 << 6)
+#define cuMemUTF8_TWO_CONTS     (1 << 7)    // two continuations, maybe valid
+#define cuMemUTF8_CARRY         (cuMemUTF8_TOO_SHORT | cuMemUTF8_TOO_LONG \
+                                 | cuMemUTF8_TWO_CONTS)
+
+static const unsigned char cuMem_utf8_byte1_high[16] = {
+    /* 0___ ASCII */
+    cuMemUTF8_TOO_LONG, cuMemUTF8_TOO_LONG, cuMemUTF8_TOO_LONG,
+    cuMemUTF8_TOO_LONG, cuMemUTF8_TOO_LONG, cuMemUTF8_TOO_LONG,
+    cuMemUTF8_TOO_LONG, cuMemUTF8_TOO_LONG,
+    /* 10__ continuation */
+    cuMemUTF8_TWO_CONTS, cuMemUTF8_TWO_CONTS,
+    cuMemUTF8_TWO_CONTS, cuMemUTF8_TWO_CONTS,
+    /* 1100, 1101 two byte lead */
+    cuMemUTF8_TOO_SHORT | cuMemUTF8_OVERLONG_2,
+    cuMemUTF8_TOO_SHORT,
+    /* 1110 three byte lead */
+    cuMemUTF8_TOO_SHORT | cuMemUTF8_OVERLONG_3 | cuMemUTF8_SURROGATE,
+    /* 1111 four byte lead */
+    cuMemUTF8_TOO_SHORT | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000
+    | cuMemUTF8_OVERLONG_4,
+};
+
+static const unsigned char cuMem_utf8_byte1_low[16] = {
+    cuMemUTF8_CARRY | cuMemUTF8_OVERLONG_3 | cuMemUTF8_OVERLONG_2
+    | cuMemUTF8_OVERLONG_4,
+    cuMemUTF8_CARRY | cuMemUTF8_OVERLONG_2,
+    cuMemUTF8_CARRY,
+    cuMemUTF8_CARRY,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000
+    | cuMemUTF8_SURROGATE,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+    cuMemUTF8_CARRY | cuMemUTF8_TOO_LARGE | cuMemUTF8_TOO_LARGE_1000,
+};
+
+static const unsigned char cuMem_utf8_byte2_high[16] = {
+    /* 0___ ASCII */
+    cuMemUTF8_TOO_SHORT, cuMemUTF8_TOO_SHORT, cuMemUTF8_TOO_SHORT,
+    cuMemUTF8_TOO_SHORT, cuMemUTF8_TOO_SHORT, cuMemUTF8_TOO_SHORT,
+    cuMemUTF8_TOO_SHORT, cuMemUTF8_TOO_SHORT,
+    /* 1000 */
+    cuMemUTF8_TOO_LONG | cuMemUTF8_OVERLONG_2 | cuMemUTF8_TWO_CONTS
+    | cuMemUTF8_OVERLONG_3 | cuMemUTF8_TOO_LARGE_1000 | cuMemUTF8_OVERLONG_4,
+    /* 1001 */
+    cuMemUTF8_TOO_LONG | cuMemUTF8_OVERLONG_2 | cuMemUTF8_TWO_CONTS
+    | cuMemUTF8_OVERLONG_3 | cuMemUTF8_TOO_LARGE,
+    /* 101_ */
+    cuMemUTF8_TOO_LONG | cuMemUTF8_OVERLONG_2 | cuMemUTF8_TWO_CONTS
+    | cuMemUTF8_SURROGATE | cuMemUTF8_TOO_LARGE,
+    cuMemUTF8_TOO_LONG | cuMemUTF8_OVERLONG_2 | cuMemUTF8_TWO_CONTS
+    | cuMemUTF8_SURROGATE | cuMemUTF8_TOO_LARGE,
+    /* 11__ lead */
+    cuMemUTF8_TOO_SHORT, cuMemUTF8_TOO_SHORT, cuMemUTF8_TOO_SHORT,
+    cuMemUTF8_TOO_SHORT,
+};
+
+/* One of the tables above in a vector. The kernels load the three once,
+ * before their loop, and pass them to the error checks.
+ */
+#define cuMemUTF8_TABLE(t)      _mm_loadu_si128((const __m128i *)(t))
+
+CU_TARGET_SSSE3
+static __m128i cuMem_utf8_errors_ssse3(__m128i v, __m128i prev,
+                                       __m128i byte1_high, __m128i byte1_low,
+                                       __m128i byte2_high)
+{
+    const __m128i low4 = _mm_set1_epi8(0x0f);
+    const __m128i top = _mm_set1_epi8((char)0x80);
+    const __m128i prev1 = _mm_alignr_epi8(v, prev, 15);
+    const __m128i high1 = _mm_and_si128(_mm_srli_epi16(prev1, 4), low4);
+    const __m128i low1 = _mm_and_si128(prev1, low4);
+    const __m128i high2 = _mm_and_si128(_mm_srli_epi16(v, 4), low4);
+    __m128i sc, must3, must4;
+
+    sc = _mm_shuffle_epi8(byte1_high, high1);
+    sc = _mm_and_si128(sc, _mm_shuffle_epi8(byte1_low, low1));
+    sc = _mm_and_si128(sc, _mm_shuffle_epi8(byte2_high, high2));
+
+    /* Only a lead of three or four bytes two or three places back leaves
+     * the top bit set
+     */
+    must3 = _mm_subs_epu8(_mm_alignr_epi8(v, prev, 14),
+                          _mm_set1_epi8(0xE0 - 0x80));
+    must4 = _mm_subs_epu8(_mm_alignr_epi8(v, prev, 13),
+                          _mm_set1_epi8((char)(0xF0 - 0x80)));
+    must3 = _mm_or_si128(must3, must4);
+    return _mm_xor_si128(_mm_and_si128(must3, top), sc);
+}
+
+/* Returns the length of a valid prefix or CUMEM_UTF_ERROR. Blocks of ASCII
+ * only need to check that the block before did not end inside a character.
+ */
+CU_TARGET_SSSE3
+static size_t cuMem_utf8_validate_ssse3(const char *s, size_t n)
+{
+    const __m128i max_tail = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,
+                                           -1, -1, -1, -1, -1, (char)0xEF,
+                                           (char)0xDF, (char)0xBF);
+    const __m128i byte1_high = cuMemUTF8_TABLE(cuMem_utf8_byte1_high);
+    const __m128i byte1_low = cuMemUTF8_TABLE(cuMem_utf8_byte1_low);
+    const __m128i byte2_high = cuMemUTF8_TABLE(cuMem_utf8_byte2_high);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i prev = zero, incomplete = zero, error = zero;
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+
+        if (_mm_movemask_epi8(v) == 0) {
+            error = _mm_or_si128(error, incomplete);
+            incomplete = zero;
+        } else {
+            __m128i e = cuMem_utf8_errors_ssse3(v, prev, byte1_high,
+                                                byte1_low, byte2_high);
+            error = _mm_or_si128(error, e);
+            incomplete = _mm_subs_epu8(v, max_tail);
+        }
+        prev = v;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF)
+        return CUMEM_UTF_ERROR;
+    return cuMem_utf8_char_start(s, i);
+}
+
+/* The last n bytes of prev followed by v, for each 128-bit lane */
+#define cuMemUTF8_PREV_AVX2(v, prev, n) \
+    _mm256_alignr_epi8((v), _mm256_permute2x128_si256((prev), (v), 0x21), \
+                       16 - (n))
+
+CU_TARGET_AVX2
+static __m256i cuMem_utf8_errors_avx2(__m256i v, __m256i prev,
+                                      __m256i byte1_high, __m256i byte1_low,
+                                      __m256i byte2_high)
+{
+    const __m256i low4 = _mm256_set1_epi8(0x0f);
+    const __m256i top = _mm256_set1_epi8((char)0x80);
+    const __m256i prev1 = cuMemUTF8_PREV_AVX2(v, prev, 1);
+    const __m256i high1 = _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low4);
+    const __m256i low1 = _mm256_and_si256(prev1, low4);
+    const __m256i high2 = _mm256_and_si256(_mm256_srli_epi16(v, 4), low4);
+    __m256i sc, must3, must4;
+
+    sc = _mm256_shuffle_epi8(byte1_high, high1);
+    sc = _mm256_and_si256(sc, _mm256_shuffle_epi8(byte1_low, low1));
+    sc = _mm256_and_si256(sc, _mm256_shuffle_epi8(byte2_high, high2));
+
+    must3 = _mm256_subs_epu8(cuMemUTF8_PREV_AVX2(v, prev, 2),
+                             _mm256_set1_epi8(0xE0 - 0x80));
+    must4 = _mm256_subs_epu8(cuMemUTF8_PREV_AVX2(v, prev, 3),
+                             _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    must3 = _mm256_or_si256(must3, must4);
+    return _mm256_xor_si256(_mm256_and_si256(must3, top), sc);
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_utf8_validate_avx2(const char *s, size_t n)
+{
+    const __m256i max_tail = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1,
+                                              -1, -1, -1, -1, -1, -1, -1, -1,
+                                              -1, -1, -1, -1, -1, -1, -1, -1,
+                                              -1, -1, -1, -1, -1, (char)0xEF,
+                                              (char)0xDF, (char)0xBF);
+    const __m256i byte1_high =
+        _mm256_broadcastsi128_si256(cuMemUTF8_TABLE(cuMem_utf8_byte1_high));
+    const __m256i byte1_low =
+        _mm256_broadcastsi128_si256(cuMemUTF8_TABLE(cuMem_utf8_byte1_low));
+    const __m256i byte2_high =
+        _mm256_broadcastsi128_si256(cuMemUTF8_TABLE(cuMem_utf8_byte2_high));
+    __m256i prev = _mm256_setzero_si256(), incomplete = prev, error = prev;
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+
+        if (_mm256_movemask_epi8(v) == 0) {
+            error = _mm256_or_si256(error, incomplete);
+            incomplete = _mm256_setzero_si256();
+        } else {
+            __m256i e = cuMem_utf8_errors_avx2(v, prev, byte1_high,
+                                               byte1_low, byte2_high);
+            error = _mm256_or_si256(error, e);
+            incomplete = _mm256_subs_epu8(v, max_tail);
+        }
+        prev = v;
+    }
+    if (!_mm256_testz_si256(error, error))
+        return CUMEM_UTF_ERROR;
+    return cuMem_utf8_char_start(s, i);
+}
+
+/* Code points in the first n / 16 * 16 bytes: every byte above 0xBF as a
+ * signed value is not a continuation byte. The counts are kept per byte for
+ * up to 255 blocks.
+ */
+static size_t cuMem_utf8_length_sse2(const char *s, size_t n)
+{
+    const __m128i cont_max = _mm_set1_epi8((char)0xBF);
+    size_t i = 0, k, count = 0;
+
+    while (i + 16 <= n) {
+        __m128i counts = _mm_setzero_si128();
+        for (k = 0; k < 255 && i + 16 <= n; k++, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+            counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(v, cont_max));
+        }
+        counts = _mm_sad_epu8(counts, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si32(counts);
+        counts = _mm_unpackhi_epi64(counts, counts);
+        count += (size_t)_mm_cvtsi128_si32(counts);
+    }
+    return count;
+}
+
+/* The same for the first n / 32 * 32 bytes */
+CU_TARGET_AVX2
+static size_t cuMem_utf8_length_avx2(const char *s, size_t n)
+{
+    const __m256i cont_max = _mm256_set1_epi8((char)0xBF);
+    size_t i = 0, k, count = 0;
+
+    while (i + 32 <= n) {
+        __m256i counts = _mm256_setzero_si256();
+        for (k = 0; k < 255 && i + 32 <= n; k++, i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+            counts = _mm256_sub_epi8(counts, _mm256_cmpgt_epi8(v, cont_max));
+        }
+        counts = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+        count += (size_t)_mm256_extract_epi64(counts, 0)
+                 + (size_t)_mm256_extract_epi64(counts, 1)
+                 + (size_t)_mm256_extract_epi64(counts, 2)
+                 + (size_t)_mm256_extract_epi64(counts, 3);
+    }
+    return count;
+}
+
+/* ASCII fast paths: convert whole blocks for as long as they hold nothing
+ * else, and return the number of characters done. Those from UTF-8 take
+ * the arguments of the AVX2 kernels further down, which set *units to the
+ * number of code units written.
+ */
+static size_t cuMem_ascii_to_utf16_sse2(char *dst, const char *src, size_t n,
+                                        size_t *units)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i *out = (__m128i *)(dst + 2 * i);
+        if (_mm_movemask_epi8(v))
+            break;
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(v, zero));
+    }
+    *units = i;
+    return i;
+}
+
+static size_t cuMem_ascii_to_utf32_sse2(char *dst, const char *src, size_t n,
+                                        size_t *units)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i *out = (__m128i *)(dst + 4 * i);
+        __m128i lo, hi;
+        if (_mm_movemask_epi8(v))
+            break;
+        lo = _mm_unpacklo_epi8(v, zero);
+        hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+    }
+    *units = i;
+    return i;
+}
+
+static size_t cuMem_utf16_to_ascii_sse2(char *dst, const uint16_t *src,
+                                        size_t n)
+{
+    const __m128i non_ascii = _mm_set1_epi16((short)0xFF80);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 8));
+        __m128i high = _mm_and_si128(_mm_or_si128(a, b), non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, zero)) != 0xFFFF)
+            break;
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(a, b));
+    }
+    return i;
+}
+
+static size_t cuMem_utf32_to_ascii_sse2(char *dst, const uint32_t *src,
+                                        size_t n)
+{
+    const __m128i non_ascii = _mm_set1_epi32((int)0xFFFFFF80);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 4));
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + i + 8));
+        __m128i d = _mm_loadu_si128((const __m128i *)(src + i + 12));
+        __m128i high = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        high = _mm_and_si128(high, non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, zero)) != 0xFFFF)
+            break;
+        a = _mm_packs_epi32(a, b);
+        c = _mm_packs_epi32(c, d);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(a, c));
+    }
+    return i;
+}
+
+/* For the AVX2 kernels: the positions of the set bits of each byte value,
+ * three bits each from the lowest, with their count in the top byte
+ */
+static const uint32_t cuMem_utf8_compress[256] = {
+    0x00000000, 0x01000000, 0x01000001, 0x02000008, 0x01000002, 0x02000010,
+    0x02000011, 0x03000088, 0x01000003, 0x02000018, 0x02000019, 0x030000c8,
+    0x0200001a, 0x030000d0, 0x030000d1, 0x04000688, 0x01000004, 0x02000020,
+    0x02000021, 0x03000108, 0x02000022, 0x03000110, 0x03000111, 0x04000888,
+    0x02000023, 0x03000118, 0x03000119, 0x040008c8, 0x0300011a, 0x040008d0,
+    0x040008d1, 0x05004688, 0x01000005, 0x02000028, 0x02000029, 0x03000148,
+    0x0200002a, 0x03000150, 0x03000151, 0x04000a88, 0x0200002b, 0x03000158,
+    0x03000159, 0x04000ac8, 0x0300015a, 0x04000ad0, 0x04000ad1, 0x05005688,
+    0x0200002c, 0x03000160, 0x03000161, 0x04000b08, 0x03000162, 0x04000b10,
+    0x04000b11, 0x05005888, 0x03000163, 0x04000b18, 0x04000b19, 0x050058c8,
+    0x04000b1a, 0x050058d0, 0x050058d1, 0x0602c688, 0x01000006, 0x02000030,
+    0x02000031, 0x03000188, 0x02000032, 0x03000190, 0x03000191, 0x04000c88,
+    0x02000033, 0x03000198, 0x03000199, 0x04000cc8, 0x0300019a, 0x04000cd0,
+    0x04000cd1, 0x05006688, 0x02000034, 0x030001a0, 0x030001a1, 0x04000d08,
+    0x030001a2, 0x04000d10, 0x04000d11, 0x05006888, 0x030001a3, 0x04000d18,
+    0x04000d19, 0x050068c8, 0x04000d1a, 0x050068d0, 0x050068d1, 0x06034688,
+    0x02000035, 0x030001a8, 0x030001a9, 0x04000d48, 0x030001aa, 0x04000d50,
+    0x04000d51, 0x05006a88, 0x030001ab, 0x04000d58, 0x04000d59, 0x05006ac8,
+    0x04000d5a, 0x05006ad0, 0x05006ad1, 0x06035688, 0x030001ac, 0x04000d60,
+    0x04000d61, 0x05006b08, 0x04000d62, 0x05006b10, 0x05006b11, 0x06035888,
+    0x04000d63, 0x05006b18, 0x05006b19, 0x060358c8, 0x05006b1a, 0x060358d0,
+    0x060358d1, 0x071ac688, 0x01000007, 0x02000038, 0x02000039, 0x030001c8,
+    0x0200003a, 0x030001d0, 0x030001d1, 0x04000e88, 0x0200003b, 0x030001d8,
+    0x030001d9, 0x04000ec8, 0x030001da, 0x04000ed0, 0x04000ed1, 0x05007688,
+    0x0200003c, 0x030001e0, 0x030001e1, 0x04000f08, 0x030001e2, 0x04000f10,
+    0x04000f11, 0x05007888, 0x030001e3, 0x04000f18, 0x04000f19, 0x050078c8,
+    0x04000f1a, 0x050078d0, 0x050078d1, 0x0603c688, 0x0200003d, 0x030001e8,
+    0x030001e9, 0x04000f48, 0x030001ea, 0x04000f50, 0x04000f51, 0x05007a88,
+    0x030001eb, 0x04000f58, 0x04000f59, 0x05007ac8, 0x04000f5a, 0x05007ad0,
+    0x05007ad1, 0x0603d688, 0x030001ec, 0x04000f60, 0x04000f61, 0x05007b08,
+    0x04000f62, 0x05007b10, 0x05007b11, 0x0603d888, 0x04000f63, 0x05007b18,
+    0x05007b19, 0x0603d8c8, 0x05007b1a, 0x0603d8d0, 0x0603d8d1, 0x071ec688,
+    0x0200003e, 0x030001f0, 0x030001f1, 0x04000f88, 0x030001f2, 0x04000f90,
+    0x04000f91, 0x05007c88, 0x030001f3, 0x04000f98, 0x04000f99, 0x05007cc8,
+    0x04000f9a, 0x05007cd0, 0x05007cd1, 0x0603e688, 0x030001f4, 0x04000fa0,
+    0x04000fa1, 0x05007d08, 0x04000fa2, 0x05007d10, 0x05007d11, 0x0603e888,
+    0x04000fa3, 0x05007d18, 0x05007d19, 0x0603e8c8, 0x05007d1a, 0x0603e8d0,
+    0x0603e8d1, 0x071f4688, 0x030001f5, 0x04000fa8, 0x04000fa9, 0x05007d48,
+    0x04000faa, 0x05007d50, 0x05007d51, 0x0603ea88, 0x04000fab, 0x05007d58,
+    0x05007d59, 0x0603eac8, 0x05007d5a, 0x0603ead0, 0x0603ead1, 0x071f5688,
+    0x04000fac, 0x05007d60, 0x05007d61, 0x0603eb08, 0x05007d62, 0x0603eb10,
+    0x0603eb11, 0x071f5888, 0x05007d63, 0x0603eb18, 0x0603eb19, 0x071f58c8,
+    0x0603eb1a, 0x071f58d0, 0x071f58d1, 0x08fac688,
+};
+
+/* The code point of the character that would start at each of the first 8
+ * bytes at p, in 32-bit lanes; those at continuation bytes mean nothing.
+ * Each lane gets the 4 bytes from its position, so that 11 bytes are read
+ * from the 16 loaded. With the marker bits of the bytes masked off, two
+ * multiply-adds put the payloads of all 4 together as if it was a four
+ * byte character, and a shift drops those of the bytes past the end of
+ * shorter ones.
+ */
+CU_TARGET_AVX2
+static inline __m256i cuMem_utf8_decode8_avx2(__m128i raw)
+{
+    const __m256i spread = _mm256_setr_epi8(0, 1, 2, 3, 1, 2, 3, 4,
+                                            2, 3, 4, 5, 3, 4, 5, 6,
+                                            4, 5, 6, 7, 5, 6, 7, 8,
+                                            6, 7, 8, 9, 7, 8, 9, 10);
+    /* By the high nibble of the first byte */
+    const __m256i lead_mask = _mm256_setr_epi8(
+        0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+        0x3F, 0x3F, 0x3F, 0x3F, 0x1F, 0x1F, 0x0F, 0x07,
+        0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F,
+        0x3F, 0x3F, 0x3F, 0x3F, 0x1F, 0x1F, 0x0F, 0x07);
+    const __m256i shift = _mm256_setr_epi8(
+        18, 18, 18, 18, 18, 18, 18, 18, 0, 0, 0, 0, 12, 12, 6, 0,
+        18, 18, 18, 18, 18, 18, 18, 18, 0, 0, 0, 0, 12, 12, 6, 0);
+    const __m256i first = _mm256_set1_epi32(0xFF);
+    const __m256i low4 = _mm256_set1_epi8(0x0F);
+    const __m256i x = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(raw),
+                                          spread);
+    const __m256i nibble = _mm256_and_si256(_mm256_srli_epi16(x, 4), low4);
+    __m256i mask, payload, cp;
+
+    mask = _mm256_and_si256(_mm256_shuffle_epi8(lead_mask, nibble), first);
+    mask = _mm256_or_si256(mask, _mm256_set1_epi32(0x3F3F3F00));
+    payload = _mm256_and_si256(x, mask);
+    cp = _mm256_maddubs_epi16(payload, _mm256_set1_epi16(0x0140));
+    cp = _mm256_madd_epi16(cp, _mm256_set1_epi32(0x00011000));
+    return _mm256_srlv_epi32(cp, _mm256_and_si256(
+        _mm256_shuffle_epi8(shift, nibble), first));
+}
+
+/* Move the lanes picked by the bits of mask to the front; *count gets how
+ * many there are
+ */
+CU_TARGET_AVX2
+static inline __m256i cuMem_utf8_compress_avx2(__m256i v, unsigned mask,
+                                               size_t *count)
+{
+    const uint32_t entry = cuMem_utf8_compress[mask];
+    const __m256i shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    __m256i idx = _mm256_srlv_epi32(_mm256_set1_epi32((int)entry), shifts);
+
+    *count = entry >> 24;
+    idx = _mm256_and_si256(idx, _mm256_set1_epi32(7));
+    return _mm256_permutevar8x32_epi32(v, idx);
+}
+
+/* Valid UTF-8 to UTF-32, 16 bytes of ASCII or 8 bytes of anything at a
+ * time: decode a character at every position and keep those that start
+ * one. Stops before the last 16 bytes and returns the number of bytes done,
+ * past the end of the last character.
+ */
+CU_TARGET_AVX2
+static size_t cuMem_utf8_to_utf32_avx2(char *dst, const char *src, size_t n,
+                                       size_t *units)
+{
+    const __m128i cont_max = _mm_set1_epi8((char)0xBF);
+    size_t i = 0, o = 0, count;
+    unsigned starts;
+    __m256i cp;
+
+    while (i + 16 <= n) {
+        __m128i raw = _mm_loadu_si128((const __m128i *)(src + i));
+        __m256i *out = (__m256i *)(dst + 4 * o);
+
+        if (_mm_movemask_epi8(raw) == 0) {
+            _mm256_storeu_si256(out, _mm256_cvtepu8_epi32(raw));
+            raw = _mm_srli_si128(raw, 8);
+            _mm256_storeu_si256(out + 1, _mm256_cvtepu8_epi32(raw));
+            i += 16;
+            o += 16;
+            continue;
+        }
+        starts = (unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(raw, cont_max));
+        cp = cuMem_utf8_decode8_avx2(raw);
+        _mm256_storeu_si256(out, cuMem_utf8_compress_avx2(cp, starts & 0xFF,
+                                                          &count));
+        i += 8;
+        o += count;
+    }
+    while (i < n && cuMem_utf8_is_cont((unsigned char)src[i]))
+        i++;
+    *units = o;
+    return i;
+}
+
+/* The same to UTF-16, stopping at characters that need a surrogate pair */
+CU_TARGET_AVX2
+static size_t cuMem_utf8_to_utf16_avx2(char *dst, const char *src, size_t n,
+                                       size_t *units)
+{
+    const __m128i cont_max = _mm_set1_epi8((char)0xBF);
+    const __m128i lead4 = _mm_set1_epi8((char)0xF0);
+    size_t i = 0, o = 0, count;
+    unsigned starts;
+    __m256i cp;
+
+    while (i + 16 <= n) {
+        __m128i raw = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i four;
+
+        if (_mm_movemask_epi8(raw) == 0) {
+            _mm256_storeu_si256((__m256i *)(dst + 2 * o),
+                                _mm256_cvtepu8_epi16(raw));
+            i += 16;
+            o += 16;
+            continue;
+        }
+        four = _mm_cmpeq_epi8(_mm_and_si128(raw, lead4), lead4);
+        if (_mm_movemask_epi8(four) & 0xFF)
+            break;
+        starts = (unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(raw, cont_max));
+        cp = cuMem_utf8_decode8_avx2(raw);
+        cp = cuMem_utf8_compress_avx2(cp, starts & 0xFF, &count);
+        cp = _mm256_permute4x64_epi64(_mm256_packus_epi32(cp, cp), 0xD8);
+        _mm_storeu_si128((__m128i *)(dst + 2 * o), _mm256_castsi256_si128(cp));
+        i += 8;
+        o += count;
+    }
+    while (i < n && cuMem_utf8_is_cont((unsigned char)src[i]))
+        i++;
+    *units = o;
+    return i;
+}
+
+/* Packing works within 128-bit lanes, so the result is put back in order */
+CU_TARGET_AVX2
+static size_t cuMem_utf16_to_ascii_avx2(char *dst, const uint16_t *src,
+                                        size_t n)
+{
+    const __m256i non_ascii = _mm256_set1_epi16((short)0xFF80);
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i + 16));
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), non_ascii))
+            break;
+        a = _mm256_packus_epi16(a, b);
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_permute4x64_epi64(a, 0xD8));
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_utf32_to_ascii_avx2(char *dst, const uint32_t *src,
+                                        size_t n)
+{
+    const __m256i non_ascii = _mm256_set1_epi32((int)0xFFFFFF80);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(src + i + 16));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(src + i + 24));
+        __m256i all = _mm256_or_si256(_mm256_or_si256(a, b),
+                                      _mm256_or_si256(c, d));
+        if (!_mm256_testz_si256(all, non_ascii))
+            break;
+        a = _mm256_packs_epi32(a, b);
+        c = _mm256_packs_epi32(c, d);
+        a = _mm256_packus_epi16(a, c);
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_permutevar8x32_epi32(a, order));
+    }
+    return i;
+}
+
+#endif /* CU_SIMD_X86 */
+
+/* The kernel for code units of unit bytes, if there is one */
+typedef size_t (*cuMemUtf8Kernel)(char *, const char *, size_t, size_t *);
+
+static cuMemUtf8Kernel cuMem_utf8_kernel(size_t unit)
+{
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        return unit == 2 ? cuMem_utf8_to_utf16_avx2 : cuMem_utf8_to_utf32_avx2;
+    if (features & CU_CPU_SSE2)
+        return unit == 2 ? cuMem_ascii_to_utf16_sse2
+                         : cuMem_ascii_to_utf32_sse2;
+#endif
+    (void)unit;
+    return NULL;
+}
+
+/* Valid UTF-8 to UTF-16 and UTF-32, stored unaligned. The kernel goes as
+ * far as it can and the scalar code takes over; when the kernel gave up
+ * early, for at least 16 bytes.
+ */
+static size_t cuMem_utf8_to_units16(char *dst, const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    const unsigned char *end = s + n, *retry = s;
+    cuMemUtf8Kernel kernel = cuMem_utf8_kernel(2);
+    char *o = dst;
+    size_t units;
+    uint32_t cp;
+
+    while (s < end) {
+        if (kernel && s >= retry && end - s >= 16) {
+            size_t done = kernel(o, (const char *)s, (size_t)(end - s), &units);
+            s += done;
+            o += 2 * units;
+            if (s == end)
+                break;
+            if (done < 16)
+                retry = s + 16;
+        }
+        if (*s < 0x80) {
+            cuMem_store16(o, *s++);
+            o += 2;
+            continue;
+        }
+        s += cuMem_utf8_decode(s, &cp);
+        if (cp < 0x10000) {
+            cuMem_store16(o, cp);
+            o += 2;
+        } else {
+            cp -= 0x10000;
+            cuMem_store16(o, 0xD800 | cp >> 10);
+            cuMem_store16(o + 2, 0xDC00 | (cp & 0x3FF));
+            o += 4;
+        }
+    }
+    return (size_t)(o - dst) / 2;
+}
+
+static size_t cuMem_utf8_to_units32(char *dst, const char *src, size_t n)
+{
+    const unsigned char *s = (const unsigned char *)src;
+    const unsigned char *end = s + n, *retry = s;
+    cuMemUtf8Kernel kernel = cuMem_utf8_kernel(4);
+    char *o = dst;
+    size_t units;
+    uint32_t cp;
+
+    while (s < end) {
+        if (kernel && s >= retry && end - s >= 16) {
+            size_t done = kernel(o, (const char *)s, (size_t)(end - s), &units);
+            s += done;
+            o += 4 * units;
+            if (s == end)
+                break;
+            if (done < 16)
+                retry = s + 16;
+        }
+        if (*s < 0x80) {
+            cp = *s++;
+        } else {
+            s += cuMem_utf8_decode(s, &cp);
+        }
+        cuMem_store32(o, cp);
+        o += 4;
+    }
+    return (size_t)(o - dst) / 4;
+}
+
+static cuStr *cuStr_utf_commit(cuStr *cus, size_t len)
+{
+    if (len == CUMEM_UTF_ERROR) {
+        if (cus->mem)
+            cus->mem[cus->elements_used] = '\0';
+        return NULL;
+    }
+    return cuStr_commit(cus, len);
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+bool cuMem_utf8_validate(const char *s, size_t n)
+{
+    size_t done = 0;
+
+    assert(s != NULL || n == 0); // pre-condition
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        done = cuMem_utf8_validate_avx2(s, n);
+    else if (features & CU_CPU_SSSE3)
+        done = cuMem_utf8_validate_ssse3(s, n);
+    if (done == CUMEM_UTF_ERROR)
+        return false;
+#endif
+    return cuMem_utf8_validate_scalar(s + done, n - done);
+}
+
+bool cuStr_utf8_validate(const cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+
+    return cuMem_utf8_validate(cus->mem, cus->elements_used);
+}
+
+size_t cuMem_utf8_length(const char *s, size_t n)
+{
+    size_t done = 0, count = 0;
+
+    assert(s != NULL || n == 0); // pre-condition
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2) {
+        count = cuMem_utf8_length_avx2(s, n);
+        done = n / 32 * 32;
+    } else if (features & CU_CPU_SSE2) {
+        count = cuMem_utf8_length_sse2(s, n);
+        done = n / 16 * 16;
+    }
+#endif
+    return count + cuMem_utf8_length_scalar(s + done, n - done);
+}
+
+size_t cuStr_utf8_length(const cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+
+    return cuMem_utf8_length(cus->mem, cus->elements_used);
+}
+
+size_t cuMem_utf8_to_utf16(uint16_t *dst, const char *src, size_t n)
+{
+    if (!cuMem_utf8_validate(src, n))
+        return CUMEM_UTF_ERROR;
+    return cuMem_utf8_to_units16((char *)dst, src, n);
+}
+
+size_t cuMem_utf8_to_utf32(uint32_t *dst, const char *src, size_t n)
+{
+    if (!cuMem_utf8_validate(src, n))
+        return CUMEM_UTF_ERROR;
+    return cuMem_utf8_to_units32((char *)dst, src, n);
+}
+
+size_t cuMem_utf16_to_utf8(char *dst, const uint16_t *src, size_t n)
+{
+    size_t (*ascii)(char *, const uint16_t *, size_t) = NULL;
+    size_t i = 0, o = 0;
+
+    assert(src != NULL || n == 0); // pre-condition
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        ascii = cuMem_utf16_to_ascii_avx2;
+    else if (features & CU_CPU_SSE2)
+        ascii = cuMem_utf16_to_ascii_sse2;
+#endif
+
+    while (i < n) {
+        uint32_t cp = src[i];
+
+        if (cp < 0x80) {
+            if (ascii) {
+                size_t done = ascii(dst + o, src + i, n - i);
+                i += done;
+                o += done;
+            }
+            for (; i < n && src[i] < 0x80; i++)
+                dst[o++] = (char)src[i];
+            continue;
+        }
+        if (cp >= 0xD800 && cp <= 0xDFFF) {
+            if (cp > 0xDBFF || i + 1 == n
+                || src[i + 1] < 0xDC00 || src[i + 1] > 0xDFFF)
+                return CUMEM_UTF_ERROR;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (src[++i] - 0xDC00);
+        }
+        o += cuMem_utf8_encode(dst + o, cp);
+        i++;
+    }
+    return o;
+}
+
+size_t cuMem_utf32_to_utf8(char *dst, const uint32_t *src, size_t n)
+{
+    size_t (*ascii)(char *, const uint32_t *, size_t) = NULL;
+    size_t i = 0, o = 0;
+
+    assert(src != NULL || n == 0); // pre-condition
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_AVX2)
+        ascii = cuMem_utf32_to_ascii_avx2;
+    else if (features & CU_CPU_SSE2)
+        ascii = cuMem_utf32_to_ascii_sse2;
+#endif
+
+    while (i < n) {
+        uint32_t cp = src[i];
+
+        if (cp < 0x80) {
+            if (ascii) {
+                size_t done = ascii(dst + o, src + i, n - i);
+                i += done;
+                o += done;
+            }
+            for (; i < n && src[i] < 0x80; i++)
+                dst[o++] = (char)src[i];
+            continue;
+        }
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            return CUMEM_UTF_ERROR;
+        o += cuMem_utf8_encode(dst + o, cp);
+        i++;
+    }
+    return o;
+}
+
+cuStr *cuStr_utf8_to_utf16(cuStr *cus, const char *src, size_t n)
+{
+    size_t len;
+
+    assert(cus != NULL); // pre-condition
+    assert(src != NULL || n == 0); // pre-condition
+
+    if (!cuMem_utf8_validate(src, n) || !cuStr_grow(cus, 2 * n))
+        return NULL;
+    len = cuMem_utf8_to_units16(cus->mem + cus->elements_used, src, n);
+    return cuStr_commit(cus, 2 * len);
+}
+
+cuStr *cuStr_utf8_to_utf32(cuStr *cus, const char *src, size_t n)
+{
+    size_t len;
+
+    assert(cus != NULL); // pre-condition
+    assert(src != NULL || n == 0); // pre-condition
+
+    if (!cuMem_utf8_validate(src, n) || !cuStr_grow(cus, 4 * n))
+        return NULL;
+    len = cuMem_utf8_to_units32(cus->mem + cus->elements_used, src, n);
+    return cuStr_commit(cus, 4 * len);
+}
+
+cuStr *cuStr_utf16_to_utf8(cuStr *cus, const uint16_t *src, size_t n)
+{
+    size_t len;
+
+    assert(cus != NULL); // pre-condition
+
+    if (!cuStr_grow(cus, 3 * n))
+        return NULL;
+    len = cuMem_utf16_to_utf8(cus->mem + cus->elements_used, src, n);
+    return cuStr_utf_commit(cus, len);
+}
+
+cuStr *cuStr_utf32_to_utf8(cuStr *cus, const uint32_t *src, size_t n)
+{
+    size_t len;
+
+    assert(cus != NULL); // pre-condition
+
+    if (!cuStr_grow(cus, 4 * n))
+        return NULL;
+    len = cuMem_utf32_to_utf8(cus->mem + cus->elements_used, src, n);
+    return cuStr_utf_commit(cus, len);
+}
@@ -0,0 +1,46 @@
+#ifndef CU_INCLUDE_STRUTF8_H
+#define CU_INCLUDE_STRUTF8_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "cutil_string.h"
+
+/* Returned by the cuMem transcoding functions for invalid input */
+#define CUMEM_UTF_ERROR ((size_t)-1)
+
+/* UTF-8 is valid as defined by RFC 3629: no overlong forms, no surrogates
+ * and nothing above U+10FFFF. UTF-16 and UTF-32 are arrays of code units in
+ * the machine's byte order, without a byte order mark; UTF-16 must not
+ * have unpaired surrogates.
+ */
+
+/* Returns true if the n bytes at s are valid UTF-8 */
+bool cuMem_utf8_validate(const char *s, size_t n);
+bool cuStr_utf8_validate(const cuStr *cus);
+
+/* The number of code points in valid UTF-8. For other input this is the
+ * number of bytes that are not continuation bytes.
+ */
+size_t cuMem_utf8_length(const char *s, size_t n);
+size_t cuStr_utf8_length(const cuStr *cus);
+
+/* Append the UTF-16 or UTF-32 code units of the n bytes of UTF-8 at src,
+ * or the UTF-8 of the n code units at src. Returns cus, or NULL if out of
+ * memory or src is not valid, leaving cus unchanged.
+ */
+cuStr *cuStr_utf8_to_utf16(cuStr *cus, const char *src, size_t n);
+cuStr *cuStr_utf8_to_utf32(cuStr *cus, const char *src, size_t n);
+cuStr *cuStr_utf16_to_utf8(cuStr *cus, const uint16_t *src, size_t n);
+cuStr *cuStr_utf32_to_utf8(cuStr *cus, const uint32_t *src, size_t n);
+
+/* The same over raw memory; dst must have room for n code units, or for
+ * 3 * n and 4 * n bytes of UTF-8. These return the number of code units
+ * or bytes written, or CUMEM_UTF_ERROR.
+ */
+size_t cuMem_utf8_to_utf16(uint16_t *dst, const char *src, size_t n);
+size_t cuMem_utf8_to_utf32(uint32_t *dst, const char *src, size_t n);
+size_t cuMem_utf16_to_utf8(char *dst, const uint16_t *src, size_t n);
+size_t cuMem_utf32_to_utf8(char *dst, const uint32_t *src, size_t n);
+
+#endif /* CU_INCLUDE_STRUTF8_H */
@@ -0,0 +1,235 @@
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include "cutil_strview.h"
+#include "cutil_strcmp.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+#define cuStrViewIS_SPACE(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+#define cuStrTokIS_DELIM(tok, c) \
+    ((tok)->delims[(unsigned char)(c) >> 3] & (1U << ((unsigned char)(c) & 7)))
+
+/* Convert a match to a position in the view */
+static size_t cuStrView_match_pos(cuStrView v, const char *match)
+{
+    return match ? (size_t)(match - v.ptr) : CUSTR_NPOS;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+cuStrView cuStrView_make(const char *ptr, size_t len)
+{
+    cuStrView v;
+
+    assert(ptr != NULL || len == 0); // pre-condition
+
+    v.ptr = ptr ? ptr : "";
+    v.len = len;
+    return v;
+}
+
+cuStrView cuStrView_from_cstr(const char *s)
+{
+    assert(s != NULL); // pre-condition
+
+    return cuStrView_make(s, strlen(s));
+}
+
+cuStrView cuStrView_of(const cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+
+    return cuStrView_make(cuStr_cstr(cus), cuStr_len(cus));
+}
+
+cuStr *cuStr_set_view(cuStr *cus, cuStrView v)
+{
+    assert(cus != NULL); // pre-condition
+
+    if (v.len > UINT_MAX)
+        return NULL;
+    return cuStr_set_fromarray(cus, v.ptr, (unsigned)v.len);
+}
+
+cuStr *cuStr_append_view(cuStr *cus, cuStrView v)
+{
+    assert(cus != NULL); // pre-condition
+
+    if (v.len > UINT_MAX)
+        return NULL;
+    return cuStr_append_array(cus, v.ptr, (unsigned)v.len);
+}
+
+cuStrView cuStrView_substr(cuStrView v, size_t pos, size_t n)
+{
+    if (pos > v.len)
+        pos = v.len;
+    if (n > v.len - pos)
+        n = v.len - pos;
+    return cuStrView_make(v.ptr + pos, n);
+}
+
+cuStrView cuStrView_trim(cuStrView v)
+{
+    return cuStrView_trim_right(cuStrView_trim_left(v));
+}
+
+cuStrView cuStrView_trim_left(cuStrView v)
+{
+    while (v.len && cuStrViewIS_SPACE(*v.ptr)) {
+        v.ptr++;
+        v.len--;
+    }
+    return v;
+}
+
+cuStrView cuStrView_trim_right(cuStrView v)
+{
+    while (v.len && cuStrViewIS_SPACE(v.ptr[v.len - 1]))
+        v.len--;
+    return v;
+}
+
+bool cuStrView_equal(cuStrView a, cuStrView b)
+{
+    return a.len == b.len && (a.len == 0 || cuMem_equal(a.ptr, b.ptr, a.len));
+}
+
+int cuStrView_compare(cuStrView a, cuStrView b)
+{
+    return cuMem_compare(a.ptr, a.len, b.ptr, b.len);
+}
+
+bool cuStrView_starts_with(cuStrView v, cuStrView prefix)
+{
+    return prefix.len <= v.len
+           && (prefix.len == 0 || cuMem_equal(v.ptr, prefix.ptr, prefix.len));
+}
+
+bool cuStrView_ends_with(cuStrView v, cuStrView suffix)
+{
+    return suffix.len <= v.len
+           && (suffix.len == 0
+               || cuMem_equal(v.ptr + v.len - suffix.len, suffix.ptr, suffix.len));
+}
+
+size_t cuStrView_find_byte(cuStrView v, char c, size_t pos)
+{
+    if (pos >= v.len)
+        return CUSTR_NPOS;
+    return cuStrView_match_pos(v, cuMem_find_byte(v.ptr + pos, v.len - pos, c));
+}
+
+size_t cuStrView_rfind_byte(cuStrView v, char c, size_t pos)
+{
+    if (v.len == 0)
+        return CUSTR_NPOS;
+    if (pos >= v.len)
+        pos = v.len - 1;
+    return cuStrView_match_pos(v, cuMem_rfind_byte(v.ptr, pos + 1, c));
+}
+
+size_t cuStrView_find(cuStrView v, cuStrView needle, size_t pos)
+{
+    if (pos > v.len)
+        return CUSTR_NPOS;
+    return cuStrView_match_pos(v, cuMem_find(v.ptr + pos, v.len - pos,
+                                             needle.ptr, needle.len));
+}
+
+size_t cuStrView_rfind(cuStrView v, cuStrView needle, size_t pos)
+{
+    size_t end;
+
+    if (needle.len > v.len)
+        return CUSTR_NPOS;
+    /* Only matches that start at or before pos */
+    if (pos > v.len - needle.len)
+        pos = v.len - needle.len;
+    end = pos + needle.len;
+    return cuStrView_match_pos(v, cuMem_rfind(v.ptr, end, needle.ptr,
+                                              needle.len));
+}
+
+size_t cuStrView_count(cuStrView v, cuStrView needle)
+{
+    return cuMem_count(v.ptr, v.len, needle.ptr, needle.len);
+}
+
+void cuStrSplit_init(cuStrSplit *it, cuStrView v, cuStrView sep)
+{
+    assert(it != NULL); // pre-condition
+    assert(sep.len > 0); // pre-condition
+
+    it->rest = v;
+    it->sep = sep;
+    it->done = false;
+}
+
+bool cuStrSplit_next(cuStrSplit *it, cuStrView *field)
+{
+    const char *match;
+
+    assert(it != NULL && field != NULL); // pre-conditions
+
+    if (it->done)
+        return false;
+    if (it->sep.len == 1)
+        match = cuMem_find_byte(it->rest.ptr, it->rest.len, it->sep.ptr[0]);
+    else
+        match = cuMem_find(it->rest.ptr, it->rest.len, it->sep.ptr, it->sep.len);
+
+    if (!match) {
+        /* The last field is whatever is left, even if it is empty */
+        *field = it->rest;
+        it->done = true;
+        return true;
+    }
+    *field = cuStrView_make(it->rest.ptr, (size_t)(match - it->rest.ptr));
+    it->rest = cuStrView_substr(it->rest, field->len + it->sep.len, CUSTR_NPOS);
+    return true;
+}
+
+void cuStrTok_init(cuStrTok *tok, cuStrView v, const char *delims,
+                   size_t n_delims)
+{
+    size_t i;
+
+    assert(tok != NULL); // pre-condition
+    assert(delims != NULL || n_delims == 0); // pre-condition
+
+    tok->rest = v;
+    memset(tok->delims, 0, sizeof tok->delims);
+    for (i = 0; i < n_delims; i++) {
+        unsigned char c = (unsigned char)delims[i];
+        tok->delims[c >> 3] |= (unsigned char)(1U << (c & 7));
+    }
+}
+
+bool cuStrTok_next(cuStrTok *tok, cuStrView *token)
+{
+    const char *p, *end;
+
+    assert(tok != NULL && token != NULL); // pre-conditions
+
+    p = tok->rest.ptr;
+    end = p + tok->rest.len;
+    while (p < end && cuStrTokIS_DELIM(tok, *p))
+        p++;
+    if (p == end) {
+        tok->rest = cuStrView_make(end, 0);
+        return false;
+    }
+    token->ptr = p;
+    while (p < end && !cuStrTokIS_DELIM(tok, *p))
+        p++;
+    token->len = (size_t)(p - token->ptr);
+    tok->rest = cuStrView_make(p, (size_t)(end - p));
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef CU_INCLUDE_STRVIEW_H
+#define CU_INCLUDE_STRVIEW_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "cutil_string.h"
+#include "cutil_strsearch.h"
+
+/* A cuStrView borrows len bytes at ptr from a cuStr or any other memory
+ * without copying them. It is not '\0' terminated and stays valid only as
+ * long as the memory it points into: a view of a cuStr is invalidated by
+ * anything that changes or frees the string.
+ */
+typedef struct cuStrView {
+    const char *ptr;
+    size_t len;
+} cuStrView;
+
+cuStrView cuStrView_make(const char *ptr, size_t len);
+cuStrView cuStrView_from_cstr(const char *s);
+cuStrView cuStrView_of(const cuStr *cus);
+/* Copy the viewed bytes into cus; returns NULL if out of memory */
+cuStr *cuStr_set_view(cuStr *cus, cuStrView v);
+cuStr *cuStr_append_view(cuStr *cus, cuStrView v);
+
+/* Up to n bytes from pos, cut short at the end of the view (CUSTR_NPOS for
+ * all of the rest). A pos past the end gives an empty view.
+ */
+cuStrView cuStrView_substr(cuStrView v, size_t pos, size_t n);
+/* Without ASCII whitespace (" \t\n\v\f\r") at one or both ends */
+cuStrView cuStrView_trim(cuStrView v);
+cuStrView cuStrView_trim_left(cuStrView v);
+cuStrView cuStrView_trim_right(cuStrView v);
+
+/* Comparisons and searches as for cuStr (see cutil_strcmp.h and
+ * cutil_strsearch.h); positions are relative to the start of the view
+ */
+bool cuStrView_equal(cuStrView a, cuStrView b);
+int cuStrView_compare(cuStrView a, cuStrView b);
+bool cuStrView_starts_with(cuStrView v, cuStrView prefix);
+bool cuStrView_ends_with(cuStrView v, cuStrView suffix);
+size_t cuStrView_find_byte(cuStrView v, char c, size_t pos);
+size_t cuStrView_rfind_byte(cuStrView v, char c, size_t pos);
+size_t cuStrView_find(cuStrView v, cuStrView needle, size_t pos);
+size_t cuStrView_rfind(cuStrView v, cuStrView needle, size_t pos);
+size_t cuStrView_count(cuStrView v, cuStrView needle);
+
+/* Splits a view at every occurrence of a separator, so n separators give
+ * n + 1 fields, some of which may be empty:
+ *
+ *     cuStrSplit it;
+ *     cuStrView field;
+ *     cuStrSplit_init(&it, line, cuStrView_from_cstr(","));
+ *     while (cuStrSplit_next(&it, &field))
+ *         ...
+ */
+typedef struct cuStrSplit {
+    cuStrView rest;     // not yet split
+    cuStrView sep;
+    bool done;
+} cuStrSplit;
+
+/* sep must not be empty */
+void cuStrSplit_init(cuStrSplit *it, cuStrView v, cuStrView sep);
+bool cuStrSplit_next(cuStrSplit *it, cuStrView *field);
+
+/* Splits a view into tokens separated by runs of delimiter bytes, like
+ * strtok() but without changing the input: there are no empty tokens
+ */
+typedef struct cuStrTok {
+    cuStrView rest;
+    unsigned char delims[256 / 8];  // bit set of the delimiter bytes
+} cuStrTok;
+
+void cuStrTok_init(cuStrTok *tok, cuStrView v, const char *delims,
+                   size_t n_delims);
+bool cuStrTok_next(cuStrTok *tok, cuStrView *token);
+
+#endif /* CU_INCLUDE_STRVIEW_H */
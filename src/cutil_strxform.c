@@ -0,0 +1,732 @@
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "cutil_strxform.h"
+#include "cutil_simd.h"
+#include "cutil_simd_byteset.h"
+
+/* ===========================================================================
+   Private functions
+   =========================================================================*/
+
+/* Spaces as cuStrView_trim() sees them */
+#define cuMemXFORM_IS_SPACE(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+#define cuMemXFORM_CLASSES  7
+
+/* The classes of each byte, for the scalar code */
+static const unsigned char cuMem_byte_class[256] = {
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x03, 0x03, 0x03, 0x03, 0x03, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x02, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+    0x04, 0x04, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08,
+    0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08,
+    0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08,
+    0x08, 0x08, 0x08, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x20, 0x20, 0x20, 0x20, 0x01,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40
+};
+
+/* Most functions below take avail, the number of bytes at p that may be
+ * read and written, which is at least n. For a cuStr it is its whole
+ * buffer, so that the kernels can finish the string with a whole block
+ * instead of going byte by byte; what they leave after the end of the
+ * string does not matter, as long as the '\0' is written again.
+ */
+
+#ifdef CU_SIMD_X86
+
+/* Each class as a byte set of cutil_simd_byteset.h */
+static const unsigned char cuMem_class_rows[cuMemXFORM_CLASSES][32] = {
+    /* control */
+    { 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03,
+      0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x83,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    /* space */
+    { 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    /* digit */
+    { 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08,
+      0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    /* upper */
+    { 0x20, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30,
+      0x30, 0x30, 0x30, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    /* lower */
+    { 0x80, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0, 0xc0,
+      0xc0, 0xc0, 0xc0, 0x40, 0x40, 0x40, 0x40, 0x40,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    /* punct */
+    { 0x50, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+      0x04, 0x04, 0x0c, 0xac, 0xac, 0xac, 0xac, 0x2c,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    /* high */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }
+};
+
+/* Byte indices that move the set bits of an 8 bit mask to the front */
+static const uint64_t cuMem_filter_compress[256] = {
+    UINT64_C(0x0000000000000000), UINT64_C(0x0000000000000000),
+    UINT64_C(0x0000000000000001), UINT64_C(0x0000000000000100),
+    UINT64_C(0x0000000000000002), UINT64_C(0x0000000000000200),
+    UINT64_C(0x0000000000000201), UINT64_C(0x0000000000020100),
+    UINT64_C(0x0000000000000003), UINT64_C(0x0000000000000300),
+    UINT64_C(0x0000000000000301), UINT64_C(0x0000000000030100),
+    UINT64_C(0x0000000000000302), UINT64_C(0x0000000000030200),
+    UINT64_C(0x0000000000030201), UINT64_C(0x0000000003020100),
+    UINT64_C(0x0000000000000004), UINT64_C(0x0000000000000400),
+    UINT64_C(0x0000000000000401), UINT64_C(0x0000000000040100),
+    UINT64_C(0x0000000000000402), UINT64_C(0x0000000000040200),
+    UINT64_C(0x0000000000040201), UINT64_C(0x0000000004020100),
+    UINT64_C(0x0000000000000403), UINT64_C(0x0000000000040300),
+    UINT64_C(0x0000000000040301), UINT64_C(0x0000000004030100),
+    UINT64_C(0x0000000000040302), UINT64_C(0x0000000004030200),
+    UINT64_C(0x0000000004030201), UINT64_C(0x0000000403020100),
+    UINT64_C(0x0000000000000005), UINT64_C(0x0000000000000500),
+    UINT64_C(0x0000000000000501), UINT64_C(0x0000000000050100),
+    UINT64_C(0x0000000000000502), UINT64_C(0x0000000000050200),
+    UINT64_C(0x0000000000050201), UINT64_C(0x0000000005020100),
+    UINT64_C(0x0000000000000503), UINT64_C(0x0000000000050300),
+    UINT64_C(0x0000000000050301), UINT64_C(0x0000000005030100),
+    UINT64_C(0x0000000000050302), UINT64_C(0x0000000005030200),
+    UINT64_C(0x0000000005030201), UINT64_C(0x0000000503020100),
+    UINT64_C(0x0000000000000504), UINT64_C(0x0000000000050400),
+    UINT64_C(0x0000000000050401), UINT64_C(0x0000000005040100),
+    UINT64_C(0x0000000000050402), UINT64_C(0x0000000005040200),
+    UINT64_C(0x0000000005040201), UINT64_C(0x0000000504020100),
+    UINT64_C(0x0000000000050403), UINT64_C(0x0000000005040300),
+    UINT64_C(0x0000000005040301), UINT64_C(0x0000000504030100),
+    UINT64_C(0x0000000005040302), UINT64_C(0x0000000504030200),
+    UINT64_C(0x0000000504030201), UINT64_C(0x0000050403020100),
+    UINT64_C(0x0000000000000006), UINT64_C(0x0000000000000600),
+    UINT64_C(0x0000000000000601), UINT64_C(0x0000000000060100),
+    UINT64_C(0x0000000000000602), UINT64_C(0x0000000000060200),
+    UINT64_C(0x0000000000060201), UINT64_C(0x0000000006020100),
+    UINT64_C(0x0000000000000603), UINT64_C(0x0000000000060300),
+    UINT64_C(0x0000000000060301), UINT64_C(0x0000000006030100),
+    UINT64_C(0x0000000000060302), UINT64_C(0x0000000006030200),
+    UINT64_C(0x0000000006030201), UINT64_C(0x0000000603020100),
+    UINT64_C(0x0000000000000604), UINT64_C(0x0000000000060400),
+    UINT64_C(0x0000000000060401), UINT64_C(0x0000000006040100),
+    UINT64_C(0x0000000000060402), UINT64_C(0x0000000006040200),
+    UINT64_C(0x0000000006040201), UINT64_C(0x0000000604020100),
+    UINT64_C(0x0000000000060403), UINT64_C(0x0000000006040300),
+    UINT64_C(0x0000000006040301), UINT64_C(0x0000000604030100),
+    UINT64_C(0x0000000006040302), UINT64_C(0x0000000604030200),
+    UINT64_C(0x0000000604030201), UINT64_C(0x0000060403020100),
+    UINT64_C(0x0000000000000605), UINT64_C(0x0000000000060500),
+    UINT64_C(0x0000000000060501), UINT64_C(0x0000000006050100),
+    UINT64_C(0x0000000000060502), UINT64_C(0x0000000006050200),
+    UINT64_C(0x0000000006050201), UINT64_C(0x0000000605020100),
+    UINT64_C(0x0000000000060503), UINT64_C(0x0000000006050300),
+    UINT64_C(0x0000000006050301), UINT64_C(0x0000000605030100),
+    UINT64_C(0x0000000006050302), UINT64_C(0x0000000605030200),
+    UINT64_C(0x0000000605030201), UINT64_C(0x0000060503020100),
+    UINT64_C(0x0000000000060504), UINT64_C(0x0000000006050400),
+    UINT64_C(0x0000000006050401), UINT64_C(0x0000000605040100),
+    UINT64_C(0x0000000006050402), UINT64_C(0x0000000605040200),
+    UINT64_C(0x0000000605040201), UINT64_C(0x0000060504020100),
+    UINT64_C(0x0000000006050403), UINT64_C(0x0000000605040300),
+    UINT64_C(0x0000000605040301), UINT64_C(0x0000060504030100),
+    UINT64_C(0x0000000605040302), UINT64_C(0x0000060504030200),
+    UINT64_C(0x0000060504030201), UINT64_C(0x0006050403020100),
+    UINT64_C(0x0000000000000007), UINT64_C(0x0000000000000700),
+    UINT64_C(0x0000000000000701), UINT64_C(0x0000000000070100),
+    UINT64_C(0x0000000000000702), UINT64_C(0x0000000000070200),
+    UINT64_C(0x0000000000070201), UINT64_C(0x0000000007020100),
+    UINT64_C(0x0000000000000703), UINT64_C(0x0000000000070300),
+    UINT64_C(0x0000000000070301), UINT64_C(0x0000000007030100),
+    UINT64_C(0x0000000000070302), UINT64_C(0x0000000007030200),
+    UINT64_C(0x0000000007030201), UINT64_C(0x0000000703020100),
+    UINT64_C(0x0000000000000704), UINT64_C(0x0000000000070400),
+    UINT64_C(0x0000000000070401), UINT64_C(0x0000000007040100),
+    UINT64_C(0x0000000000070402), UINT64_C(0x0000000007040200),
+    UINT64_C(0x0000000007040201), UINT64_C(0x0000000704020100),
+    UINT64_C(0x0000000000070403), UINT64_C(0x0000000007040300),
+    UINT64_C(0x0000000007040301), UINT64_C(0x0000000704030100),
+    UINT64_C(0x0000000007040302), UINT64_C(0x0000000704030200),
+    UINT64_C(0x0000000704030201), UINT64_C(0x0000070403020100),
+    UINT64_C(0x0000000000000705), UINT64_C(0x0000000000070500),
+    UINT64_C(0x0000000000070501), UINT64_C(0x0000000007050100),
+    UINT64_C(0x0000000000070502), UINT64_C(0x0000000007050200),
+    UINT64_C(0x0000000007050201), UINT64_C(0x0000000705020100),
+    UINT64_C(0x0000000000070503), UINT64_C(0x0000000007050300),
+    UINT64_C(0x0000000007050301), UINT64_C(0x0000000705030100),
+    UINT64_C(0x0000000007050302), UINT64_C(0x0000000705030200),
+    UINT64_C(0x0000000705030201), UINT64_C(0x0000070503020100),
+    UINT64_C(0x0000000000070504), UINT64_C(0x0000000007050400),
+    UINT64_C(0x0000000007050401), UINT64_C(0x0000000705040100),
+    UINT64_C(0x0000000007050402), UINT64_C(0x0000000705040200),
+    UINT64_C(0x0000000705040201), UINT64_C(0x0000070504020100),
+    UINT64_C(0x0000000007050403), UINT64_C(0x0000000705040300),
+    UINT64_C(0x0000000705040301), UINT64_C(0x0000070504030100),
+    UINT64_C(0x0000000705040302), UINT64_C(0x0000070504030200),
+    UINT64_C(0x0000070504030201), UINT64_C(0x0007050403020100),
+    UINT64_C(0x0000000000000706), UINT64_C(0x0000000000070600),
+    UINT64_C(0x0000000000070601), UINT64_C(0x0000000007060100),
+    UINT64_C(0x0000000000070602), UINT64_C(0x0000000007060200),
+    UINT64_C(0x0000000007060201), UINT64_C(0x0000000706020100),
+    UINT64_C(0x0000000000070603), UINT64_C(0x0000000007060300),
+    UINT64_C(0x0000000007060301), UINT64_C(0x0000000706030100),
+    UINT64_C(0x0000000007060302), UINT64_C(0x0000000706030200),
+    UINT64_C(0x0000000706030201), UINT64_C(0x0000070603020100),
+    UINT64_C(0x0000000000070604), UINT64_C(0x0000000007060400),
+    UINT64_C(0x0000000007060401), UINT64_C(0x0000000706040100),
+    UINT64_C(0x0000000007060402), UINT64_C(0x0000000706040200),
+    UINT64_C(0x0000000706040201), UINT64_C(0x0000070604020100),
+    UINT64_C(0x0000000007060403), UINT64_C(0x0000000706040300),
+    UINT64_C(0x0000000706040301), UINT64_C(0x0000070604030100),
+    UINT64_C(0x0000000706040302), UINT64_C(0x0000070604030200),
+    UINT64_C(0x0000070604030201), UINT64_C(0x0007060403020100),
+    UINT64_C(0x0000000000070605), UINT64_C(0x0000000007060500),
+    UINT64_C(0x0000000007060501), UINT64_C(0x0000000706050100),
+    UINT64_C(0x0000000007060502), UINT64_C(0x0000000706050200),
+    UINT64_C(0x0000000706050201), UINT64_C(0x0000070605020100),
+    UINT64_C(0x0000000007060503), UINT64_C(0x0000000706050300),
+    UINT64_C(0x0000000706050301), UINT64_C(0x0000070605030100),
+    UINT64_C(0x0000000706050302), UINT64_C(0x0000070605030200),
+    UINT64_C(0x0000070605030201), UINT64_C(0x0007060503020100),
+    UINT64_C(0x0000000007060504), UINT64_C(0x0000000706050400),
+    UINT64_C(0x0000000706050401), UINT64_C(0x0000070605040100),
+    UINT64_C(0x0000000706050402), UINT64_C(0x0000070605040200),
+    UINT64_C(0x0000070605040201), UINT64_C(0x0007060504020100),
+    UINT64_C(0x0000000706050403), UINT64_C(0x0000070605040300),
+    UINT64_C(0x0000070605040301), UINT64_C(0x0007060504030100),
+    UINT64_C(0x0000070605040302), UINT64_C(0x0007060504030200),
+    UINT64_C(0x0007060504030201), UINT64_C(0x0706050403020100)
+};
+
+/* Case mapping: the bytes from first to first + 25 have 0x20 flipped.
+ * Bytes from 0x80 up are negative and never in the range.
+ */
+static size_t cuMem_case_sse2(char *p, size_t n, char first)
+{
+    const __m128i below = _mm_set1_epi8((char)(first - 1));
+    const __m128i above = _mm_set1_epi8((char)(first + 26));
+    const __m128i flip = _mm_set1_epi8(0x20);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i in = _mm_and_si128(_mm_cmpgt_epi8(v, below),
+                                   _mm_cmpgt_epi8(above, v));
+        v = _mm_xor_si128(v, _mm_and_si128(in, flip));
+        _mm_storeu_si128((__m128i *)(p + i), v);
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_case_avx2(char *p, size_t n, char first)
+{
+    const __m256i below = _mm256_set1_epi8((char)(first - 1));
+    const __m256i above = _mm256_set1_epi8((char)(first + 26));
+    const __m256i flip = _mm256_set1_epi8(0x20);
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i in = _mm256_and_si256(_mm256_cmpgt_epi8(v, below),
+                                      _mm256_cmpgt_epi8(above, v));
+        v = _mm256_xor_si256(v, _mm256_and_si256(in, flip));
+        _mm256_storeu_si256((__m256i *)(p + i), v);
+    }
+    return i;
+}
+
+/* Bit i is set if byte i is not a space */
+static unsigned cuMem_nonspace_sse2(const char *s)
+{
+    const __m128i v = _mm_loadu_si128((const __m128i *)s);
+    const __m128i above = _mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1));
+    const __m128i below = _mm_cmpgt_epi8(_mm_set1_epi8('\r' + 1), v);
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+
+    space = _mm_or_si128(space, _mm_and_si128(above, below));
+    return ~(unsigned)_mm_movemask_epi8(space) & 0xFFFF;
+}
+
+CU_TARGET_AVX2
+static unsigned cuMem_nonspace_avx2(const char *s)
+{
+    const __m256i v = _mm256_loadu_si256((const __m256i *)s);
+    const __m256i above = _mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1));
+    const __m256i below = _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v);
+    __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+
+    space = _mm256_or_si256(space, _mm256_and_si256(above, below));
+    return ~(unsigned)_mm256_movemask_epi8(space);
+}
+
+/* The number of leading spaces, or less if fewer than a block is left */
+static size_t cuMem_space_prefix_sse2(const char *s, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        unsigned other = cuMem_nonspace_sse2(s + i);
+        if (other)
+            return i + (size_t)__builtin_ctz(other);
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_space_prefix_avx2(const char *s, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        unsigned other = cuMem_nonspace_avx2(s + i);
+        if (other)
+            return i + (size_t)__builtin_ctz(other);
+    }
+    return i;
+}
+
+/* The number of trailing spaces, or less if fewer than a block is left */
+static size_t cuMem_space_suffix_sse2(const char *s, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        unsigned other = cuMem_nonspace_sse2(s + n - i - 16);
+        if (other)
+            return i + (size_t)__builtin_clz(other) - 16;
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_space_suffix_avx2(const char *s, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        unsigned other = cuMem_nonspace_avx2(s + n - i - 32);
+        if (other)
+            return i + (size_t)__builtin_clz(other);
+    }
+    return i;
+}
+
+/* Translation with 16 byte lookups, after Muła. The table is taken in
+ * groups of 16 entries, each xor'ed with the next group of the same half,
+ * the last group of a half as it is. Adding 0x70 - 16 * k with saturation
+ * leaves the top bit clear for the bytes of group k and of the groups below
+ * it in the same half, so that pshufb looks them up in group k; the bytes
+ * of the groups above become 0x80 or more and look up zero. The xor of all
+ * the lookups leaves table[c] for each byte. The upper half does the same
+ * with the top bit flipped.
+ */
+CU_TARGET_SSSE3
+static size_t cuMem_translate_ssse3(char *p, size_t n,
+                                    const unsigned char table[256])
+{
+    const __m128i top = _mm_set1_epi8((char)0x80);
+    __m128i group[16];
+    size_t i, k;
+
+    for (k = 0; k < 16; k++) {
+        group[k] = _mm_loadu_si128((const __m128i *)(table + 16 * k));
+        if (k % 8 != 0)
+            group[k - 1] = _mm_xor_si128(group[k - 1], group[k]);
+    }
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i high = _mm_xor_si128(v, top), r = _mm_setzero_si128();
+
+        for (k = 0; k < 8; k++) {
+            const __m128i bias = _mm_set1_epi8((char)(0x70 - 16 * k));
+            __m128i lo = _mm_adds_epu8(v, bias);
+            __m128i hi = _mm_adds_epu8(high, bias);
+            r = _mm_xor_si128(r, _mm_shuffle_epi8(group[k], lo));
+            r = _mm_xor_si128(r, _mm_shuffle_epi8(group[k + 8], hi));
+        }
+        _mm_storeu_si128((__m128i *)(p + i), r);
+    }
+    return i;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_translate_avx2(char *p, size_t n,
+                                   const unsigned char table[256])
+{
+    const __m256i top = _mm256_set1_epi8((char)0x80);
+    __m256i group[16];
+    size_t i, k;
+
+    for (k = 0; k < 16; k++) {
+        __m128i g = _mm_loadu_si128((const __m128i *)(table + 16 * k));
+        group[k] = _mm256_broadcastsi128_si256(g);
+        if (k % 8 != 0)
+            group[k - 1] = _mm256_xor_si256(group[k - 1], group[k]);
+    }
+    for (i = 0; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i high = _mm256_xor_si256(v, top), r = _mm256_setzero_si256();
+
+        for (k = 0; k < 8; k++) {
+            const __m256i bias = _mm256_set1_epi8((char)(0x70 - 16 * k));
+            __m256i lo = _mm256_adds_epu8(v, bias);
+            __m256i hi = _mm256_adds_epu8(high, bias);
+            r = _mm256_xor_si256(r, _mm256_shuffle_epi8(group[k], lo));
+            r = _mm256_xor_si256(r, _mm256_shuffle_epi8(group[k + 8], hi));
+        }
+        _mm256_storeu_si256((__m256i *)(p + i), r);
+    }
+    return i;
+}
+
+/* Without a popcnt instruction, which SSSE3 does not imply */
+static size_t cuMem_popcount8(unsigned x)
+{
+    x -= x >> 1 & 0x55;
+    x = (x & 0x33) + (x >> 2 & 0x33);
+    return (x + (x >> 4)) & 0x0F;
+}
+
+/* Writes the bytes of v selected by keep to o, 8 bytes at a time, and
+ * returns the end of them. The stores go at most 16 bytes past o, so this
+ * works in place when o is not past the place v was loaded from.
+ */
+CU_TARGET_SSSE3
+static char *cuMem_compress_ssse3(char *o, __m128i v, unsigned keep)
+{
+    const uint64_t low = cuMem_filter_compress[keep & 0xFF];
+    const uint64_t high = cuMem_filter_compress[keep >> 8]
+                          + UINT64_C(0x0808080808080808);
+
+    v = _mm_shuffle_epi8(v, _mm_set_epi64x((long long)high, (long long)low));
+    _mm_storel_epi64((__m128i *)o, v);
+    o += cuMem_popcount8(keep & 0xFF);
+    _mm_storel_epi64((__m128i *)o, _mm_unpackhi_epi64(v, v));
+    return o + cuMem_popcount8(keep >> 8);
+}
+
+/* These filter src to dst, which may be src or before it, and return the
+ * number of bytes read; *kept is set to the number written. With avail past
+ * n, the last bytes are done as a whole block.
+ */
+CU_TARGET_SSSE3
+static size_t cuMem_filter_ssse3(char *dst, const char *src, size_t n,
+                                 size_t avail, __m128i rows_low,
+                                 __m128i rows_high, size_t *kept)
+{
+    char *o = dst;
+    size_t i;
+
+    for (i = 0; i < n && i + 16 <= avail; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i mask = cu_byteset_absent_ssse3(v, rows_low, rows_high);
+        unsigned keep = (unsigned)_mm_movemask_epi8(mask);
+        unsigned all = n - i < 16 ? (1U << (n - i)) - 1 : 0xFFFF;
+
+        keep &= all;
+        if (keep == all) {
+            _mm_storeu_si128((__m128i *)o, v);
+            o += n - i < 16 ? n - i : 16;
+        } else {
+            o = cuMem_compress_ssse3(o, v, keep);
+        }
+    }
+    *kept = (size_t)(o - dst);
+    return i < n ? i : n;
+}
+
+CU_TARGET_AVX2
+static size_t cuMem_filter_avx2(char *dst, const char *src, size_t n,
+                                __m128i rows_low, __m128i rows_high,
+                                size_t *kept)
+{
+    const __m256i low = _mm256_broadcastsi128_si256(rows_low);
+    const __m256i high = _mm256_broadcastsi128_si256(rows_high);
+    char *o = dst;
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i mask = cu_byteset_absent_avx2(v, low, high);
+        unsigned keep = (unsigned)_mm256_movemask_epi8(mask);
+
+        if (keep == 0xFFFFFFFF) {
+            _mm256_storeu_si256((__m256i *)o, v);
+            o += 32;
+        } else {
+            __m128i half = _mm256_castsi256_si128(v);
+            o = cuMem_compress_ssse3(o, half, keep & 0xFFFF);
+            half = _mm256_extracti128_si256(v, 1);
+            o = cuMem_compress_ssse3(o, half, keep >> 16);
+        }
+    }
+    *kept = (size_t)(o - dst);
+    return i;
+}
+
+#endif /* CU_SIMD_X86 */
+
+/* Whole blocks run past n when avail allows; case mapping leaves the '\0'
+ * as it is
+ */
+static void cuMem_case(char *p, size_t n, size_t avail, char first)
+{
+    size_t i = 0;
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    size_t blocks = (n + 15) / 16 * 16;
+
+    if (blocks > avail)
+        blocks = n;
+    if ((features & CU_CPU_AVX2) && blocks >= 32)
+        i = cuMem_case_avx2(p, blocks, first);
+    if (features & CU_CPU_SSE2)
+        i += cuMem_case_sse2(p + i, blocks - i, first);
+#else
+    (void)avail;
+#endif
+    for (; i < n; i++) {
+        if ((unsigned char)(p[i] - first) < 26)
+            p[i] ^= 0x20;
+    }
+}
+
+/* The number of leading spaces in *lead and trailing ones in *trail,
+ * which do not overlap. Most strings have a space or two at either end, so
+ * the kernels are only worth calling for longer runs.
+ */
+static void cuMem_trim(const char *s, size_t n, size_t *lead, size_t *trail)
+{
+    size_t i = 0, k = 0;
+
+    while (i < n && i < 16 && cuMemXFORM_IS_SPACE(s[i]))
+        i++;
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (i == 16) {
+        if (features & CU_CPU_AVX2)
+            i += cuMem_space_prefix_avx2(s + i, n - i);
+        if (features & CU_CPU_SSE2)
+            i += cuMem_space_prefix_sse2(s + i, n - i);
+    }
+#endif
+    while (i < n && cuMemXFORM_IS_SPACE(s[i]))
+        i++;
+
+    while (k < n - i && k < 16 && cuMemXFORM_IS_SPACE(s[n - 1 - k]))
+        k++;
+#ifdef CU_SIMD_X86
+    if (k == 16) {
+        if (features & CU_CPU_AVX2)
+            k += cuMem_space_suffix_avx2(s + i, n - i - k);
+        if (features & CU_CPU_SSE2)
+            k += cuMem_space_suffix_sse2(s + i, n - i - k);
+    }
+#endif
+    while (k < n - i && cuMemXFORM_IS_SPACE(s[n - 1 - k]))
+        k++;
+    *lead = i;
+    *trail = k;
+}
+
+static void cuMem_translate_avail(char *p, size_t n, size_t avail,
+                                  const unsigned char table[256])
+{
+    size_t i = 0;
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    size_t blocks = (n + 15) / 16 * 16;
+
+    if (blocks > avail)
+        blocks = n;
+    if ((features & CU_CPU_AVX2) && blocks >= 32)
+        i = cuMem_translate_avx2(p, blocks, table);
+    if (features & CU_CPU_SSSE3)
+        i += cuMem_translate_ssse3(p + i, blocks - i, table);
+#else
+    (void)avail;
+#endif
+    for (; i < n; i++)
+        p[i] = (char)table[(unsigned char)p[i]];
+}
+
+static size_t cuMem_filter(char *p, size_t n, size_t avail, unsigned classes)
+{
+    size_t i = 0, o = 0;
+
+#ifdef CU_SIMD_X86
+    unsigned features = cu_cpu_features();
+    if (features & CU_CPU_SSSE3) {
+        __m128i rows_low = _mm_setzero_si128(), rows_high = rows_low;
+        size_t k, kept;
+
+        for (k = 0; k < cuMemXFORM_CLASSES; k++) {
+            const __m128i *rows = (const __m128i *)cuMem_class_rows[k];
+            if (classes & 1U << k) {
+                rows_low = _mm_or_si128(rows_low, _mm_loadu_si128(rows));
+                rows_high = _mm_or_si128(rows_high,
+                                         _mm_loadu_si128(rows + 1));
+            }
+        }
+        if ((features & CU_CPU_AVX2) && n >= 32)
+            i = cuMem_filter_avx2(p, p, n, rows_low, rows_high, &o);
+        i += cuMem_filter_ssse3(p + o, p + i, n - i, avail - i,
+                                rows_low, rows_high, &kept);
+        o += kept;
+    }
+#else
+    (void)avail;
+#endif
+    for (; i < n; i++) {
+        if (!(cuMem_byte_class[(unsigned char)p[i]] & classes))
+            p[o++] = p[i];
+    }
+    return o;
+}
+
+/* The bytes a cuStr's kernels may touch */
+static size_t cuStr_avail(const cuStr *cus)
+{
+    return cus->mem ? cus->max_elements + 1 : 0;
+}
+
+/* After a change in place: sets the new length, writes the '\0' again and
+ * drops the cached hash
+ */
+static cuStr *cuStr_changed(cuStr *cus, size_t len)
+{
+    if (cus->mem) {
+        cus->elements_used = len;
+        cus->mem[len] = '\0';
+    }
+    cus->hash = 0;
+    return cus;
+}
+
+/* ===========================================================================
+   Public functions
+   =========================================================================*/
+
+void cuMem_to_lower(char *p, size_t n)
+{
+    assert(p != NULL || n == 0); // pre-condition
+
+    cuMem_case(p, n, n, 'A');
+}
+
+void cuMem_to_upper(char *p, size_t n)
+{
+    assert(p != NULL || n == 0); // pre-condition
+
+    cuMem_case(p, n, n, 'a');
+}
+
+cuStr *cuStr_to_lower(cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+    assert(cus->map_len == 0); // pre-condition
+
+    cuMem_case(cus->mem, cus->elements_used, cuStr_avail(cus), 'A');
+    return cuStr_changed(cus, cus->elements_used);
+}
+
+cuStr *cuStr_to_upper(cuStr *cus)
+{
+    assert(cus != NULL); // pre-condition
+    assert(cus->map_len == 0); // pre-condition
+
+    cuMem_case(cus->mem, cus->elements_used, cuStr_avail(cus), 'a');
+    return cuStr_changed(cus, cus->elements_used);
+}
+
+cuStr *cuStr_trim(cuStr *cus)
+{
+    size_t n, lead, trail;
+
+    assert(cus != NULL); // pre-condition
+    assert(cus->map_len == 0); // pre-condition
+
+    n = cus->elements_used;
+    if (n == 0 || (!cuMemXFORM_IS_SPACE(cus->mem[0])
+                   && !cuMemXFORM_IS_SPACE(cus->mem[n - 1])))
+        return cus;
+
+    cuMem_trim(cus->mem, n, &lead, &trail);
+    n -= lead + trail;
+    if (lead)
+        memmove(cus->mem, cus->mem + lead, n);
+    return cuStr_changed(cus, n);
+}
+
+void cuMem_translate(char *p, size_t n, const unsigned char table[256])
+{
+    assert(p != NULL || n == 0); // pre-condition
+    assert(table != NULL); // pre-condition
+
+    cuMem_translate_avail(p, n, n, table);
+}
+
+cuStr *cuStr_translate(cuStr *cus, const unsigned char table[256])
+{
+    assert(cus != NULL); // pre-condition
+    assert(cus->map_len == 0); // pre-condition
+    assert(table != NULL); // pre-condition
+
+    cuMem_translate_avail(cus->mem, cus->elements_used, cuStr_avail(cus),
+                          table);
+    return cuStr_changed(cus, cus->elements_used);
+}
+
+size_t cuMem_filter_class(char *p, size_t n, unsigned classes)
+{
+    assert(p != NULL || n == 0); // pre-condition
+
+    return cuMem_filter(p, n, n, classes);
+}
+
+cuStr *cuStr_filter_class(cuStr *cus, unsigned classes)
+{
+    size_t len;
+
+    assert(cus != NULL); // pre-condition
+    assert(cus->map_len == 0); // pre-condition
+
+    len = cuMem_filter(cus->mem, cus->elements_used, cuStr_avail(cus),
+                       classes);
+    return cuStr_changed(cus, len);
+}
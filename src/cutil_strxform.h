@@ -0,0 +1,37 @@
+#ifndef CU_INCLUDE_STRXFORM_H
+#define CU_INCLUDE_STRXFORM_H
+
+#include <stddef.h>
+#include "cutil_string.h"
+
+/* Byte classes for cuStr_filter_class(), which may be or'ed. They are
+ * ASCII classes; every byte from 0x80 up is in CUSTR_CLASS_HIGH only.
+ */
+#define CUSTR_CLASS_CNTRL   (1U << 0)   // 0x00 to 0x1F and 0x7F
+#define CUSTR_CLASS_SPACE   (1U << 1)   // ' ' and '\t' to '\r'
+#define CUSTR_CLASS_DIGIT   (1U << 2)
+#define CUSTR_CLASS_UPPER   (1U << 3)
+#define CUSTR_CLASS_LOWER   (1U << 4)
+#define CUSTR_CLASS_PUNCT   (1U << 5)   // printable, not space or alphanumeric
+#define CUSTR_CLASS_HIGH    (1U << 6)
+
+/* In place ASCII case mapping; other bytes are left as they are */
+void cuMem_to_lower(char *p, size_t n);
+void cuMem_to_upper(char *p, size_t n);
+cuStr *cuStr_to_lower(cuStr *cus);
+cuStr *cuStr_to_upper(cuStr *cus);
+
+/* Remove leading and trailing spaces, as cuStrView_trim() does */
+cuStr *cuStr_trim(cuStr *cus);
+
+/* Replace every byte c with table[c] */
+void cuMem_translate(char *p, size_t n, const unsigned char table[256]);
+cuStr *cuStr_translate(cuStr *cus, const unsigned char table[256]);
+
+/* Remove every byte in one of the classes, keeping the order of the rest.
+ * cuMem_filter_class() returns the number of bytes kept.
+ */
+size_t cuMem_filter_class(char *p, size_t n, unsigned classes);
+cuStr *cuStr_filter_class(cuStr *cus, unsigned classes);
+
+#endif /* CU_INCLUDE_STRXFORM_H */
@@ -1,5 +1,24 @@
 #include "tests/test_string.h"
 #include "tests/test_math.h"
+#include "tests/test_arena.h"
+#include "tests/test_strnum.h"
+#include "tests/test_strsearch.h"
+#include "tests/test_strcmp.h"
+#include "tests/test_strhash.h"
+#include "tests/test_strmap.h"
+#include "tests/test_strpool.h"
+#include "tests/test_strrotate.h"
+#include "tests/test_strstats.h"
+#include "tests/test_strview.h"
+#include "tests/test_strfile.h"
+#include "tests/test_strreader.h"
+#include "tests/test_strchain.h"
+#include "tests/test_strcodec.h"
+#include "tests/test_strlog.h"
+#include "tests/test_strcache.h"
+#include "tests/test_strutf8.h"
+#include "tests/test_strxform.h"
+#include "tests/test_strmatch.h"
 
 int main()
 {
@@ -10,7 +29,30 @@ int main()
     //        using debug (not release) builds.
 #ifndef NDEBUG
     test_bytearray();
+    test_sso();
+    test_growth();
+    test_printf();
     test_gcd();
+    test_modular();
+    test_arena();
+    test_strnum();
+    test_strsearch();
+    test_strcmp();
+    test_strhash();
+    test_strmap();
+    test_strpool();
+    test_strrotate();
+    test_strstats();
+    test_strview();
+    test_strfile();
+    test_strreader();
+    test_strchain();
+    test_strcodec();
+    test_strlog();
+    test_strcache();
+    test_strutf8();
+    test_strxform();
+    test_strmatch();
 #endif
 
     return 0;
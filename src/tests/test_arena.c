@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include "test_arena.h"
+#include "../cutil_arena.h"
+#include "../cutil_string.h"
+
+void test_arena(void)
+{
+    cuArena *arena;
+    cuStr *cus, *cus2;
+    const char *mem;
+    int i;
+    static const char *result[] = { "FAILED", "Ok"};
+
+    arena = cuArena_new(1024);
+    if (!arena) {
+        printf("cuArena_new() failed. Aborting tests\n");
+        return;
+    }
+
+    cus = cuStr_new_in(arena, -1);
+    if (!cus) {
+        printf("cuStr_new_in() failed. Aborting tests\n");
+        cuArena_destroy(&arena);
+        return;
+    }
+    cuStr_set(cus, "arena");
+    printf("Arena string: %s\n", result[cuStr_strcmp_cstr(cus, "arena") == 0
+                                        && cus->arena == arena]);
+
+    /* Move to an arena buffer and then grow it: it is the most recent
+     * allocation so it should be extended in place
+     */
+    cuStr_set_chunksize(cus, 1);
+    cuStr_append(cus, " string that no longer fits inline");
+    mem = cuStr_cstr(cus);
+    cuStr_append(cus, "!");
+    printf("Arena grow in place: %s\n", result[mem == cuStr_cstr(cus)
+            && cuStr_strcmp_cstr(cus, "arena string that no longer fits inline!") == 0]);
+
+    cus2 = cuStr_copy(cus);
+    printf("Arena copy: %s\n", result[cus2 && cus2->arena == arena
+                                      && cuStr_cmp(cus, cus2) == 0]);
+
+    /* No longer the last allocation, so this must move */
+    for (i = 0; i < 100; i++)
+        cuStr_append(cus, "0123456789");
+    printf("Arena grow (moved): %s\n", result[cuStr_len(cus) == 1040
+                                              && cuStr_at(cus, 1039) == '9']);
+
+    cuStr_destroy(&cus2);
+    cuStr_destroy(&cus);
+    cuArena_reset(arena);
+
+    cus = cuStr_new_in(arena, 100);
+    printf("Arena reset: %s\n", result[cus != NULL && cuStr_len(cus) == 0]);
+    cuArena_destroy(&arena);
+    printf("cuArena_destroy(): %s\n", result[arena == NULL]);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_ARENA_H
+#define CU_INCLUDE_TEST_ARENA_H
+
+void test_arena(void);
+
+#endif /* CU_INCLUDE_TEST_ARENA_H */
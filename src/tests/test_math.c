@@ -1,6 +1,10 @@
 #include <stdio.h>
+#include <limits.h>
 #include "test_math.h"
 #include "../cutil_math.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
 
 typedef struct {
     int a, b;
@@ -12,15 +16,239 @@ static void print_gcd_calc(const gcd_calc *g)
     printf("gcd(%d,%d) = %u", g->a, g->b, g->result);
 }
 
+/* Euclid's algorithm, as the reference */
+static uint64_t ref_gcd(uint64_t a, uint64_t b)
+{
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* xorshift64, with a random number of low bits cleared so that there are
+ * plenty of common factors of 2
+ */
+static uint64_t test_rand64(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return (x >> (x & 31)) << ((x >> 8) & 7);
+}
+
+static int test_gcd_pairs(void)
+{
+    static uint64_t a[1003], b[1003], out[1003];
+    uint64_t state = 88172645463325252u, g;
+    size_t i, n;
+
+    for (i = 0; i < sizeof a / sizeof a[0]; i++) {
+        a[i] = test_rand64(&state);
+        b[i] = i % 17 == 0 ? 0 : test_rand64(&state) * (i % 5 + 1);
+        if (i % 29 == 0)
+            a[i] = 0;
+    }
+    gcd_pairs_u64(a, b, out, sizeof a / sizeof a[0]);
+    for (i = 0; i < sizeof a / sizeof a[0]; i++) {
+        if (out[i] != ref_gcd(a[i], b[i]))
+            return 0;
+    }
+
+    /* Every length up to 40, for the vector body and the tail */
+    for (i = 0; i < sizeof a / sizeof a[0]; i++)
+        a[i] = 36 * (i + 1) * (i % 7 + 1) * (i % 2 + 1);
+    for (n = 0, g = 0; n <= 40; g = ref_gcd(g, a[n]), n++) {
+        if (gcd_array_u64(a, n) != g)
+            return 0;
+    }
+    return gcd_array_u64(a, sizeof a / sizeof a[0]) == 36
+           && gcd_array_u64(b, 1) == 0;
+}
+
 int test_gcd()
 {
     gcd_calc r;
+    uint64_t state = 2463534242u;
+    int i, ok;
 
     r.a = 114;
     r.b = -65535;
     r.result = gcd(r.a, r.b);
     print_gcd_calc(&r); printf("\n");
 
+    ok = gcd(0, 0) == 0 && gcd(0, -6) == 6 && gcd(INT_MIN, 0) == 0x80000000u
+         && gcd(INT_MIN, 6) == 2 && gcd(-4, -6) == 2 && gcd(17, 5) == 1;
+    for (i = 0; i < 100000 && ok; i++) {
+        uint64_t a = test_rand64(&state), b = test_rand64(&state) * (i % 9 + 1);
+        ok = gcd_u64(a, b) == ref_gcd(a, b)
+             && gcd((int)(a >> 33), (int)(b >> 33)) == ref_gcd(a >> 33, b >> 33);
+    }
+    printf("gcd() and gcd_u64(): %s\n", result[ok]);
+
+#ifdef __SIZEOF_INT128__
+    {
+        cu_uint128 p = (cu_uint128)0xFFFFFFFFFFFFFFC5ULL;  // largest 64 bit prime
+        cu_uint128 big = p * 0x123456789ULL * 8, other = p * 0xABCDEFULL * 12;
+        ok = gcd_u128(big, other) == p * ref_gcd(0x123456789ULL * 8, 0xABCDEFULL * 12)
+             && gcd_u128(big, 0) == big && gcd_u128(big, 6) == 6
+             && gcd_u128((cu_uint128)1 << 100, (cu_uint128)3 << 90) == (cu_uint128)1 << 90;
+        printf("gcd_u128(): %s\n", result[ok]);
+    }
+#endif
+
+    printf("lcm(): %s\n", result[lcm(4, -6) == 12 && lcm(0, 5) == 0 && lcm(7, 7) == 7
+                                 && lcm_u64(1ULL << 40, 3ULL << 20) == 3ULL << 40]);
+
+    cu_cpu_set_mask(0);
+    ok = test_gcd_pairs();
+    cu_cpu_set_mask(~0U);
+    ok = ok && test_gcd_pairs();
+    printf("gcd_pairs_u64() and gcd_array_u64(): %s\n", result[ok]);
+
+    return 1;
+}
+
+/* Double and add, then square and multiply, as the reference */
+static uint64_t ref_mulmod(uint64_t a, uint64_t b, uint64_t m)
+{
+    uint64_t r = 0;
+
+    a %= m;
+    for (; b; b >>= 1) {
+        if (b & 1)
+            r = r >= m - a ? r - (m - a) : r + a;
+        a = a >= m - a ? a - (m - a) : a + a;
+    }
+    return r;
+}
+
+static uint64_t ref_modpow(uint64_t b, uint64_t e, uint64_t m)
+{
+    uint64_t r = 1 % m;
+
+    for (; e; e >>= 1) {
+        if (e & 1)
+            r = ref_mulmod(r, b, m);
+        b = ref_mulmod(b, b, m);
+    }
+    return r;
+}
+
+static int ref_is_prime(uint64_t n)
+{
+    uint64_t d;
+
+    if (n < 2)
+        return 0;
+    for (d = 2; d * d <= n; d++) {
+        if (n % d == 0)
+            return 0;
+    }
     return 1;
 }
 
+int test_modular(void)
+{
+    /* Carmichael numbers, strong pseudoprimes to several small bases and
+     * products of two large primes
+     */
+    static const uint64_t composites[] = {
+        561, 41041, 825265, 321197185, 3215031751ULL, 2152302898747ULL,
+        3474749660383ULL, 341550071728321ULL, 3825123056546413051ULL,
+        4294967291ULL * 4294967279ULL, 0xFFFFFFFFFFFFFFFFULL
+    };
+    static const uint64_t primes[] = {
+        2, 3, 37, 1000000007, 4294967291ULL, 4294967311ULL,
+        2305843009213693951ULL, 0xFFFFFFFFFFFFFFC5ULL
+    };
+    static const uint64_t moduli[] = {
+        2, 3, 1000000007, 1000000008, 1ULL << 63, (1ULL << 63) + 1,
+        0xFFFFFFFFFFFFFFC5ULL, 0xFFFFFFFFFFFFFFFFULL
+    };
+    uint64_t state = 2463534242u, inv;
+    int64_t x, y, g;
+    size_t i, k;
+    int ok;
+
+    ok = gcd_ext_i64(240, 46, &x, &y) == 2 && 240 * x + 46 * y == 2
+         && gcd_ext_i64(-240, 46, &x, &y) == 2 && -240 * x + 46 * y == 2
+         && gcd_ext_i64(0, -5, &x, &y) == 5 && -5 * y == 5
+         && gcd_ext_i64(0, 0, &x, &y) == 0;
+    for (i = 0; i < 10000 && ok; i++) {
+        int64_t a = (int64_t)(test_rand64(&state) >> 34) - (1LL << 28);
+        int64_t b = (int64_t)(test_rand64(&state) >> 34) - (1LL << 28);
+        g = gcd_ext_i64(a, b, &x, &y);
+        ok = (uint64_t)g == ref_gcd(a < 0 ? -a : a, b < 0 ? -b : b)
+             && a * x + b * y == g;
+    }
+    printf("gcd_ext_i64(): %s\n", result[ok]);
+
+    ok = modinv_u64(3, 7, &inv) == 0 && inv == 5
+         && modinv_u64(6, 9, &inv) == -1 && modinv_u64(0, 9, &inv) == -1
+         && modinv_u64(10, 7, &inv) == 0 && inv == 5;
+    for (i = 0; i < 10000 && ok; i++) {
+        uint64_t m = test_rand64(&state) | 2, a = test_rand64(&state);
+        if (i % 3 == 0)
+            m = 0xFFFFFFFFFFFFFFFFULL - i;
+        if (modinv_u64(a, m, &inv) == 0)
+            ok = inv < m && ref_mulmod(a, inv, m) == 1;
+        else
+            ok = ref_gcd(a % m, m) != 1;
+    }
+    printf("modinv_u64(): %s\n", result[ok]);
+
+    ok = mulmod_u64(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFC5ULL) == 3364
+         && modpow_u64(5, 0, 1) == 0 && modpow_u64(0, 0, 7) == 1
+         && modpow_u64(2, 10, 1000) == 24;
+    for (i = 0; i < 10000 && ok; i++) {
+        uint64_t a = test_rand64(&state), b = test_rand64(&state), m = test_rand64(&state) | 1;
+        ok = mulmod_u64(a, b, m) == ref_mulmod(a, b, m);
+    }
+    for (k = 0; k < sizeof moduli / sizeof moduli[0] && ok; k++) {
+        for (i = 0; i < 200 && ok; i++) {
+            uint64_t b = test_rand64(&state), e = test_rand64(&state);
+            ok = modpow_u64(b, e, moduli[k]) == ref_modpow(b, e, moduli[k]);
+        }
+    }
+    printf("mulmod_u64() and modpow_u64(): %s\n", result[ok]);
+
+    {
+        cuMontgomery mont;
+        ok = cuMontgomery_init(&mont, 1) == -1 && cuMontgomery_init(&mont, 10) == -1;
+        for (k = 0; k < sizeof moduli / sizeof moduli[0] && ok; k++) {
+            if (cuMontgomery_init(&mont, moduli[k]) != 0)
+                continue;
+            for (i = 0; i < 1000 && ok; i++) {
+                uint64_t a = test_rand64(&state), b = test_rand64(&state);
+                uint64_t p = cuMontgomery_mul(&mont, cuMontgomery_to(&mont, a),
+                                              cuMontgomery_to(&mont, b));
+                ok = cuMontgomery_from(&mont, p) == ref_mulmod(a, b, moduli[k])
+                     && cuMontgomery_from(&mont, cuMontgomery_to(&mont, a)) == a % moduli[k];
+            }
+        }
+        printf("cuMontgomery: %s\n", result[ok]);
+    }
+
+    ok = 1;
+    for (i = 0; i < 20000 && ok; i++)
+        ok = is_prime_u64(i) == ref_is_prime(i);
+    for (i = 0; i < sizeof composites / sizeof composites[0] && ok; i++)
+        ok = !is_prime_u64(composites[i]);
+    for (i = 0; i < sizeof primes / sizeof primes[0] && ok; i++)
+        ok = is_prime_u64(primes[i]);
+    /* Near 2^32, where trial division is still quick */
+    for (i = 0; i < 2000 && ok; i++)
+        ok = is_prime_u64(0xFFFFF000ULL + i) == ref_is_prime(0xFFFFF000ULL + i);
+    printf("is_prime_u64(): %s\n", result[ok]);
+
+    printf("next_prime_u64(): %s\n", result[next_prime_u64(0) == 2 && next_prime_u64(3) == 3
+                                            && next_prime_u64(24) == 29
+                                            && next_prime_u64(1000000000) == 1000000007
+                                            && next_prime_u64(0xFFFFFFFFFFFFFFB0ULL) == 0xFFFFFFFFFFFFFFC5ULL
+                                            && next_prime_u64(0xFFFFFFFFFFFFFFC6ULL) == 0]);
+    return 1;
+}
@@ -2,5 +2,6 @@
 #define CU_INCLUDE_TEST_MATH_H
 
 int test_gcd(void);
+int test_modular(void);
 
 #endif /* CU_INCLUDE_TEST_MATH_H */
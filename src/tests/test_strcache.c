@@ -0,0 +1,117 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_strcache.h"
+#include "../cutil_strcache.h"
+#include "../cutil_string.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_STRCACHE_STRINGS   8
+
+/* Create strings and free them again, leaving them in the thread's cache;
+ * arg gets the addresses of the headers
+ */
+static void *test_strcache_worker_run(void *arg)
+{
+    cuStr *strings[TEST_STRCACHE_STRINGS];
+    const void **headers = arg;
+    int i;
+
+    for (i = 0; i < TEST_STRCACHE_STRINGS; i++)
+        headers[i] = strings[i] = cuStr_new(100);
+    for (i = TEST_STRCACHE_STRINGS - 1; i >= 0; i--)
+        cuStr_destroy(&strings[i]);
+    return NULL;
+}
+
+/* Blocks a thread leaves behind go to the depot and on to other threads */
+static int test_depot(void)
+{
+    cuStr *strings[TEST_STRCACHE_STRINGS];
+    const void *headers[TEST_STRCACHE_STRINGS];
+    pthread_t thread;
+    size_t reused = 0;
+    int i, k;
+
+    cuStr_cache_trim();
+    if (pthread_create(&thread, NULL, test_strcache_worker_run, headers) != 0)
+        return 0;
+    pthread_join(thread, NULL);
+
+    for (i = 0; i < TEST_STRCACHE_STRINGS; i++) {
+        strings[i] = cuStr_new(100);
+        for (k = 0; k < TEST_STRCACHE_STRINGS; k++)
+            reused += strings[i] != NULL && strings[i] == headers[k];
+    }
+    for (i = 0; i < TEST_STRCACHE_STRINGS; i++)
+        cuStr_destroy(&strings[i]);
+    return reused == TEST_STRCACHE_STRINGS;
+}
+
+void test_strcache(void)
+{
+    cuStr *cus, *cus2;
+    const void *header, *mem;
+    bool enabled = cuStr_cache_enabled();
+
+    cuStr_cache_enable(true);
+    cus = cuStr_new(100);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        cuStr_cache_enable(enabled);
+        return;
+    }
+
+    printf("cuStr_cache size class: %s\n", result[cuStr_max_elements(cus) == 255
+                                                  && cuStr_cache_size(1) == 32
+                                                  && cuStr_cache_size(129) == 256
+                                                  && cuStr_cache_size(CUSTR_CACHE_MAX_SIZE + 1) == CUSTR_CACHE_MAX_SIZE + 1]);
+
+    /* The last string freed is the next one handed out */
+    header = cus;
+    mem = cuStr_cstr(cus);
+    cuStr_destroy(&cus);
+    cus = cuStr_new(100);
+    printf("cuStr_cache reuse: %s\n", result[cus == header && cuStr_cstr(cus) == mem]);
+
+    /* Growing moves the contents to a larger class and frees the old block
+     * to the cache
+     */
+    cuStr_set(cus, "cached");
+    cuStr_reserve(cus, 1000);
+    cus2 = cuStr_new(120);
+    printf("cuStr_cache resize: %s\n", result[cuStr_max_elements(cus) == 1023
+                                              && cuStr_strcmp_cstr(cus, "cached") == 0
+                                              && cus2 && cuStr_cstr(cus2) == mem]);
+    cuStr_destroy(&cus2);
+
+    /* Past the largest class it goes back to realloc() */
+    cuStr_reserve(cus, 4 * CUSTR_CACHE_MAX_SIZE);
+    cuStr_reserve(cus, 8 * CUSTR_CACHE_MAX_SIZE);
+    printf("cuStr_cache large resize: %s\n", result[cuStr_cache_holds(CUSTR_CACHE_MAX_SIZE)
+                                                    && !cuStr_cache_holds(CUSTR_CACHE_MAX_SIZE + 1)
+                                                    && !cuStr_cache_holds(300)
+                                                    && cuStr_max_elements(cus) >= 8 * CUSTR_CACHE_MAX_SIZE
+                                                    && cuStr_strcmp_cstr(cus, "cached") == 0]);
+
+    printf("cuStr_cache depot: %s\n", result[test_depot()]);
+
+    /* Strings can outlive the setting they were created with */
+    cuStr_cache_enable(false);
+    cus2 = cuStr_new(100);
+    cuStr_append(cus2, "uncached");
+    cuStr_cache_enable(true);
+    cuStr_reserve(cus2, 500);
+    cuStr_append(cus2, " then cached");
+    printf("cuStr_cache toggle: %s\n", result[cus2 && cuStr_max_elements(cus2) == 511
+                                             && cuStr_strcmp_cstr(cus2, "uncached then cached") == 0]);
+    cuStr_destroy(&cus2);
+    cuStr_cache_enable(false);
+    cuStr_destroy(&cus);
+
+    cuStr_cache_trim();
+    cuStr_cache_enable(enabled);
+}
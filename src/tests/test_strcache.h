@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRCACHE_H
+#define CU_INCLUDE_TEST_STRCACHE_H
+
+void test_strcache(void);
+
+#endif /* CU_INCLUDE_TEST_STRCACHE_H */
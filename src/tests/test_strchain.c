@@ -0,0 +1,136 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "test_strchain.h"
+#include "../cutil_strchain.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_STRCHAIN_SEGMENTS  5000    // more than IOV_MAX
+#define TEST_STRCHAIN_LONG      100     // referenced, not copied
+
+/* Write the chain to a temporary file and compare what it holds */
+static int test_write_file(cuStrChain *chain, const char *expected, size_t n)
+{
+    char path[] = "/tmp/cu_strchain_XXXXXX";
+    char *back = malloc(n + 1);
+    ssize_t got = -1;
+    int fd, ok;
+
+    if ((fd = mkstemp(path)) < 0) {
+        free(back);
+        return 0;
+    }
+    unlink(path);
+    ok = back != NULL && cuStrChain_write(chain, fd) == 0
+         && cuStrChain_len(chain) == 0 && lseek(fd, 0, SEEK_SET) == 0;
+    if (ok)
+        got = read(fd, back, n + 1);
+    ok = ok && got == (ssize_t)n && memcmp(back, expected, n) == 0;
+    close(fd);
+    free(back);
+    return ok;
+}
+
+/* Fill a non-blocking pipe until the chain stops, then drain and resume */
+static int test_would_block(void)
+{
+    cuStrChain *chain = cuStrChain_new();
+    size_t n = 1 << 20, i, total = 0;
+    char *src = malloc(n), *back = malloc(n);
+    int fds[2], rc = 1, ok = chain && src && back && pipe(fds) == 0;
+    int stopped = 0;
+    ssize_t got;
+
+    if (ok) {
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        for (i = 0; i < n; i++)
+            src[i] = (char)(i * 7 + i / 4093);
+        /* Segments of odd lengths so that writes stop inside them */
+        for (i = 0; i < n && ok; i += 997)
+            ok = cuStrChain_add_array(chain, src + i, n - i < 997 ? n - i : 997) == 0;
+    }
+    while (ok && rc != 0) {
+        rc = cuStrChain_write(chain, fds[1]);
+        if (rc == 1)
+            stopped++;
+        ok = rc >= 0 && cuStrChain_len(chain) + total <= n;
+        while (ok && (got = read(fds[0], back + total, n - total)) > 0)
+            total += (size_t)got;
+    }
+    ok = ok && stopped > 0 && total == n && memcmp(src, back, n) == 0;
+    if (chain) {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    cuStrChain_destroy(&chain);
+    free(src);
+    free(back);
+    return ok;
+}
+
+void test_strchain(void)
+{
+    cuStrChain *chain;
+    cuStr *cus;
+    char *expected, tmp[16];
+    size_t i, n = 0, len;
+    int ok = 1;
+
+    chain = cuStrChain_new();
+    cus = cuStr_new(0);
+    expected = malloc(TEST_STRCHAIN_SEGMENTS * (TEST_STRCHAIN_LONG + 16));
+    if (!chain || !cus || !expected) {
+        printf("cuStrChain_new() failed. Aborting tests\n");
+        cuStrChain_destroy(&chain);
+        cuStr_destroy(&cus);
+        free(expected);
+        return;
+    }
+
+    /* Short pieces in a row become one segment */
+    cuStr_set(cus, "world");
+    ok = cuStrChain_add_array(chain, "hello, ", 7) == 0
+         && cuStrChain_add(chain, cus) == 0
+         && cuStrChain_add_view(chain, cuStrView_from_cstr("!\n")) == 0;
+    printf("cuStrChain_add() merges copies: %s\n", result[ok && chain->count == 1
+                                                          && cuStrChain_len(chain) == 14
+                                                          && memcmp(chain->segments[0].ptr, "hello, world!\n", 14) == 0]);
+    cuStrChain_clear(chain);
+    printf("cuStrChain_clear(): %s\n", result[cuStrChain_len(chain) == 0 && chain->count == 0]);
+
+    /* Long pieces are referenced, short ones in between copied */
+    cuStr_clear(cus);
+    for (i = 0; i < TEST_STRCHAIN_LONG; i++)
+        cuStr_append(cus, i % 2 ? "x" : "y");
+    for (i = 0; i < TEST_STRCHAIN_SEGMENTS && ok; i++) {
+        ok = cuStrChain_add(chain, cus) == 0;
+        memcpy(expected + n, cuStr_cstr(cus), cuStr_len(cus));
+        n += cuStr_len(cus);
+        len = (size_t)snprintf(tmp, sizeof tmp, "<%zu>", i);
+        ok = ok && cuStrChain_copy_array(chain, tmp, len) == 0;
+        memcpy(expected + n, tmp, len);
+        n += len;
+    }
+    printf("cuStrChain_add() references long strings: %s\n", result[ok && chain->count == 2 * TEST_STRCHAIN_SEGMENTS
+                                                                    && chain->segments[0].ptr == cuStr_cstr(cus)
+                                                                    && cuStrChain_len(chain) == n]);
+    printf("cuStrChain_write() past IOV_MAX: %s\n", result[test_write_file(chain, expected, n)]);
+    printf("cuStrChain_write() empty: %s\n", result[test_write_file(chain, "", 0)]);
+
+    printf("cuStrChain_write() would block: %s\n", result[test_would_block()]);
+    printf("cuStrChain_write() bad fd: %s\n", result[cuStrChain_add_array(chain, "x", 1) == 0
+                                                     && cuStrChain_write(chain, -1) == -1
+                                                     && errno == EBADF
+                                                     && cuStrChain_len(chain) == 1]);
+
+    cuStrChain_destroy(&chain);
+    cuStr_destroy(&cus);
+    free(expected);
+}
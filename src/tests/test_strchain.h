@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRCHAIN_H
+#define CU_INCLUDE_TEST_STRCHAIN_H
+
+void test_strchain(void);
+
+#endif /* CU_INCLUDE_TEST_STRCHAIN_H */
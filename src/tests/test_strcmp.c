@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <string.h>
+#include "test_strcmp.h"
+#include "../cutil_strcmp.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+static int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+/* Compare against memcmp() for every length up to 200 and every position
+ * of a single differing byte
+ */
+static int test_compare_kernels(void)
+{
+    char a[200], b[200];
+    size_t n, i;
+
+    for (i = 0; i < sizeof a; i++)
+        a[i] = b[i] = (char)(i * 7);
+
+    for (n = 0; n <= sizeof a; n++) {
+        if (!cuMem_equal(a, b, n) || cuMem_mismatch(a, b, n) != n)
+            return 0;
+        for (i = 0; i < n; i++) {
+            b[i] = (char)(a[i] ^ 0x80);  // must compare as unsigned
+            if (cuMem_equal(a, b, n) || cuMem_mismatch(a, b, n) != i
+                || sign(cuMem_compare(a, n, b, n)) != sign(memcmp(a, b, n)))
+                return 0;
+            b[i] = a[i];
+        }
+    }
+    return 1;
+}
+
+void test_strcmp(void)
+{
+    cuStr *cus1, *cus2;
+    const char arr1[] = { 'a', '\0', 'b' };
+    const char arr2[] = { 'a', '\0', 'c' };
+    int ok;
+
+    ok = test_compare_kernels();
+    cu_cpu_set_mask(CU_CPU_SSE2);
+    ok = ok && test_compare_kernels();
+    cu_cpu_set_mask(0);
+    ok = ok && test_compare_kernels();
+    cu_cpu_set_mask(~0U);
+    printf("Compare kernels: %s\n", result[ok]);
+
+    cus1 = cuStr_new(-1);
+    cus2 = cuStr_new(0);
+    if (!cus1 || !cus2) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        cuStr_destroy(&cus1);
+        cuStr_destroy(&cus2);
+        return;
+    }
+
+    /* Differences after an embedded '\0' count */
+    cuStr_set_fromarray(cus1, arr1, sizeof arr1);
+    cuStr_set_fromarray(cus2, arr2, sizeof arr2);
+    printf("cuStr_equal() past '\\0': %s\n", result[!cuStr_equal(cus1, cus2)
+                                               && cuStr_compare(cus1, cus2) < 0
+                                               && cuStr_compare(cus2, cus1) > 0]);
+
+    /* Prefixes order first, regardless of the next byte */
+    cuStr_set(cus1, "abc");
+    cuStr_set(cus2, "ab");
+    printf("cuStr_compare() prefix: %s\n", result[cuStr_compare(cus2, cus1) < 0
+                                            && cuStr_compare(cus1, cus2) > 0
+                                            && cuStr_compare_array(cus1, "b", 1) < 0]);
+
+    cuStr_set(cus2, "abc");
+    printf("cuStr_equal(): %s\n", result[cuStr_equal(cus1, cus2)
+                                         && cuStr_compare(cus1, cus2) == 0
+                                         && cuStr_equal_array(cus1, "abc", 3)]);
+
+    cuStr_set(cus1, "content-type: text/plain");
+    printf("cuStr_starts_with(): %s\n", result[cuStr_starts_with_array(cus1, "content-", 8)
+                                               && !cuStr_starts_with_array(cus1, "type", 4)
+                                               && cuStr_starts_with_array(cus1, "", 0)]);
+    cuStr_set(cus2, "plain");
+    printf("cuStr_ends_with(): %s\n", result[cuStr_ends_with(cus1, cus2)
+                                             && !cuStr_ends_with(cus2, cus1)]);
+
+    cuStr_clear(cus1);
+    cuStr_shrinktofit(cus1);
+    cuStr_clear(cus2);
+    printf("cuStr_equal() empty: %s\n", result[cuStr_equal(cus1, cus2)
+                                               && cuStr_compare(cus1, cus2) == 0]);
+
+    cuStr_destroy(&cus1);
+    cuStr_destroy(&cus2);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRCMP_H
+#define CU_INCLUDE_TEST_STRCMP_H
+
+void test_strcmp(void);
+
+#endif /* CU_INCLUDE_TEST_STRCMP_H */
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_strcodec.h"
+#include "../cutil_strcodec.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_CODEC_MAX  300     // covers every block and tail size
+
+static const unsigned masks[] = { 0, CU_CPU_SSE2 | CU_CPU_SSSE3, ~0U };
+
+static void test_fill(char *p, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        p[i] = (char)(i * 7 + i / 251);
+}
+
+/* Hex of every length against snprintf(), in both cases, and back */
+static int test_hex_lengths(void)
+{
+    char src[TEST_CODEC_MAX], enc[2 * TEST_CODEC_MAX + 1], ref[2 * TEST_CODEC_MAX + 1];
+    char dec[TEST_CODEC_MAX];
+    size_t n, i;
+
+    test_fill(src, sizeof src);
+    for (n = 0; n <= sizeof src; n++) {
+        for (i = 0; i < n; i++)
+            snprintf(ref + 2 * i, 3, "%02x", (unsigned char)src[i]);
+        if (cuMem_hex_encode(enc, src, n) != 2 * n || memcmp(enc, ref, 2 * n) != 0)
+            return 0;
+        if (cuMem_hex_decode(dec, enc, 2 * n) != n || memcmp(dec, src, n) != 0)
+            return 0;
+        for (i = 0; i < 2 * n; i++)
+            ref[i] = (char)(ref[i] >= 'a' ? ref[i] - 'a' + 'A' : ref[i]);
+        if (cuMem_hex_decode(dec, ref, 2 * n) != n || memcmp(dec, src, n) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/* A bad character anywhere must be found, whichever kernel reads it */
+static int test_hex_invalid(void)
+{
+    static const char bad[] = { 'g', 'G', '/', ':', '@', '`', ' ', '\0', (char)0x80, (char)0xb0 };
+    char enc[2 * TEST_CODEC_MAX], dec[TEST_CODEC_MAX], src[TEST_CODEC_MAX];
+    size_t i, k, n = 2 * TEST_CODEC_MAX;
+
+    test_fill(src, sizeof src);
+    cuMem_hex_encode(enc, src, sizeof src);
+    for (i = 0; i < n; i++) {
+        char c = enc[i];
+        for (k = 0; k < sizeof bad; k++) {
+            enc[i] = bad[k];
+            if (cuMem_hex_decode(dec, enc, n) != CUMEM_DECODE_ERROR)
+                return 0;
+        }
+        enc[i] = c;
+    }
+    return cuMem_hex_decode(dec, enc, n - 1) == CUMEM_DECODE_ERROR;
+}
+
+/* Every kernel must give the scalar encoding, which round-trips */
+static int test_base64_lengths(void)
+{
+    char src[TEST_CODEC_MAX], enc[CUMEM_BASE64_ENCODED_LEN(TEST_CODEC_MAX)];
+    char ref[sizeof enc], dec[TEST_CODEC_MAX];
+    size_t n, len;
+    unsigned mask = cu_cpu_features();
+
+    test_fill(src, sizeof src);
+    for (n = 0; n <= sizeof src; n++) {
+        cu_cpu_set_mask(0);
+        len = cuMem_base64_encode(ref, src, n);
+        cu_cpu_set_mask(mask);
+        if (len != CUMEM_BASE64_ENCODED_LEN(n) || cuMem_base64_encode(enc, src, n) != len
+            || memcmp(enc, ref, len) != 0)
+            return 0;
+        if (cuMem_base64_decode(dec, enc, len) != n || memcmp(dec, src, n) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+static int test_base64_invalid(void)
+{
+    static const char bad[] = { '=', '-', '_', '.', ' ', '\n', '\0', (char)0x80, (char)0xab };
+    char src[TEST_CODEC_MAX], enc[CUMEM_BASE64_ENCODED_LEN(TEST_CODEC_MAX)];
+    char dec[TEST_CODEC_MAX];
+    size_t i, k, n;
+
+    test_fill(src, sizeof src);
+    n = cuMem_base64_encode(enc, src, sizeof src);
+    for (i = 0; i < n; i++) {
+        char c = enc[i];
+        /* (padding may end the input) */
+        for (k = i == n - 1; k < sizeof bad; k++) {
+            enc[i] = bad[k];
+            if (cuMem_base64_decode(dec, enc, n) != CUMEM_DECODE_ERROR)
+                return 0;
+        }
+        enc[i] = c;
+    }
+    return cuMem_base64_decode(dec, enc, n - 1) == CUMEM_DECODE_ERROR;
+}
+
+/* Compare what cuStr_hexdump() writes with the same dump made byte by
+ * byte
+ */
+static int test_hexdump(const char *data, size_t n, int bytesperline)
+{
+    FILE *f = tmpfile();
+    cuStr *cus = cuStr_new(-1);
+    char *ref = malloc(3 * n + 2), *out = malloc(3 * n + 3);
+    size_t i, len = 0, got = 0;
+    int ok = f && cus && ref && out;
+
+    if (ok) {
+        for (i = 0; i < n; i++) {
+            snprintf(ref + len, 3, "%02x", (unsigned char)data[i]);
+            ref[len + 2] = (i + 1) % (size_t)bytesperline ? ' ' : '\n';
+            len += 3;
+        }
+        if (n % (size_t)bytesperline)
+            ref[len++] = '\n';
+        cuStr_set_fromarray(cus, data, (unsigned)n);
+        cuStr_hexdump(f, cus, bytesperline);
+        rewind(f);
+        got = fread(out, 1, 3 * n + 3, f);
+        ok = got == len && memcmp(out, ref, len) == 0;
+    }
+    if (f)
+        fclose(f);
+    cuStr_destroy(&cus);
+    free(ref);
+    free(out);
+    return ok;
+}
+
+void test_strcodec(void)
+{
+    static const char *const rfc4648[][2] = {
+        { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" },
+    };
+    const char high[] = { 0x00, 0x7f, (char)0x80, (char)0xff, 'a' };
+    char *big = malloc(10000);
+    cuStr *cus;
+    size_t k;
+    int ok;
+
+    cus = cuStr_new(-1);
+    if (!cus || !big) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        cuStr_destroy(&cus);
+        free(big);
+        return;
+    }
+
+    for (k = 0, ok = 1; k < sizeof masks / sizeof masks[0]; k++) {
+        cu_cpu_set_mask(masks[k]);
+        ok = ok && test_hex_lengths() && test_hex_invalid();
+    }
+    cu_cpu_set_mask(~0U);
+    printf("cuMem_hex_encode/decode() kernels: %s\n", result[ok]);
+
+    for (k = 0, ok = 1; k < sizeof masks / sizeof masks[0]; k++) {
+        cu_cpu_set_mask(masks[k]);
+        ok = ok && test_base64_lengths() && test_base64_invalid();
+    }
+    cu_cpu_set_mask(~0U);
+    printf("cuMem_base64_encode/decode() kernels: %s\n", result[ok]);
+
+    for (k = 0, ok = 1; k < sizeof rfc4648 / sizeof rfc4648[0] && ok; k++) {
+        cuStr_clear(cus);
+        ok = cuStr_base64_encode(cus, rfc4648[k][0], strlen(rfc4648[k][0])) == cus
+             && cuStr_strcmp_cstr(cus, rfc4648[k][1]) == 0;
+        cuStr_clear(cus);
+        ok = ok && cuStr_base64_decode(cus, rfc4648[k][1], strlen(rfc4648[k][1])) == cus
+             && cuStr_strcmp_cstr(cus, rfc4648[k][0]) == 0;
+    }
+    printf("cuStr_base64_encode/decode() RFC 4648: %s\n", result[ok]);
+
+    /* Unused bits after the last character must be zero */
+    printf("cuStr_base64_decode() non-canonical: %s\n", result[cuStr_base64_decode(cus, "QUI=", 4) != NULL
+                                                               && cuStr_base64_decode(cus, "QUJ=", 4) == NULL
+                                                               && cuStr_base64_decode(cus, "QQ==", 4) != NULL
+                                                               && cuStr_base64_decode(cus, "QR==", 4) == NULL
+                                                               && cuStr_base64_decode(cus, "Q===", 4) == NULL
+                                                               && cuStr_base64_decode(cus, "QQ=A", 4) == NULL]);
+
+    /* Appends, and leaves the string alone on error */
+    cuStr_set(cus, "id=");
+    ok = cuStr_hex_encode(cus, high, sizeof high) != NULL
+         && cuStr_strcmp_cstr(cus, "id=007f80ff61") == 0
+         && cuStr_hex_decode(cus, "4142zz", 6) == NULL
+         && cuStr_strcmp_cstr(cus, "id=007f80ff61") == 0 && cuStr_len(cus) == 13
+         && cuStr_hex_decode(cus, "4142", 4) != NULL
+         && cuStr_strcmp_cstr(cus, "id=007f80ff61AB") == 0;
+    printf("cuStr_hex_encode/decode() append: %s\n", result[ok]);
+
+    /* High bytes used to come out sign-extended, e.g. as ffffff80 */
+    test_fill(big, 10000);
+    printf("cuStr_hexdump(): %s\n", result[test_hexdump(high, sizeof high, 4)
+                                           && test_hexdump(high, sizeof high, 5)
+                                           && test_hexdump(high, 0, 8)
+                                           && test_hexdump(big, 10000, 16)
+                                           && test_hexdump(big, 10000, 1)
+                                           && test_hexdump(big, 10000, 3000)]);
+
+    cuStr_destroy(&cus);
+    free(big);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRCODEC_H
+#define CU_INCLUDE_TEST_STRCODEC_H
+
+void test_strcodec(void);
+
+#endif /* CU_INCLUDE_TEST_STRCODEC_H */
@@ -0,0 +1,80 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "test_strfile.h"
+#include "../cutil_strfile.h"
+#include "../cutil_strcmp.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+/* Write n bytes of a pattern to a new temporary file; returns 0 or -1 */
+static int test_write_file(char *path, size_t n)
+{
+    FILE *f;
+    size_t i;
+    int fd;
+
+    strcpy(path, "/tmp/cu_strfile_XXXXXX");
+    if ((fd = mkstemp(path)) < 0 || (f = fdopen(fd, "wb")) == NULL)
+        return -1;
+    for (i = 0; i < n; i++)
+        fputc(i % 251 == 250 ? '\0' : 'a' + (int)(i % 26), f);
+    return fclose(f);
+}
+
+/* Map the file both ways and check the contents */
+static int test_map(const char *path, size_t n)
+{
+    static const unsigned flags[] = {
+        CUSTR_MAP_SEQUENTIAL, CUSTR_MAP_HUGEPAGE, CUSTR_MAP_READ
+    };
+    size_t i, k;
+
+    for (k = 0; k < sizeof flags / sizeof flags[0]; k++) {
+        cuStr *cus = cuStr_map_file(path, flags[k]), *copy;
+        int ok = cus != NULL && cuStr_len(cus) == n
+                 && cuStr_cstr(cus)[n] == '\0';
+        for (i = 0; i < n && ok; i++)
+            ok = cuStr_cstr(cus)[i] == (i % 251 == 250 ? '\0' : 'a' + (int)(i % 26));
+        /* A copy is an ordinary string */
+        if (ok) {
+            copy = cuStr_copy(cus);
+            ok = copy != NULL && cuStr_equal(copy, cus)
+                 && cuStr_append(copy, "!") != NULL && cuStr_len(copy) == n + 1;
+            cuStr_destroy(&copy);
+        }
+        cuStr_destroy(&cus);
+        if (!ok)
+            return 0;
+    }
+    return 1;
+}
+
+void test_strfile(void)
+{
+    static const size_t sizes[] = { 0, 1, 100, 4095, 4096, 3 * 4096, 200000 };
+    char path[64];
+    size_t i;
+    int ok = 1;
+    cuStr *cus;
+
+    for (i = 0; i < sizeof sizes / sizeof sizes[0] && ok; i++) {
+        ok = test_write_file(path, sizes[i]) == 0 && test_map(path, sizes[i]);
+        unlink(path);
+    }
+    printf("cuStr_map_file(): %s\n", result[ok]);
+
+    errno = 0;
+    cus = cuStr_map_file("/nonexistent/cu_strfile", 0);
+    printf("cuStr_map_file() missing file: %s\n", result[cus == NULL && errno == ENOENT]);
+
+    /* Special files have no size to go by */
+    cus = cuStr_map_file("/proc/self/status", 0);
+    ok = cus == NULL || (cuStr_len(cus) > 0 && strlen(cuStr_cstr(cus)) == cuStr_len(cus));
+    printf("cuStr_map_file() /proc: %s\n", result[ok]);
+    cuStr_destroy(&cus);
+}
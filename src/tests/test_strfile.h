@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRFILE_H
+#define CU_INCLUDE_TEST_STRFILE_H
+
+void test_strfile(void);
+
+#endif /* CU_INCLUDE_TEST_STRFILE_H */
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <string.h>
+#include "test_strhash.h"
+#include "../cutil_strhash.h"
+#include "../cutil_strnum.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+/* Reference values from wyhash, seeded with the index. Loads are native
+ * endian, so these only hold on little-endian machines.
+ */
+static int test_known_values(void)
+{
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    static const struct {
+        const char *s;
+        uint64_t hash;
+    } known[] = {
+        { "", 0x93228a4de0eec5a2ULL },
+        { "a", 0xc5bac3db178713c4ULL },
+        { "abc", 0xa97f2f7b1d9b3314ULL },
+        { "message digest", 0x786d1f1df3801df4ULL },
+        { "abcdefghijklmnopqrstuvwxyz", 0xdca5a8138ad37c87ULL },
+        { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+          0xb9e734f117cfaf70ULL },
+        { "1234567890123456789012345678901234567890"
+          "1234567890123456789012345678901234567890", 0x6cc5eab49a92d617ULL },
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof known / sizeof known[0]; i++) {
+        if (cuMem_hash(known[i].s, strlen(known[i].s), i) != known[i].hash)
+            return 0;
+    }
+#endif
+    return 1;
+}
+
+/* The cached value must always match a fresh hash of the contents */
+static int hash_is_current(const cuStr *cus)
+{
+    return cuStr_hash(cus) == cuMem_hash(cuStr_cstr(cus), cuStr_len(cus),
+                                         CUSTR_HASH_SEED);
+}
+
+void test_strhash(void)
+{
+    cuStr *cus1, *cus2;
+    const char arr1[] = { 'k', '\0', 'a' };
+    const char arr2[] = { 'k', '\0', 'b' };
+    char buf[256];
+    size_t n;
+    int ok;
+
+    printf("cuMem_hash() known values: %s\n", result[test_known_values()]);
+
+    /* Every length up to 256, so each tail path is used, and a change to
+     * any single byte must change the hash
+     */
+    for (n = 0; n < sizeof buf; n++)
+        buf[n] = (char)(n * 31);
+    ok = 1;
+    for (n = 1; n <= sizeof buf && ok; n++) {
+        uint64_t h = cuMem_hash(buf, n, 0);
+        size_t i;
+        for (i = 0; i < n && ok; i++) {
+            buf[i] ^= 1;
+            ok = cuMem_hash(buf, n, 0) != h;
+            buf[i] ^= 1;
+        }
+        ok = ok && cuMem_hash(buf, n, 1) != h && cuMem_hash(buf, n - 1, 0) != h;
+    }
+    printf("cuMem_hash() single byte changes: %s\n", result[ok]);
+
+    cus1 = cuStr_new(0);
+    cus2 = cuStr_new(0);
+    if (!cus1 || !cus2) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        cuStr_destroy(&cus1);
+        cuStr_destroy(&cus2);
+        return;
+    }
+
+    cuStr_set_fromarray(cus1, arr1, sizeof arr1);
+    cuStr_set_fromarray(cus2, arr2, sizeof arr2);
+    printf("cuStr_hash() past '\\0': %s\n", result[cuStr_hash(cus1) != cuStr_hash(cus2)]);
+
+    /* Each mutator drops the cached value */
+    cuStr_set(cus1, "a key long enough to be kept on the heap");
+    ok = hash_is_current(cus1);
+    cuStr_append(cus1, "!");
+    ok = ok && hash_is_current(cus1);
+    cuStr_append_array(cus1, arr1, sizeof arr1);
+    ok = ok && hash_is_current(cus1);
+    cuStr_printf(cus1, "%d", 42);
+    ok = ok && hash_is_current(cus1);
+    cuStr_printf_append(cus1, "%s", "x");
+    ok = ok && hash_is_current(cus1);
+    cuStr_append_i64(cus1, -7);
+    ok = ok && hash_is_current(cus1);
+    cuStr_rotate(cus1, 1, 3);
+    ok = ok && hash_is_current(cus1);
+    cuStr_reserve(cus1, 1);
+    ok = ok && hash_is_current(cus1);
+    cuStr_clear(cus1);
+    ok = ok && hash_is_current(cus1);
+    printf("cuStr_hash() invalidation: %s\n", result[ok]);
+
+    cuStr_set(cus1, "shared");
+    cuStr_set(cus2, "shared");
+    cuStr_hash(cus1);
+    cuStr_destroy(&cus2);
+    cus2 = cuStr_copy(cus1);
+    printf("cuStr_hash() equal strings: %s\n", result[cus2 != NULL
+                                                      && cuStr_hash(cus2) == cuStr_hash(cus1)
+                                                      && hash_is_current(cus2)]);
+
+    cuStr_destroy(&cus1);
+    cuStr_destroy(&cus2);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRHASH_H
+#define CU_INCLUDE_TEST_STRHASH_H
+
+void test_strhash(void);
+
+#endif /* CU_INCLUDE_TEST_STRHASH_H */
@@ -1,6 +1,8 @@
 #include <stdio.h>
+#include <stdarg.h>
 #include "test_string.h"
 #include "../types.h"
+#include "../cutil_strcache.h"
 
 #ifndef NDEBUG
 void test_bytearray(void)
@@ -167,6 +169,160 @@ void test_bytearray(void)
     cuStr_destroy(&cus2);
 }
 
+void test_sso(void)
+{
+    cuStr *cus, *cus2;
+    static const char *result[] = { "FAILED", "Ok"};
+
+    cus = cuStr_new(-1);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        return;
+    }
+    printf("SSO new: %s\n", result[cus->mem == cus->sso]);
+
+    cuStr_set(cus, "content-length");
+    printf("SSO set: %s\n", result[cus->mem == cus->sso
+                                    && cuStr_strcmp_cstr(cus, "content-length") == 0
+                                    && cuStr_len(cus) == 14]);
+
+    cus2 = cuStr_copy(cus);
+    cuStr_set(cus2, "x");
+    printf("SSO copy: %s\n", result[cus2 && cus2->mem == cus2->sso
+                                     && cuStr_strcmp_cstr(cus, "content-length") == 0
+                                     && cuStr_strcmp_cstr(cus2, "x") == 0]);
+    cuStr_destroy(&cus2);
+
+    cuStr_append_array(cus, ": 1234567890", 12);
+    printf("SSO append to heap: %s\n", result[cus->mem != cus->sso
+                                               && cuStr_len(cus) == 26
+                                               && cuStr_at(cus, 25) == '0'
+                                               && cuStr_strcmp_cstr(cus, "content-length: 1234567890") == 0]);
+
+    cuStr_set(cus, "short");
+    cuStr_shrinktofit(cus);
+    printf("SSO shrinktofit: %s\n", result[cus->mem == cus->sso
+                                            && cuStr_strcmp_cstr(cus, "short") == 0]);
+
+    cuStr_destroy(&cus);
+}
+
+static size_t test_growth_policy(const cuStr *cus, size_t required)
+{
+    (void)cus;
+    return required + 1000;
+}
+
+void test_growth(void)
+{
+    cuStr *cus;
+    size_t prev_max;
+    unsigned reallocs = 0;
+    int i;
+    static const char *result[] = { "FAILED", "Ok"};
+    bool cached = cuStr_cache_enabled();
+
+    /* The capacities checked here are exact, not rounded to a size class */
+    cuStr_cache_enable(false);
+    cus = cuStr_new(-1);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        cuStr_cache_enable(cached);
+        return;
+    }
+
+    /* Geometric growth means the number of capacity changes grows with the
+     * log of the length, not linearly
+     */
+    prev_max = cuStr_max_elements(cus);
+    for (i = 0; i < 100000; i++) {
+        cuStr_append_array(cus, "0123456789", 10);
+        if (cuStr_max_elements(cus) != prev_max) {
+            reallocs++;
+            prev_max = cuStr_max_elements(cus);
+        }
+    }
+    printf("Geometric growth: (%u resizes) %s\n", reallocs,
+           result[reallocs < 40 && cuStr_len(cus) == 1000000]);
+
+    cuStr_clear(cus);
+    cuStr_shrinktofit(cus);
+    cuStr_reserve(cus, 5000);
+    printf("cuStr_reserve(): %s\n", result[cuStr_max_elements(cus) == 5000]);
+    cuStr_set(cus, "reserved");
+    printf("cuStr_reserve() keeps capacity: %s\n",
+           result[cuStr_max_elements(cus) == 5000]);
+
+    cuStr_set_growth_policy(cus, test_growth_policy);
+    cuStr_reserve(cus, 4000);
+    cuStr_append_array(cus, "x", 1);
+    for (i = 0; i < 5000; i++)
+        cuStr_append_array(cus, "x", 1);
+    printf("Growth policy: %s\n", result[cuStr_max_elements(cus) == 6001
+                                          && cuStr_len(cus) == 5009]);
+
+    cuStr_set_growth_policy(cus, NULL);
+    cuStr_set_growth_factor(cus, 200);
+    for (i = 0; i < 100; i++)
+        cuStr_append_array(cus, "0123456789", 10);
+    printf("Growth factor: %s\n", result[cuStr_max_elements(cus) >= 12002]);
+
+    cuStr_destroy(&cus);
+    cuStr_cache_enable(cached);
+}
+
+static int test_vprintf_wrapper(cuStr *cus, const char *format, ...)
+{
+    va_list args;
+    int r;
+
+    va_start(args, format);
+    r = cuStr_vprintf_append(cus, format, args);
+    va_end(args);
+    return r;
+}
+
+void test_printf(void)
+{
+    cuStr *cus;
+    int r;
+    static const char *result[] = { "FAILED", "Ok"};
+
+    cus = cuStr_new(0);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        return;
+    }
+
+    r = cuStr_printf(cus, "%s", "");
+    printf("cuStr_printf() empty: %s\n", result[r == 0 && cuStr_len(cus) == 0]);
+
+    r = cuStr_printf(cus, "%d", -12345678);
+    printf("cuStr_printf(): %s\n", result[r == 9
+                                           && cuStr_strcmp_cstr(cus, "-12345678") == 0]);
+
+    /* Fits in the spare capacity */
+    r = cuStr_printf_append(cus, ".%d", 7);
+    printf("cuStr_printf_append() fits: %s\n", result[r == 2
+                                         && cuStr_strcmp_cstr(cus, "-12345678.7") == 0]);
+
+    /* Doesn't fit: has to resize and format again */
+    r = cuStr_printf_append(cus, " %s %s", "ABCDEFGHIJKLMNOPQRS", "TUVWXYZ");
+    printf("cuStr_printf_append() resize: %s\n", result[r == 28
+            && cuStr_len(cus) == 39
+            && cuStr_strcmp_cstr(cus, "-12345678.7 ABCDEFGHIJKLMNOPQRS TUVWXYZ") == 0]);
+
+    r = test_vprintf_wrapper(cus, "%c%03d", '#', 5);
+    printf("cuStr_vprintf_append(): %s\n", result[r == 4
+            && cuStr_strcmp_cstr(cus, "-12345678.7 ABCDEFGHIJKLMNOPQRS TUVWXYZ#005") == 0]);
+
+    r = cuStr_printf(cus, "%s", "reset");
+    printf("cuStr_printf() overwrite: %s\n", result[r == 5
+                                            && cuStr_strcmp_cstr(cus, "reset") == 0]);
+
+    cuStr_destroy(&cus);
+}
+
 cuStr *look_and_say(const char *seed_str, int terms)
 {
     cuStr *cus1, *cus2, *src, *dest, *tmp;
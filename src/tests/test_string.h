@@ -5,6 +5,9 @@
 
 #ifndef NDEBUG
 void test_bytearray(void);
+void test_sso(void);
+void test_growth(void);
+void test_printf(void);
 cuStr *look_and_say(const char *seed_str, int terms);
 #endif // NDEBUG
 #endif
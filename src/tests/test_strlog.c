@@ -0,0 +1,268 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include "test_strlog.h"
+#include "../cutil_strlog.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_STRLOG_THREADS 4
+#define TEST_STRLOG_RECORDS 20000   // per thread
+
+typedef struct test_strlog_worker {
+    pthread_t thread;
+    cuStrLogBuffer *buf;
+    int id, failed;
+} test_strlog_worker;
+
+typedef struct test_strlog_consumer {
+    pthread_t thread;
+    cuStrLogBuffer *buf;
+    int fd, failed;
+    int stop;                   // set once the producers are done
+} test_strlog_consumer;
+
+/* Read back everything written to fd since it was created */
+static char *test_read_back(int fd, size_t *n)
+{
+    off_t size = lseek(fd, 0, SEEK_END);
+    char *data = malloc((size_t)size + 1);
+
+    if (!data || lseek(fd, 0, SEEK_SET) != 0
+        || read(fd, data, (size_t)size) != (ssize_t)size) {
+        free(data);
+        return NULL;
+    }
+    data[size] = '\0';
+    *n = (size_t)size;
+    return data;
+}
+
+static int test_temp_file(void)
+{
+    char path[] = "/tmp/cu_strlog_XXXXXX";
+    int fd = mkstemp(path);
+
+    if (fd >= 0)
+        unlink(path);
+    return fd;
+}
+
+/* Every 50th line is too long to be formatted on the stack */
+static void *test_strlog_worker_run(void *arg)
+{
+    test_strlog_worker *w = arg;
+    int i;
+
+    for (i = 0; i < TEST_STRLOG_RECORDS && !w->failed; i++) {
+        if (i % 50 == 0)
+            w->failed = cuStrLogBuffer_printf(w->buf, "t%d %d %0*d\n", w->id, i,
+                                              CUSTRLOGBUFFER_LINE + 10, 0) != 0;
+        else
+            w->failed = cuStrLogBuffer_printf(w->buf, "t%d %d\n", w->id, i) != 0;
+    }
+    return NULL;
+}
+
+static void *test_strlog_consumer_run(void *arg)
+{
+    test_strlog_consumer *c = arg;
+    ssize_t n;
+
+    for (;;) {
+        int stop = __atomic_load_n(&c->stop, __ATOMIC_ACQUIRE);
+        if ((n = cuStrLogBuffer_drain(c->buf, c->fd)) < 0) {
+            c->failed = 1;
+            break;
+        }
+        if (n == 0) {
+            if (stop)
+                break;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* Producers that wait on a small ring: each record must come out once,
+ * and those of each thread in order
+ */
+static int test_threads(void)
+{
+    test_strlog_worker workers[TEST_STRLOG_THREADS];
+    test_strlog_consumer consumer;
+    int next[TEST_STRLOG_THREADS] = { 0 };
+    char *data = NULL, *line, *save;
+    size_t n;
+    int t, started, ok = 1, id, seq;
+
+    consumer.buf = cuStrLogBuffer_new(4096);
+    consumer.fd = test_temp_file();
+    consumer.failed = consumer.stop = 0;
+    if (!consumer.buf || consumer.fd < 0
+        || pthread_create(&consumer.thread, NULL, test_strlog_consumer_run, &consumer) != 0) {
+        cuStrLogBuffer_destroy(&consumer.buf);
+        if (consumer.fd >= 0)
+            close(consumer.fd);
+        return 0;
+    }
+    for (started = 0; started < TEST_STRLOG_THREADS; started++) {
+        workers[started].buf = consumer.buf;
+        workers[started].id = started;
+        workers[started].failed = 0;
+        if (pthread_create(&workers[started].thread, NULL, test_strlog_worker_run,
+                           &workers[started]) != 0)
+            break;
+    }
+    for (t = 0; t < started; t++) {
+        pthread_join(workers[t].thread, NULL);
+        ok = ok && !workers[t].failed;
+    }
+    __atomic_store_n(&consumer.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(consumer.thread, NULL);
+    ok = ok && started == TEST_STRLOG_THREADS && !consumer.failed
+         && (data = test_read_back(consumer.fd, &n)) != NULL;
+
+    for (line = ok ? strtok_r(data, "\n", &save) : NULL; line && ok;
+         line = strtok_r(NULL, "\n", &save)) {
+        ok = sscanf(line, "t%d %d", &id, &seq) == 2 && id >= 0
+             && id < TEST_STRLOG_THREADS && seq == next[id]++
+             && strlen(line) == (seq % 50 ? 0 : CUSTRLOGBUFFER_LINE + 11)
+                                + (size_t)snprintf(NULL, 0, "t%d %d", id, seq);
+    }
+    for (t = 0; t < TEST_STRLOG_THREADS; t++)
+        ok = ok && next[t] == TEST_STRLOG_RECORDS;
+
+    free(data);
+    close(consumer.fd);
+    cuStrLogBuffer_destroy(&consumer.buf);
+    return ok;
+}
+
+/* Records of every length, drained one at a time, go round the ring many
+ * times
+ */
+static int test_wrap(cuStrLogBuffer *buf)
+{
+    char src[1000], *data = NULL;
+    size_t len, n = 0, expected = 0;
+    int fd = test_temp_file(), ok = fd >= 0;
+
+    for (len = 0; len < sizeof src; len++)
+        src[len] = (char)('a' + len % 26);
+    for (len = 0; len < sizeof src && ok; len += 3) {
+        ok = cuStrLogBuffer_write_array(buf, src, len) == 0
+             && cuStrLogBuffer_drain(buf, fd) == (ssize_t)len;
+        expected += len;
+    }
+    ok = ok && (data = test_read_back(fd, &n)) != NULL && n == expected;
+    for (len = 0, n = 0; len < sizeof src && ok; n += len, len += 3)
+        ok = memcmp(data + n, src, len) == 0;
+    free(data);
+    if (fd >= 0)
+        close(fd);
+    return ok;
+}
+
+/* Fill a non-blocking pipe: what does not fit stays for the next drain */
+static int test_would_block(void)
+{
+    cuStrLogBuffer *buf = cuStrLogBuffer_new(1 << 18);
+    char *src = malloc(50000), *back = malloc(200000);
+    size_t i, total = 0;
+    ssize_t n, got;
+    int fds[2], ok = buf && src && back && pipe(fds) == 0, rounds = 0;
+
+    if (ok) {
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        for (i = 0; i < 50000; i++)
+            src[i] = (char)(i * 7 + i / 4093);
+        for (i = 0; i < 4 && ok; i++)
+            ok = cuStrLogBuffer_write_array(buf, src, 50000) == 0;
+        while (ok && total < 200000) {
+            n = cuStrLogBuffer_drain(buf, fds[1]);
+            ok = n > 0 || (n < 0 && errno == EAGAIN);
+            while ((got = read(fds[0], back + total, 200000 - total)) > 0)
+                total += (size_t)got;
+            rounds++;
+        }
+        for (i = 0; i < 4 && ok; i++)
+            ok = memcmp(back + i * 50000, src, 50000) == 0;
+        ok = ok && rounds > 1 && cuStrLogBuffer_drain(buf, fds[1]) == 0;
+        close(fds[0]);
+        close(fds[1]);
+    }
+    cuStrLogBuffer_destroy(&buf);
+    free(src);
+    free(back);
+    return ok;
+}
+
+void test_strlog(void)
+{
+    cuStrLogBuffer *buf;
+    cuStr *cus;
+    char *record, *data = NULL;
+    size_t n = 0;
+    int fd, ok;
+
+    buf = cuStrLogBuffer_new(100);
+    cus = cuStr_new(-1);
+    fd = test_temp_file();
+    if (!buf || !cus || fd < 0) {
+        printf("cuStrLogBuffer_new() failed. Aborting tests\n");
+        cuStrLogBuffer_destroy(&buf);
+        cuStr_destroy(&cus);
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    cuStr_set(cus, "from a cuStr\n");
+    ok = cuStrLogBuffer_write_array(buf, "first\n", 6) == 0
+         && cuStrLogBuffer_printf(buf, "%s %d\n", "second", 2) == 0
+         && cuStrLogBuffer_write(buf, cus) == 0
+         && (record = cuStrLogBuffer_reserve(buf, 32)) != NULL;
+    if (ok) {
+        memcpy(record, "in place\n", 9);
+        cuStrLogBuffer_publish(buf, record, 9);
+    }
+    ok = ok && cuStrLogBuffer_drain(buf, fd) == 37 && cuStrLogBuffer_drain(buf, fd) == 0
+         && (data = test_read_back(fd, &n)) != NULL
+         && strcmp(data, "first\nsecond 2\nfrom a cuStr\nin place\n") == 0;
+    printf("cuStrLogBuffer_write/printf/drain(): %s\n", result[ok]);
+
+    /* The capacity went up to 4096, so a slot takes at most 2048 bytes, 8
+     * of which the header takes. The ring is not at offset 0 any more, where
+     * a slot of nearly the whole ring would never fit.
+     */
+    ok = cuStrLogBuffer_reserve(buf, 4089) == NULL && cuStrLogBuffer_reserve(buf, 4088) == NULL
+         && cuStrLogBuffer_reserve(buf, 2041) == NULL
+         && cuStrLogBuffer_write_array(buf, "", 5000) == -1;
+    record = ok ? cuStrLogBuffer_reserve(buf, 2040) : NULL;
+    if (record)
+        cuStrLogBuffer_publish(buf, record, 0);
+    ok = ok && record != NULL && cuStrLogBuffer_drain(buf, -1) == 0;
+    printf("cuStrLogBuffer_reserve() too long: %s\n", result[ok]);
+    if ((record = cuStrLogBuffer_reserve(buf, 1000)) != NULL)
+        cuStrLogBuffer_publish(buf, record, 0);
+    printf("cuStrLogBuffer_drain() empty record: %s\n", result[cuStrLogBuffer_drain(buf, fd) == 0
+                                                               && cuStrLogBuffer_drain(buf, -1) == 0]);
+
+    printf("cuStrLogBuffer wrap around: %s\n", result[test_wrap(buf)]);
+    printf("cuStrLogBuffer_drain() would block: %s\n", result[test_would_block()]);
+    printf("cuStrLogBuffer threads: %s\n", result[test_threads()]);
+
+    free(data);
+    close(fd);
+    cuStrLogBuffer_destroy(&buf);
+    cuStr_destroy(&cus);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRLOG_H
+#define CU_INCLUDE_TEST_STRLOG_H
+
+void test_strlog(void);
+
+#endif /* CU_INCLUDE_TEST_STRLOG_H */
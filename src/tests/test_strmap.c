@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "test_strmap.h"
+#include "../cutil_strmap.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_STRMAP_KEYS 5000
+
+/* Short keys are stored inline, every seventh key is long enough for the
+ * heap
+ */
+static size_t test_key(char *buf, size_t sz, int id)
+{
+    if (id % 7 == 0)
+        return (size_t)snprintf(buf, sz, "a much longer key, number %d", id);
+    return (size_t)snprintf(buf, sz, "k%d", id);
+}
+
+/* Random inserts, replacements and erases, checked against a plain array */
+static int test_random_ops(void)
+{
+    static void *expected[TEST_STRMAP_KEYS];
+    cuStrMap *map = cuStrMap_new(0);
+    uint64_t state = 88172645463325252u;
+    size_t i, size = 0, len;
+    char key[64];
+    int ok = map != NULL;
+
+    memset(expected, 0, sizeof expected);
+    for (i = 0; i < 200000 && ok; i++) {
+        int id, op;
+        void **value;
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        id = (int)(state % TEST_STRMAP_KEYS);
+        op = (int)((state >> 32) % 3);
+        len = test_key(key, sizeof key, id);
+
+        if (op < 2) {
+            if (expected[id] == NULL)
+                size++;
+            expected[id] = (void *)(uintptr_t)(i + 1);
+            ok = cuStrMap_put_array(map, key, len, expected[id]) == 0;
+        } else {
+            ok = cuStrMap_erase_array(map, key, len) == (expected[id] != NULL);
+            if (expected[id] != NULL)
+                size--;
+            expected[id] = NULL;
+        }
+        value = cuStrMap_get_array(map, key, len);
+        ok = ok && (value ? *value == expected[id] : expected[id] == NULL)
+                && cuStrMap_size(map) == size;
+    }
+
+    for (i = 0; i < TEST_STRMAP_KEYS && ok; i++) {
+        void **value;
+        len = test_key(key, sizeof key, (int)i);
+        value = cuStrMap_get_array(map, key, len);
+        ok = value ? *value == expected[i] : expected[i] == NULL;
+    }
+    cuStrMap_destroy(&map);
+    return ok;
+}
+
+void test_strmap(void)
+{
+    cuStrMap *map;
+    cuStr *key;
+    const char arr1[] = { 'k', '\0', 'a' };
+    const char arr2[] = { 'k', '\0', 'b' };
+    const char *k;
+    size_t pos, len, count;
+    void **value, *v;
+    int a = 1, b = 2, ok;
+
+    printf("cuStrMap random operations: %s\n", result[test_random_ops()]);
+
+    map = cuStrMap_new(10);
+    key = cuStr_new(0);
+    if (!map || !key) {
+        printf("cuStrMap_new() failed. Aborting tests\n");
+        cuStrMap_destroy(&map);
+        cuStr_destroy(&key);
+        return;
+    }
+
+    /* cuStr keys and arrays find the same entries */
+    cuStr_set(key, "apple");
+    cuStrMap_put(map, key, &a);
+    value = cuStrMap_get_array(map, "apple", 5);
+    ok = value && *value == &a && cuStrMap_get_array(map, "appl", 4) == NULL;
+    cuStrMap_put_array(map, "apple", 5, &b);
+    value = cuStrMap_get(map, key);
+    printf("cuStrMap_put() replace: %s\n", result[ok && value && *value == &b
+                                                  && cuStrMap_size(map) == 1]);
+
+    /* Keys differ after an embedded '\0' */
+    cuStrMap_put_array(map, arr1, sizeof arr1, &a);
+    cuStrMap_put_array(map, arr2, sizeof arr2, &b);
+    value = cuStrMap_get_array(map, arr1, sizeof arr1);
+    ok = value && *value == &a;
+    value = cuStrMap_get_array(map, arr2, sizeof arr2);
+    printf("cuStrMap key past '\\0': %s\n", result[ok && value && *value == &b
+                                                    && cuStrMap_get_array(map, "k", 1) == NULL]);
+
+    cuStrMap_put_array(map, "", 0, &a);
+    count = 0;
+    pos = 0;
+    while (cuStrMap_next(map, &pos, &k, &len, &v))
+        count += k[len] == '\0' && v != NULL;
+    printf("cuStrMap_next(): %s\n", result[count == 4 && cuStrMap_size(map) == 4]);
+
+    ok = cuStrMap_erase(map, key) && !cuStrMap_erase(map, key)
+         && cuStrMap_get(map, key) == NULL && cuStrMap_size(map) == 3;
+    cuStrMap_clear(map);
+    printf("cuStrMap_erase(): %s\n", result[ok && cuStrMap_size(map) == 0
+                                            && cuStrMap_get_array(map, "", 0) == NULL]);
+
+    cuStrMap_destroy(&map);
+    cuStr_destroy(&key);
+}
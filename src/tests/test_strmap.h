@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRMAP_H
+#define CU_INCLUDE_TEST_STRMAP_H
+
+void test_strmap(void);
+
+#endif /* CU_INCLUDE_TEST_STRMAP_H */
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_strmatch.h"
+#include "../cutil_strmatch.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_MATCH_TEXT     2000
+#define TEST_MATCH_MAX      40000       // matches kept per scan
+#define TEST_MATCH_TOKENS   200
+
+static const unsigned masks[] = { 0, CU_CPU_SSE2, CU_CPU_SSE2 | CU_CPU_SSSE3, ~0U };
+
+typedef struct test_matches {
+    size_t id[TEST_MATCH_MAX];
+    size_t offset[TEST_MATCH_MAX];
+    size_t n;
+    size_t stop;                // stop after this many, 0 for never
+} test_matches;
+
+static int test_record(void *ctx, size_t id, size_t offset)
+{
+    test_matches *t = ctx;
+
+    if (t->n < TEST_MATCH_MAX) {
+        t->id[t->n] = id;
+        t->offset[t->n] = offset;
+    }
+    t->n++;
+    return t->stop != 0 && t->n >= t->stop;
+}
+
+/* Every match by brute force, in the order the matcher reports them: by
+ * end position, then longest first and then by id
+ */
+static void test_naive(test_matches *t, const char *const *patterns, const size_t *lengths,
+                       size_t n, const char *s, size_t len)
+{
+    size_t end, l, i;
+
+    t->n = 0;
+    for (end = 1; end <= len; end++) {
+        for (l = end; l > 0; l--) {
+            for (i = 0; i < n; i++) {
+                if (lengths[i] == l && memcmp(s + end - l, patterns[i], l) == 0)
+                    test_record(t, i, end - l);
+            }
+        }
+    }
+}
+
+static int test_equal(const test_matches *a, const test_matches *b)
+{
+    return a->n == b->n && a->n <= TEST_MATCH_MAX
+           && memcmp(a->id, b->id, a->n * sizeof a->id[0]) == 0
+           && memcmp(a->offset, b->offset, a->n * sizeof a->offset[0]) == 0;
+}
+
+/* The whole scan and streams fed in pieces against the reference, with
+ * every kernel
+ */
+static int test_set_of(const char *const *patterns, const size_t *lengths, size_t n,
+                       const char *s, size_t len)
+{
+    static const size_t chunks[] = { 1, 7, 64, 1000 };
+    static test_matches ref, got;
+    cuStrMatcher *m;
+    cuStrMatchStream stream;
+    size_t k, c, i;
+    int ok = 1;
+
+    if ((m = cuStrMatcher_new_arrays(patterns, lengths, n)) == NULL)
+        return 0;
+    test_naive(&ref, patterns, lengths, n, s, len);
+    for (k = 0; ok && k < sizeof masks / sizeof masks[0]; k++) {
+        cu_cpu_set_mask(masks[k]);
+        got.n = got.stop = 0;
+        ok = cuStrMatcher_scan_array(m, s, len, test_record, &got) == ref.n
+             && test_equal(&ref, &got);
+        for (c = 0; ok && c < sizeof chunks / sizeof chunks[0]; c++) {
+            got.n = 0;
+            cuStrMatchStream_init(&stream, m);
+            for (i = 0; i < len; i += chunks[c])
+                cuStrMatchStream_feed(&stream, s + i, len - i < chunks[c] ? len - i : chunks[c],
+                                      test_record, &got);
+            ok = test_equal(&ref, &got);
+        }
+    }
+    cu_cpu_set_mask(~0U);
+    cuStrMatcher_destroy(&m);
+    return ok;
+}
+
+static int test_set_cstr(const char *const *patterns, size_t n, const char *s, size_t len)
+{
+    size_t lengths[16], i;
+
+    for (i = 0; i < n; i++)
+        lengths[i] = strlen(patterns[i]);
+    return test_set_of(patterns, lengths, n, s, len);
+}
+
+/* Text that repeats so that each set has matches throughout */
+static void test_text(char *s, size_t n, const char *words)
+{
+    size_t i, w = strlen(words);
+
+    for (i = 0; i < n; i++)
+        s[i] = words[(i * 7 + i / 13) % w];
+}
+
+static int test_small_sets(void)
+{
+    static const char *const classic[] = { "he", "she", "his", "hers" };
+    static const char *const singles[] = { "a", "e", "th", "the", "zz" };
+    static const char *const dup[] = { "abc", "bc", "abc", "c", "abcabc" };
+    static const char *const binary[] = { "\x80\xff", "a\x80", "\xff\xfe\x80" };
+    char s[TEST_MATCH_TEXT];
+    size_t i;
+    int ok;
+
+    test_text(s, sizeof s, "ushers his hershey ");
+    ok = test_set_cstr(classic, 4, s, sizeof s);
+    test_text(s, sizeof s, "the theme of these aazz ");
+    ok = ok && test_set_cstr(singles, 5, s, sizeof s);
+    test_text(s, sizeof s, "abcabcab cc");
+    ok = ok && test_set_cstr(dup, 5, s, sizeof s);
+    /* Nothing to find but bytes that pass the fingerprints */
+    test_text(s, sizeof s, "xyzXYZ !");
+    ok = ok && test_set_cstr(classic, 4, s, sizeof s);
+
+    /* Zero and high bytes */
+    for (i = 0; i < sizeof s; i++)
+        s[i] = (char)(i * 37 % 7 == 0 ? 0 : "a\x80\xff\xfe\x80"[i % 5]);
+    {
+        static const size_t lengths[] = { 2, 2, 3, 2 };
+        const char *const withzero[] = { binary[0], binary[1], binary[2], "\0a" };
+        ok = ok && test_set_of(withzero, lengths, 4, s, sizeof s);
+    }
+    return ok;
+}
+
+/* More patterns than Teddy takes, so that the first byte bitmap is used */
+static int test_large_set(void)
+{
+    static char tokens[TEST_MATCH_TOKENS][8];
+    const char *patterns[TEST_MATCH_TOKENS];
+    size_t lengths[TEST_MATCH_TOKENS], i, k;
+    char s[TEST_MATCH_TEXT];
+    unsigned seed = 1;
+
+    for (i = 0; i < TEST_MATCH_TOKENS; i++) {
+        lengths[i] = 2 + i % 5;
+        for (k = 0; k < lengths[i]; k++) {
+            seed = seed * 1103515245 + 12345;
+            tokens[i][k] = (char)('a' + (seed >> 16) % 12 + (i % 3 == 0 ? 0x60 : 0));
+        }
+        patterns[i] = tokens[i];
+    }
+    for (i = 0; i < sizeof s; i++) {
+        seed = seed * 1103515245 + 12345;
+        s[i] = (char)('a' + (seed >> 16) % 26);
+    }
+    if (!test_set_of(patterns, lengths, TEST_MATCH_TOKENS, s, sizeof s))
+        return 0;
+    /* Text with high bytes too */
+    for (i = 0; i < sizeof s; i += 3)
+        s[i] = (char)(s[i] + 0x60);
+    return test_set_of(patterns, lengths, TEST_MATCH_TOKENS, s, sizeof s);
+}
+
+static cuStr *test_new(const char *s)
+{
+    cuStr *cus = cuStr_new(-1);
+
+    if (cus && !cuStr_set(cus, s))
+        cuStr_destroy(&cus);
+    return cus;
+}
+
+void test_strmatch(void)
+{
+    static test_matches got;
+    cuStr *patterns[3], *cus;
+    cuStrMatcher *m;
+    size_t i, count;
+    int ok;
+
+    printf("cuStrMatcher small sets: %s\n", result[test_small_sets()]);
+    printf("cuStrMatcher large set: %s\n", result[test_large_set()]);
+
+    patterns[0] = test_new("GET ");
+    patterns[1] = test_new("Host:");
+    patterns[2] = test_new("\r\n");
+    cus = test_new("GET / HTTP/1.1\r\nHost: a\r\nHost: b\r\n\r\n");
+    if (!patterns[0] || !patterns[1] || !patterns[2] || !cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        goto done;
+    }
+    m = cuStrMatcher_new((const cuStr *const *)patterns, 3);
+    if (!m) {
+        printf("cuStrMatcher_new() failed. Aborting tests\n");
+        goto done;
+    }
+
+    got.n = got.stop = 0;
+    count = cuStrMatcher_scan(m, cus, test_record, &got);
+    ok = count == 7 && got.id[0] == 0 && got.offset[0] == 0 && got.id[1] == 2
+         && got.offset[1] == 14 && got.id[2] == 1 && got.offset[2] == 16
+         && got.id[6] == 2 && got.offset[6] == 34;
+    printf("cuStrMatcher_scan(): %s\n", result[ok]);
+
+    got.n = 0;
+    got.stop = 3;
+    ok = cuStrMatcher_scan(m, cus, test_record, &got) == 3 && got.n == 3;
+    printf("cuStrMatcher_scan() stopped: %s\n", result[ok]);
+    cuStrMatcher_destroy(&m);
+    ok = m == NULL;
+
+    /* No patterns, and nothing to scan */
+    m = cuStrMatcher_new(NULL, 0);
+    got.n = got.stop = 0;
+    ok = ok && m != NULL && cuStrMatcher_scan(m, cus, test_record, &got) == 0 && got.n == 0;
+    cuStrMatcher_destroy(&m);
+    m = cuStrMatcher_new((const cuStr *const *)patterns, 3);
+    ok = ok && m != NULL && cuStrMatcher_scan_array(m, NULL, 0, test_record, &got) == 0;
+    cuStrMatcher_destroy(&m);
+    printf("cuStrMatcher_new/destroy(), empty sets: %s\n", result[ok]);
+
+done:
+    for (i = 0; i < 3; i++)
+        cuStr_destroy(&patterns[i]);
+    cuStr_destroy(&cus);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRMATCH_H
+#define CU_INCLUDE_TEST_STRMATCH_H
+
+void test_strmatch(void);
+
+#endif /* CU_INCLUDE_TEST_STRMATCH_H */
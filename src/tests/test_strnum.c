@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <locale.h>
+#include "test_strnum.h"
+#include "../cutil_strnum.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+static int check_double(cuStr *cus, double d, const char *expected)
+{
+    cuStr_clear(cus);
+    cuStr_append_double(cus, d);
+    if (cuStr_strcmp_cstr(cus, expected) != 0) {
+        printf("  %.17g gave \"%s\", expected \"%s\"\n", d, cuStr_cstr(cus),
+               expected);
+        return 0;
+    }
+    return 1;
+}
+
+/* xorshift64, so the round trip test is repeatable */
+static uint64_t test_rand64(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+void test_strnum(void)
+{
+    cuStr *cus;
+    int64_t i64;
+    double d, parsed;
+    uint64_t bits, state = 88172645463325252u;
+    size_t n;
+    int ok, i;
+
+    cus = cuStr_new(-1);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        return;
+    }
+
+    cuStr_append_i64(cus, 0);
+    cuStr_append(cus, " ");
+    cuStr_append_i64(cus, -1234567);
+    cuStr_append(cus, " ");
+    cuStr_append_i64(cus, INT64_MIN);
+    cuStr_append(cus, " ");
+    cuStr_append_u64(cus, UINT64_MAX);
+    printf("cuStr_append_i64/u64(): %s\n", result[cuStr_strcmp_cstr(cus,
+           "0 -1234567 -9223372036854775808 18446744073709551615") == 0]);
+
+    n = cuStr_parse_i64(cus, 11, &i64);
+    ok = n == 20 && i64 == INT64_MIN;
+    n = cuStr_parse_i64(cus, 2, &i64);
+    ok = ok && n == 8 && i64 == -1234567;
+    ok = ok && cuStr_parse_i64(cus, 32, &i64) == 0;    // overflows
+    ok = ok && cuStr_parse_i64(cus, 1, &i64) == 0;     // not a number
+    printf("cuStr_parse_i64(): %s\n", result[ok]);
+
+    ok = check_double(cus, 0.0, "0");
+    ok &= check_double(cus, -0.0, "-0");
+    ok &= check_double(cus, 1.0, "1");
+    ok &= check_double(cus, 0.1, "0.1");
+    ok &= check_double(cus, -1.5, "-1.5");
+    ok &= check_double(cus, 1.0 / 3.0, "0.3333333333333333");
+    ok &= check_double(cus, 123456789012.0, "123456789012");
+    ok &= check_double(cus, 1e21, "1e+21");
+    ok &= check_double(cus, 1.5e-7, "1.5e-7");
+    ok &= check_double(cus, 0.000001, "0.000001");
+    ok &= check_double(cus, 5e-324, "5e-324");
+    ok &= check_double(cus, 1.7976931348623157e308, "1.7976931348623157e+308");
+    ok &= check_double(cus, strtod("inf", NULL), "inf");
+    ok &= check_double(cus, -strtod("inf", NULL), "-inf");
+    ok &= check_double(cus, strtod("nan", NULL), "nan");
+    printf("cuStr_append_double(): %s\n", result[ok]);
+
+    /* Every finite double must read back as itself */
+    ok = 1;
+    for (i = 0; i < 100000 && ok; i++) {
+        bits = test_rand64(&state);
+        memcpy(&d, &bits, sizeof d);
+        if (d != d || d - d != 0)
+            continue;   // NaN or infinity
+        cuStr_clear(cus);
+        cuStr_append_double(cus, d);
+        n = cuStr_parse_double(cus, 0, &parsed);
+        if (n != cuStr_len(cus) || memcmp(&parsed, &d, sizeof d) != 0
+            || strtod(cuStr_cstr(cus), NULL) != d) {
+            printf("  round trip of %.17g failed (\"%s\")\n", d, cuStr_cstr(cus));
+            ok = 0;
+        }
+    }
+    printf("cuStr_append_double() round trip: %s\n", result[ok]);
+
+    cuStr_set(cus, "x=-12.5e3,y=0.1,z=123456789012345678901234567890");
+    ok = cuStr_parse_double(cus, 2, &parsed) == 7 && parsed == -12.5e3;
+    ok = ok && cuStr_parse_double(cus, 12, &parsed) == 3 && parsed == 0.1;
+    ok = ok && cuStr_parse_double(cus, 18, &parsed) == 30
+            && parsed == 123456789012345678901234567890.0;
+    ok = ok && cuStr_parse_double(cus, 0, &parsed) == 0;
+    printf("cuStr_parse_double(): %s\n", result[ok]);
+
+    /* Long mantissas and large exponents go to strtod(), which must still
+     * take '.' where the locale has ',' (if such a locale is installed)
+     */
+    cuStr_set(cus, "0.1234567890123456789012345 1.5e300");
+    {
+        double expected = strtod("0.1234567890123456789012345", NULL);
+        const char *old_locale = setlocale(LC_NUMERIC, NULL);
+        char saved[64];
+
+        snprintf(saved, sizeof saved, "%s", old_locale ? old_locale : "C");
+        if (!setlocale(LC_NUMERIC, "de_DE.UTF-8"))
+            setlocale(LC_NUMERIC, "de_DE");
+        ok = cuStr_parse_double(cus, 0, &parsed) == 27 && parsed == expected
+             && cuStr_parse_double(cus, 28, &parsed) == 7 && parsed == 1.5e300;
+        setlocale(LC_NUMERIC, saved);
+    }
+    printf("cuStr_parse_double() locale: %s\n", result[ok]);
+
+    cuStr_destroy(&cus);
+}
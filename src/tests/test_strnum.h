@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRNUM_H
+#define CU_INCLUDE_TEST_STRNUM_H
+
+void test_strnum(void);
+
+#endif /* CU_INCLUDE_TEST_STRNUM_H */
@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_strpool.h"
+#include "../cutil_strpool.h"
+#include "../cutil_strhash.h"
+#include "../cutil_strcmp.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_STRPOOL_THREADS    4
+#define TEST_STRPOOL_KEYS       2000
+
+typedef struct test_strpool_worker {
+    pthread_t thread;
+    cuStrPool *pool;
+    int first;                                  // offset into the key ids
+    const cuStr *handles[TEST_STRPOOL_KEYS];    // handle for each key id
+    const cuStr *shared;                        // interned by every worker
+    const cuStr *shared_handle;
+} test_strpool_worker;
+
+static size_t test_key(char *buf, size_t sz, int id)
+{
+    if (id % 5 == 0)
+        return (size_t)snprintf(buf, sz, "long field name number %d", id);
+    return (size_t)snprintf(buf, sz, "f%d", id);
+}
+
+/* Every worker interns all the keys, starting at a different one, and
+ * the same cuStr now and then, whose hash they all cache
+ */
+static void *test_strpool_worker_run(void *arg)
+{
+    test_strpool_worker *w = arg;
+    char key[64];
+    int i;
+
+    for (i = 0; i < TEST_STRPOOL_KEYS; i++) {
+        int id = (w->first + i) % TEST_STRPOOL_KEYS;
+        size_t len = test_key(key, sizeof key, id);
+        if (i % 100 == 0) {
+            w->shared_handle = cuStrPool_intern(w->pool, w->shared);
+            if (w->shared_handle && !cuStr_equal(w->shared, w->shared_handle))
+                w->shared_handle = NULL;
+        }
+        w->handles[id] = cuStrPool_intern_array(w->pool, key, len);
+    }
+    return NULL;
+}
+
+/* All threads must get the same handle for the same contents */
+static int test_threads(void)
+{
+    static test_strpool_worker workers[TEST_STRPOOL_THREADS];
+    cuStrPool *pool = cuStrPool_new(CUSTRPOOL_THREADSAFE);
+    cuStr *shared = cuStr_new(-1);
+    char key[64];
+    int i, t, ok = pool != NULL && shared != NULL
+                   && cuStr_set(shared, "shared field name, not hashed yet");
+
+    for (t = 0; t < TEST_STRPOOL_THREADS && ok; t++) {
+        workers[t].pool = pool;
+        workers[t].shared = shared;
+        workers[t].first = t * (TEST_STRPOOL_KEYS / TEST_STRPOOL_THREADS);
+        ok = pthread_create(&workers[t].thread, NULL, test_strpool_worker_run,
+                            &workers[t]) == 0;
+    }
+    while (t--)
+        pthread_join(workers[t].thread, NULL);
+
+    for (i = 0; i < TEST_STRPOOL_KEYS && ok; i++) {
+        size_t len = test_key(key, sizeof key, i);
+        const cuStr *h = workers[0].handles[i];
+        ok = h != NULL && cuStr_len(h) == len
+             && memcmp(cuStr_cstr(h), key, len) == 0;
+        for (t = 1; t < TEST_STRPOOL_THREADS && ok; t++)
+            ok = workers[t].handles[i] == h;
+    }
+    for (t = 0; t < TEST_STRPOOL_THREADS && ok; t++)
+        ok = workers[t].shared_handle != NULL
+             && workers[t].shared_handle == workers[0].shared_handle;
+    ok = ok && cuStrPool_size(pool) == TEST_STRPOOL_KEYS + 1;
+    cuStrPool_destroy(&pool);
+    cuStr_destroy(&shared);
+    return ok;
+}
+
+void test_strpool(void)
+{
+    cuStrPool *pool;
+    cuStr *cus1, *cus2;
+    const cuStr *h1, *h2;
+    const char arr1[] = { 'k', '\0', 'a' };
+    const char arr2[] = { 'k', '\0', 'b' };
+
+    pool = cuStrPool_new(0);
+    cus1 = cuStr_new(0);
+    cus2 = cuStr_new(0);
+    if (!pool || !cus1 || !cus2) {
+        printf("cuStrPool_new() failed. Aborting tests\n");
+        cuStrPool_destroy(&pool);
+        cuStr_destroy(&cus1);
+        cuStr_destroy(&cus2);
+        return;
+    }
+
+    /* Separate copies of the same contents share one handle */
+    cuStr_set(cus1, "content-type");
+    cuStr_set(cus2, "content-");
+    cuStr_append(cus2, "type");
+    h1 = cuStrPool_intern(pool, cus1);
+    h2 = cuStrPool_intern(pool, cus2);
+    printf("cuStrPool_intern() same contents: %s\n", result[h1 != NULL && h1 == h2
+                                                           && h1 != cus1
+                                                           && cuStr_strcmp(h1, cus1) == 0
+                                                           && cuStrPool_size(pool) == 1]);
+
+    cuStr_set(cus2, "content-length");
+    h2 = cuStrPool_intern(pool, cus2);
+    printf("cuStrPool_intern() different contents: %s\n", result[h2 != NULL && h1 != h2
+                                                                && cuStrPool_size(pool) == 2]);
+
+    h1 = cuStrPool_intern_array(pool, arr1, sizeof arr1);
+    h2 = cuStrPool_intern_array(pool, arr2, sizeof arr2);
+    printf("cuStrPool_intern() past '\\0': %s\n", result[h1 && h2 && h1 != h2
+                                                        && cuStr_len(h1) == sizeof arr1
+                                                        && cuStrPool_intern_array(pool, arr1, sizeof arr1) == h1]);
+
+    printf("cuStrPool_lookup_array(): %s\n", result[cuStrPool_lookup_array(pool, arr2, sizeof arr2) == h2
+                                                    && cuStrPool_lookup_array(pool, "content", 7) == NULL
+                                                    && cuStr_hash(h2) == cuMem_hash(arr2, sizeof arr2, CUSTR_HASH_SEED)]);
+
+    /* Interned strings never grow, so they get no room past their length */
+    h1 = cuStrPool_intern_array(pool, "x-request-id-of-thirty-bytes-", 29);
+    h2 = cuStrPool_intern_array(pool, "short", 5);
+    printf("cuStrPool_intern() exact size: %s\n", result[h1 && cuStr_max_elements(h1) == 29
+                                                         && h2 && cuStr_max_elements(h2) == CUSTR_SSO_CAPACITY]);
+
+    printf("cuStrPool threads: %s\n", result[test_threads()]);
+
+    cuStrPool_destroy(&pool);
+    cuStr_destroy(&cus1);
+    cuStr_destroy(&cus2);
+}
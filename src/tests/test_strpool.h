@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRPOOL_H
+#define CU_INCLUDE_TEST_STRPOOL_H
+
+void test_strpool(void);
+
+#endif /* CU_INCLUDE_TEST_STRPOOL_H */
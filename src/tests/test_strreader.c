@@ -0,0 +1,168 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "test_strreader.h"
+#include "../cutil_strreader.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_STRREADER_RECORDS  500
+
+typedef struct test_strreader_writer {
+    pthread_t thread;
+    int fd;
+    const char *data;
+    size_t len;
+} test_strreader_writer;
+
+/* Record i is i % 97 bytes long, or much longer than the buffers used
+ * below every 50th time, so that plenty of records span refills
+ */
+static size_t test_record_len(size_t i)
+{
+    return i % 50 == 49 ? 1000 + i : i % 97;
+}
+
+static char *test_make_input(char delim, size_t *len)
+{
+    size_t i, k, n = 0;
+    char *data;
+
+    for (i = 0; i < TEST_STRREADER_RECORDS; i++)
+        n += test_record_len(i) + 1;
+    if ((data = malloc(n)) == NULL)
+        return NULL;
+    for (i = 0, n = 0; i < TEST_STRREADER_RECORDS; i++) {
+        for (k = 0; k < test_record_len(i); k++)
+            data[n++] = (char)('a' + (i + k) % 26);
+        data[n++] = delim;
+    }
+    /* Leave the delimiter off the last record */
+    *len = n - 1;
+    return data;
+}
+
+static int test_record_ok(size_t i, const char *p, size_t len)
+{
+    size_t k;
+
+    if (len != test_record_len(i))
+        return 0;
+    for (k = 0; k < len; k++) {
+        if (p[k] != (char)('a' + (i + k) % 26))
+            return 0;
+    }
+    return 1;
+}
+
+/* Write the input in small pieces, so the reader sees short reads */
+static void *test_strreader_write(void *arg)
+{
+    test_strreader_writer *w = arg;
+    size_t off = 0, n;
+
+    while (off < w->len) {
+        n = w->len - off < 777 ? w->len - off : 777;
+        if (write(w->fd, w->data + off, n) != (ssize_t)n)
+            break;
+        off += n;
+    }
+    close(w->fd);
+    return NULL;
+}
+
+/* Read the input through a pipe, as views or into a cuStr */
+static int test_read(const char *data, size_t len, char delim,
+                     size_t buffer_size, int use_views)
+{
+    test_strreader_writer w;
+    cuStrReader *reader;
+    cuStrView view;
+    cuStr *cus = cuStr_new(-1);
+    int fds[2], ok, r = 1;
+    size_t i;
+
+    if (!cus || pipe(fds) != 0) {
+        cuStr_destroy(&cus);
+        return 0;
+    }
+    w.fd = fds[1];
+    w.data = data;
+    w.len = len;
+    ok = pthread_create(&w.thread, NULL, test_strreader_write, &w) == 0;
+    reader = cuStrReader_new(fds[0], buffer_size);
+    ok = ok && reader != NULL;
+
+    for (i = 0; ok; i++) {
+        if (use_views) {
+            r = cuStrReader_next(reader, delim, &view);
+            ok = r == 0 || (r == 1 && test_record_ok(i, view.ptr, view.len));
+        } else {
+            r = cuStrReader_read(reader, delim, cus);
+            ok = r == 0 || (r == 1 && test_record_ok(i, cuStr_cstr(cus), cuStr_len(cus))
+                            && cuStr_cstr(cus)[cuStr_len(cus)] == '\0');
+        }
+        if (r == 0)
+            break;
+    }
+    ok = ok && i == TEST_STRREADER_RECORDS
+         && (use_views ? cuStrReader_next(reader, delim, &view)
+                       : cuStrReader_read(reader, delim, cus)) == 0;
+
+    pthread_join(w.thread, NULL);
+    close(fds[0]);
+    cuStrReader_destroy(&reader);
+    cuStr_destroy(&cus);
+    return ok;
+}
+
+void test_strreader(void)
+{
+    static const size_t buffer_sizes[] = { 16, 100, 4096, 0 };
+    cuStrReader *reader;
+    cuStrView view;
+    size_t len, i;
+    char *lines, *list;
+    int ok, fds[2];
+
+    lines = test_make_input('\n', &len);
+    list = test_make_input('\0', &len);
+    if (!lines || !list) {
+        printf("malloc() failed. Aborting tests\n");
+        free(lines);
+        free(list);
+        return;
+    }
+
+    ok = 1;
+    for (i = 0; i < sizeof buffer_sizes / sizeof buffer_sizes[0] && ok; i++)
+        ok = test_read(lines, len, '\n', buffer_sizes[i], 1)
+             && test_read(list, len, '\0', buffer_sizes[i], 1);
+    printf("cuStrReader_next(): %s\n", result[ok]);
+
+    ok = 1;
+    for (i = 0; i < sizeof buffer_sizes / sizeof buffer_sizes[0] && ok; i++)
+        ok = test_read(lines, len, '\n', buffer_sizes[i], 0)
+             && test_read(list, len, '\0', buffer_sizes[i], 0);
+    printf("cuStrReader_read(): %s\n", result[ok]);
+
+    /* Empty records, and no input at all */
+    ok = pipe(fds) == 0 && write(fds[1], "\n\nx\n", 4) == 4 && close(fds[1]) == 0
+         && (reader = cuStrReader_new(fds[0], 0)) != NULL;
+    if (ok) {
+        ok = cuStrReader_next(reader, '\n', &view) == 1 && view.len == 0
+             && cuStrReader_next(reader, '\n', &view) == 1 && view.len == 0
+             && cuStrReader_next(reader, '\n', &view) == 1 && view.len == 1
+             && cuStrReader_next(reader, '\n', &view) == 0;
+        cuStrReader_destroy(&reader);
+        close(fds[0]);
+    }
+    printf("cuStrReader empty records: %s\n", result[ok]);
+
+    free(lines);
+    free(list);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRREADER_H
+#define CU_INCLUDE_TEST_STRREADER_H
+
+void test_strreader(void);
+
+#endif /* CU_INCLUDE_TEST_STRREADER_H */
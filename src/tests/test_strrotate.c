@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "test_strrotate.h"
+#include "../cutil_string.h"
+#include "../cutil_strrotate.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_ROTATE_MAX (3 * CUMEM_ROTATE_SCRATCH)
+
+static void test_fill(char *p, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; i++)
+        p[i] = (char)(i * 7 + i / 251);
+}
+
+/* Every length up to 300 covers all the block and tail sizes */
+static int test_reverse_kernels(void)
+{
+    char buf[300], ref[300];
+    size_t n, i;
+
+    for (n = 0; n <= sizeof buf; n++) {
+        test_fill(buf, n);
+        for (i = 0; i < n; i++)
+            ref[i] = buf[n - 1 - i];
+        cuMem_reverse(buf, n);
+        if (memcmp(buf, ref, n) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/* Shifts on both sides of the scratch limit, from either end */
+static int test_rotate_lengths(char *buf, char *ref)
+{
+    static const size_t lengths[] = { 0, 1, 2, 3, 17, 100, CUMEM_ROTATE_SCRATCH + 1,
+                                      2 * CUMEM_ROTATE_SCRATCH + 3, TEST_ROTATE_MAX };
+    size_t k, n, shift;
+
+    for (k = 0; k < sizeof lengths / sizeof lengths[0]; k++) {
+        n = lengths[k];
+        for (shift = 0; shift <= n + 1; shift += 1 + (shift > 40 && shift + 40 < n) * 13) {
+            size_t s = n ? shift % n : 0;
+            test_fill(buf, n);
+            memcpy(ref, buf + s, n - s);
+            memcpy(ref + n - s, buf, s);
+            cuMem_rotate(buf, n, shift);
+            if (memcmp(buf, ref, n) != 0)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+void test_strrotate(void)
+{
+    static const unsigned masks[] = { 0, CU_CPU_SSE2, CU_CPU_SSE2 | CU_CPU_SSSE3, ~0U };
+    char *buf = malloc(TEST_ROTATE_MAX), *ref = malloc(TEST_ROTATE_MAX);
+    cuStr *cus;
+    size_t k;
+    int ok = 1;
+
+    if (!buf || !ref) {
+        printf("malloc() failed. Aborting tests\n");
+        free(buf);
+        free(ref);
+        return;
+    }
+
+    for (k = 0; k < sizeof masks / sizeof masks[0]; k++) {
+        cu_cpu_set_mask(masks[k]);
+        ok = ok && test_reverse_kernels();
+    }
+    cu_cpu_set_mask(~0U);
+    printf("cuMem_reverse() kernels: %s\n", result[ok]);
+
+    for (k = 0; k < sizeof masks / sizeof masks[0]; k++) {
+        cu_cpu_set_mask(masks[k]);
+        ok = ok && test_rotate_lengths(buf, ref);
+    }
+    cu_cpu_set_mask(~0U);
+    printf("cuMem_rotate(): %s\n", result[ok]);
+
+    /* The most negative shift must not overflow when it is negated. Both
+     * 2^63 and 2^31 leave 2 modulo 3.
+     */
+    cus = cuStr_new(0);
+    if (cus) {
+        cuStr_set(cus, "abcdefgh");
+        cuStr_rotate(cus, PTRDIFF_MIN, 3);
+        ok = cuStr_strcmp_cstr(cus, "cabdefgh") == 0;
+        cuStr_rotate(cus, 5, 100);
+        printf("cuStr_rotate() extreme shifts: %s\n",
+               result[ok && cuStr_strcmp_cstr(cus, "defghcab") == 0]);
+        cuStr_destroy(&cus);
+    }
+
+    free(buf);
+    free(ref);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRROTATE_H
+#define CU_INCLUDE_TEST_STRROTATE_H
+
+void test_strrotate(void);
+
+#endif /* CU_INCLUDE_TEST_STRROTATE_H */
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+#include "test_strsearch.h"
+#include "../cutil_strsearch.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+/* Straightforward reference implementations */
+static size_t ref_find(const char *s, size_t n, const char *nd, size_t nn,
+                       size_t pos)
+{
+    size_t i;
+
+    for (i = pos; i + nn <= n; i++) {
+        if (memcmp(s + i, nd, nn) == 0)
+            return i;
+    }
+    return CUSTR_NPOS;
+}
+
+static size_t ref_rfind(const char *s, size_t n, const char *nd, size_t nn,
+                        size_t pos)
+{
+    size_t i;
+
+    if (nn > n)
+        return CUSTR_NPOS;
+    i = pos > n - nn ? n - nn : pos;
+    for (;; i--) {
+        if (memcmp(s + i, nd, nn) == 0)
+            return i;
+        if (i == 0)
+            return CUSTR_NPOS;
+    }
+}
+
+static size_t ref_count(const char *s, size_t n, const char *nd, size_t nn)
+{
+    size_t i = 0, count = 0;
+
+    while ((i = ref_find(s, n, nd, nn, i)) != CUSTR_NPOS) {
+        count++;
+        i += nn;
+    }
+    return count;
+}
+
+/* Compare every kernel against the reference on pseudo-random data from a
+ * small alphabet (including '\0') so there are plenty of partial matches
+ */
+static int test_search_kernels(void)
+{
+    static const char alphabet[] = { 'a', 'b', 'c', '\0' };
+    char hay[300], nd[8];
+    unsigned seed = 12345;
+    int round, i;
+    cuStr *cus = cuStr_new(-1);
+
+    if (!cus)
+        return 0;
+
+    for (round = 0; round < 2000; round++) {
+        size_t n = (size_t)(round % 300), nn, pos;
+
+        for (i = 0; i < (int)n; i++) {
+            seed = seed * 1103515245 + 12345;
+            hay[i] = alphabet[(seed >> 16) & 3];
+        }
+        seed = seed * 1103515245 + 12345;
+        nn = 1 + (seed >> 16) % 6;
+        for (i = 0; i < (int)nn; i++) {
+            seed = seed * 1103515245 + 12345;
+            nd[i] = alphabet[(seed >> 16) & 3];
+        }
+        seed = seed * 1103515245 + 12345;
+        pos = n ? (seed >> 16) % n : 0;
+        cuStr_set_fromarray(cus, hay, (unsigned)n);
+
+        if (cuStr_find_array(cus, nd, nn, pos) != ref_find(hay, n, nd, nn, pos)
+            || cuStr_rfind_array(cus, nd, nn, pos) != ref_rfind(hay, n, nd, nn, pos)
+            || cuStr_count_array(cus, nd, nn) != ref_count(hay, n, nd, nn)
+            || cuStr_find_byte(cus, nd[0], pos) != ref_find(hay, n, nd, 1, pos)
+            || cuStr_rfind_byte(cus, nd[0], pos) != ref_rfind(hay, n, nd, 1, pos)) {
+            printf("  mismatch: round %d, length %zu, needle length %zu\n",
+                   round, n, nn);
+            cuStr_destroy(&cus);
+            return 0;
+        }
+    }
+    cuStr_destroy(&cus);
+    return 1;
+}
+
+void test_strsearch(void)
+{
+    cuStr *cus, *needle;
+    const char arr[] = { 'x', '\0', 'y', 'z', '\0', 'y', 'z' };
+    int ok;
+
+    ok = test_search_kernels();
+    cu_cpu_set_mask(CU_CPU_SSE2);
+    ok = ok && test_search_kernels();
+    cu_cpu_set_mask(0);
+    ok = ok && test_search_kernels();
+    cu_cpu_set_mask(~0U);
+    printf("Search kernels: %s\n", result[ok]);
+
+    cus = cuStr_new(-1);
+    needle = cuStr_new(-1);
+    if (!cus || !needle) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        cuStr_destroy(&cus);
+        cuStr_destroy(&needle);
+        return;
+    }
+
+    /* Matches after an embedded '\0' must be found */
+    cuStr_set_fromarray(cus, arr, sizeof arr);
+    cuStr_set_fromarray(needle, arr + 1, 3);
+    printf("cuStr_find() past '\\0': %s\n", result[cuStr_find(cus, needle, 0) == 1
+                                                 && cuStr_find(cus, needle, 2) == 4]);
+    printf("cuStr_rfind(): %s\n", result[cuStr_rfind(cus, needle, CUSTR_NPOS) == 4
+                                         && cuStr_rfind(cus, needle, 3) == 1]);
+    printf("cuStr_count(): %s\n", result[cuStr_count(cus, needle) == 2
+                                         && cuStr_count_array(cus, "\0", 1) == 2]);
+    printf("cuStr_find_byte(): %s\n", result[cuStr_find_byte(cus, 'z', 0) == 3
+                                             && cuStr_rfind_byte(cus, 'z', CUSTR_NPOS) == 6
+                                             && cuStr_find_byte(cus, 'q', 0) == CUSTR_NPOS]);
+
+    cuStr_destroy(&cus);
+    cuStr_destroy(&needle);
+}
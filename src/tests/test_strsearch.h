@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRSEARCH_H
+#define CU_INCLUDE_TEST_STRSEARCH_H
+
+void test_strsearch(void);
+
+#endif /* CU_INCLUDE_TEST_STRSEARCH_H */
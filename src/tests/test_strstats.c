@@ -0,0 +1,93 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "test_strstats.h"
+#include "../cutil_string.h"
+#include "../cutil_strstats.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#ifdef CUSTR_STATS
+static void *test_strstats_worker(void *arg)
+{
+    int i;
+
+    (void)arg;
+    for (i = 0; i < 100; i++) {
+        cuStr *cus = cuStr_new(1000);
+        cuStr_destroy(&cus);
+    }
+    return NULL;
+}
+
+void test_strstats(void)
+{
+    cuStrStats stats;
+    cuStr *cus, *copy;
+    pthread_t thread;
+    FILE *f;
+    int ok;
+
+    cuStr_stats_reset();
+    cus = cuStr_new(-1);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        return;
+    }
+    /* Out of the inline buffer into 255 + 1 bytes on the heap */
+    cuStr_append(cus, "0123456789012345678901234567890123456789");
+    copy = cuStr_copy(cus);
+    cuStr_destroy(&cus);
+    cuStr_destroy(&copy);
+
+    cuStr_stats_snapshot(&stats);
+    printf("cuStr_stats_snapshot(): %s\n", result[stats.allocs == 4 && stats.frees == 4
+                                                  && stats.reallocs == 0
+                                                  && stats.bytes_copied == 1 + 41
+                                                  && stats.peak_capacity == 256
+                                                  && stats.wasted_capacity == 2 * (255 - 40)]);
+
+    cuStr_stats_reset();
+    cus = cuStr_new(300);
+    cuStr_reserve(cus, 100000);
+    cuStr_set(cus, "short");
+    cuStr_shrinktofit(cus);
+    cuStr_destroy(&cus);
+    cuStr_stats_snapshot(&stats);
+    ok = stats.allocs == 2 && stats.reallocs == 1 && stats.frees == 2
+         && stats.peak_capacity == 100001 && stats.bytes_copied >= 5;
+    printf("cuStr_stats_snapshot() realloc and shrink: %s\n", result[ok]);
+
+    /* Counters of a thread that has exited are kept */
+    cuStr_stats_reset();
+    ok = pthread_create(&thread, NULL, test_strstats_worker, NULL) == 0
+         && pthread_join(thread, NULL) == 0;
+    cuStr_stats_snapshot(&stats);
+    printf("cuStr_stats_snapshot() threads: %s\n", result[ok && stats.allocs == 200
+                                                          && stats.frees == 200]);
+
+    ok = (f = tmpfile()) != NULL;
+    if (ok) {
+        char line[64] = "";
+        cuStr_stats_dump(f, &stats);
+        rewind(f);
+        ok = fgets(line, sizeof line, f) != NULL
+             && strcmp(line, "cuStr allocs:          200\n") == 0;
+        fclose(f);
+    }
+    printf("cuStr_stats_dump(): %s\n", result[ok]);
+}
+#else
+void test_strstats(void)
+{
+    cuStrStats stats;
+    cuStr *cus = cuStr_new(1000);
+
+    cuStr_destroy(&cus);
+    cuStr_stats_snapshot(&stats);
+    printf("cuStr_stats_snapshot() without CUSTR_STATS: %s\n",
+           result[stats.allocs == 0 && stats.frees == 0 && stats.peak_capacity == 0]);
+}
+#endif
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRSTATS_H
+#define CU_INCLUDE_TEST_STRSTATS_H
+
+void test_strstats(void);
+
+#endif /* CU_INCLUDE_TEST_STRSTATS_H */
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <string.h>
+#include "test_strutf8.h"
+#include "../cutil_strutf8.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_UTF8_MAX   300     // covers every block and tail size
+
+static const unsigned masks[] = { 0, CU_CPU_SSE2, CU_CPU_SSE2 | CU_CPU_SSSE3, ~0U };
+
+/* Text with characters of every length, and runs of ASCII long enough for
+ * whole blocks of it; returns its length, at most TEST_UTF8_MAX
+ */
+static size_t test_text(char *p)
+{
+    static const char *const parts[] = {
+        "plain ASCII text that fills a block or two, ",
+        "caf\xc3\xa9 ", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xd0\x96\xd0\xb8",
+        "\xe6\x97\xa5\xe6\x9c\xac", "\xf4\x8f\xbf\xbf", "\xef\xbf\xbf", "\x7f\xc2\x80",
+        "\xed\x9f\xbf\xee\x80\x80", "\xf0\x90\x80\x80", "\xdf\xbf", "\x01",
+    };
+    size_t n = 0, k, len;
+
+    for (k = 0;; k++) {
+        len = strlen(parts[k % (sizeof parts / sizeof parts[0])]);
+        if (n + len > TEST_UTF8_MAX)
+            return n;
+        memcpy(p + n, parts[k % (sizeof parts / sizeof parts[0])], len);
+        n += len;
+    }
+}
+
+/* Known cases for the scalar code, which the kernels are then checked
+ * against
+ */
+static int test_known(void)
+{
+    static const struct {
+        const char *s;
+        bool valid;
+    } cases[] = {
+        { "", true }, { "a", true }, { "\xc2\x80", true }, { "\xdf\xbf", true },
+        { "\xe0\xa0\x80", true }, { "\xed\x9f\xbf", true }, { "\xee\x80\x80", true },
+        { "\xf0\x90\x80\x80", true }, { "\xf4\x8f\xbf\xbf", true },
+        { "\x80", false }, { "\xbf", false }, { "\xc0\x80", false }, { "\xc1\xbf", false },
+        { "\xc2", false }, { "\xc2\x41", false }, { "\xc2\x80\x80", false },
+        { "\xe0\x80\x80", false }, { "\xe0\x9f\xbf", false }, { "\xed\xa0\x80", false },
+        { "\xed\xbf\xbf", false }, { "\xe1\x80", false }, { "\xe1\x80\xc0", false },
+        { "\xf0\x80\x80\x80", false }, { "\xf0\x8f\xbf\xbf", false },
+        { "\xf4\x90\x80\x80", false }, { "\xf5\x80\x80\x80", false },
+        { "\xf0\x90\x80", false }, { "\xf0\x90\x80\x41", false }, { "\xff", false },
+    };
+    size_t k;
+
+    for (k = 0; k < sizeof cases / sizeof cases[0]; k++) {
+        if (cuMem_utf8_validate(cases[k].s, strlen(cases[k].s)) != cases[k].valid)
+            return 0;
+    }
+    return 1;
+}
+
+/* Every prefix, and every byte replaced with something that breaks the
+ * text or may not, must give the scalar answer
+ */
+static int test_validate_kernels(void)
+{
+    static const unsigned char bad[] = { 0x00, 0x41, 0x80, 0x9f, 0xa0, 0xbf, 0xc0, 0xc2,
+                                         0xe0, 0xed, 0xef, 0xf0, 0xf4, 0xf5, 0xff };
+    char text[TEST_UTF8_MAX];
+    size_t n = test_text(text), len, i, k, m, count;
+    bool ref;
+
+    for (m = 0; m < sizeof masks / sizeof masks[0]; m++) {
+        for (len = 0; len <= n; len++) {
+            cu_cpu_set_mask(0);
+            ref = cuMem_utf8_validate(text, len);
+            count = cuMem_utf8_length(text, len);
+            cu_cpu_set_mask(masks[m]);
+            if (cuMem_utf8_validate(text, len) != ref
+                || cuMem_utf8_length(text, len) != count)
+                return 0;
+        }
+        for (i = 0; i < n; i++) {
+            char c = text[i];
+            for (k = 0; k < sizeof bad; k++) {
+                text[i] = (char)bad[k];
+                cu_cpu_set_mask(0);
+                ref = cuMem_utf8_validate(text, n);
+                cu_cpu_set_mask(masks[m]);
+                if (cuMem_utf8_validate(text, n) != ref)
+                    return 0;
+            }
+            text[i] = c;
+        }
+    }
+    cu_cpu_set_mask(~0U);
+    return cuMem_utf8_validate(text, n);
+}
+
+/* UTF-8 to UTF-16 and UTF-32 and back, at every length */
+static int test_roundtrip(void)
+{
+    char text[TEST_UTF8_MAX], back[4 * TEST_UTF8_MAX];
+    uint16_t u16[TEST_UTF8_MAX], ref16[TEST_UTF8_MAX];
+    uint32_t u32[TEST_UTF8_MAX], ref32[TEST_UTF8_MAX];
+    size_t n = test_text(text), len, n16, n32, m;
+
+    for (len = 0; len <= n; len++) {
+        if (!cuMem_utf8_validate(text, len))
+            continue;
+        cu_cpu_set_mask(0);
+        n16 = cuMem_utf8_to_utf16(ref16, text, len);
+        n32 = cuMem_utf8_to_utf32(ref32, text, len);
+        if (n32 != cuMem_utf8_length(text, len) || n16 < n32)
+            return 0;
+        for (m = 0; m < sizeof masks / sizeof masks[0]; m++) {
+            cu_cpu_set_mask(masks[m]);
+            if (cuMem_utf8_to_utf16(u16, text, len) != n16
+                || memcmp(u16, ref16, n16 * sizeof *u16) != 0
+                || cuMem_utf16_to_utf8(back, u16, n16) != len
+                || memcmp(back, text, len) != 0)
+                return 0;
+            if (cuMem_utf8_to_utf32(u32, text, len) != n32
+                || memcmp(u32, ref32, n32 * sizeof *u32) != 0
+                || cuMem_utf32_to_utf8(back, u32, n32) != len
+                || memcmp(back, text, len) != 0)
+                return 0;
+        }
+    }
+    cu_cpu_set_mask(~0U);
+    return 1;
+}
+
+void test_strutf8(void)
+{
+    static const uint16_t lone_high[] = { 'a', 0xD83D, 'b' }, lone_low[] = { 0xDE00, 'a' };
+    static const uint16_t pair[] = { 'a', 0xD83D, 0xDE00 };
+    static const uint32_t too_large[] = { 'a', 0x110000 }, surrogate[] = { 0xDFFF };
+    static const uint32_t euro[] = { 0x20AC };
+    char buf[8];
+    uint16_t u16[4];
+    cuStr *cus;
+    int ok;
+
+    cus = cuStr_new(-1);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        return;
+    }
+
+    printf("cuMem_utf8_validate() known cases: %s\n", result[test_known()]);
+    printf("cuMem_utf8_validate() kernels: %s\n", result[test_validate_kernels()]);
+    printf("cuMem_utf8_length(): %s\n", result[cuMem_utf8_length("", 0) == 0
+                                              && cuMem_utf8_length("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", 10) == 4]);
+    printf("cuMem_utf8_to_utf16/32() round trip: %s\n", result[test_roundtrip()]);
+
+    printf("cuMem_utf16_to_utf8() surrogates: %s\n", result[cuMem_utf16_to_utf8(buf, pair, 3) == 5
+                                                          && memcmp(buf, "a\xf0\x9f\x98\x80", 5) == 0
+                                                          && cuMem_utf16_to_utf8(buf, lone_high, 3) == CUMEM_UTF_ERROR
+                                                          && cuMem_utf16_to_utf8(buf, pair, 2) == CUMEM_UTF_ERROR
+                                                          && cuMem_utf16_to_utf8(buf, lone_low, 2) == CUMEM_UTF_ERROR]);
+    printf("cuMem_utf32_to_utf8() invalid: %s\n", result[cuMem_utf32_to_utf8(buf, too_large, 2) == CUMEM_UTF_ERROR
+                                                       && cuMem_utf32_to_utf8(buf, surrogate, 1) == CUMEM_UTF_ERROR
+                                                       && cuMem_utf8_to_utf16(u16, "\xed\xa0\x80", 3) == CUMEM_UTF_ERROR]);
+
+    /* Appends, and leaves the string alone on error */
+    cuStr_set(cus, "x=");
+    ok = cuStr_utf32_to_utf8(cus, euro, 1) == cus
+         && cuStr_strcmp_cstr(cus, "x=\xe2\x82\xac") == 0
+         && cuStr_utf16_to_utf8(cus, lone_high, 3) == NULL
+         && cuStr_utf32_to_utf8(cus, too_large, 2) == NULL
+         && cuStr_strcmp_cstr(cus, "x=\xe2\x82\xac") == 0 && cuStr_len(cus) == 5
+         && cuStr_utf16_to_utf8(cus, pair, 3) == cus
+         && cuStr_len(cus) == 10 && cuStr_utf8_validate(cus) && cuStr_utf8_length(cus) == 5;
+    printf("cuStr_utf16/32_to_utf8(): %s\n", result[ok]);
+
+    cuStr_set(cus, "");
+    ok = cuStr_utf8_to_utf16(cus, "a\xf0\x9f\x98\x80", 5) == cus && cuStr_len(cus) == 6
+         && cuStr_utf8_to_utf16(cus, "\xc0\xaf", 2) == NULL && cuStr_len(cus) == 6;
+    memcpy(u16, cuStr_cstr(cus), 6);
+    ok = ok && memcmp(u16, pair, 6) == 0;
+    cuStr_set(cus, "");
+    ok = ok && cuStr_utf8_to_utf32(cus, "\xe2\x82\xac", 3) == cus && cuStr_len(cus) == 4
+         && memcmp(cuStr_cstr(cus), euro, 4) == 0
+         && cuStr_utf8_to_utf32(cus, "\xe2\x82", 2) == NULL && cuStr_len(cus) == 4;
+    printf("cuStr_utf8_to_utf16/32(): %s\n", result[ok]);
+
+    cuStr_destroy(&cus);
+}
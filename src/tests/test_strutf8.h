@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRUTF8_H
+#define CU_INCLUDE_TEST_STRUTF8_H
+
+void test_strutf8(void);
+
+#endif /* CU_INCLUDE_TEST_STRUTF8_H */
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+#include "test_strview.h"
+#include "../cutil_strview.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+/* True if v holds exactly the bytes of s */
+static int test_is(cuStrView v, const char *s)
+{
+    return v.len == strlen(s) && memcmp(v.ptr, s, v.len) == 0;
+}
+
+static int test_split(const char *line, const char *sep,
+                      const char *const *fields, size_t n)
+{
+    cuStrSplit it;
+    cuStrView field;
+    size_t i = 0;
+
+    cuStrSplit_init(&it, cuStrView_from_cstr(line), cuStrView_from_cstr(sep));
+    while (cuStrSplit_next(&it, &field)) {
+        if (i >= n || !test_is(field, fields[i]))
+            return 0;
+        i++;
+    }
+    return i == n && !cuStrSplit_next(&it, &field);
+}
+
+static int test_tok(const char *line, const char *delims,
+                    const char *const *tokens, size_t n)
+{
+    cuStrTok tok;
+    cuStrView token;
+    size_t i = 0;
+
+    cuStrTok_init(&tok, cuStrView_from_cstr(line), delims, strlen(delims));
+    while (cuStrTok_next(&tok, &token)) {
+        if (i >= n || !test_is(token, tokens[i]))
+            return 0;
+        i++;
+    }
+    return i == n;
+}
+
+void test_strview(void)
+{
+    static const char *const f1[] = { "GET", "/index.html", "HTTP/1.1" };
+    static const char *const f2[] = { "", "a", "", "b", "" };
+    static const char *const f3[] = { "key", "value", "" };
+    static const char *const f4[] = { "" };
+    static const char *const t1[] = { "a", "b", "c" };
+    const char bytes[] = { 'x', '\0', 'y', '\0', 'z' };
+    cuStrView v, w;
+    cuStr *cus = cuStr_new(0);
+    int ok;
+
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        return;
+    }
+
+    cuStr_set(cus, "  content-length: 42 \r\n");
+    v = cuStrView_of(cus);
+    ok = v.ptr == cuStr_cstr(cus) && v.len == cuStr_len(cus);
+    printf("cuStrView_of(): %s\n", result[ok]);
+
+    printf("cuStrView_trim(): %s\n", result[test_is(cuStrView_trim(v), "content-length: 42")
+                                           && test_is(cuStrView_trim_left(v), "content-length: 42 \r\n")
+                                           && test_is(cuStrView_trim_right(v), "  content-length: 42")
+                                           && cuStrView_trim(cuStrView_from_cstr(" \t\n")).len == 0]);
+
+    v = cuStrView_trim(v);
+    printf("cuStrView_substr(): %s\n", result[test_is(cuStrView_substr(v, 0, 7), "content")
+                                             && test_is(cuStrView_substr(v, 16, CUSTR_NPOS), "42")
+                                             && cuStrView_substr(v, 100, 3).len == 0
+                                             && cuStrView_substr(v, 2, 0).len == 0
+                                             && cuStrView_substr(v, 8, 3).ptr == v.ptr + 8]);
+
+    w = cuStrView_make(bytes, sizeof bytes);
+    ok = cuStrView_find_byte(v, ':', 0) == 14 && cuStrView_find_byte(v, ':', 15) == CUSTR_NPOS
+         && cuStrView_rfind_byte(v, 'e', CUSTR_NPOS) == 9
+         && cuStrView_find(v, cuStrView_from_cstr("length"), 0) == 8
+         && cuStrView_find(v, cuStrView_from_cstr("length"), 9) == CUSTR_NPOS
+         && cuStrView_find(v, cuStrView_from_cstr(""), 3) == 3
+         && cuStrView_rfind(v, cuStrView_from_cstr("t"), CUSTR_NPOS) == 12
+         && cuStrView_rfind(v, cuStrView_from_cstr("t"), 10) == 6
+         && cuStrView_count(v, cuStrView_from_cstr("n")) == 3
+         && cuStrView_find(w, cuStrView_make("\0z", 2), 0) == 3;
+    printf("cuStrView find: %s\n", result[ok]);
+
+    ok = cuStrView_equal(cuStrView_substr(v, 0, 7), cuStrView_from_cstr("content"))
+         && !cuStrView_equal(w, cuStrView_make(bytes, 4))
+         && cuStrView_compare(cuStrView_make(bytes, 4), w) < 0
+         && cuStrView_compare(cuStrView_from_cstr("b"), cuStrView_from_cstr("a")) > 0
+         && cuStrView_compare(cuStrView_make("\xff", 1), cuStrView_from_cstr("a")) > 0
+         && cuStrView_starts_with(v, cuStrView_from_cstr("content-"))
+         && cuStrView_ends_with(v, cuStrView_from_cstr(": 42"))
+         && !cuStrView_ends_with(cuStrView_from_cstr("42"), cuStrView_from_cstr(": 42"))
+         && cuStrView_starts_with(v, cuStrView_make(NULL, 0));
+    printf("cuStrView compare: %s\n", result[ok]);
+
+    ok = test_split("GET /index.html HTTP/1.1", " ", f1, 3)
+         && test_split(",a,,b,", ",", f2, 5)
+         && test_split("key := value := ", " := ", f3, 3)
+         && test_split("", ",", f4, 1);
+    printf("cuStrSplit: %s\n", result[ok]);
+
+    ok = test_tok("  a,b ,, c  ", " ,", t1, 3)
+         && test_tok(" ,, ", " ,", NULL, 0)
+         && test_tok("", " ", NULL, 0);
+    printf("cuStrTok: %s\n", result[ok]);
+
+    ok = cuStr_set_view(cus, cuStrView_substr(cuStrView_from_cstr("abcdef"), 1, 3)) != NULL
+         && cuStr_append_view(cus, w) != NULL
+         && cuStr_len(cus) == 3 + sizeof bytes
+         && memcmp(cuStr_cstr(cus), "bcdx\0y\0z", 8) == 0;
+    printf("cuStr_set_view() and cuStr_append_view(): %s\n", result[ok]);
+
+    cuStr_destroy(&cus);
+}
@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRVIEW_H
+#define CU_INCLUDE_TEST_STRVIEW_H
+
+void test_strview(void);
+
+#endif /* CU_INCLUDE_TEST_STRVIEW_H */
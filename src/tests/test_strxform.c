@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <string.h>
+#include "test_strxform.h"
+#include "../cutil_strxform.h"
+#include "../cutil_simd.h"
+
+static const char *result[] = { "FAILED", "Ok"};
+
+#define TEST_XFORM_MAX  300     // covers every block and tail size
+
+static const unsigned masks[] = { 0, CU_CPU_SSE2, CU_CPU_SSE2 | CU_CPU_SSSE3, ~0U };
+
+/* Every byte value, and a header line so that whole blocks are kept */
+static void test_fill(char *p, size_t n, int text)
+{
+    static const char line[] = "Content-Type: Text/HTML; charset=UTF-8\r\n";
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        p[i] = text ? line[i % (sizeof line - 1)] : (char)(i * 7 + i / 251);
+}
+
+static unsigned test_class(unsigned char c)
+{
+    unsigned classes = 0;
+
+    if (c < 0x20 || c == 0x7F)
+        classes |= CUSTR_CLASS_CNTRL;
+    if (c == ' ' || (c >= '\t' && c <= '\r'))
+        classes |= CUSTR_CLASS_SPACE;
+    if (c >= '0' && c <= '9')
+        classes |= CUSTR_CLASS_DIGIT;
+    if (c >= 'A' && c <= 'Z')
+        classes |= CUSTR_CLASS_UPPER;
+    if (c >= 'a' && c <= 'z')
+        classes |= CUSTR_CLASS_LOWER;
+    if (c > ' ' && c < 0x7F && !classes)
+        classes |= CUSTR_CLASS_PUNCT;
+    if (c >= 0x80)
+        classes |= CUSTR_CLASS_HIGH;
+    return classes;
+}
+
+/* The same through a cuStr, whose kernels may finish with a whole block
+ * in the rest of its buffer
+ */
+static int test_same(cuStr *cus, const char *ref, size_t n)
+{
+    return cuStr_len(cus) == n && memcmp(cuStr_cstr(cus), ref, n) == 0
+           && cuStr_cstr(cus)[n] == '\0';
+}
+
+static void test_set(cuStr *cus, const char *p, size_t n)
+{
+    cuStr_set(cus, "");
+    cuStr_append_array(cus, p, n);
+}
+
+/* Case mapping and translation against byte by byte references, for
+ * every length and kernel
+ */
+static int test_map_kernels(cuStr *cus)
+{
+    char buf[TEST_XFORM_MAX], ref[TEST_XFORM_MAX];
+    unsigned char table[256];
+    size_t n, i, m;
+    int text;
+
+    for (i = 0; i < 256; i++)
+        table[i] = (unsigned char)(i * 167 + 13);
+
+    for (m = 0; m < sizeof masks / sizeof masks[0]; m++) {
+        cu_cpu_set_mask(masks[m]);
+        for (text = 0; text < 2; text++) {
+            for (n = 0; n <= TEST_XFORM_MAX; n++) {
+                test_fill(buf, n, text);
+                for (i = 0; i < n; i++)
+                    ref[i] = (char)(test_class((unsigned char)buf[i]) & CUSTR_CLASS_UPPER ? buf[i] + 32 : buf[i]);
+                test_set(cus, buf, n);
+                cuMem_to_lower(buf, n);
+                if (memcmp(buf, ref, n) != 0 || !test_same(cuStr_to_lower(cus), ref, n))
+                    return 0;
+
+                test_fill(buf, n, text);
+                for (i = 0; i < n; i++)
+                    ref[i] = (char)(test_class((unsigned char)buf[i]) & CUSTR_CLASS_LOWER ? buf[i] - 32 : buf[i]);
+                test_set(cus, buf, n);
+                cuMem_to_upper(buf, n);
+                if (memcmp(buf, ref, n) != 0 || !test_same(cuStr_to_upper(cus), ref, n))
+                    return 0;
+
+                test_fill(buf, n, text);
+                for (i = 0; i < n; i++)
+                    ref[i] = (char)table[(unsigned char)buf[i]];
+                test_set(cus, buf, n);
+                cuMem_translate(buf, n, table);
+                if (memcmp(buf, ref, n) != 0 || !test_same(cuStr_translate(cus, table), ref, n))
+                    return 0;
+            }
+        }
+    }
+    cu_cpu_set_mask(~0U);
+    return 1;
+}
+
+static int test_filter_kernels(cuStr *cus)
+{
+    static const unsigned sets[] = {
+        0, CUSTR_CLASS_CNTRL, CUSTR_CLASS_SPACE, CUSTR_CLASS_DIGIT, CUSTR_CLASS_UPPER,
+        CUSTR_CLASS_LOWER, CUSTR_CLASS_PUNCT, CUSTR_CLASS_HIGH,
+        CUSTR_CLASS_CNTRL | CUSTR_CLASS_SPACE, CUSTR_CLASS_UPPER | CUSTR_CLASS_HIGH, 0x7F,
+    };
+    char buf[TEST_XFORM_MAX], ref[TEST_XFORM_MAX];
+    size_t n, i, k, m, len;
+    int text;
+
+    for (m = 0; m < sizeof masks / sizeof masks[0]; m++) {
+        cu_cpu_set_mask(masks[m]);
+        for (k = 0; k < sizeof sets / sizeof sets[0]; k++) {
+            for (text = 0; text < 2; text++) {
+                for (n = 0; n <= TEST_XFORM_MAX; n++) {
+                    test_fill(buf, n, text);
+                    for (i = len = 0; i < n; i++) {
+                        if (!(test_class((unsigned char)buf[i]) & sets[k]))
+                            ref[len++] = buf[i];
+                    }
+                    test_set(cus, buf, n);
+                    if (cuMem_filter_class(buf, n, sets[k]) != len || memcmp(buf, ref, len) != 0
+                        || !test_same(cuStr_filter_class(cus, sets[k]), ref, len))
+                        return 0;
+                }
+            }
+        }
+    }
+    cu_cpu_set_mask(~0U);
+    return 1;
+}
+
+/* Leading and trailing runs of every length up to a few blocks */
+static int test_trim_kernels(cuStr *cus)
+{
+    char buf[TEST_XFORM_MAX];
+    size_t lead, trail, m;
+
+    for (m = 0; m < sizeof masks / sizeof masks[0]; m++) {
+        cu_cpu_set_mask(masks[m]);
+        for (lead = 0; lead < 100; lead += 3) {
+            for (trail = 0; trail < 100; trail += 7) {
+                memset(buf, ' ', lead);
+                buf[lead % 5] = '\t';
+                memcpy(buf + lead, "a \r b", 5);
+                memset(buf + lead + 5, '\n', trail);
+                test_set(cus, buf, lead + 5 + trail);
+                if (cuStr_trim(cus) != cus || cuStr_strcmp_cstr(cus, "a \r b") != 0
+                    || cuStr_cstr(cus)[5] != '\0')
+                    return 0;
+                memset(buf, ' ', lead + trail);
+                test_set(cus, buf, lead + trail);
+                if (cuStr_len(cuStr_trim(cus)) != 0)
+                    return 0;
+            }
+        }
+    }
+    cu_cpu_set_mask(~0U);
+    return 1;
+}
+
+void test_strxform(void)
+{
+    unsigned char table[256];
+    cuStr *cus;
+    size_t i;
+    int ok;
+
+    cus = cuStr_new(-1);
+    if (!cus) {
+        printf("cuStr_new() failed. Aborting tests\n");
+        return;
+    }
+
+    printf("cuMem_to_lower/upper(), cuMem_translate() kernels: %s\n", result[test_map_kernels(cus)]);
+    printf("cuMem_filter_class() kernels: %s\n", result[test_filter_kernels(cus)]);
+    printf("cuStr_trim() kernels: %s\n", result[test_trim_kernels(cus)]);
+
+    /* Normalizing a header name */
+    cuStr_set(cus, " \tX-Forwarded\x01-FOR\x7f\r\n");
+    ok = cuStr_trim(cus) == cus && cuStr_filter_class(cus, CUSTR_CLASS_CNTRL) == cus
+         && cuStr_to_lower(cus) == cus && cuStr_strcmp_cstr(cus, "x-forwarded-for") == 0
+         && cuStr_len(cus) == 15 && cuStr_to_upper(cus) == cus
+         && cuStr_strcmp_cstr(cus, "X-FORWARDED-FOR") == 0;
+    printf("cuStr_trim/filter_class/to_lower/to_upper(): %s\n", result[ok]);
+
+    for (i = 0; i < 256; i++)
+        table[i] = (unsigned char)(i == '-' ? '_' : i);
+    cuStr_set(cus, "a-b-c");
+    ok = cuStr_translate(cus, table) == cus && cuStr_strcmp_cstr(cus, "a_b_c") == 0;
+    cuStr_set(cus, "");
+    ok = ok && cuStr_trim(cus) == cus && cuStr_to_lower(cus) == cus
+         && cuStr_filter_class(cus, 0x7F) == cus && cuStr_len(cus) == 0;
+    printf("cuStr_translate(), empty strings: %s\n", result[ok]);
+
+    cuStr_destroy(&cus);
+}
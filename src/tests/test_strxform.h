@@ -0,0 +1,6 @@
+#ifndef CU_INCLUDE_TEST_STRXFORM_H
+#define CU_INCLUDE_TEST_STRXFORM_H
+
+void test_strxform(void);
+
+#endif /* CU_INCLUDE_TEST_STRXFORM_H */